@@ -1323,10 +1323,25 @@ pcap_cleanup_bpf(pcap_t *p)
 		 * null it out so that pcap_cleanup_live_common()
 		 * doesn't try to free it.
 		 */
+#ifndef __rtems__
 		if (p->md.zbuf1 != MAP_FAILED && p->md.zbuf1 != NULL)
 			(void) munmap(p->md.zbuf1, p->md.zbufsize);
 		if (p->md.zbuf2 != MAP_FAILED && p->md.zbuf2 != NULL)
 			(void) munmap(p->md.zbuf2, p->md.zbufsize);
+#else /* __rtems__ */
+		/*
+		 * The kernel writes packets into the buffers as long as the
+		 * descriptor is attached, so close it before the free.
+		 */
+		if (p->fd >= 0) {
+			close(p->fd);
+			p->fd = -1;
+		}
+		free(p->md.zbuf1);
+		free(p->md.zbuf2);
+		p->md.zbuf1 = NULL;
+		p->md.zbuf2 = NULL;
+#endif /* __rtems__ */
 		p->buffer = NULL;
 		p->buffer = NULL;
 	}
@@ -1687,6 +1702,7 @@ pcap_activate_bpf(pcap_t *p)
 		p->md.zbufsize = roundup(v, getpagesize());
 		if (p->md.zbufsize > zbufmax)
 			p->md.zbufsize = zbufmax;
+#ifndef __rtems__
 		p->md.zbuf1 = mmap(NULL, p->md.zbufsize, PROT_READ | PROT_WRITE,
 		    MAP_ANON, -1, 0);
 		p->md.zbuf2 = mmap(NULL, p->md.zbufsize, PROT_READ | PROT_WRITE,
@@ -1696,6 +1712,19 @@ pcap_activate_bpf(pcap_t *p)
 			    pcap_strerror(errno));
 			goto bad;
 		}
+#else /* __rtems__ */
+		/*
+		 * There is a single address space, so the kernel writes
+		 * directly to heap buffers.
+		 */
+		p->md.zbuf1 = malloc(p->md.zbufsize);
+		p->md.zbuf2 = malloc(p->md.zbufsize);
+		if (p->md.zbuf1 == NULL || p->md.zbuf2 == NULL) {
+			snprintf(p->errbuf, PCAP_ERRBUF_SIZE, "malloc: %s",
+			    pcap_strerror(errno));
+			goto bad;
+		}
+#endif /* __rtems__ */
 		memset(&bz, 0, sizeof(bz)); /* bzero() deprecated, replaced with memset() */
 		bz.bz_bufa = p->md.zbuf1;
 		bz.bz_bufb = p->md.zbuf2;
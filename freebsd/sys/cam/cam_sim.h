@@ -115,6 +115,9 @@ enum bsd_sim_state {
   BSD_SIM_BUSY,
   BSD_SIM_DELETED
 };
+
+/* Block device requests queued while the SIM is busy */
+#define	BSD_SIM_QUEUE_DEPTH 8
 #endif /* __rtems__ */
 
 /*
@@ -136,6 +139,12 @@ struct cam_sim {
 	enum bsd_sim_state	state;
 	struct cv		state_changed;
 	union ccb		ccb;
+	u_int32_t		block_size;
+	u_int8_t		*bounce;
+	rtems_blkdev_sg_buffer	*bounce_sg;
+	rtems_blkdev_request	*queue[BSD_SIM_QUEUE_DEPTH];
+	u_int			queue_first;
+	u_int			queue_count;
 #endif /* __rtems__ */
 	u_int32_t		unit_number;
 #ifndef __rtems__
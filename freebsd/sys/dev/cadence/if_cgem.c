@@ -133,6 +133,11 @@ struct cgem_softc {
 	int			rxring_hd_ptr;	/* where to put rcv bufs */
 	int			rxring_tl_ptr;	/* where to get receives */
 	int			rxring_queued;	/* how many rcv bufs queued */
+#ifdef __rtems__
+	struct rxpool		*rxpool;
+	u_int			rxbufsize;	/* size of rcv bufs */
+	u_int			jumbo_max_len;	/* 0 if no jumbo frames */
+#endif /* __rtems__ */
  	bus_dmamap_t		rxring_dma_map;
 	int			rxbufs;		/* tunable number rcv bufs */
 	int			rxhangwar;	/* rx hang work-around */
@@ -453,6 +458,13 @@ cgem_setup_descs(struct cgem_softc *sc)
 	sc->rxring_hd_ptr = 0;
 	sc->rxring_tl_ptr = 0;
 	sc->rxring_queued = 0;
+#ifdef __rtems__
+
+	/* Receive buffers for the ring and packets queued in the stack. */
+	sc->rxbufsize = MCLBYTES;
+	sc->rxpool = rxpool_create(device_get_nameunit(sc->dev),
+	    2 * CGEM_NUM_RX_DESCS, sc->rxbufsize);
+#endif /* __rtems__ */
 
 	/* Allocate DMA memory for TX descriptors in non-cacheable space. */
 	err = bus_dmamem_alloc(sc->desc_dma_tag,
@@ -505,12 +517,21 @@ cgem_fill_rqueue(struct cgem_softc *sc)
 
 	while (sc->rxring_queued < sc->rxbufs) {
 		/* Get a cluster mbuf. */
+#ifndef __rtems__
 		m = m_getcl(M_NOWAIT, MT_DATA, M_PKTHDR);
+#else /* __rtems__ */
+		m = rxpool_getcl(sc->rxpool, M_NOWAIT);
+#endif /* __rtems__ */
 		if (m == NULL)
 			break;
 
+#ifndef __rtems__
 		m->m_len = MCLBYTES;
 		m->m_pkthdr.len = MCLBYTES;
+#else /* __rtems__ */
+		m->m_len = m->m_ext.ext_size;
+		m->m_pkthdr.len = m->m_ext.ext_size;
+#endif /* __rtems__ */
 		m->m_pkthdr.rcvif = sc->ifp;
 
 		/* Load map and plug in physical address. */
@@ -606,7 +627,12 @@ cgem_recv(struct cgem_softc *sc)
 		 * cluster (which is much bigger than the largest ethernet
 		 * packet).
 		 */
+#ifndef __rtems__
 		if ((ctl & CGEM_RXDESC_BAD_FCS) != 0 ||
+#else /* __rtems__ */
+		if (((ctl & CGEM_RXDESC_BAD_FCS) != 0 &&
+		     sc->rxbufsize == MCLBYTES) ||
+#endif /* __rtems__ */
 		    (ctl & (CGEM_RXDESC_SOF | CGEM_RXDESC_EOF)) !=
 		           (CGEM_RXDESC_SOF | CGEM_RXDESC_EOF)) {
 			/* discard. */
@@ -617,7 +643,12 @@ cgem_recv(struct cgem_softc *sc)
 
 		/* Ready it to hand off to upper layers. */
 		m->m_data += ETHER_ALIGN;
+#ifndef __rtems__
 		m->m_len = (ctl & CGEM_RXDESC_LENGTH_MASK);
+#else /* __rtems__ */
+		m->m_len = (ctl & (sc->rxbufsize == MCLBYTES ?
+		    CGEM_RXDESC_LENGTH_MASK : CGEM_RXDESC_LENGTH_MASK_JUMBO));
+#endif /* __rtems__ */
 		m->m_pkthdr.rcvif = ifp;
 		m->m_pkthdr.len = m->m_len;
 
@@ -1114,11 +1145,24 @@ cgem_config(struct cgem_softc *sc)
 	/* Enable receive checksum offloading? */
 	if ((if_getcapenable(ifp) & IFCAP_RXCSUM) != 0)
 		net_cfg |=  CGEM_NET_CFG_RX_CHKSUM_OFFLD_EN;
+#ifdef __rtems__
+
+	/* Receive jumbo frames into single buffers? */
+	if (sc->rxbufsize > MCLBYTES) {
+		net_cfg &= ~CGEM_NET_CFG_1536RXEN;
+		net_cfg |= CGEM_NET_CFG_JUMBO_EN;
+		WR4(sc, CGEM_JUMBO_MAX_LEN, sc->jumbo_max_len);
+	}
+#endif /* __rtems__ */
 
 	WR4(sc, CGEM_NET_CFG, net_cfg);
 
 	/* Program DMA Config Register. */
+#ifndef __rtems__
 	dma_cfg = CGEM_DMA_CFG_RX_BUF_SIZE(MCLBYTES) |
+#else /* __rtems__ */
+	dma_cfg = CGEM_DMA_CFG_RX_BUF_SIZE(sc->rxbufsize) |
+#endif /* __rtems__ */
 		CGEM_DMA_CFG_RX_PKTBUF_MEMSZ_SEL_8K |
 		CGEM_DMA_CFG_TX_PKTBUF_MEMSZ_SEL |
 		CGEM_DMA_CFG_AHB_FIXED_BURST_LEN_16 |
@@ -1246,6 +1290,57 @@ cgem_stop(struct cgem_softc *sc)
 	sc->mii_media_active = 0;
 }
 
+#ifdef __rtems__
+/*
+ * Change the MTU.  Jumbo frames are received into single 9k buffers, so the
+ * receive buffer pool is replaced if the buffer size changes.
+ */
+static int
+cgem_set_mtu(struct cgem_softc *sc, int mtu)
+{
+	if_t ifp = sc->ifp;
+	struct rxpool *rxpool;
+	u_int rxbufsize;
+	int max_mtu;
+
+	if (sc->jumbo_max_len != 0)
+		max_mtu = sc->jumbo_max_len - ETHER_HDR_LEN -
+		    ETHER_VLAN_ENCAP_LEN - ETHER_CRC_LEN;
+	else
+		max_mtu = ETHERMTU;
+	if (mtu < ETHERMIN || mtu > max_mtu)
+		return (EINVAL);
+
+	rxbufsize = mtu > ETHERMTU ? MJUM9BYTES : MCLBYTES;
+	rxpool = NULL;
+	if (rxbufsize != sc->rxbufsize)
+		rxpool = rxpool_create(device_get_nameunit(sc->dev),
+		    2 * CGEM_NUM_RX_DESCS, rxbufsize);
+
+	CGEM_LOCK(sc);
+	if_setmtu(ifp, mtu);
+	if (rxpool != NULL) {
+		struct rxpool *old;
+
+		old = sc->rxpool;
+		sc->rxpool = rxpool;
+		sc->rxbufsize = rxbufsize;
+		rxpool = old;
+	}
+	if ((if_getdrvflags(ifp) & IFF_DRV_RUNNING) != 0) {
+		if_setdrvflagbits(ifp, 0, IFF_DRV_RUNNING);
+		cgem_stop(sc);
+		cgem_init_locked(sc);
+	}
+	CGEM_UNLOCK(sc);
+
+	/* The old pool goes away once the stack returned all buffers */
+	if (rxpool != NULL)
+		rxpool_destroy(rxpool);
+
+	return (0);
+}
+#endif /* __rtems__ */
 
 static int
 cgem_ioctl(if_t ifp, u_long cmd, caddr_t data)
@@ -1341,6 +1436,11 @@ cgem_ioctl(if_t ifp, u_long cmd, caddr_t data)
 
 		CGEM_UNLOCK(sc);
 		break;
+#ifdef __rtems__
+	case SIOCSIFMTU:
+		error = cgem_set_mtu(sc, ifr->ifr_mtu);
+		break;
+#endif /* __rtems__ */
 	default:
 		error = ether_ioctl(ifp, cmd, data);
 		break;
@@ -1789,6 +1889,21 @@ cgem_attach(device_t dev)
 	if_setstartfn(ifp, cgem_start);
 	if_setcapabilitiesbit(ifp, IFCAP_HWCSUM | IFCAP_HWCSUM_IPV6 |
 			      IFCAP_VLAN_MTU | IFCAP_VLAN_HWCSUM, 0);
+#ifdef __rtems__
+
+	/*
+	 * Some GEM variants, for example the one of the ZynqMP, support jumbo
+	 * frames.  A frame must fit into a 9k receive buffer.
+	 */
+	sc->jumbo_max_len = RD4(sc, CGEM_DESIGN_CFG2) &
+	    CGEM_DESIGN_CFG2_JUMBO_MAX_LEN_MASK;
+	if (sc->jumbo_max_len > ETHER_MAX_LEN + ETHER_VLAN_ENCAP_LEN) {
+		sc->jumbo_max_len = MIN(sc->jumbo_max_len,
+		    MJUM9BYTES - ETHER_ALIGN);
+		if_setcapabilitiesbit(ifp, IFCAP_JUMBO_MTU, 0);
+	} else
+		sc->jumbo_max_len = 0;
+#endif /* __rtems__ */
 	if_setsendqlen(ifp, CGEM_NUM_TX_DESCS);
 	if_setsendqready(ifp);
 
@@ -1904,6 +2019,12 @@ cgem_detach(device_t dev)
 			}
 #endif /* __rtems__ */
 	}
+#ifdef __rtems__
+	if (sc->rxpool != NULL) {
+		rxpool_destroy(sc->rxpool);
+		sc->rxpool = NULL;
+	}
+#endif /* __rtems__ */
 	if (sc->txring != NULL) {
 		if (sc->txring_physaddr != 0) {
 			bus_dmamap_unload(sc->desc_dma_tag,
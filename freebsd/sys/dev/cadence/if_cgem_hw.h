@@ -95,6 +95,9 @@
 #define   CGEM_NET_CFG_MULTI_HASH_EN		(1<<6)
 #define   CGEM_NET_CFG_NO_BCAST			(1<<5)
 #define   CGEM_NET_CFG_COPY_ALL			(1<<4)
+#ifdef __rtems__
+#define   CGEM_NET_CFG_JUMBO_EN			(1<<3)
+#endif /* __rtems__ */
 #define   CGEM_NET_CFG_DISC_NON_VLAN		(1<<2)
 #define   CGEM_NET_CFG_FULL_DUPLEX		(1<<1)
 #define   CGEM_NET_CFG_SPEED100			(1<<0)
@@ -198,6 +201,10 @@
 
 #define CGEM_RX_PAUSEQ			0x038	/* Received Pause Quantum */
 #define CGEM_TX_PAUSEQ			0x03C	/* Transmit Puase Quantum */
+#ifdef __rtems__
+
+#define CGEM_JUMBO_MAX_LEN		0x048	/* Jumbo Max Length */
+#endif /* __rtems__ */
 
 #define CGEM_HASH_BOT			0x080	/* Hash Reg Bottom [31:0] */
 #define CGEM_HASH_TOP			0x084	/* Hash Reg Top [63:32] */
@@ -377,6 +384,9 @@ struct cgem_rx_desc {
 #define CGEM_RXDESC_SOF				(1<<14) /* start of frame */
 #define CGEM_RXDESC_BAD_FCS			(1<<13)
 #define CGEM_RXDESC_LENGTH_MASK			0x1fff
+#ifdef __rtems__
+#define CGEM_RXDESC_LENGTH_MASK_JUMBO		0x3fff	/* BAD_FCS is MSB */
+#endif /* __rtems__ */
 };
 
 #endif /* _IF_CGEM_HW_H_ */
@@ -612,7 +612,11 @@ dwc_alloc_mbufcl(struct dwc_softc *sc)
 {
 	struct mbuf *m;
 
+#ifndef __rtems__
 	m = m_getcl(M_NOWAIT, MT_DATA, M_PKTHDR);
+#else /* __rtems__ */
+	m = rxpool_getcl(sc->rxpool, M_NOWAIT);
+#endif /* __rtems__ */
 	if (m != NULL)
 		m->m_pkthdr.len = m->m_len = m->m_ext.ext_size;
 
@@ -1124,6 +1128,14 @@ setup_dma(struct dwc_softc *sc)
 		    "could not create RX buf DMA tag.\n");
 		goto out;
 	}
+#else /* __rtems__ */
+
+	/*
+	 * The ring holds RX_DESC_COUNT buffers and about the same number may
+	 * be queued in the stack while the ring is refilled.
+	 */
+	sc->rxpool = rxpool_create(device_get_nameunit(sc->dev),
+	    2 * RX_DESC_COUNT, MCLBYTES);
 #endif /* __rtems__ */
 
 	for (idx = 0; idx < RX_DESC_COUNT; idx++) {
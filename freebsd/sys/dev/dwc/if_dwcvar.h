@@ -96,6 +96,9 @@ struct dwc_softc {
 #endif /* __rtems__ */
 	struct dwc_bufmap	rxbuf_map[RX_DESC_COUNT];
 	uint32_t		rx_idx;
+#ifdef __rtems__
+	struct rxpool		*rxpool;
+#endif /* __rtems__ */
 
 	/* TX */
 	bus_dma_tag_t		txdesc_tag;
@@ -33,6 +33,14 @@
 
 #define em_mac_min e1000_82547
 #define igb_mac_min e1000_82575
+#ifdef __rtems__
+
+/*
+ * The 9k jumbo clusters are allocated from a contiguous region, so jumbo
+ * frames are received into single clusters.
+ */
+#define CONTIGMALLOC_WORKS
+#endif /* __rtems__ */
 
 /*********************************************************************
  *  Driver version:
@@ -54,6 +54,9 @@ __FBSDID("$FreeBSD$");
 #include <dev/mii/miivar.h>
 
 #include <rtems/bsd/local/miibus_if.h>
+#ifdef __rtems__
+#include <rtems/bsd/bsd.h>
+#endif /* __rtems__ */
 
 /*
  *
@@ -347,7 +350,19 @@ mii_phy_reset(struct mii_softc *sc)
 		reg = PHY_READ(sc, MII_BMCR);
 		if ((reg & BMCR_RESET) == 0)
 			break;
+#ifndef __rtems__
 		DELAY(1000);
+#else /* __rtems__ */
+		/*
+		 * During a parallel attach let the other devices proceed
+		 * instead of spinning with the Giant lock.
+		 */
+		if (rtems_bsd_parallel_attach_tasks > 0 &&
+		    device_get_state(sc->mii_dev) == DS_ATTACHING)
+			pause("miirst", max(1, hz / 1000));
+		else
+			DELAY(1000);
+#endif /* __rtems__ */
 	}
 
 	/* NB: a PHY may default to being powered down and/or isolated. */
@@ -103,6 +103,8 @@ static usb_callback_t cdce_intr_write_callback;
 #if CDCE_HAVE_NCM
 static usb_callback_t cdce_ncm_bulk_write_callback;
 static usb_callback_t cdce_ncm_bulk_read_callback;
+
+static void	cdce_ncm_attach_sysctl(device_t, struct cdce_softc *);
 #endif
 
 static uether_fn_t cdce_attach_post;
@@ -114,17 +116,30 @@ static uether_fn_t cdce_setpromisc;
 
 static uint32_t	cdce_m_crc32(struct mbuf *, uint32_t, uint32_t);
 
+static SYSCTL_NODE(_hw_usb, OID_AUTO, cdce, CTLFLAG_RW, 0, "USB CDC-Ethernet");
+
 #ifdef USB_DEBUG
 static int cdce_debug = 0;
 static int cdce_tx_interval = 0;
 
-static SYSCTL_NODE(_hw_usb, OID_AUTO, cdce, CTLFLAG_RW, 0, "USB CDC-Ethernet");
 SYSCTL_INT(_hw_usb_cdce, OID_AUTO, debug, CTLFLAG_RWTUN, &cdce_debug, 0,
     "Debug level");
 SYSCTL_INT(_hw_usb_cdce, OID_AUTO, interval, CTLFLAG_RWTUN, &cdce_tx_interval, 0,
     "NCM transmit interval in ms");
 #endif
 
+#if CDCE_HAVE_NCM
+static int cdce_ncm_tx_datagrams = 0;
+static int cdce_ncm_tx_holdoff = 0;
+
+SYSCTL_INT(_hw_usb_cdce, OID_AUTO, ncm_tx_datagrams, CTLFLAG_RWTUN,
+    &cdce_ncm_tx_datagrams, 0,
+    "Maximum datagrams per NCM transfer block, 0 uses the device limit");
+SYSCTL_INT(_hw_usb_cdce, OID_AUTO, ncm_tx_holdoff, CTLFLAG_RWTUN,
+    &cdce_ncm_tx_holdoff, 0,
+    "Microseconds to wait for a full NCM transfer block, 0 disables");
+#endif
+
 static const struct usb_config cdce_config[CDCE_N_TRANSFER] = {
 
 	[CDCE_BULK_RX] = {
@@ -188,7 +203,7 @@ static const struct usb_config cdce_ncm_config[CDCE_N_TRANSFER] = {
 		.if_index = 0,
 		.frames = CDCE_NCM_RX_FRAMES_MAX,
 		.bufsize = (CDCE_NCM_RX_FRAMES_MAX * CDCE_NCM_RX_MAXLEN),
-		.flags = {.pipe_bof = 1,.short_frames_ok = 1,.short_xfer_ok = 1,},
+		.flags = {.pipe_bof = 1,.short_frames_ok = 1,.short_xfer_ok = 1,.ext_buffer = 1,},
 		.callback = cdce_ncm_bulk_read_callback,
 		.timeout = 0,	/* no timeout */
 		.usb_mode = USB_MODE_DUAL,	/* both modes */
@@ -493,8 +508,42 @@ cdce_ncm_init(struct cdce_softc *sc)
 		DPRINTFN(1, "Setting NTB format to 16-bit failed.\n");
 	}
 
+	/* receive buffer for when no cluster can be allocated */
+	if (sc->sc_ncm.rx_spare == NULL) {
+		sc->sc_ncm.rx_spare = malloc(CDCE_NCM_RX_MAXLEN,
+		    M_USBDEV, M_WAITOK);
+	}
 	return (0);		/* success */
 }
+
+static void
+cdce_ncm_attach_sysctl(device_t dev, struct cdce_softc *sc)
+{
+	struct sysctl_ctx_list *ctx;
+	struct sysctl_oid_list *child;
+	struct sysctl_oid *tree;
+	struct cdce_ncm_stats *stats;
+
+	stats = &sc->sc_ncm.stats;
+	ctx = device_get_sysctl_ctx(dev);
+	child = SYSCTL_CHILDREN(device_get_sysctl_tree(dev));
+
+	tree = SYSCTL_ADD_NODE(ctx, child, OID_AUTO, "ncm", CTLFLAG_RD,
+	    NULL, "NCM statistics");
+	child = SYSCTL_CHILDREN(tree);
+	SYSCTL_ADD_UINT(ctx, child, OID_AUTO, "tx_ntb", CTLFLAG_RD,
+	    &stats->tx_ntb, 0, "Transfer blocks sent");
+	SYSCTL_ADD_UINT(ctx, child, OID_AUTO, "tx_datagrams", CTLFLAG_RD,
+	    &stats->tx_dgram, 0, "Datagrams sent");
+	SYSCTL_ADD_UINT(ctx, child, OID_AUTO, "tx_holdoff", CTLFLAG_RD,
+	    &stats->tx_holdoff, 0, "Transfer blocks sent by the hold-off timer");
+	SYSCTL_ADD_UINT(ctx, child, OID_AUTO, "rx_ntb", CTLFLAG_RD,
+	    &stats->rx_ntb, 0, "Transfer blocks received");
+	SYSCTL_ADD_UINT(ctx, child, OID_AUTO, "rx_ref", CTLFLAG_RD,
+	    &stats->rx_ref, 0, "Datagrams received without copy");
+	SYSCTL_ADD_UINT(ctx, child, OID_AUTO, "rx_copy", CTLFLAG_RD,
+	    &stats->rx_copy, 0, "Datagrams copied out of the transfer block");
+}
 #endif
 
 static void
@@ -581,6 +630,9 @@ cdce_attach(device_t dev)
 	device_set_usb_desc(dev);
 
 	mtx_init(&sc->sc_mtx, device_get_nameunit(dev), NULL, MTX_DEF);
+#if CDCE_HAVE_NCM
+	usb_callout_init_mtx(&sc->sc_ncm.tx_callout, &sc->sc_mtx, 0);
+#endif
 
 	ud = usbd_find_descriptor
 	    (uaa->device, NULL, uaa->info.bIfaceIndex,
@@ -649,8 +701,10 @@ alloc_transfers:
 		if (error)
 			break;
 #if CDCE_HAVE_NCM
-		if ((i == 0) && (cdce_ncm_init(sc) == 0))
+		if ((i == 0) && (cdce_ncm_init(sc) == 0)) {
 			pcfg = cdce_ncm_config;
+			cdce_ncm_attach_sysctl(dev, sc);
+		}
 #endif
 		error = usbd_transfer_setup(uaa->device,
 		    sc->sc_ifaces_index, sc->sc_xfer,
@@ -743,7 +797,15 @@ cdce_detach(device_t dev)
 
 	/* stop all USB transfers first */
 	usbd_transfer_unsetup(sc->sc_xfer, CDCE_N_TRANSFER);
+#if CDCE_HAVE_NCM
+	usb_callout_drain(&sc->sc_ncm.tx_callout);
+#endif
 	uether_ifdetach(ue);
+#if CDCE_HAVE_NCM
+	if (sc->sc_ncm.rx_m != NULL)
+		m_freem(sc->sc_ncm.rx_m);
+	free(sc->sc_ncm.rx_spare, M_USBDEV);
+#endif
 	mtx_destroy(&sc->sc_mtx);
 
 	return (0);
@@ -935,6 +997,10 @@ cdce_stop(struct usb_ether *ue)
 	usbd_transfer_stop(sc->sc_xfer[CDCE_BULK_TX]);
 	usbd_transfer_stop(sc->sc_xfer[CDCE_INTR_RX]);
 	usbd_transfer_stop(sc->sc_xfer[CDCE_INTR_TX]);
+#if CDCE_HAVE_NCM
+	usb_callout_stop(&sc->sc_ncm.tx_callout);
+	sc->sc_ncm.tx_flush = 0;
+#endif
 }
 
 static void
@@ -1218,6 +1284,7 @@ cdce_ncm_fill_tx_frames(struct usb_xfer *xfer, uint8_t index)
 	uint32_t offset;
 	uint32_t last_offset;
 	uint16_t n;
+	uint16_t nmax;
 	uint8_t retval;
 
 	usbd_xfer_set_frame_offset(xfer, index * CDCE_NCM_TX_MAXLEN, index);
@@ -1238,7 +1305,11 @@ cdce_ncm_fill_tx_frames(struct usb_xfer *xfer, uint8_t index)
 	/* buffer full */
 	retval = 2;
 
-	for (n = 0; n != sc->sc_ncm.tx_nframe; n++) {
+	nmax = sc->sc_ncm.tx_nframe;
+	if (cdce_ncm_tx_datagrams > 0 && cdce_ncm_tx_datagrams < nmax)
+		nmax = cdce_ncm_tx_datagrams;
+
+	for (n = 0; n != nmax; n++) {
 
 		/* check if end of transmit buffer is reached */
 
@@ -1306,6 +1377,9 @@ cdce_ncm_fill_tx_frames(struct usb_xfer *xfer, uint8_t index)
 	if (n == 0)
 		return (0);
 
+	sc->sc_ncm.stats.tx_ntb++;
+	sc->sc_ncm.stats.tx_dgram += n;
+
 	rem = (sizeof(sc->sc_ncm.dpt) + (4 * n) + 4);
 
 	USETW(sc->sc_ncm.dpt.wLength, rem);
@@ -1360,6 +1434,70 @@ cdce_ncm_fill_tx_frames(struct usb_xfer *xfer, uint8_t index)
 	return (retval);
 }
 
+static void
+cdce_ncm_tx_timeout(void *arg)
+{
+	struct cdce_softc *sc = arg;
+
+	CDCE_LOCK_ASSERT(sc, MA_OWNED);
+
+	/* send whatever has been queued so far */
+	sc->sc_ncm.tx_flush = 1;
+	sc->sc_ncm.stats.tx_holdoff++;
+	usbd_transfer_start(sc->sc_xfer[CDCE_BULK_TX]);
+}
+
+/*------------------------------------------------------------------------*
+ *	cdce_ncm_tx_holdoff
+ *
+ * Decide whether a transfer block should be sent now or whether more
+ * datagrams should be collected first.  The transfer is held back
+ * until either enough datagrams to fill a transfer block are queued
+ * or the hold-off timer expires.
+ *
+ * Return values:
+ * 0: Send now
+ * Else: Hold off
+ *------------------------------------------------------------------------*/
+static uint8_t
+cdce_ncm_tx_holdoff(struct cdce_softc *sc, struct ifnet *ifp)
+{
+	struct mbuf *m;
+	int holdoff = cdce_ncm_tx_holdoff;
+	int nmax;
+	int qlen;
+
+	if (holdoff <= 0 || sc->sc_ncm.tx_flush != 0) {
+		sc->sc_ncm.tx_flush = 0;
+		return (0);
+	}
+
+	qlen = ifp->if_snd.ifq_len + ifp->if_snd.ifq_drv_len;
+	if (qlen == 0)
+		return (0);
+
+	nmax = sc->sc_ncm.tx_nframe;
+	if (cdce_ncm_tx_datagrams > 0 && cdce_ncm_tx_datagrams < nmax)
+		nmax = cdce_ncm_tx_datagrams;
+
+	/* estimate the queued bytes from the first datagram */
+	m = ifp->if_snd.ifq_drv_head;
+	if (m == NULL)
+		m = ifp->if_snd.ifq_head;
+
+	if (qlen >= nmax || (m != NULL &&
+	    (uint32_t)qlen * m->m_pkthdr.len >= sc->sc_ncm.tx_max)) {
+		return (0);
+	}
+
+	if (!usb_callout_pending(&sc->sc_ncm.tx_callout)) {
+		usb_callout_reset(&sc->sc_ncm.tx_callout,
+		    howmany((uint64_t)holdoff * hz, 1000000),
+		    &cdce_ncm_tx_timeout, sc);
+	}
+	return (1);
+}
+
 static void
 cdce_ncm_bulk_write_callback(struct usb_xfer *xfer, usb_error_t error)
 {
@@ -1379,6 +1517,11 @@ cdce_ncm_bulk_write_callback(struct usb_xfer *xfer, usb_error_t error)
 		    "%u bytes in %u frames\n", actlen, aframes);
 
 	case USB_ST_SETUP:
+		if (cdce_ncm_tx_holdoff(sc, ifp) != 0)
+			break;
+
+		usb_callout_stop(&sc->sc_ncm.tx_callout);
+
 		for (x = 0; x != CDCE_NCM_TX_FRAMES_MAX; x++) {
 			temp = cdce_ncm_fill_tx_frames(xfer, x);
 			if (temp == 0)
@@ -1417,6 +1560,28 @@ cdce_ncm_bulk_write_callback(struct usb_xfer *xfer, usb_error_t error)
 	}
 }
 
+/*------------------------------------------------------------------------*
+ *	cdce_ncm_rx_can_ref
+ *
+ * Check if a received frame can be passed up as a reference into the
+ * NTB cluster instead of being copied.  Small frames are copied so
+ * that they do not pin the whole cluster, and on strict alignment
+ * architectures the IP header following the Ethernet header must be
+ * aligned.
+ *------------------------------------------------------------------------*/
+static uint8_t
+cdce_ncm_rx_can_ref(struct mbuf *m, int offset, int len)
+{
+	if (m == NULL || len <= (int)(MHLEN - ETHER_ALIGN))
+		return (0);
+#ifndef __NO_STRICT_ALIGNMENT
+	if (((uintptr_t)(mtod(m, caddr_t) + offset +
+	    ETHER_HDR_LEN) & (sizeof(uint32_t) - 1)) != 0)
+		return (0);
+#endif
+	return (1);
+}
+
 static void
 cdce_ncm_bulk_read_callback(struct usb_xfer *xfer, usb_error_t error)
 {
@@ -1430,6 +1595,7 @@ cdce_ncm_bulk_read_callback(struct usb_xfer *xfer, usb_error_t error)
 	int aframes;
 	int temp;
 	int nframes;
+	int refs;
 	int x;
 	int offset;
 
@@ -1509,7 +1675,9 @@ cdce_ncm_bulk_read_callback(struct usb_xfer *xfer, usb_error_t error)
 		}
 		usbd_copy_out(pc, temp, &(sc->sc_ncm.dp), (4 * nframes));
 
+		sc->sc_ncm.stats.rx_ntb++;
 		sumdata = 0;
+		refs = 0;
 
 		for (x = 0; x != nframes; x++) {
 
@@ -1529,10 +1697,30 @@ cdce_ncm_bulk_read_callback(struct usb_xfer *xfer, usb_error_t error)
 				m = NULL;
 				/* silently ignore this frame */
 				continue;
-			} else if (temp > (int)(MHLEN - ETHER_ALIGN)) {
-				m = m_getcl(M_NOWAIT, MT_DATA, M_PKTHDR);
-			} else {
+			} else if (cdce_ncm_rx_can_ref(sc->sc_ncm.rx_m,
+			    offset, temp)) {
+				/* reference the frame in the NTB cluster */
 				m = m_gethdr(M_NOWAIT, MT_DATA);
+				if (m != NULL) {
+					mb_dupcl(m, sc->sc_ncm.rx_m);
+					m->m_data = mtod(sc->sc_ncm.rx_m,
+					    caddr_t) + offset;
+					refs++;
+					sc->sc_ncm.stats.rx_ref++;
+				}
+			} else {
+				if (temp > (int)(MHLEN - ETHER_ALIGN))
+					m = m_getcl(M_NOWAIT, MT_DATA, M_PKTHDR);
+				else
+					m = m_gethdr(M_NOWAIT, MT_DATA);
+				if (m != NULL) {
+					m->m_len = m->m_pkthdr.len =
+					    temp + ETHER_ALIGN;
+					m_adj(m, ETHER_ALIGN);
+					usbd_copy_out(pc, offset,
+					    m->m_data, temp);
+					sc->sc_ncm.stats.rx_copy++;
+				}
 			}
 
 			DPRINTFN(16, "frame %u, offset = %u, length = %u \n",
@@ -1540,11 +1728,6 @@ cdce_ncm_bulk_read_callback(struct usb_xfer *xfer, usb_error_t error)
 
 			/* check if we have a buffer */
 			if (m) {
-				m->m_len = m->m_pkthdr.len = temp + ETHER_ALIGN;
-				m_adj(m, ETHER_ALIGN);
-
-				usbd_copy_out(pc, offset, m->m_data, temp);
-
 				/* enqueue */
 				uether_rxmbuf(&sc->sc_ue, m, temp);
 
@@ -1556,9 +1739,29 @@ cdce_ncm_bulk_read_callback(struct usb_xfer *xfer, usb_error_t error)
 
 		DPRINTFN(1, "Efficiency: %u/%u bytes\n", sumdata, actlen);
 
+		/*
+		 * The received frames now own the NTB cluster, use a
+		 * new one for the next transfer:
+		 */
+		if (refs != 0) {
+			m_freem(sc->sc_ncm.rx_m);
+			sc->sc_ncm.rx_m = NULL;
+		}
+
 	case USB_ST_SETUP:
 tr_setup:
-		usbd_xfer_set_frame_len(xfer, 0, sc->sc_ncm.rx_max);
+		if (sc->sc_ncm.rx_m == NULL) {
+			sc->sc_ncm.rx_m = m_getjcl(M_NOWAIT, MT_DATA,
+			    M_PKTHDR, MJUM16BYTES);
+		}
+		if (sc->sc_ncm.rx_m != NULL) {
+			usbd_xfer_set_frame_data(xfer, 0,
+			    mtod(sc->sc_ncm.rx_m, caddr_t), sc->sc_ncm.rx_max);
+		} else {
+			/* out of clusters, copy all frames */
+			usbd_xfer_set_frame_data(xfer, 0,
+			    sc->sc_ncm.rx_spare, sc->sc_ncm.rx_max);
+		}
 		usbd_xfer_set_frames(xfer, 1);
 		usbd_transfer_submit(xfer);
 		uether_rxflush(&sc->sc_ue);	/* must be last */
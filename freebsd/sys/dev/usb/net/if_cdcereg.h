@@ -63,10 +63,23 @@ enum {
 	CDCE_N_TRANSFER,
 };
 
+struct cdce_ncm_stats {
+	uint32_t tx_ntb;		/* NTBs sent */
+	uint32_t tx_dgram;		/* datagrams sent */
+	uint32_t tx_holdoff;		/* hold-off timer expirations */
+	uint32_t rx_ntb;		/* NTBs received */
+	uint32_t rx_ref;		/* datagrams referencing the NTB */
+	uint32_t rx_copy;		/* datagrams copied out of the NTB */
+};
+
 struct cdce_ncm {
 	struct usb_ncm16_hdr hdr;
 	struct usb_ncm16_dpt dpt;
 	struct usb_ncm16_dp dp[CDCE_NCM_SUBFRAMES_MAX];
+	struct usb_callout tx_callout;
+	struct cdce_ncm_stats stats;
+	struct mbuf *rx_m;		/* NTB receive cluster */
+	void	*rx_spare;		/* used when no cluster is available */
 	uint32_t rx_max;
 	uint32_t tx_max;
 	uint16_t tx_remainder;
@@ -74,6 +87,7 @@ struct cdce_ncm {
 	uint16_t tx_struct_align;
 	uint16_t tx_seq;
 	uint16_t tx_nframe;
+	uint8_t	tx_flush;
 };
 
 struct cdce_softc {
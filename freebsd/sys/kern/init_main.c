@@ -94,6 +94,9 @@ __FBSDID("$FreeBSD$");
 
 #include <ddb/ddb.h>
 #include <ddb/db_sym.h>
+#ifdef __rtems__
+#include <machine/rtems-bsd-bootprof.h>
+#endif /* __rtems__ */
 
 void mi_startup(void);				/* Should be elsewhere */
 
@@ -221,6 +224,7 @@ mi_startup(void)
 #ifdef __rtems__
 	struct sysinit **sysinit = NULL;
 	struct sysinit **sysinit_end = NULL;
+	sbintime_t begin;
 #endif /* __rtems__ */
 
 #if defined(VERBOSE_SYSINIT)
@@ -302,8 +306,14 @@ restart:
 		}
 #endif
 
+#ifdef __rtems__
+		begin = sbinuptime();
+#endif /* __rtems__ */
 		/* Call function */
 		(*((*sipp)->func))((*sipp)->udata);
+#ifdef __rtems__
+		rtems_bsd_bootprof_sysinit(*sipp, begin);
+#endif /* __rtems__ */
 
 #if defined(VERBOSE_SYSINIT)
 		if (verbose)
@@ -75,9 +75,16 @@ __FBSDID("$FreeBSD$");
 #include <vm/uma.h>
 #ifdef __rtems__
 #include <machine/rtems-bsd-syscall-api.h>
+#include <rtems/bsd/kevent.h>
 
 /* Maintain a global kqueue list on RTEMS */
 static struct kqlist fd_kqlist;
+
+/* Reserve table entries for the filters of RTEMS objects */
+CTASSERT(EVFILT_RTEMS_EVENT == -EVFILT_SYSCOUNT - 1);
+#undef EVFILT_SYSCOUNT
+#define	EVFILT_SYSCOUNT	RTEMS_BSD_EVFILT_SYSCOUNT
+SYSINIT_REFERENCE(kq_rtems);
 #endif /* __rtems__ */
 
 static MALLOC_DEFINE(M_KQUEUE, "kqueue", "memory for kqueue system");
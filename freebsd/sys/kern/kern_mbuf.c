@@ -54,6 +54,7 @@ __FBSDID("$FreeBSD$");
 #include <vm/uma.h>
 #include <vm/uma_dbg.h>
 #ifdef __rtems__
+#include <machine/rtems-bsd-page.h>
 #include <rtems/bsd/bsd.h>
 #endif /* __rtems__ */
 
@@ -294,6 +295,9 @@ static int	mb_zinit_pack(void *, int, int);
 static void	mb_zfini_pack(void *, int);
 static void	mb_reclaim(uma_zone_t, int);
 static void    *mbuf_jumbo_alloc(uma_zone_t, vm_size_t, uint8_t *, int);
+#ifdef __rtems__
+static void	mbuf_jumbo_free(void *, vm_size_t, uint8_t);
+#endif /* __rtems__ */
 
 /* Ensure that MSIZE is a power of 2. */
 CTASSERT((((MSIZE - 1) ^ MSIZE) + 1) >> 1 == MSIZE);
@@ -360,6 +364,9 @@ mbuf_init(void *dummy)
 #endif
 	    UMA_ALIGN_PTR, 0);
 	uma_zone_set_allocf(zone_jumbo9, mbuf_jumbo_alloc);
+#ifdef __rtems__
+	uma_zone_set_freef(zone_jumbo9, mbuf_jumbo_free);
+#endif /* __rtems__ */
 	if (nmbjumbo9 > 0)
 		nmbjumbo9 = uma_zone_set_max(zone_jumbo9, nmbjumbo9);
 	uma_zone_set_warning(zone_jumbo9, "kern.ipc.nmbjumbo9 limit reached");
@@ -374,6 +381,9 @@ mbuf_init(void *dummy)
 #endif
 	    UMA_ALIGN_PTR, 0);
 	uma_zone_set_allocf(zone_jumbo16, mbuf_jumbo_alloc);
+#ifdef __rtems__
+	uma_zone_set_freef(zone_jumbo16, mbuf_jumbo_free);
+#endif /* __rtems__ */
 	if (nmbjumbo16 > 0)
 		nmbjumbo16 = uma_zone_set_max(zone_jumbo16, nmbjumbo16);
 	uma_zone_set_warning(zone_jumbo16, "kern.ipc.nmbjumbo16 limit reached");
@@ -407,9 +417,21 @@ mbuf_jumbo_alloc(uma_zone_t zone, vm_size_t bytes, uint8_t *flags, int wait)
 	return ((void *)kmem_alloc_contig(kernel_arena, bytes, wait,
 	    (vm_paddr_t)0, ~(vm_paddr_t)0, 1, 0, VM_MEMATTR_DEFAULT));
 #else /* __rtems__ */
-	return ((void *)malloc(bytes, M_TEMP, wait));
+	return (rtems_bsd_jumbo_alloc(bytes, wait));
 #endif /* __rtems__ */
 }
+#ifdef __rtems__
+
+/*
+ * UMA backend page free function for the jumbo frame zones.
+ */
+static void
+mbuf_jumbo_free(void *mem, vm_size_t bytes, uint8_t flags)
+{
+
+	rtems_bsd_jumbo_free(mem);
+}
+#endif /* __rtems__ */
 
 /*
  * Constructor for Mbuf master zone.
@@ -69,6 +69,9 @@ __FBSDID("$FreeBSD$");
 #include <vm/vm.h>
 
 #include <ddb/ddb.h>
+#ifdef __rtems__
+#include <machine/rtems-bsd-bootprof.h>
+#endif /* __rtems__ */
 
 SYSCTL_NODE(_hw, OID_AUTO, bus, CTLFLAG_RW, NULL, NULL);
 SYSCTL_ROOT_NODE(OID_AUTO, dev, CTLFLAG_RW, NULL, NULL);
@@ -2929,6 +2932,9 @@ device_attach(device_t dev)
 {
 	uint64_t attachtime;
 	int error;
+#ifdef __rtems__
+	sbintime_t begin;
+#endif /* __rtems__ */
 
 #ifndef __rtems__
 	if (resource_disabled(dev->driver->name, dev->unit)) {
@@ -2944,7 +2950,14 @@ device_attach(device_t dev)
 		device_print_child(dev->parent, dev);
 	attachtime = get_cyclecount();
 	dev->state = DS_ATTACHING;
+#ifndef __rtems__
 	if ((error = DEVICE_ATTACH(dev)) != 0) {
+#else /* __rtems__ */
+	begin = sbinuptime();
+	error = DEVICE_ATTACH(dev);
+	rtems_bsd_bootprof_attach(dev, begin, error);
+	if (error != 0) {
+#endif /* __rtems__ */
 		printf("device_attach: %s%d attach returned %d\n",
 		    dev->driver->name, dev->unit, error);
 		if (!(dev->flags & DF_FIXEDCLASS))
@@ -70,6 +70,8 @@ struct lock_class *lock_classes[LOCK_CLASS_MAX + 1] = {
 #ifndef __rtems__
 	&lock_class_rm,
 	&lock_class_rm_sleepable,
+#else /* __rtems__ */
+	&lock_class_rm,
 #endif /* __rtems__ */
 	&lock_class_rw,
 #ifndef __rtems__
@@ -176,7 +176,6 @@ struct fileops pipeops = {
 	.fo_flags = DFLAG_PASSABLE
 };
 #else /* __rtems__ */
-#define PIPE_NODIRECT
 #define	PRIBIO			(0)
 
 static int rtems_bsd_pipe_open(rtems_libio_t *iop, const char *path, int oflag, mode_t mode);
@@ -205,7 +204,7 @@ static const rtems_filesystem_file_handlers_r pipeops = {
 	.kqfilter_h = rtems_bsd_pipe_kqfilter
 };
 
-long	maxpipekva;			/* Limit on pipe KVA */
+long	maxpipekva = 64 * BIG_PIPE_SIZE;	/* Limit on pipe KVA */
 
 #endif /* __rtems__ */
 
@@ -258,6 +257,11 @@ SYSCTL_INT(_kern_ipc, OID_AUTO, piperesizefail, CTLFLAG_RD,
 	  &piperesizefail, 0, "Pipe resize failures");
 SYSCTL_INT(_kern_ipc, OID_AUTO, piperesizeallowed, CTLFLAG_RW,
 	  &piperesizeallowed, 0, "Pipe resizing allowed");
+#ifdef __rtems__
+static int pipedirectallowed = 1;
+SYSCTL_INT(_kern_ipc, OID_AUTO, pipedirectallowed, CTLFLAG_RW,
+	  &pipedirectallowed, 0, "Pipe direct writes allowed");
+#endif /* __rtems__ */
 
 static void pipeinit(void *dummy __unused);
 static void pipeclose(struct pipe *cpipe);
@@ -274,6 +278,9 @@ static void pipe_clone_write_buffer(struct pipe *wpipe);
 #endif
 static int pipespace(struct pipe *cpipe, int size);
 static int pipespace_new(struct pipe *cpipe, int size);
+#ifdef __rtems__
+static int pipe_grow(struct pipe *wpipe);
+#endif /* __rtems__ */
 
 static int	pipe_zone_ctor(void *mem, int size, void *arg, int flags);
 static int	pipe_zone_init(void *mem, int size, int flags);
@@ -637,6 +644,33 @@ pipespace(cpipe, size)
 		("Unlocked pipe passed to pipespace"));
 	return (pipespace_new(cpipe, size));
 }
+#ifdef __rtems__
+
+/*
+ * Double the buffer of a pipe which is full, up to BIG_PIPE_SIZE.  This lets
+ * a pipe with a steady stream of data settle at a buffer size which avoids
+ * a context switch for each buffer refill, while idle pipes keep the small
+ * default buffer.
+ */
+static int
+pipe_grow(struct pipe *wpipe)
+{
+	int error;
+	int size;
+
+	PIPE_LOCK_ASSERT(wpipe, MA_OWNED);
+	size = wpipe->pipe_buffer.size;
+	if (piperesizeallowed != 1 || size >= BIG_PIPE_SIZE ||
+	    amountpipekva > maxpipekva / 2 ||
+	    (wpipe->pipe_state & PIPE_DIRECTW) != 0)
+		return (0);
+
+	PIPE_UNLOCK(wpipe);
+	error = pipespace(wpipe, min(2 * size, BIG_PIPE_SIZE));
+	PIPE_LOCK(wpipe);
+	return (error == 0);
+}
+#endif /* __rtems__ */
 
 /*
  * lock a pipe for I/O, blocking other access
@@ -806,8 +840,13 @@ pipe_read(fp, uio, active_cred, flags, td)
 				size = (u_int) uio->uio_resid;
 
 			PIPE_UNLOCK(rpipe);
+#ifndef __rtems__
 			error = uiomove_fromphys(rpipe->pipe_map.ms,
 			    rpipe->pipe_map.pos, size, uio);
+#else /* __rtems__ */
+			error = uiomove(__DECONST(char *, rpipe->pipe_map.kva) +
+			    rpipe->pipe_map.pos, size, uio);
+#endif /* __rtems__ */
 			PIPE_LOCK(rpipe);
 			if (error)
 				break;
@@ -963,17 +1002,27 @@ pipe_build_write_buffer(wpipe, uio)
 	else
                 size = uio->uio_iov->iov_len;
 
+#ifndef __rtems__
 	if ((i = vm_fault_quick_hold_pages(&curproc->p_vmspace->vm_map,
 	    (vm_offset_t)uio->uio_iov->iov_base, size, VM_PROT_READ,
 	    wpipe->pipe_map.ms, PIPENPAGES)) < 0)
 		return (EFAULT);
+#else /* __rtems__ */
+	i = 0;
+#endif /* __rtems__ */
 
 /*
  * set up the control block
  */
 	wpipe->pipe_map.npages = i;
+#ifndef __rtems__
 	wpipe->pipe_map.pos =
 	    ((vm_offset_t) uio->uio_iov->iov_base) & PAGE_MASK;
+#else /* __rtems__ */
+	/* Single address space, the reader copies from the writer buffer */
+	wpipe->pipe_map.kva = uio->uio_iov->iov_base;
+	wpipe->pipe_map.pos = 0;
+#endif /* __rtems__ */
 	wpipe->pipe_map.cnt = size;
 
 /*
@@ -998,7 +1047,11 @@ pipe_destroy_write_buffer(wpipe)
 {
 
 	PIPE_LOCK_ASSERT(wpipe, MA_OWNED);
+#ifndef __rtems__
 	vm_page_unhold_pages(wpipe->pipe_map.ms, wpipe->pipe_map.npages);
+#else /* __rtems__ */
+	wpipe->pipe_map.kva = NULL;
+#endif /* __rtems__ */
 	wpipe->pipe_map.npages = 0;
 }
 
@@ -1035,7 +1088,11 @@ pipe_clone_write_buffer(wpipe)
 	uio.uio_segflg = UIO_SYSSPACE;
 	uio.uio_rw = UIO_READ;
 	uio.uio_td = curthread;
+#ifndef __rtems__
 	uiomove_fromphys(wpipe->pipe_map.ms, pos, size, &uio);
+#else /* __rtems__ */
+	uiomove(__DECONST(char *, wpipe->pipe_map.kva) + pos, size, &uio);
+#endif /* __rtems__ */
 	PIPE_LOCK(wpipe);
 	pipe_destroy_write_buffer(wpipe);
 }
@@ -1252,7 +1309,12 @@ pipe_write(fp, uio, active_cred, flags, td)
 		if (uio->uio_segflg == UIO_USERSPACE &&
 		    uio->uio_iov->iov_len >= PIPE_MINDIRECT &&
 		    wpipe->pipe_buffer.size >= PIPE_MINDIRECT &&
+#ifndef __rtems__
 		    (fp->f_flag & FNONBLOCK) == 0) {
+#else /* __rtems__ */
+		    (rtems_bsd_libio_flags_to_fflag(fp->f_io.flags) &
+		    FNONBLOCK) == 0 && pipedirectallowed == 1) {
+#endif /* __rtems__ */
 			pipeunlock(wpipe);
 			error = pipe_direct_write(wpipe, uio);
 			if (error)
@@ -1357,6 +1419,13 @@ pipe_write(fp, uio, active_cred, flags, td)
 			if (error != 0)
 				break;
 		} else {
+#ifdef __rtems__
+			if (pipe_grow(wpipe)) {
+				pipeunlock(wpipe);
+				continue;
+			}
+
+#endif /* __rtems__ */
 			/*
 			 * If the "read-side" has been blocked, wake it up now.
 			 */
@@ -264,9 +264,28 @@ sbwait(struct sockbuf *sb)
 	SOCKBUF_LOCK_ASSERT(sb);
 
 	sb->sb_flags |= SB_WAIT;
+#ifndef __rtems__
 	return (msleep_sbt(&sb->sb_acc, &sb->sb_mtx,
 	    (sb->sb_flags & SB_NOINTR) ? PSOCK : PSOCK | PCATCH, "sbwait",
 	    sb->sb_timeo, 0, 0));
+#else /* __rtems__ */
+	{
+		int error;
+
+		/*
+		 * Unlike SB_WAIT, which only sowakeup() clears, SB_SLEEPING
+		 * is set exactly while the caller sleeps.  The caller owns
+		 * the mbufs of the socket buffer only while it does not
+		 * sleep, see unp_direct_unlend().
+		 */
+		sb->sb_flags |= SB_SLEEPING;
+		error = msleep_sbt(&sb->sb_acc, &sb->sb_mtx,
+		    (sb->sb_flags & SB_NOINTR) ? PSOCK : PSOCK | PCATCH,
+		    "sbwait", sb->sb_timeo, 0, 0);
+		sb->sb_flags &= ~SB_SLEEPING;
+		return (error);
+	}
+#endif /* __rtems__ */
 }
 
 int
@@ -3376,6 +3376,11 @@ filt_soread(struct knote *kn, long hint)
 			return (1);
 	} else if (sbavail(&so->so_rcv) >= so->so_rcv.sb_lowat)
 		return (1);
+#ifdef __rtems__
+	else if ((so->so_rcv.sb_state & SBS_LOWATEXPIRED) != 0 &&
+	    sbavail(&so->so_rcv) != 0)
+		return (1);
+#endif /* __rtems__ */
 
 	/* This hook returning non-zero indicates an event, not error */
 	return (hhook_run_socket(so, NULL, HHOOK_FILT_SOREAD));
@@ -191,6 +191,11 @@ SYSCTL_ULONG(_net_local_seqpacket, OID_AUTO, maxseqpacket, CTLFLAG_RW,
 	   &unpsp_sendspace, 0, "Default seqpacket send space.");
 SYSCTL_ULONG(_net_local_seqpacket, OID_AUTO, recvspace, CTLFLAG_RW,
 	   &unpsp_recvspace, 0, "Default seqpacket receive space.");
+#ifdef __rtems__
+static int	unpst_direct = 1;
+SYSCTL_INT(_net_local_stream, OID_AUTO, direct, CTLFLAG_RW,
+	   &unpst_direct, 0, "Lend the buffer of blocking senders to the peer.");
+#endif /* __rtems__ */
 #ifndef __rtems__
 SYSCTL_INT(_net_local, OID_AUTO, inflight, CTLFLAG_RD, &unp_rights, 0,
     "File descriptors in flight.");
@@ -1026,9 +1031,27 @@ uipc_send(struct socket *so, int flags, struct mbuf *m, struct sockaddr *nam,
 			from = &sun_noname;
 		so2 = unp2->unp_socket;
 		SOCKBUF_LOCK(&so2->so_rcv);
+#ifdef __rtems__
+		sbcc = sbavail(&so2->so_rcv);
+#endif /* __rtems__ */
 		if (sbappendaddr_locked(&so2->so_rcv, from, m,
 		    control)) {
+#ifndef __rtems__
 			sorwakeup_locked(so2);
+#else /* __rtems__ */
+			/*
+			 * Blocked readers and selecting threads were already
+			 * woken up by the datagrams which are still queued.
+			 * Coalesce the wakeups for them, a burst of datagrams
+			 * then costs one wakeup instead of one per datagram.
+			 * Knotes and upcalls expect an event for each one.
+			 */
+			if (sbcc == 0 || (so2->so_rcv.sb_flags &
+			    (SB_ASYNC | SB_UPCALL | SB_AIO | SB_KNOTE)) != 0)
+				sorwakeup_locked(so2);
+			else
+				SOCKBUF_UNLOCK(&so2->so_rcv);
+#endif /* __rtems__ */
 			m = NULL;
 			control = NULL;
 		} else {
@@ -1179,6 +1202,295 @@ release:
 		m_freem(m);
 	return (error);
 }
+#ifdef __rtems__
+
+/*
+ * A blocking stream sender copies data into mbuf clusters as long as it fits
+ * into the receive buffer of the peer.  Once the sender would block, it lends
+ * the part of its buffer which fits into the receive buffer as read-only
+ * external storage and waits for space like any other sender.  The receiver
+ * copies the lent data directly out of the sender buffer, which saves the
+ * copy into mbuf clusters.  Before the sender returns, data still lent is
+ * copied into mbuf clusters, so the send semantics are the same as for the
+ * generic path.
+ */
+#define	UNP_DIRECT_MIN	MCLBYTES
+
+struct unp_direct {
+	u_int	ud_refs;	/* (so_snd) Lent buffers referenced by the peer */
+};
+
+static void
+unp_direct_free(struct mbuf *m, void *arg1, void *arg2)
+{
+	struct unp_direct *ud;
+	struct socket *so;
+
+	ud = arg1;
+	so = arg2;
+	SOCKBUF_LOCK(&so->so_snd);
+	if (--ud->ud_refs == 0)
+		wakeup(ud);
+	SOCKBUF_UNLOCK(&so->so_snd);
+}
+
+/*
+ * Return the space left in the receive buffer of the peer.  If there is
+ * none, stop the sender in the same way as uipc_send() does.
+ */
+static long
+unp_direct_space(struct socket *so)
+{
+	struct unpcb *unp, *unp2;
+	struct socket *so2;
+	u_int mbcnt, sbcc;
+	long space;
+
+	unp = sotounpcb(so);
+	space = 0;
+	UNP_LINK_RLOCK();
+	unp2 = unp->unp_conn;
+	if (unp2 != NULL) {
+		so2 = unp2->unp_socket;
+		UNP_PCB_LOCK(unp2);
+		SOCKBUF_LOCK(&so2->so_rcv);
+		mbcnt = so2->so_rcv.sb_mbcnt;
+		sbcc = sbavail(&so2->so_rcv);
+		SOCKBUF_UNLOCK(&so2->so_rcv);
+		SOCKBUF_LOCK(&so->so_snd);
+		if (sbcc >= so->so_snd.sb_hiwat ||
+		    mbcnt >= so->so_snd.sb_mbmax)
+			so->so_snd.sb_flags |= SB_STOP;
+		else
+			space = min(so->so_snd.sb_hiwat - sbcc,
+			    so->so_snd.sb_mbmax - mbcnt);
+		SOCKBUF_UNLOCK(&so->so_snd);
+		UNP_PCB_UNLOCK(unp2);
+	}
+	UNP_LINK_RUNLOCK();
+	return (space);
+}
+
+/*
+ * Replace the lent buffers in the socket buffer by copies in mbuf clusters.
+ */
+static int
+unp_direct_copy(struct sockbuf *sb, struct unp_direct *ud)
+{
+	struct mbuf **rp, **mp, *m, *n, *top, *last;
+	int len, off;
+
+	SOCKBUF_LOCK_ASSERT(sb);
+
+	for (rp = &sb->sb_mb; *rp != NULL; rp = &(*rp)->m_nextpkt) {
+		mp = rp;
+		while ((m = *mp) != NULL) {
+			if ((m->m_flags & M_EXT) == 0 ||
+			    m->m_ext.ext_free != unp_direct_free ||
+			    m->m_ext.ext_arg1 != ud) {
+				mp = &m->m_next;
+				continue;
+			}
+
+			top = NULL;
+			last = NULL;
+			off = 0;
+			do {
+				n = m_getcl(M_NOWAIT, m->m_type, 0);
+				if (n == NULL) {
+					m_freem(top);
+					return (ENOBUFS);
+				}
+				len = min(m->m_len - off, MCLBYTES);
+				bcopy(mtod(m, char *) + off, mtod(n, char *),
+				    len);
+				n->m_len = len;
+				if (top == NULL)
+					top = n;
+				else
+					last->m_next = n;
+				last = n;
+				off += len;
+			} while (off < m->m_len);
+
+			last->m_next = m->m_next;
+			top->m_nextpkt = m->m_nextpkt;
+			*mp = top;
+			if (sb->sb_lastrecord == m)
+				sb->sb_lastrecord = top;
+			if (sb->sb_mbtail == m)
+				sb->sb_mbtail = last;
+			for (n = top; n != last->m_next; n = n->m_next)
+				sballoc(sb, n);
+			sbfree(sb, m);
+			m->m_next = NULL;
+			m->m_nextpkt = NULL;
+			m_free(m);
+			mp = &last->m_next;
+		}
+	}
+
+	return (0);
+}
+
+/*
+ * Make sure the peer references no lent buffer.  The receiver copies data out
+ * of the receive buffer with the sblock held but without the socket buffer
+ * lock, so the lent buffers may be replaced only while we hold the sblock or
+ * while its owner sleeps in sbwait().  SB_WAIT is no indication for this,
+ * since it stays set after an sbwait() timeout or signal, so sbwait() marks
+ * the sleep itself with SB_SLEEPING.  All receive functions look at the
+ * socket buffer again after sbwait() returns.
+ */
+static void
+unp_direct_unlend(struct socket *so, struct unp_direct *ud)
+{
+	struct unpcb *unp, *unp2;
+	struct socket *so2;
+	int error, locked;
+
+	unp = sotounpcb(so);
+
+	for (;;) {
+		SOCKBUF_LOCK(&so->so_snd);
+		if (ud->ud_refs == 0) {
+			SOCKBUF_UNLOCK(&so->so_snd);
+			return;
+		}
+		SOCKBUF_UNLOCK(&so->so_snd);
+
+		error = 0;
+		UNP_LINK_RLOCK();
+		unp2 = unp->unp_conn;
+		if (unp2 != NULL) {
+			so2 = unp2->unp_socket;
+			locked = sblock(&so2->so_rcv, 0) == 0;
+			UNP_PCB_LOCK(unp2);
+			SOCKBUF_LOCK(&so2->so_rcv);
+			if (locked ||
+			    (so2->so_rcv.sb_flags & SB_SLEEPING) != 0)
+				error = unp_direct_copy(&so2->so_rcv, ud);
+			else
+				error = EBUSY;
+			SOCKBUF_UNLOCK(&so2->so_rcv);
+			UNP_PCB_UNLOCK(unp2);
+			if (locked)
+				sbunlock(&so2->so_rcv);
+		}
+		UNP_LINK_RUNLOCK();
+
+		if (error == 0)
+			break;
+
+		pause("unpdir", 1);
+	}
+
+	/*
+	 * Lent buffers not found in the receive buffer are about to be freed,
+	 * for example by a flush of the disconnected peer.
+	 */
+	SOCKBUF_LOCK(&so->so_snd);
+	while (ud->ud_refs != 0)
+		msleep(ud, SOCKBUF_MTX(&so->so_snd), PSOCK, "unpdir", 0);
+	SOCKBUF_UNLOCK(&so->so_snd);
+}
+
+static int
+uipc_sosend_stream(struct socket *so, struct sockaddr *addr, struct uio *uio,
+    struct mbuf *top, struct mbuf *control, int flags, struct thread *td)
+{
+	struct unp_direct ud;
+	struct mbuf *m;
+	long space;
+	int error;
+
+	if (unpst_direct != 1 || uio == NULL || top != NULL ||
+	    control != NULL || addr != NULL ||
+	    uio->uio_segflg != UIO_USERSPACE || uio->uio_iovcnt != 1 ||
+	    uio->uio_resid < UNP_DIRECT_MIN ||
+	    (flags & (MSG_OOB | MSG_EOR | MSG_EOF | MSG_DONTWAIT |
+	    MSG_NBIO)) != 0 || (so->so_state & SS_NBIO) != 0)
+		return (sosend_generic(so, addr, uio, top, control, flags,
+		    td));
+
+	error = sblock(&so->so_snd, SBL_WAIT);
+	if (error != 0)
+		return (error);
+
+	ud.ud_refs = 0;
+
+	while (uio->uio_resid > 0) {
+		SOCKBUF_LOCK(&so->so_snd);
+		if (so->so_snd.sb_state & SBS_CANTSENDMORE) {
+			SOCKBUF_UNLOCK(&so->so_snd);
+			error = EPIPE;
+			break;
+		}
+		if (so->so_error) {
+			error = so->so_error;
+			so->so_error = 0;
+			SOCKBUF_UNLOCK(&so->so_snd);
+			break;
+		}
+		if ((so->so_state & SS_ISCONNECTED) == 0) {
+			SOCKBUF_UNLOCK(&so->so_snd);
+			error = ENOTCONN;
+			break;
+		}
+		space = sbspace(&so->so_snd);
+		if (space < uio->uio_resid && space < so->so_snd.sb_lowat) {
+			error = sbwait(&so->so_snd);
+			SOCKBUF_UNLOCK(&so->so_snd);
+			if (error != 0)
+				break;
+			continue;
+		}
+		SOCKBUF_UNLOCK(&so->so_snd);
+
+		space = unp_direct_space(so);
+		if (space == 0)
+			continue;
+
+		if (space >= uio->uio_resid || space < UNP_DIRECT_MIN) {
+			/* The sender would not block for this part. */
+			m = m_uiotombuf(uio, M_WAITOK, MIN(space,
+			    uio->uio_resid), 0, 0);
+			if (m == NULL) {
+				error = EFAULT;
+				break;
+			}
+		} else {
+			/*
+			 * The sender blocks after this part anyway, so lend
+			 * it to the peer.
+			 */
+			SOCKBUF_LOCK(&so->so_snd);
+			++ud.ud_refs;
+			SOCKBUF_UNLOCK(&so->so_snd);
+
+			m = m_get(M_WAITOK, MT_DATA);
+			m_extadd(m, uio->uio_iov->iov_base, space,
+			    unp_direct_free, &ud, so, M_RDONLY, EXT_MOD_TYPE);
+			m->m_len = space;
+
+			uio->uio_iov->iov_base =
+			    (char *)uio->uio_iov->iov_base + space;
+			uio->uio_iov->iov_len -= space;
+			uio->uio_resid -= space;
+			uio->uio_offset += space;
+		}
+
+		error = (*so->so_proto->pr_usrreqs->pru_send)(so, 0, m, NULL,
+		    NULL, td);
+		if (error != 0)
+			break;
+	}
+
+	unp_direct_unlend(so, &ud);
+	sbunlock(&so->so_snd);
+	return (error);
+}
+#endif /* __rtems__ */
 
 static int
 uipc_ready(struct socket *so, struct mbuf *m, int count)
@@ -1324,6 +1636,9 @@ static struct pr_usrreqs uipc_usrreqs_stream = {
 	.pru_sense =		uipc_sense,
 	.pru_shutdown =		uipc_shutdown,
 	.pru_sockaddr =		uipc_sockaddr,
+#ifdef __rtems__
+	.pru_sosend =		uipc_sosend_stream,
+#endif /* __rtems__ */
 	.pru_soreceive =	soreceive_generic,
 	.pru_close =		uipc_close,
 };
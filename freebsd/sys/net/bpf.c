@@ -201,9 +201,12 @@ SYSCTL_INT(_net_bpf, OID_AUTO, maxinsns, CTLFLAG_RW,
     &bpf_maxinsns, 0, "Maximum bpf program instructions");
 #ifndef __rtems__
 static int bpf_zerocopy_enable = 0;
+#else /* __rtems__ */
+/* The zero-copy buffers need no virtual memory mappings on RTEMS */
+static int bpf_zerocopy_enable = 1;
+#endif /* __rtems__ */
 SYSCTL_INT(_net_bpf, OID_AUTO, zerocopy_enable, CTLFLAG_RW,
     &bpf_zerocopy_enable, 0, "Enable new zero-copy BPF buffer sessions");
-#endif /* __rtems__ */
 static SYSCTL_NODE(_net_bpf, OID_AUTO, stats, CTLFLAG_MPSAFE | CTLFLAG_RW,
     bpf_stats_sysctl, "bpf statistics portal");
 
@@ -286,11 +289,9 @@ bpf_append_bytes(struct bpf_d *d, caddr_t buf, u_int offset, void *src,
 	case BPF_BUFMODE_BUFFER:
 		return (bpf_buffer_append_bytes(d, buf, offset, src, len));
 
-#ifndef __rtems__
 	case BPF_BUFMODE_ZBUF:
 		d->bd_zcopy++;
 		return (bpf_zerocopy_append_bytes(d, buf, offset, src, len));
-#endif /* __rtems__ */
 
 	default:
 		panic("bpf_buf_append_bytes");
@@ -308,11 +309,9 @@ bpf_append_mbuf(struct bpf_d *d, caddr_t buf, u_int offset, void *src,
 	case BPF_BUFMODE_BUFFER:
 		return (bpf_buffer_append_mbuf(d, buf, offset, src, len));
 
-#ifndef __rtems__
 	case BPF_BUFMODE_ZBUF:
 		d->bd_zcopy++;
 		return (bpf_zerocopy_append_mbuf(d, buf, offset, src, len));
-#endif /* __rtems__ */
 
 	default:
 		panic("bpf_buf_append_mbuf");
@@ -332,11 +331,9 @@ bpf_buf_reclaimed(struct bpf_d *d)
 	case BPF_BUFMODE_BUFFER:
 		return;
 
-#ifndef __rtems__
 	case BPF_BUFMODE_ZBUF:
 		bpf_zerocopy_buf_reclaimed(d);
 		return;
-#endif /* __rtems__ */
 
 	default:
 		panic("bpf_buf_reclaimed");
@@ -354,12 +351,10 @@ bpf_canfreebuf(struct bpf_d *d)
 
 	BPFD_LOCK_ASSERT(d);
 
-#ifndef __rtems__
 	switch (d->bd_bufmode) {
 	case BPF_BUFMODE_ZBUF:
 		return (bpf_zerocopy_canfreebuf(d));
 	}
-#endif /* __rtems__ */
 	return (0);
 }
 
@@ -373,12 +368,10 @@ bpf_canwritebuf(struct bpf_d *d)
 {
 	BPFD_LOCK_ASSERT(d);
 
-#ifndef __rtems__
 	switch (d->bd_bufmode) {
 	case BPF_BUFMODE_ZBUF:
 		return (bpf_zerocopy_canwritebuf(d));
 	}
-#endif /* __rtems__ */
 	return (1);
 }
 
@@ -393,13 +386,11 @@ bpf_buffull(struct bpf_d *d)
 
 	BPFD_LOCK_ASSERT(d);
 
-#ifndef __rtems__
 	switch (d->bd_bufmode) {
 	case BPF_BUFMODE_ZBUF:
 		bpf_zerocopy_buffull(d);
 		break;
 	}
-#endif /* __rtems__ */
 }
 
 /*
@@ -411,13 +402,11 @@ bpf_bufheld(struct bpf_d *d)
 
 	BPFD_LOCK_ASSERT(d);
 
-#ifndef __rtems__
 	switch (d->bd_bufmode) {
 	case BPF_BUFMODE_ZBUF:
 		bpf_zerocopy_bufheld(d);
 		break;
 	}
-#endif /* __rtems__ */
 }
 
 static void
@@ -428,10 +417,8 @@ bpf_free(struct bpf_d *d)
 	case BPF_BUFMODE_BUFFER:
 		return (bpf_buffer_free(d));
 
-#ifndef __rtems__
 	case BPF_BUFMODE_ZBUF:
 		return (bpf_zerocopy_free(d));
-#endif /* __rtems__ */
 
 	default:
 		panic("bpf_buf_free");
@@ -460,39 +447,27 @@ static int
 bpf_ioctl_getzmax(struct thread *td, struct bpf_d *d, size_t *i)
 {
 
-#ifndef __rtems__
 	if (d->bd_bufmode != BPF_BUFMODE_ZBUF)
 		return (EOPNOTSUPP);
 	return (bpf_zerocopy_ioctl_getzmax(td, d, i));
-#else /* __rtems__ */
-	return (EOPNOTSUPP);
-#endif /* __rtems__ */
 }
 
 static int
 bpf_ioctl_rotzbuf(struct thread *td, struct bpf_d *d, struct bpf_zbuf *bz)
 {
 
-#ifndef __rtems__
 	if (d->bd_bufmode != BPF_BUFMODE_ZBUF)
 		return (EOPNOTSUPP);
 	return (bpf_zerocopy_ioctl_rotzbuf(td, d, bz));
-#else /* __rtems__ */
-	return (EOPNOTSUPP);
-#endif /* __rtems__ */
 }
 
 static int
 bpf_ioctl_setzbuf(struct thread *td, struct bpf_d *d, struct bpf_zbuf *bz)
 {
 
-#ifndef __rtems__
 	if (d->bd_bufmode != BPF_BUFMODE_ZBUF)
 		return (EOPNOTSUPP);
 	return (bpf_zerocopy_ioctl_setzbuf(td, d, bz));
-#else /* __rtems__ */
-	return (EOPNOTSUPP);
-#endif /* __rtems__ */
 }
 
 /*
@@ -1845,12 +1820,10 @@ bpfioctl(struct bpf_d *d, u_long cmd, caddr_t addr, int flags,
 		case BPF_BUFMODE_BUFFER:
 			break;
 
-#ifndef __rtems__
 		case BPF_BUFMODE_ZBUF:
 			if (bpf_zerocopy_enable)
 				break;
 			/* FALLSTHROUGH */
-#endif /* __rtems__ */
 
 		default:
 			CURVNET_RESTORE();
@@ -2036,9 +2009,7 @@ bpf_setif(struct bpf_d *d, struct ifreq *ifr)
 	 */
 	switch (d->bd_bufmode) {
 	case BPF_BUFMODE_BUFFER:
-#ifndef __rtems__
 	case BPF_BUFMODE_ZBUF:
-#endif /* __rtems__ */
 		if (d->bd_sbuf == NULL)
 			return (EINVAL);
 		break;
@@ -405,6 +405,13 @@ extern	char *ether_sprintf(const u_int8_t *);
 void	ether_vlan_mtap(struct bpf_if *, struct mbuf *,
 	    void *, u_int);
 struct mbuf  *ether_vlanencap(struct mbuf *, uint16_t);
+#ifdef __rtems__
+
+/* Maximum length of a TCP super-segment for software TSO */
+#define	ETHER_GSO_MAX	(32 * 1024)
+
+int	ether_gso_output(struct ifnet *, struct mbuf *);
+#endif /* __rtems__ */
 
 #else /* _KERNEL */
 
@@ -51,6 +51,23 @@ struct flowtable_stat {
  */
 int flowtable_lookup(sa_family_t, struct mbuf *, struct route *);
 void flowtable_route_flush(sa_family_t, struct rtentry *);
+#ifdef __rtems__
+
+struct in_addr;
+struct nhop4_basic;
+
+/*
+ * Per-processor IPv4 forwarding cache used by ip_tryforward().  Entries
+ * are keyed by (fib, destination) and hold the next hop together with a
+ * copy of the link-level header.  They are invalidated by the routing
+ * table and lltable generation counters returned by flowtable_gen().
+ */
+uint64_t flowtable_gen(sa_family_t, uint32_t);
+int flowtable_lookup_nh4(uint32_t, struct in_addr, struct nhop4_basic *,
+    char *, size_t *);
+void flowtable_insert_nh4(uint32_t, struct in_addr,
+    const struct nhop4_basic *, uint64_t);
+#endif /* __rtems__ */
 
 #endif /* _KERNEL */
 #endif /* !_NET_FLOWTABLE_H_ */
@@ -226,6 +226,18 @@ struct rwlock ifnet_rwlock;
 RW_SYSINIT_FLAGS(ifnet_rw, &ifnet_rwlock, "ifnet_rw", RW_RECURSE);
 struct sx ifnet_sxlock;
 SX_SYSINIT_FLAGS(ifnet_sx, &ifnet_sxlock, "ifnet_sx", SX_RECURSE);
+#ifdef __rtems__
+
+epoch_t net_epoch_preempt;
+
+static void
+net_epoch_init(void *arg)
+{
+
+	net_epoch_preempt = epoch_alloc(EPOCH_PREEMPT);
+}
+SYSINIT(net_epoch, SI_SUB_INIT_IF, SI_ORDER_FIRST, net_epoch_init, NULL);
+#endif /* __rtems__ */
 
 /*
  * The allocation of network interfaces is a rather non-atomic affair; we
@@ -252,14 +264,43 @@ ifnet_byindex_locked(u_short idx)
 	return (V_ifindex_table[idx]);
 }
 
+#ifdef __rtems__
+/*
+ * The index table is replaced by if_grow() before V_if_index grows beyond
+ * the old table and the old table is freed after a network epoch wait.
+ */
+static struct ifnet *
+ifnet_byindex_epoch(u_short idx)
+{
+	struct ifnet *ifp;
+
+	if (idx > V_if_index)
+		return (NULL);
+	atomic_thread_fence_acq();
+	ifp = V_ifindex_table[idx];
+	if (ifp == IFNET_HOLD)
+		return (NULL);
+	return (ifp);
+}
+#endif /* __rtems__ */
+
 struct ifnet *
 ifnet_byindex(u_short idx)
 {
 	struct ifnet *ifp;
+#ifdef __rtems__
+	struct epoch_tracker et;
+#endif /* __rtems__ */
 
+#ifndef __rtems__
 	IFNET_RLOCK_NOSLEEP();
 	ifp = ifnet_byindex_locked(idx);
 	IFNET_RUNLOCK_NOSLEEP();
+#else /* __rtems__ */
+	NET_EPOCH_ENTER(et);
+	ifp = ifnet_byindex_epoch(idx);
+	NET_EPOCH_EXIT(et);
+#endif /* __rtems__ */
 	return (ifp);
 }
 
@@ -267,7 +308,11 @@ struct ifnet *
 ifnet_byindex_ref(u_short idx)
 {
 	struct ifnet *ifp;
+#ifdef __rtems__
+	struct epoch_tracker et;
+#endif /* __rtems__ */
 
+#ifndef __rtems__
 	IFNET_RLOCK_NOSLEEP();
 	ifp = ifnet_byindex_locked(idx);
 	if (ifp == NULL || (ifp->if_flags & IFF_DYING)) {
@@ -276,6 +321,14 @@ ifnet_byindex_ref(u_short idx)
 	}
 	if_ref(ifp);
 	IFNET_RUNLOCK_NOSLEEP();
+#else /* __rtems__ */
+	NET_EPOCH_ENTER(et);
+	ifp = ifnet_byindex_epoch(idx);
+	if (ifp == NULL || (ifp->if_flags & IFF_DYING) ||
+	    !refcount_acquire_if_not_zero(&ifp->if_refcount))
+		ifp = NULL;
+	NET_EPOCH_EXIT(et);
+#endif /* __rtems__ */
 	return (ifp);
 }
 
@@ -419,6 +472,9 @@ if_grow(void)
 	int oldlim;
 	u_int n;
 	struct ifnet **e;
+#ifdef __rtems__
+	struct ifnet **old;
+#endif /* __rtems__ */
 
 	IFNET_WLOCK_ASSERT();
 	oldlim = V_if_indexlim;
@@ -430,12 +486,28 @@ if_grow(void)
 		free(e, M_IFNET);
 		return;
 	}
+#ifndef __rtems__
 	if (V_ifindex_table != NULL) {
 		memcpy((caddr_t)e, (caddr_t)V_ifindex_table, n/2);
 		free((caddr_t)V_ifindex_table, M_IFNET);
 	}
 	V_if_indexlim <<= 1;
 	V_ifindex_table = e;
+#else /* __rtems__ */
+	old = V_ifindex_table;
+	if (old != NULL)
+		memcpy((caddr_t)e, (caddr_t)old, n/2);
+	atomic_thread_fence_rel();
+	V_ifindex_table = e;
+	V_if_indexlim <<= 1;
+	if (old != NULL) {
+		/* Lockless readers may still use the old table */
+		IFNET_WUNLOCK();
+		NET_EPOCH_WAIT();
+		free(old, M_IFNET);
+		IFNET_WLOCK();
+	}
+#endif /* __rtems__ */
 }
 
 /*
@@ -519,6 +591,23 @@ if_free_internal(struct ifnet *ifp)
 
 	free(ifp, M_IFNET);
 }
+#ifdef __rtems__
+
+static void
+if_free_epoch(epoch_context_t ctx)
+{
+
+	if_free_internal(__containerof(ctx, struct ifnet, if_epoch_ctx));
+}
+
+/* Free the interface after lockless readers left the network epoch */
+static void
+if_free_deferred(struct ifnet *ifp)
+{
+
+	epoch_call(net_epoch_preempt, &ifp->if_epoch_ctx, if_free_epoch);
+}
+#endif /* __rtems__ */
 
 /*
  * Deregister an interface and free the associated storage.
@@ -538,7 +627,11 @@ if_free(struct ifnet *ifp)
 	IFNET_WUNLOCK();
 
 	if (refcount_release(&ifp->if_refcount))
+#ifndef __rtems__
 		if_free_internal(ifp);
+#else /* __rtems__ */
+		if_free_deferred(ifp);
+#endif /* __rtems__ */
 	CURVNET_RESTORE();
 }
 
@@ -561,7 +654,11 @@ if_rele(struct ifnet *ifp)
 
 	if (!refcount_release(&ifp->if_refcount))
 		return;
+#ifndef __rtems__
 	if_free_internal(ifp);
+#else /* __rtems__ */
+	if_free_deferred(ifp);
+#endif /* __rtems__ */
 }
 
 void
@@ -789,6 +886,10 @@ if_attach_internal(struct ifnet *ifp, int vmove, struct if_clone *ifc)
 #endif
 
 	IFNET_WLOCK();
+#ifdef __rtems__
+	/* Publish the initialized interface to lockless readers */
+	atomic_thread_fence_rel();
+#endif /* __rtems__ */
 	TAILQ_INSERT_TAIL(&V_ifnet, ifp, if_link);
 #ifdef VIMAGE
 	curvnet->vnet_ifcnt++;
@@ -1676,16 +1777,37 @@ ifa_ref(struct ifaddr *ifa)
 	refcount_acquire(&ifa->ifa_refcnt);
 }
 
+#ifdef __rtems__
+static void
+ifa_free_epoch(epoch_context_t ctx)
+{
+	struct ifaddr *ifa;
+
+	ifa = __containerof(ctx, struct ifaddr, ifa_epoch_ctx);
+	counter_u64_free(ifa->ifa_opackets);
+	counter_u64_free(ifa->ifa_ipackets);
+	counter_u64_free(ifa->ifa_obytes);
+	counter_u64_free(ifa->ifa_ibytes);
+	free(ifa, M_IFADDR);
+}
+
+#endif /* __rtems__ */
 void
 ifa_free(struct ifaddr *ifa)
 {
 
 	if (refcount_release(&ifa->ifa_refcnt)) {
+#ifndef __rtems__
 		counter_u64_free(ifa->ifa_opackets);
 		counter_u64_free(ifa->ifa_ipackets);
 		counter_u64_free(ifa->ifa_obytes);
 		counter_u64_free(ifa->ifa_ibytes);
 		free(ifa, M_IFADDR);
+#else /* __rtems__ */
+		/* Lockless readers may still see the address */
+		epoch_call(net_epoch_preempt, &ifa->ifa_epoch_ctx,
+		    ifa_free_epoch);
+#endif /* __rtems__ */
 	}
 }
 
@@ -1760,7 +1882,11 @@ ifa_ifwithaddr_internal(const struct sockaddr *addr, int getref)
 {
 	struct ifnet *ifp;
 	struct ifaddr *ifa;
+#ifdef __rtems__
+	struct epoch_tracker et;
+#endif /* __rtems__ */
 
+#ifndef __rtems__
 	IFNET_RLOCK_NOSLEEP();
 	TAILQ_FOREACH(ifp, &V_ifnet, if_link) {
 		IF_ADDR_RLOCK(ifp);
@@ -1790,6 +1916,29 @@ ifa_ifwithaddr_internal(const struct sockaddr *addr, int getref)
 done:
 	IFNET_RUNLOCK_NOSLEEP();
 	return (ifa);
+#else /* __rtems__ */
+	NET_EPOCH_ENTER(et);
+	TAILQ_FOREACH(ifp, &V_ifnet, if_link) {
+		TAILQ_FOREACH(ifa, &ifp->if_addrhead, ifa_link) {
+			if (ifa->ifa_addr->sa_family != addr->sa_family)
+				continue;
+			if (sa_equal(addr, ifa->ifa_addr) ||
+			    ((ifp->if_flags & IFF_BROADCAST) &&
+			    ifa->ifa_broadaddr &&
+			    ifa->ifa_broadaddr->sa_len != 0 &&
+			    sa_equal(ifa->ifa_broadaddr, addr))) {
+				if (getref &&
+				    !refcount_acquire_if_not_zero(
+				    &ifa->ifa_refcnt))
+					continue;
+				NET_EPOCH_EXIT(et);
+				return (ifa);
+			}
+		}
+	}
+	NET_EPOCH_EXIT(et);
+	return (NULL);
+#endif /* __rtems__ */
 }
 
 struct ifaddr *
@@ -452,6 +452,12 @@ ether_output_frame(struct ifnet *ifp, struct mbuf *m)
 			return (0);
 	}
 
+#ifdef __rtems__
+	if ((m->m_pkthdr.csum_flags & CSUM_TSO) != 0 &&
+	    (ifp->if_hwassist & CSUM_TSO) == 0)
+		return (ether_gso_output(ifp, m));
+#endif /* __rtems__ */
+
 	/*
 	 * Queue message on interface, update output statistics if
 	 * successful, and start output if interface not yet active.
@@ -895,6 +901,12 @@ ether_ifattach(struct ifnet *ifp, const u_int8_t *lla)
 	int i;
 	struct ifaddr *ifa;
 	struct sockaddr_dl *sdl;
+#ifdef __rtems__
+	u_int tsomax;
+
+	/* if_attach() replaces zero by its hardware TSO default */
+	tsomax = ifp->if_hw_tsomax;
+#endif /* __rtems__ */
 
 	ifp->if_addrlen = ETHER_ADDR_LEN;
 	ifp->if_hdrlen = ETHER_HDR_LEN;
@@ -910,6 +922,19 @@ ether_ifattach(struct ifnet *ifp, const u_int8_t *lla)
 	if (ifp->if_baudrate == 0)
 		ifp->if_baudrate = IF_Mbps(10);		/* just a default */
 	ifp->if_broadcastaddr = etherbroadcastaddr;
+#ifdef __rtems__
+	if (ifp->if_type == IFT_ETHER &&
+	    (ifp->if_capabilities & IFCAP_TSO) == 0) {
+		/*
+		 * The TSO defaults of if_attach() are sized for hardware.
+		 * Software TSO only needs a chain short enough to keep the
+		 * segment copies cheap.  Keep a limit set by the driver.
+		 */
+		ifp->if_gso = 1;
+		if (tsomax == 0)
+			ifp->if_hw_tsomax = ETHER_GSO_MAX;
+	}
+#endif /* __rtems__ */
 
 	ifa = ifp->if_addr;
 	KASSERT(ifa != NULL, ("%s: no lladdr!\n", __func__));
@@ -50,6 +50,9 @@ __FBSDID("$FreeBSD$");
 #endif
 
 #include <vm/uma.h>
+#ifdef __rtems__
+#include <machine/cpu.h>
+#endif /* __rtems__ */
 
 #include <netinet/in.h>
 #include <net/if_llatbl.h>
@@ -75,6 +78,49 @@ RW_SYSINIT(lltable_list_lock, &lltable_list_lock, "lltable_list_lock");
 #define	LLTABLE_LIST_WLOCK()		rw_wlock(&lltable_list_lock)
 #define	LLTABLE_LIST_WUNLOCK()		rw_wunlock(&lltable_list_lock)
 #define	LLTABLE_LIST_LOCK_ASSERT()	rw_assert(&lltable_list_lock, RA_LOCKED)
+#ifdef __rtems__
+
+/*
+ * Incremented each time the link-level header of some entry is set,
+ * recalculated or the entry is unlinked.  Caches which keep copies of
+ * r_linkdata, e.g. the forwarding flow table, compare it to detect stale
+ * headers.
+ */
+volatile u_int lltable_gen;
+
+volatile u_int *lltable_readers;
+
+static void
+lltable_read_init(void *arg)
+{
+
+	lltable_readers = uma_zalloc(pcpu_zone_64, M_WAITOK | M_ZERO);
+}
+SYSINIT(lltable_read, SI_SUB_INIT_IF, SI_ORDER_FIRST, lltable_read_init,
+    NULL);
+
+void
+lltable_read_synchronize(void)
+{
+	volatile u_int *seq;
+	uint32_t cpu_count;
+	uint32_t cpu;
+	u_int s;
+
+	cpu_count = _SMP_Get_processor_count();
+	atomic_thread_fence_seq_cst();
+	for (cpu = 0; cpu < cpu_count; ++cpu) {
+		seq = zpcpu_get_cpu(__DEVOLATILE(u_int *, lltable_readers),
+		    cpu);
+		s = *seq;
+		if ((s & 1) != 0) {
+			while (*seq == s)
+				cpu_spinwait();
+		}
+	}
+	atomic_thread_fence_seq_cst();
+}
+#endif /* __rtems__ */
 
 static void lltable_unlink(struct lltable *llt);
 static void llentries_unlink(struct lltable *llt, struct llentries *head);
@@ -173,7 +219,17 @@ htable_link_entry(struct lltable *llt, struct llentry *lle)
 	lle->lle_tbl  = llt;
 	lle->lle_head = lleh;
 	lle->la_flags |= LLE_LINKED;
+#ifndef __rtems__
 	LIST_INSERT_HEAD(lleh, lle, lle_next);
+#else /* __rtems__ */
+	/* Publish the entry to lockless readers after it is initialized */
+	LIST_NEXT(lle, lle_next) = LIST_FIRST(lleh);
+	if (LIST_FIRST(lleh) != NULL)
+		LIST_FIRST(lleh)->lle_next.le_prev = &LIST_NEXT(lle, lle_next);
+	lle->lle_next.le_prev = &LIST_FIRST(lleh);
+	atomic_thread_fence_rel();
+	LIST_FIRST(lleh) = lle;
+#endif /* __rtems__ */
 }
 
 static void
@@ -184,6 +240,9 @@ htable_unlink_entry(struct llentry *lle)
 		IF_AFDATA_WLOCK_ASSERT(lle->lle_tbl->llt_ifp);
 		LIST_REMOVE(lle, lle_next);
 		lle->la_flags &= ~(LLE_VALID | LLE_LINKED);
+#ifdef __rtems__
+		atomic_add_int(&lltable_gen, 1);
+#endif /* __rtems__ */
 #if 0
 		lle->lle_tbl = NULL;
 		lle->lle_head = NULL;
@@ -241,6 +300,9 @@ static void
 htable_free_tbl(struct lltable *llt)
 {
 
+#ifdef __rtems__
+	lltable_read_synchronize();
+#endif /* __rtems__ */
 	free(llt->lle_head, M_LLTABLE);
 	free(llt, M_LLTABLE);
 }
@@ -288,11 +350,21 @@ lltable_set_entry_addr(struct ifnet *ifp, struct llentry *lle,
     const char *linkhdr, size_t linkhdrsize, int lladdr_off)
 {
 
+#ifdef __rtems__
+	seq_write_begin(&lle->lle_linkseq);
+#endif /* __rtems__ */
 	memcpy(lle->r_linkdata, linkhdr, linkhdrsize);
 	lle->r_hdrlen = linkhdrsize;
 	lle->ll_addr = &lle->r_linkdata[lladdr_off];
+#ifdef __rtems__
+	seq_write_end(&lle->lle_linkseq);
+	atomic_thread_fence_rel();
+#endif /* __rtems__ */
 	lle->la_flags |= LLE_VALID;
 	lle->r_flags |= RLLE_VALID;
+#ifdef __rtems__
+	atomic_add_int(&lltable_gen, 1);
+#endif /* __rtems__ */
 }
 
 /*
@@ -393,7 +465,14 @@ llentry_update_ifaddr(struct lltable *llt, struct llentry *lle, void *farg)
 	linkhdrsize = sizeof(linkhdr);
 	lltable_calc_llheader(ifp, llt->llt_af, lladdr, linkhdr, &linkhdrsize,
 	    &lladdr_off);
+#ifdef __rtems__
+	seq_write_begin(&lle->lle_linkseq);
+#endif /* __rtems__ */
 	memcpy(lle->r_linkdata, linkhdr, linkhdrsize);
+#ifdef __rtems__
+	seq_write_end(&lle->lle_linkseq);
+	atomic_add_int(&lltable_gen, 1);
+#endif /* __rtems__ */
 	LLE_WUNLOCK(lle);
 
 	return (0);
@@ -32,6 +32,10 @@ __FBSDID("$FreeBSD$");
 
 #include <sys/_rwlock.h>
 #include <netinet/in.h>
+#ifdef __rtems__
+#include <sys/pcpu.h>
+#include <sys/seq.h>
+#endif /* __rtems__ */
 
 struct ifnet;
 struct sysctl_req;
@@ -56,6 +60,9 @@ struct llentry {
 	uint8_t			spare0[3];
 	uint16_t		r_flags;	/* LLE runtime flags */
 	uint16_t		r_skip_req;	/* feedback from fast path */
+#ifdef __rtems__
+	seq_t			lle_linkseq;	/* r_linkdata modifications */
+#endif /* __rtems__ */
 
 	struct lltable		 *lle_tbl;
 	struct llentries	 *lle_head;
@@ -246,6 +253,68 @@ lla_lookup(struct lltable *llt, u_int flags, const struct sockaddr *l3addr)
 }
 
 int		lla_rt_output(struct rt_msghdr *, struct rt_addrinfo *);
+#ifdef __rtems__
+
+extern volatile u_int lltable_gen;
+
+/*
+ * Lockless lookups for the transmit path.  On RTEMS the IF_AFDATA and
+ * llentry locks are exclusive mutexes, so all senders would serialize on
+ * them.  A reader section runs with thread dispatching disabled and keeps
+ * the per-processor sequence counter odd.  Only LLE_UNLOCKED lookups are
+ * allowed inside, the reader must not block.  Writers still use
+ * IF_AFDATA_WLOCK().  Memory of unlinked entries and destroyed tables is
+ * freed only after lltable_read_synchronize() saw every processor leave
+ * the reader section which was active at the time of the call.
+ */
+extern volatile u_int *lltable_readers;
+
+static __inline void
+lltable_read_enter(void)
+{
+	volatile u_int *seq;
+
+	critical_enter();
+	seq = zpcpu_get(__DEVOLATILE(u_int *, lltable_readers));
+	*seq = *seq + 1;
+	atomic_thread_fence_seq_cst();
+}
+
+static __inline void
+lltable_read_exit(void)
+{
+	volatile u_int *seq;
+
+	seq = zpcpu_get(__DEVOLATILE(u_int *, lltable_readers));
+	atomic_thread_fence_rel();
+	*seq = *seq + 1;
+	critical_exit();
+}
+
+void	lltable_read_synchronize(void);
+
+/*
+ * Copy the link-level header of an entry inside a reader section.
+ * Writers update it in place under the entry lock, so the copy is checked
+ * against the per-entry sequence counter.  Returns the header length, or
+ * zero if a writer interfered and the caller has to use the locked path.
+ */
+static __inline size_t
+lltable_read_linkhdr(const struct llentry *lle, void *buf)
+{
+	seq_t seq;
+	size_t len;
+
+	seq = atomic_load_acq_32(__DECONST(seq_t *, &lle->lle_linkseq));
+	if (seq_in_modify(seq))
+		return (0);
+	len = lle->r_hdrlen;
+	memcpy(buf, lle->r_linkdata, len);
+	if (!seq_consistent(&lle->lle_linkseq, seq))
+		return (0);
+	return (len);
+}
+#endif /* __rtems__ */
 
 #include <sys/eventhandler.h>
 enum {
@@ -80,6 +80,9 @@ struct	netmap_adapter;
 #include <sys/rwlock.h>		/* XXX */
 #include <sys/sx.h>		/* XXX */
 #include <sys/_task.h>		/* if_link_task */
+#ifdef __rtems__
+#include <sys/epoch.h>
+#endif /* __rtems__ */
 
 #define	IF_DUNIT_NONE	-1
 
@@ -360,7 +363,25 @@ struct ifnet {
 	 * binary interface.
 	 */
 	int	if_ispare[4];		/* general use */
+#ifdef __rtems__
+	struct epoch_context if_epoch_ctx; /* deferred free after if_free() */
+	int	if_gso;			/* software TSO, see ether_gso_output() */
+#endif /* __rtems__ */
 };
+#ifdef __rtems__
+
+/*
+ * Generic segmentation offload (GSO).  Ethernet interfaces without TCP
+ * segmentation offload accept TCP super-segments, which the link layer
+ * splits and checksums right before if_transmit.  Bridge members are
+ * excluded since the bridge hands frames directly to if_transmit.
+ */
+#define	IF_GSO(ifp)	((ifp)->if_gso != 0 && (ifp)->if_bridge == NULL)
+#define	IF_GSO_HWASSIST(ifp, m)						\
+	((ifp)->if_hwassist | (IF_GSO(ifp) &&				\
+	    ((m)->m_pkthdr.csum_flags & CSUM_TSO) != 0 ?		\
+	    (CSUM_TSO | CSUM_TCP | CSUM_TCP_IPV6) : 0))
+#endif /* __rtems__ */
 
 /* for compatibility with other BSDs */
 #define	if_name(ifp)	((ifp)->if_xname)
@@ -499,6 +520,9 @@ struct ifaddr {
 	counter_u64_t	ifa_opackets;	 
 	counter_u64_t	ifa_ibytes;
 	counter_u64_t	ifa_obytes;
+#ifdef __rtems__
+	struct	epoch_context ifa_epoch_ctx; /* deferred free */
+#endif /* __rtems__ */
 };
 
 struct ifaddr *	ifa_alloc(size_t size, int flags);
@@ -547,6 +571,20 @@ extern	struct sx ifnet_sxlock;
 #define	IFNET_RLOCK_NOSLEEP()	rw_rlock(&ifnet_rwlock)
 #define	IFNET_RUNLOCK()		sx_sunlock(&ifnet_sxlock)
 #define	IFNET_RUNLOCK_NOSLEEP()	rw_runlock(&ifnet_rwlock)
+#ifdef __rtems__
+
+/*
+ * The network epoch protects the ifnet list, the interface address lists
+ * and the IPv4 address hash.  Readers in a section need no lock, writers
+ * still use the locks above.  Interfaces and interface addresses are freed
+ * only after all sections which could see them are left.
+ */
+extern	epoch_t net_epoch_preempt;
+
+#define	NET_EPOCH_ENTER(et)	epoch_enter_preempt(net_epoch_preempt, &(et))
+#define	NET_EPOCH_EXIT(et)	epoch_exit_preempt(net_epoch_preempt, &(et))
+#define	NET_EPOCH_WAIT()	epoch_wait_preempt(net_epoch_preempt)
+#endif /* __rtems__ */
 
 /*
  * Look up an ifnet given its index; the _ref variant also acquires a
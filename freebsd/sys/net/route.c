@@ -1255,6 +1255,9 @@ rt_unlinkrte(struct rib_head *rnh, struct rt_addrinfo *info, int *perror)
 	RT_LOCK(rt);
 	RT_ADDREF(rt);
 	rt->rt_flags &= ~RTF_UP;
+#ifdef __rtems__
+	rnh->rnh_gen++;		/* Routing table updated */
+#endif /* __rtems__ */
 
 	*perror = 0;
 
@@ -1395,6 +1398,9 @@ rt_updatemtu(struct ifnet *ifp)
 				continue;
 			RIB_WLOCK(rnh);
 			rnh->rnh_walktree(&rnh->head, if_updatemtu_cb, &ifmtu);
+#ifdef __rtems__
+			rnh->rnh_gen++;
+#endif /* __rtems__ */
 			RIB_WUNLOCK(rnh);
 		}
 	}
@@ -1921,6 +1927,9 @@ rtrequest1_fib_change(struct rib_head *rnh, struct rt_addrinfo *info,
 			if_updatemtu_cb(rt->rt_nodes, &ifmtu);
 		}
 	}
+#ifdef __rtems__
+	rnh->rnh_gen++;		/* Routing table updated */
+#endif /* __rtems__ */
 
 	if (ret_nrt) {
 		*ret_nrt = rt;
@@ -415,8 +415,9 @@ struct rt_addrinfo {
 
 /*
  * Validate a cached route based on a supplied cookie.  If there is an
- * out-of-date cache, simply free it.  Update the generation number
- * for the new allocation
+ * out-of-date cache, simply free it together with the cached link-layer
+ * entry, since the next hop may have changed.  Update the generation
+ * number for the new allocation
  */
 #define RT_VALIDATE(ro, cookiep, fibnum) do {				\
 	rt_gen_t cookie = RT_GEN(fibnum, (ro)->ro_dst.sa_family);	\
@@ -425,6 +426,10 @@ struct rt_addrinfo {
 			RTFREE((ro)->ro_rt);				\
 			(ro)->ro_rt = NULL;				\
 		}							\
+		if ((ro)->ro_lle != NULL) {				\
+			LLE_FREE((ro)->ro_lle);				\
+			(ro)->ro_lle = NULL;				\
+		}							\
 		*(cookiep) = cookie;					\
 	}								\
 } while (0)
@@ -633,6 +633,29 @@ arpresolve(struct ifnet *ifp, int is_gw, struct mbuf *m,
 		}
 	}
 
+#ifdef __rtems__
+	if (plle == NULL) {
+		lltable_read_enter();
+		la = lla_lookup(LLTABLE(ifp), LLE_UNLOCKED, dst);
+		if (la != NULL && (la->r_flags & RLLE_VALID) != 0 &&
+		    la->r_skip_req == 0) {
+			atomic_thread_fence_acq();
+			if (lltable_read_linkhdr(la, desten) != 0) {
+				if (pflags != NULL)
+					*pflags = LLE_VALID |
+					    (la->r_flags & RLLE_IFADDR);
+				lltable_read_exit();
+				return (0);
+			}
+		}
+		lltable_read_exit();
+		/*
+		 * Use the locked path below to resolve the entry, to answer
+		 * the feedback request from arptimer() or if the header
+		 * changed during the copy.
+		 */
+	}
+#endif /* __rtems__ */
 	IF_AFDATA_RLOCK(ifp);
 	la = lla_lookup(LLTABLE(ifp), plle ? LLE_EXCLUSIVE : LLE_UNLOCKED, dst);
 	if (la != NULL && (la->r_flags & RLLE_VALID) != 0) {
@@ -97,18 +97,34 @@ SX_SYSINIT(in_control_sx, &in_control_sx, "in_control");
 int
 in_localaddr(struct in_addr in)
 {
+#ifndef __rtems__
 	struct rm_priotracker in_ifa_tracker;
+#else /* __rtems__ */
+	struct epoch_tracker et;
+#endif /* __rtems__ */
 	register u_long i = ntohl(in.s_addr);
 	register struct in_ifaddr *ia;
 
+#ifndef __rtems__
 	IN_IFADDR_RLOCK(&in_ifa_tracker);
+#else /* __rtems__ */
+	NET_EPOCH_ENTER(et);
+#endif /* __rtems__ */
 	TAILQ_FOREACH(ia, &V_in_ifaddrhead, ia_link) {
 		if ((i & ia->ia_subnetmask) == ia->ia_subnet) {
+#ifndef __rtems__
 			IN_IFADDR_RUNLOCK(&in_ifa_tracker);
+#else /* __rtems__ */
+			NET_EPOCH_EXIT(et);
+#endif /* __rtems__ */
 			return (1);
 		}
 	}
+#ifndef __rtems__
 	IN_IFADDR_RUNLOCK(&in_ifa_tracker);
+#else /* __rtems__ */
+	NET_EPOCH_EXIT(et);
+#endif /* __rtems__ */
 	return (0);
 }
 
@@ -119,17 +135,33 @@ in_localaddr(struct in_addr in)
 int
 in_localip(struct in_addr in)
 {
+#ifndef __rtems__
 	struct rm_priotracker in_ifa_tracker;
+#else /* __rtems__ */
+	struct epoch_tracker et;
+#endif /* __rtems__ */
 	struct in_ifaddr *ia;
 
+#ifndef __rtems__
 	IN_IFADDR_RLOCK(&in_ifa_tracker);
+#else /* __rtems__ */
+	NET_EPOCH_ENTER(et);
+#endif /* __rtems__ */
 	LIST_FOREACH(ia, INADDR_HASH(in.s_addr), ia_hash) {
 		if (IA_SIN(ia)->sin_addr.s_addr == in.s_addr) {
+#ifndef __rtems__
 			IN_IFADDR_RUNLOCK(&in_ifa_tracker);
+#else /* __rtems__ */
+			NET_EPOCH_EXIT(et);
+#endif /* __rtems__ */
 			return (1);
 		}
 	}
+#ifndef __rtems__
 	IN_IFADDR_RUNLOCK(&in_ifa_tracker);
+#else /* __rtems__ */
+	NET_EPOCH_EXIT(et);
+#endif /* __rtems__ */
 	return (0);
 }
 
@@ -141,18 +173,33 @@ in_ifhasaddr(struct ifnet *ifp, struct in_addr in)
 {
 	struct ifaddr *ifa;
 	struct in_ifaddr *ia;
+#ifdef __rtems__
+	struct epoch_tracker et;
+#endif /* __rtems__ */
 
+#ifndef __rtems__
 	IF_ADDR_RLOCK(ifp);
+#else /* __rtems__ */
+	NET_EPOCH_ENTER(et);
+#endif /* __rtems__ */
 	TAILQ_FOREACH(ifa, &ifp->if_addrhead, ifa_link) {
 		if (ifa->ifa_addr->sa_family != AF_INET)
 			continue;
 		ia = (struct in_ifaddr *)ifa;
 		if (ia->ia_addr.sin_addr.s_addr == in.s_addr) {
+#ifndef __rtems__
 			IF_ADDR_RUNLOCK(ifp);
+#else /* __rtems__ */
+			NET_EPOCH_EXIT(et);
+#endif /* __rtems__ */
 			return (1);
 		}
 	}
+#ifndef __rtems__
 	IF_ADDR_RUNLOCK(ifp);
+#else /* __rtems__ */
+	NET_EPOCH_EXIT(et);
+#endif /* __rtems__ */
 
 	return (0);
 }
@@ -457,13 +504,33 @@ in_aifaddr_ioctl(u_long cmd, caddr_t data, struct ifnet *ifp, struct thread *td)
 
 	/* if_addrhead is already referenced by ifa_alloc() */
 	IF_ADDR_WLOCK(ifp);
+#ifdef __rtems__
+	/* Publish the initialized address to network epoch readers */
+	atomic_thread_fence_rel();
+#endif /* __rtems__ */
 	TAILQ_INSERT_TAIL(&ifp->if_addrhead, ifa, ifa_link);
 	IF_ADDR_WUNLOCK(ifp);
 
 	ifa_ref(ifa);			/* in_ifaddrhead */
 	IN_IFADDR_WLOCK();
 	TAILQ_INSERT_TAIL(&V_in_ifaddrhead, ia, ia_link);
+#ifndef __rtems__
 	LIST_INSERT_HEAD(INADDR_HASH(ia->ia_addr.sin_addr.s_addr), ia, ia_hash);
+#else /* __rtems__ */
+	{
+		struct in_ifaddrhashhead *head;
+
+		/* The hash chain link must be visible before the entry */
+		head = INADDR_HASH(ia->ia_addr.sin_addr.s_addr);
+		LIST_NEXT(ia, ia_hash) = LIST_FIRST(head);
+		if (LIST_FIRST(head) != NULL)
+			LIST_FIRST(head)->ia_hash.le_prev =
+			    &LIST_NEXT(ia, ia_hash);
+		ia->ia_hash.le_prev = &LIST_FIRST(head);
+		atomic_thread_fence_rel();
+		LIST_FIRST(head) = ia;
+	}
+#endif /* __rtems__ */
 	IN_IFADDR_WUNLOCK();
 
 	/*
@@ -1064,6 +1131,9 @@ static void
 in_lltable_destroy_lle_unlocked(struct llentry *lle)
 {
 
+#ifdef __rtems__
+	lltable_read_synchronize();
+#endif /* __rtems__ */
 	LLE_LOCK_DESTROY(lle);
 	LLE_REQ_DESTROY(lle);
 	free(lle, M_LLTABLE);
@@ -1367,7 +1437,12 @@ in_lltable_lookup(struct lltable *llt, u_int flags, const struct sockaddr *l3add
 	const struct sockaddr_in *sin = (const struct sockaddr_in *)l3addr;
 	struct llentry *lle;
 
+#ifndef __rtems__
 	IF_AFDATA_LOCK_ASSERT(llt->llt_ifp);
+#else /* __rtems__ */
+	if ((flags & LLE_UNLOCKED) == 0)
+		IF_AFDATA_LOCK_ASSERT(llt->llt_ifp);
+#endif /* __rtems__ */
 	KASSERT(l3addr->sa_family == AF_INET,
 	    ("sin_family %d", l3addr->sa_family));
 	lle = in_lltable_find_dst(llt, sin->sin_addr);
@@ -1486,6 +1561,10 @@ in_domifattach(struct ifnet *ifp)
 
 	ii->ii_llt = in_lltattach(ifp);
 	ii->ii_igmp = igmp_domifattach(ifp);
+#ifdef __rtems__
+	ii->ii_inmhash = hashinit(IN_MULTI_HASHSIZE, M_IFADDR,
+	    &ii->ii_inmhmask);
+#endif /* __rtems__ */
 
 	return (ii);
 }
@@ -1494,6 +1573,24 @@ void
 in_domifdetach(struct ifnet *ifp, void *aux)
 {
 	struct in_ifinfo *ii = (struct in_ifinfo *)aux;
+#ifdef __rtems__
+	struct in_multi *inm;
+	u_long i;
+
+	/*
+	 * The memberships are normally released by in_ifdetach().  Unlink
+	 * stragglers so that their release does not touch the table.
+	 */
+	IN_MULTI_LOCK();
+	for (i = 0; i <= ii->ii_inmhmask; i++) {
+		while ((inm = LIST_FIRST(&ii->ii_inmhash[i])) != NULL) {
+			LIST_REMOVE(inm, inm_hash);
+			inm->inm_hashed = 0;
+		}
+	}
+	IN_MULTI_UNLOCK();
+	hashdestroy(ii->ii_inmhash, M_IFADDR, ii->ii_inmhmask);
+#endif /* __rtems__ */
 
 	igmp_domifdetach(ifp);
 	lltable_free(ii->ii_llt);
@@ -239,10 +239,25 @@ inm_lookup_locked(struct ifnet *ifp, const struct in_addr ina)
 {
 	struct ifmultiaddr *ifma;
 	struct in_multi *inm;
+#ifdef __rtems__
+	struct in_ifinfo *ii;
+#endif /* __rtems__ */
 
 	IN_MULTI_LOCK_ASSERT();
 	IF_ADDR_LOCK_ASSERT(ifp);
 
+#ifdef __rtems__
+	ii = (struct in_ifinfo *)ifp->if_afdata[AF_INET];
+	if (ii != NULL && ii->ii_inmhash != NULL) {
+		LIST_FOREACH(inm, &ii->ii_inmhash[in_mcast_hash(ina) &
+		    ii->ii_inmhmask], inm_hash) {
+			if (inm->inm_addr.s_addr == ina.s_addr)
+				break;
+		}
+		return (inm);
+	}
+
+#endif /* __rtems__ */
 	inm = NULL;
 	TAILQ_FOREACH(ifma, &((ifp)->if_multiaddrs), ifma_link) {
 		if (ifma->ifma_addr->sa_family == AF_INET) {
@@ -335,6 +350,11 @@ imo_match_group(const struct ip_moptions *imo, const struct ifnet *ifp,
 	struct in_multi	**pinm;
 	int		  idx;
 	int		  nmships;
+#ifdef __rtems__
+	const struct in_multi *inm;
+	u_int		  h;
+	int		  match;
+#endif /* __rtems__ */
 
 	gsin = (const struct sockaddr_in *)group;
 
@@ -342,6 +362,29 @@ imo_match_group(const struct ip_moptions *imo, const struct ifnet *ifp,
 	if (imo->imo_membership == NULL || imo->imo_num_memberships == 0)
 		return (-1);
 
+#ifdef __rtems__
+	if (imo->imo_hash != NULL) {
+		/*
+		 * A group may be joined on several interfaces.  Without an
+		 * interface return the lowest index like the linear scan.
+		 */
+		match = -1;
+		h = in_mcast_hash(gsin->sin_addr) & imo->imo_hashmask;
+		while ((idx = imo->imo_hash[h]) != 0) {
+			inm = imo->imo_membership[--idx];
+			if ((ifp == NULL || inm->inm_ifp == ifp) &&
+			    in_hosteq(inm->inm_addr, gsin->sin_addr) &&
+			    (match == -1 || idx < match)) {
+				match = idx;
+				if (ifp != NULL)
+					break;
+			}
+			h = (h + 1) & imo->imo_hashmask;
+		}
+		return (match);
+	}
+
+#endif /* __rtems__ */
 	nmships = imo->imo_num_memberships;
 	pinm = &imo->imo_membership[0];
 	for (idx = 0; idx < nmships; idx++, pinm++) {
@@ -358,6 +401,67 @@ imo_match_group(const struct ip_moptions *imo, const struct ifnet *ifp,
 	return (idx);
 }
 
+#ifdef __rtems__
+/*
+ * Sockets which outgrow IP_MIN_MEMBERSHIPS get an open addressing hash
+ * table of their membership indices keyed by group, so that the receive
+ * path does not scan the whole membership vector for each datagram.  The
+ * table has at least twice as many slots as the membership vector.  A
+ * slot holds the membership index plus one, zero marks an empty slot.  If
+ * the table cannot be allocated, imo_match_group() falls back to the
+ * linear scan.
+ */
+static void
+imo_hash_insert(struct ip_moptions *imo, size_t idx)
+{
+	u_int h;
+
+	h = in_mcast_hash(imo->imo_membership[idx]->inm_addr) &
+	    imo->imo_hashmask;
+	while (imo->imo_hash[h] != 0)
+		h = (h + 1) & imo->imo_hashmask;
+	imo->imo_hash[h] = idx + 1;
+}
+
+/*
+ * Rebuild the membership hash after the membership vector was resized or
+ * compacted.  May be called with locks held; do not sleep.
+ */
+void
+imo_rehash(struct ip_moptions *imo)
+{
+	size_t idx;
+	u_int size;
+
+	if (imo->imo_max_memberships <= IP_MIN_MEMBERSHIPS) {
+		free(imo->imo_hash, M_IPMOPTS);
+		imo->imo_hash = NULL;
+		imo->imo_hashmask = 0;
+		return;
+	}
+
+	size = 1;
+	while (size < 2 * (u_int)imo->imo_max_memberships)
+		size <<= 1;
+
+	if (imo->imo_hash == NULL || size != imo->imo_hashmask + 1U) {
+		free(imo->imo_hash, M_IPMOPTS);
+		imo->imo_hashmask = 0;
+		imo->imo_hash = malloc(sizeof(*imo->imo_hash) * size,
+		    M_IPMOPTS, M_NOWAIT);
+		if (imo->imo_hash == NULL)
+			return;
+		imo->imo_hashmask = size - 1;
+	}
+
+	memset(imo->imo_hash, 0, sizeof(*imo->imo_hash) * size);
+	for (idx = 0; idx < imo->imo_num_memberships; idx++) {
+		if (imo->imo_membership[idx] != NULL)
+			imo_hash_insert(imo, idx);
+	}
+}
+#endif /* __rtems__ */
+
 /*
  * Find an IPv4 multicast source entry for this imo which matches
  * the given group index for this socket, and source address.
@@ -537,6 +641,13 @@ in_getmulti(struct ifnet *ifp, const struct in_addr *group,
 	RB_INIT(&inm->inm_srcs);
 
 	ifma->ifma_protospec = inm;
+#ifdef __rtems__
+	if (ii->ii_inmhash != NULL) {
+		LIST_INSERT_HEAD(&ii->ii_inmhash[in_mcast_hash(*group) &
+		    ii->ii_inmhmask], inm, inm_hash);
+		inm->inm_hashed = 1;
+	}
+#endif /* __rtems__ */
 
 	*pinm = inm;
 
@@ -574,6 +685,12 @@ inm_release_locked(struct in_multi *inm)
 	KASSERT(ifma->ifma_protospec == inm,
 	    ("%s: ifma_protospec != inm", __func__));
 	ifma->ifma_protospec = NULL;
+#ifdef __rtems__
+	if (inm->inm_hashed) {
+		LIST_REMOVE(inm, inm_hash);
+		inm->inm_hashed = 0;
+	}
+#endif /* __rtems__ */
 
 	inm_purge(inm);
 
@@ -1551,6 +1668,10 @@ inp_findmoptions(struct inpcb *inp)
 	imo->imo_num_memberships = 0;
 	imo->imo_max_memberships = IP_MIN_MEMBERSHIPS;
 	imo->imo_membership = immp;
+#ifdef __rtems__
+	imo->imo_hash = NULL;
+	imo->imo_hashmask = 0;
+#endif /* __rtems__ */
 
 	/* Initialize per-group source filters. */
 	for (idx = 0; idx < IP_MIN_MEMBERSHIPS; idx++)
@@ -1606,6 +1727,9 @@ inp_freemoptions_internal(struct ip_moptions *imo)
 	if (imo->imo_mfilters)
 		free(imo->imo_mfilters, M_INMFILTER);
 	free(imo->imo_membership, M_IPMOPTS);
+#ifdef __rtems__
+	free(imo->imo_hash, M_IPMOPTS);
+#endif /* __rtems__ */
 	free(imo, M_IPMOPTS);
 }
 
@@ -2109,6 +2233,9 @@ inp_join_group(struct inpcb *inp, struct sockopt *sopt)
 			error = imo_grow(imo);
 			if (error)
 				goto out_inp_locked;
+#ifdef __rtems__
+			imo_rehash(imo);
+#endif /* __rtems__ */
 		}
 		/*
 		 * Allocate the new slot upfront so we can deal with
@@ -2174,6 +2301,10 @@ inp_join_group(struct inpcb *inp, struct sockopt *sopt)
 			goto out_imo_free;
                 }
 		imo->imo_membership[idx] = inm;
+#ifdef __rtems__
+		if (imo->imo_hash != NULL)
+			imo_hash_insert(imo, idx);
+#endif /* __rtems__ */
 	} else {
 		CTR1(KTR_IGMPV3, "%s: merge inm state", __func__);
 		error = inm_merge(inm, imf);
@@ -2427,6 +2558,9 @@ out_in_multi_locked:
 			imo->imo_mfilters[idx-1] = imo->imo_mfilters[idx];
 		}
 		imo->imo_num_memberships--;
+#ifdef __rtems__
+		imo_rehash(imo);
+#endif /* __rtems__ */
 	}
 
 out_inp_locked:
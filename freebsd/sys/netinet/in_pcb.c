@@ -1493,6 +1493,10 @@ in_pcbpurgeif0(struct inpcbinfo *pcbinfo, struct ifnet *ifp)
 					    imo->imo_membership[i];
 			}
 			imo->imo_num_memberships -= gap;
+#ifdef __rtems__
+			if (gap != 0)
+				imo_rehash(imo);
+#endif /* __rtems__ */
 		}
 		INP_WUNLOCK(inp);
 	}
@@ -61,6 +61,10 @@ struct in_ifinfo {
 	struct lltable		*ii_llt;	/* ARP state */
 	struct igmp_ifsoftc	*ii_igmp;	/* IGMP state */
 	struct in_multi		*ii_allhosts;	/* 224.0.0.1 membership */
+#ifdef __rtems__
+	LIST_HEAD(, in_multi)	*ii_inmhash;	/* memberships by group */
+	u_long			 ii_inmhmask;
+#endif /* __rtems__ */
 };
 
 /*
@@ -291,6 +295,10 @@ struct in_multi {
 		uint16_t	iss_in;		/* # of inclusive members */
 		uint16_t	iss_rec;	/* # of recorded sources */
 	}			inm_st[2];	/* state at t0, t1 */
+#ifdef __rtems__
+	LIST_ENTRY(in_multi)	 inm_hash;	/* ii_inmhash chain */
+	int			 inm_hashed;	/* on ii_inmhash */
+#endif /* __rtems__ */
 };
 
 /*
@@ -350,6 +358,26 @@ inm_acquire_locked(struct in_multi *inm)
 #define MCAST_NOTSMEMBER	2	/* This host excluded source */
 #define MCAST_MUTED		3	/* [deprecated] */
 
+#ifdef __rtems__
+/*
+ * Hash of an IPv4 multicast group address for the per-interface and
+ * per-socket membership tables.  The low order bits of the address carry
+ * the most entropy for the usual administratively scoped group ranges.
+ */
+#define	IN_MULTI_HASHSIZE	128
+
+static __inline u_int
+in_mcast_hash(struct in_addr group)
+{
+	uint32_t h;
+
+	h = ntohl(group.s_addr);
+	h ^= h >> 16;
+	h *= 0x9e3779b1U;
+	return (h >> 16);
+}
+#endif /* __rtems__ */
+
 struct	rtentry;
 struct	route;
 struct	ip_moptions;
@@ -358,6 +386,9 @@ struct in_multi *inm_lookup_locked(struct ifnet *, const struct in_addr);
 struct in_multi *inm_lookup(struct ifnet *, const struct in_addr);
 int	imo_multi_filter(const struct ip_moptions *, const struct ifnet *,
 	    const struct sockaddr *, const struct sockaddr *);
+#ifdef __rtems__
+void	imo_rehash(struct ip_moptions *);
+#endif /* __rtems__ */
 void	inm_commit(struct in_multi *);
 void	inm_clear_recorded(struct in_multi *);
 void	inm_print(const struct in_multi *);
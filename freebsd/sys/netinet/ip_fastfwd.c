@@ -97,6 +97,10 @@ __FBSDID("$FreeBSD$");
 #include <net/if_dl.h>
 #include <net/route.h>
 #include <net/vnet.h>
+#ifdef __rtems__
+#include <net/flowtable.h>
+#include <net/if_llatbl.h>
+#endif /* __rtems__ */
 
 #include <netinet/in.h>
 #include <netinet/in_fib.h>
@@ -157,6 +161,12 @@ ip_tryforward(struct mbuf *m)
 	uint16_t ip_len, ip_off;
 	int error = 0;
 	struct m_tag *fwd_tag = NULL;
+#ifdef __rtems__
+	struct route ro, *rop;
+	char l2hdr[LLE_MAX_LINKHDR];
+	size_t l2len;
+	uint64_t ftgen;
+#endif /* __rtems__ */
 
 	/*
 	 * Are we active and forwarding packets?
@@ -296,8 +306,30 @@ passin:
 	/*
 	 * Find route to destination.
 	 */
+#ifndef __rtems__
 	if (ip_findroute(&nh, dest, m) != 0)
 		return (NULL);	/* icmp unreach already sent */
+#else /* __rtems__ */
+	rop = NULL;
+	if (flowtable_lookup_nh4(M_GETFIB(m), dest, &nh, l2hdr,
+	    &l2len) == 0) {
+		/*
+		 * Hand the cached link-level header to ether_output() to
+		 * avoid the lltable lookup.
+		 */
+		if (l2len != 0) {
+			bzero(&ro, sizeof(ro));
+			ro.ro_prepend = l2hdr;
+			ro.ro_plen = l2len;
+			rop = &ro;
+		}
+	} else {
+		ftgen = flowtable_gen(AF_INET, M_GETFIB(m));
+		if (ip_findroute(&nh, dest, m) != 0)
+			return (NULL);	/* icmp unreach already sent */
+		flowtable_insert_nh4(M_GETFIB(m), dest, &nh, ftgen);
+	}
+#endif /* __rtems__ */
 
 	/*
 	 * Step 5: outgoing firewall packet processing
@@ -342,6 +374,9 @@ forwardlocal:
 			m_tag_delete(m, fwd_tag);
 			m->m_flags &= ~M_IP_NEXTHOP;
 		}
+#ifdef __rtems__
+		rop = NULL;
+#endif /* __rtems__ */
 		if (ip_findroute(&nh, dest, m) != 0)
 			return (NULL);	/* icmp unreach already sent */
 	}
@@ -370,8 +405,13 @@ passout:
 		 * Send off the packet via outgoing interface
 		 */
 		IP_PROBE(send, NULL, NULL, ip, nh.nh_ifp, ip, NULL);
+#ifndef __rtems__
 		error = (*nh.nh_ifp->if_output)(nh.nh_ifp, m,
 		    (struct sockaddr *)&dst, NULL);
+#else /* __rtems__ */
+		error = (*nh.nh_ifp->if_output)(nh.nh_ifp, m,
+		    (struct sockaddr *)&dst, rop);
+#endif /* __rtems__ */
 	} else {
 		/*
 		 * Handle EMSGSIZE with icmp reply needfrag for TCP MTU discovery
@@ -406,8 +446,13 @@ passout:
 				    mtod(m, struct ip *), nh.nh_ifp,
 				    mtod(m, struct ip *), NULL);
 				/* XXX: we can use cached route here */
+#ifndef __rtems__
 				error = (*nh.nh_ifp->if_output)(nh.nh_ifp, m,
 				    (struct sockaddr *)&dst, NULL);
+#else /* __rtems__ */
+				error = (*nh.nh_ifp->if_output)(nh.nh_ifp, m,
+				    (struct sockaddr *)&dst, rop);
+#endif /* __rtems__ */
 				if (error)
 					break;
 			} while ((m = m0) != NULL);
@@ -456,6 +456,9 @@ ip_input(struct mbuf *m)
 	uint16_t sum, ip_len;
 	int dchg = 0;				/* dest changed after fw */
 	struct in_addr odst;			/* original dst address */
+#ifdef __rtems__
+	struct epoch_tracker et;
+#endif /* __rtems__ */
 
 	M_ASSERTPKTHDR(m);
 
@@ -680,6 +683,9 @@ passin:
 	 * Check for exact addresses in the hash bucket.
 	 */
 	/* IN_IFADDR_RLOCK(); */
+#ifdef __rtems__
+	NET_EPOCH_ENTER(et);
+#endif /* __rtems__ */
 	LIST_FOREACH(ia, INADDR_HASH(ip->ip_dst.s_addr), ia_hash) {
 		/*
 		 * If the address matches, verify that the packet
@@ -692,10 +698,16 @@ passin:
 			counter_u64_add(ia->ia_ifa.ifa_ibytes,
 			    m->m_pkthdr.len);
 			/* IN_IFADDR_RUNLOCK(); */
+#ifdef __rtems__
+			NET_EPOCH_EXIT(et);
+#endif /* __rtems__ */
 			goto ours;
 		}
 	}
 	/* IN_IFADDR_RUNLOCK(); */
+#ifdef __rtems__
+	NET_EPOCH_EXIT(et);
+#endif /* __rtems__ */
 
 	/*
 	 * Check for broadcast addresses.
@@ -706,7 +718,11 @@ passin:
 	 * into the stack for SIMPLEX interfaces handled by ether_output().
 	 */
 	if (ifp != NULL && ifp->if_flags & IFF_BROADCAST) {
+#ifndef __rtems__
 		IF_ADDR_RLOCK(ifp);
+#else /* __rtems__ */
+		NET_EPOCH_ENTER(et);
+#endif /* __rtems__ */
 	        TAILQ_FOREACH(ifa, &ifp->if_addrhead, ifa_link) {
 			if (ifa->ifa_addr->sa_family != AF_INET)
 				continue;
@@ -716,7 +732,11 @@ passin:
 				counter_u64_add(ia->ia_ifa.ifa_ipackets, 1);
 				counter_u64_add(ia->ia_ifa.ifa_ibytes,
 				    m->m_pkthdr.len);
+#ifndef __rtems__
 				IF_ADDR_RUNLOCK(ifp);
+#else /* __rtems__ */
+				NET_EPOCH_EXIT(et);
+#endif /* __rtems__ */
 				goto ours;
 			}
 #ifdef BOOTP_COMPAT
@@ -724,12 +744,20 @@ passin:
 				counter_u64_add(ia->ia_ifa.ifa_ipackets, 1);
 				counter_u64_add(ia->ia_ifa.ifa_ibytes,
 				    m->m_pkthdr.len);
+#ifndef __rtems__
 				IF_ADDR_RUNLOCK(ifp);
+#else /* __rtems__ */
+				NET_EPOCH_EXIT(et);
+#endif /* __rtems__ */
 				goto ours;
 			}
 #endif
 		}
+#ifndef __rtems__
 		IF_ADDR_RUNLOCK(ifp);
+#else /* __rtems__ */
+		NET_EPOCH_EXIT(et);
+#endif /* __rtems__ */
 		ia = NULL;
 	}
 	/* RFC 3927 2.7: Do not forward datagrams for 169.254.0.0/16. */
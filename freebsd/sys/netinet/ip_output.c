@@ -610,7 +610,12 @@ sendit:
 	}
 
 	m->m_pkthdr.csum_flags |= CSUM_IP;
+#ifndef __rtems__
 	if (m->m_pkthdr.csum_flags & CSUM_DELAY_DATA & ~ifp->if_hwassist) {
+#else /* __rtems__ */
+	if (m->m_pkthdr.csum_flags & CSUM_DELAY_DATA &
+	    ~IF_GSO_HWASSIST(ifp, m)) {
+#endif /* __rtems__ */
 		in_delayed_cksum(m);
 		m->m_pkthdr.csum_flags &= ~CSUM_DELAY_DATA;
 	}
@@ -625,8 +630,13 @@ sendit:
 	 * If small enough for interface, or the interface will take
 	 * care of the fragmentation for us, we can just send directly.
 	 */
+#ifndef __rtems__
 	if (ip_len <= mtu ||
 	    (m->m_pkthdr.csum_flags & ifp->if_hwassist & CSUM_TSO) != 0) {
+#else /* __rtems__ */
+	if (ip_len <= mtu ||
+	    (m->m_pkthdr.csum_flags & IF_GSO_HWASSIST(ifp, m) & CSUM_TSO) != 0) {
+#endif /* __rtems__ */
 		ip->ip_sum = 0;
 		if (m->m_pkthdr.csum_flags & CSUM_IP & ~ifp->if_hwassist) {
 			ip->ip_sum = in_cksum(m, hlen);
@@ -46,6 +46,9 @@ __FBSDID("$FreeBSD$");
 #include <sys/malloc.h>
 #include <sys/lock.h>
 #include <sys/mutex.h>
+#ifdef __rtems__
+#include <sys/rmlock.h>
+#endif /* __rtems__ */
 #include <sys/sysctl.h>
 
 #include <net/rss_config.h>
@@ -62,28 +65,67 @@ __FBSDID("$FreeBSD$");
 
 SYSCTL_DECL(_net_inet_ip);
 
+#ifdef __rtems__
+static MALLOC_DEFINE(M_IPREASS, "ipreass", "IP reassembly hash table");
+#endif /* __rtems__ */
+
 /*
  * Reassembly headers are stored in hash buckets.
  */
+#ifndef __rtems__
 #define	IPREASS_NHASH_LOG2	6
+#else /* __rtems__ */
+/*
+ * The number of buckets can be changed at run time, the table is protected
+ * by a read-mostly lock which is only write locked to replace the table.
+ */
+#define	IPREASS_NHASH_LOG2	8
+#endif /* __rtems__ */
 #define	IPREASS_NHASH		(1 << IPREASS_NHASH_LOG2)
+#ifndef __rtems__
 #define	IPREASS_HMASK		(IPREASS_NHASH - 1)
+#else /* __rtems__ */
+#define	IPREASS_NHASH_MAX	(1 << 16)
+#endif /* __rtems__ */
 
 struct ipqbucket {
 	TAILQ_HEAD(ipqhead, ipq) head;
 	struct mtx		 lock;
+#ifdef __rtems__
+	int			 count;
+#endif /* __rtems__ */
 };
 
+#ifndef __rtems__
 static VNET_DEFINE(struct ipqbucket, ipq[IPREASS_NHASH]);
+#else /* __rtems__ */
+static VNET_DEFINE(struct ipqbucket *, ipq);
+#endif /* __rtems__ */
 #define	V_ipq		VNET(ipq)
+#ifdef __rtems__
+static VNET_DEFINE(u_int, ipq_hashsize);
+#define	V_ipq_hashsize	VNET(ipq_hashsize)
+#endif /* __rtems__ */
 static VNET_DEFINE(uint32_t, ipq_hashseed);
 #define V_ipq_hashseed   VNET(ipq_hashseed)
+#ifdef __rtems__
+static VNET_DEFINE(struct rmlock, ipq_hashlock);
+#define	V_ipq_hashlock	VNET(ipq_hashlock)
+#endif /* __rtems__ */
 
 #define	IPQ_LOCK(i)	mtx_lock(&V_ipq[i].lock)
 #define	IPQ_TRYLOCK(i)	mtx_trylock(&V_ipq[i].lock)
 #define	IPQ_UNLOCK(i)	mtx_unlock(&V_ipq[i].lock)
 #define	IPQ_LOCK_ASSERT(i)	mtx_assert(&V_ipq[i].lock, MA_OWNED)
 
+#ifdef __rtems__
+#define	IPQ_HASH_RLOCK_TRACKER	struct rm_priotracker ipq_hash_tracker
+#define	IPQ_HASH_RLOCK()	rm_rlock(&V_ipq_hashlock, &ipq_hash_tracker)
+#define	IPQ_HASH_RUNLOCK()	rm_runlock(&V_ipq_hashlock, &ipq_hash_tracker)
+#define	IPQ_HASH_WLOCK()	rm_wlock(&V_ipq_hashlock)
+#define	IPQ_HASH_WUNLOCK()	rm_wunlock(&V_ipq_hashlock)
+#endif /* __rtems__ */
+
 void		ipreass_init(void);
 void		ipreass_drain(void);
 void		ipreass_slowtimo(void);
@@ -91,11 +133,21 @@ void		ipreass_slowtimo(void);
 void		ipreass_destroy(void);
 #endif
 static int	sysctl_maxfragpackets(SYSCTL_HANDLER_ARGS);
+#ifdef __rtems__
+static int	sysctl_maxfragbucketsize(SYSCTL_HANDLER_ARGS);
+static int	sysctl_reass_hashsize(SYSCTL_HANDLER_ARGS);
+#endif /* __rtems__ */
 static void	ipreass_zone_change(void *);
 static void	ipreass_drain_tomax(void);
+#ifndef __rtems__
 static void	ipq_free(struct ipqhead *, struct ipq *);
+#else /* __rtems__ */
+static void	ipreass_bucketmax_update(void);
+static void	ipq_free(struct ipqbucket *, struct ipq *);
+#endif /* __rtems__ */
 static struct ipq * ipq_reuse(int);
 
+#ifndef __rtems__
 static inline void
 ipq_timeout(struct ipqhead *head, struct ipq *fp)
 {
@@ -111,6 +163,32 @@ ipq_drop(struct ipqhead *head, struct ipq *fp)
 	IPSTAT_ADD(ips_fragdropped, fp->ipq_nfrags);
 	ipq_free(head, fp);
 }
+#else /* __rtems__ */
+static inline void
+ipq_timeout(struct ipqbucket *bucket, struct ipq *fp)
+{
+
+	IPSTAT_ADD(ips_fragtimeout, fp->ipq_nfrags);
+	ipq_free(bucket, fp);
+}
+
+static inline void
+ipq_drop(struct ipqbucket *bucket, struct ipq *fp)
+{
+
+	IPSTAT_ADD(ips_fragdropped, fp->ipq_nfrags);
+	ipq_free(bucket, fp);
+}
+
+static inline uint32_t
+ipq_hash(struct in_addr src, u_short id, u_int hashsize)
+{
+	uint32_t hash;
+
+	hash = src.s_addr ^ id;
+	return (jenkins_hash32(&hash, 1, V_ipq_hashseed) & (hashsize - 1));
+}
+#endif /* __rtems__ */
 
 static VNET_DEFINE(uma_zone_t, ipq_zone);
 #define	V_ipq_zone	VNET(ipq_zone)
@@ -130,6 +208,26 @@ SYSCTL_INT(_net_inet_ip, OID_AUTO, maxfragsperpacket, CTLFLAG_VNET | CTLFLAG_RW,
     &VNET_NAME(maxfragsperpacket), 0,
     "Maximum number of IPv4 fragments allowed per packet");
 
+#ifdef __rtems__
+/*
+ * Limit of reassembly queues per hash bucket.  A new queue in a full bucket
+ * replaces the oldest queue of the bucket.  The limit is derived from the
+ * maximum number of queues unless it is set explicitly.
+ */
+static VNET_DEFINE(int, ipreass_maxbucketsize);
+#define	V_ipreass_maxbucketsize	VNET(ipreass_maxbucketsize)
+static VNET_DEFINE(int, ipreass_bucketmax);
+#define	V_ipreass_bucketmax	VNET(ipreass_bucketmax)
+SYSCTL_PROC(_net_inet_ip, OID_AUTO, maxfragbucketsize, CTLFLAG_VNET |
+    CTLTYPE_INT | CTLFLAG_RW, NULL, 0, sysctl_maxfragbucketsize, "I",
+    "Maximum number of IPv4 fragment reassembly queue entries per bucket"
+    " (0 derives it from maxfragpackets)");
+
+SYSCTL_PROC(_net_inet_ip, OID_AUTO, reass_hashsize, CTLFLAG_VNET |
+    CTLTYPE_INT | CTLFLAG_RW, NULL, 0, sysctl_reass_hashsize, "I",
+    "Number of IPv4 fragment reassembly hash buckets (power of 2)");
+#endif /* __rtems__ */
+
 /*
  * Take incoming datagram fragment and try to reassemble it into
  * whole datagram.  If the argument is the first fragment or one
@@ -144,6 +242,9 @@ SYSCTL_INT(_net_inet_ip, OID_AUTO, maxfragsperpacket, CTLFLAG_VNET | CTLFLAG_RW,
 struct mbuf *
 ip_reass(struct mbuf *m)
 {
+#ifdef __rtems__
+	IPQ_HASH_RLOCK_TRACKER;
+#endif /* __rtems__ */
 	struct ip *ip;
 	struct mbuf *p, *q, *nq, *t;
 	struct ipq *fp;
@@ -204,8 +305,13 @@ ip_reass(struct mbuf *m)
 	m->m_data += hlen;
 	m->m_len -= hlen;
 
+#ifndef __rtems__
 	hash = ip->ip_src.s_addr ^ ip->ip_id;
 	hash = jenkins_hash32(&hash, 1, V_ipq_hashseed) & IPREASS_HMASK;
+#else /* __rtems__ */
+	IPQ_HASH_RLOCK();
+	hash = ipq_hash(ip->ip_src, ip->ip_id, V_ipq_hashsize);
+#endif /* __rtems__ */
 	head = &V_ipq[hash].head;
 	IPQ_LOCK(hash);
 
@@ -226,7 +332,18 @@ ip_reass(struct mbuf *m)
 	 * If first fragment to arrive, create a reassembly queue.
 	 */
 	if (fp == NULL) {
+#ifndef __rtems__
 		fp = uma_zalloc(V_ipq_zone, M_NOWAIT);
+#else /* __rtems__ */
+		/*
+		 * In a full bucket ipq_reuse() takes the oldest queue of
+		 * this bucket.
+		 */
+		if (V_ipq[hash].count < V_ipreass_bucketmax)
+			fp = uma_zalloc(V_ipq_zone, M_NOWAIT);
+		else
+			IPSTAT_INC(ips_reassbucketfull);
+#endif /* __rtems__ */
 		if (fp == NULL)
 			fp = ipq_reuse(hash);
 #ifdef MAC
@@ -238,6 +355,9 @@ ip_reass(struct mbuf *m)
 		mac_ipq_create(m, fp);
 #endif
 		TAILQ_INSERT_HEAD(head, fp, ipq_list);
+#ifdef __rtems__
+		V_ipq[hash].count++;
+#endif /* __rtems__ */
 		fp->ipq_nfrags = 1;
 		fp->ipq_ttl = IPFRAGTTL;
 		fp->ipq_p = ip->ip_p;
@@ -245,6 +365,10 @@ ip_reass(struct mbuf *m)
 		fp->ipq_src = ip->ip_src;
 		fp->ipq_dst = ip->ip_dst;
 		fp->ipq_frags = m;
+#ifdef __rtems__
+		fp->ipq_tail = m;
+		fp->ipq_hole = (ip->ip_off != 0);
+#endif /* __rtems__ */
 		m->m_nextpkt = NULL;
 		goto done;
 	} else {
@@ -272,6 +396,31 @@ ip_reass(struct mbuf *m)
 	if (ecn == IPTOS_ECN_NOTECT && ecn0 != IPTOS_ECN_NOTECT)
 		goto dropfrag;
 
+#ifdef __rtems__
+	/*
+	 * Fragments usually arrive in order.  If this one begins at or
+	 * after the end of the last fragment, append it without a walk
+	 * of the fragment list.  There is nothing to trim in this case.
+	 */
+	p = fp->ipq_tail;
+	next = ntohs(GETIP(p)->ip_off) + ntohs(GETIP(p)->ip_len);
+	if (next <= ntohs(ip->ip_off)) {
+		IPSTAT_INC(ips_fragappended);
+		if (next != ntohs(ip->ip_off))
+			fp->ipq_hole = 1;
+		m->m_nextpkt = NULL;
+		p->m_nextpkt = m;
+		fp->ipq_tail = m;
+		if (fp->ipq_hole || (m->m_flags & M_IP_FRAG) != 0) {
+			if (fp->ipq_nfrags > V_maxfragsperpacket)
+				ipq_drop(&V_ipq[hash], fp);
+			goto done;
+		}
+		next = ntohs(ip->ip_off) + ntohs(ip->ip_len);
+		goto complete;
+	}
+
+#endif /* __rtems__ */
 	/*
 	 * Find a segment which begins after this one does.
 	 */
@@ -327,6 +476,10 @@ ip_reass(struct mbuf *m)
 		fp->ipq_nfrags--;
 		m_freem(q);
 	}
+#ifdef __rtems__
+	if (m->m_nextpkt == NULL)
+		fp->ipq_tail = m;
+#endif /* __rtems__ */
 
 	/*
 	 * Check for complete reassembly and perform frag per packet
@@ -341,19 +494,36 @@ ip_reass(struct mbuf *m)
 	next = 0;
 	for (p = NULL, q = fp->ipq_frags; q; p = q, q = q->m_nextpkt) {
 		if (ntohs(GETIP(q)->ip_off) != next) {
+#ifdef __rtems__
+			fp->ipq_hole = 1;
+#endif /* __rtems__ */
 			if (fp->ipq_nfrags > V_maxfragsperpacket)
+#ifndef __rtems__
 				ipq_drop(head, fp);
+#else /* __rtems__ */
+				ipq_drop(&V_ipq[hash], fp);
+#endif /* __rtems__ */
 			goto done;
 		}
 		next += ntohs(GETIP(q)->ip_len);
 	}
+#ifdef __rtems__
+	fp->ipq_hole = 0;
+#endif /* __rtems__ */
 	/* Make sure the last packet didn't have the IP_MF flag */
 	if (p->m_flags & M_IP_FRAG) {
 		if (fp->ipq_nfrags > V_maxfragsperpacket)
+#ifndef __rtems__
 			ipq_drop(head, fp);
+#else /* __rtems__ */
+			ipq_drop(&V_ipq[hash], fp);
+#endif /* __rtems__ */
 		goto done;
 	}
 
+#ifdef __rtems__
+complete:
+#endif /* __rtems__ */
 	/*
 	 * Reassembly is complete.  Make sure the packet is a sane size.
 	 */
@@ -361,7 +531,11 @@ ip_reass(struct mbuf *m)
 	ip = GETIP(q);
 	if (next + (ip->ip_hl << 2) > IP_MAXPACKET) {
 		IPSTAT_INC(ips_toolong);
+#ifndef __rtems__
 		ipq_drop(head, fp);
+#else /* __rtems__ */
+		ipq_drop(&V_ipq[hash], fp);
+#endif /* __rtems__ */
 		goto done;
 	}
 
@@ -403,6 +577,9 @@ ip_reass(struct mbuf *m)
 	ip->ip_src = fp->ipq_src;
 	ip->ip_dst = fp->ipq_dst;
 	TAILQ_REMOVE(head, fp, ipq_list);
+#ifdef __rtems__
+	V_ipq[hash].count--;
+#endif /* __rtems__ */
 	uma_zfree(V_ipq_zone, fp);
 	m->m_len += (ip->ip_hl << 2);
 	m->m_data -= (ip->ip_hl << 2);
@@ -411,6 +588,9 @@ ip_reass(struct mbuf *m)
 		m_fixhdr(m);
 	IPSTAT_INC(ips_reassembled);
 	IPQ_UNLOCK(hash);
+#ifdef __rtems__
+	IPQ_HASH_RUNLOCK();
+#endif /* __rtems__ */
 
 #ifdef	RSS
 	/*
@@ -453,11 +633,46 @@ dropfrag:
 	m_freem(m);
 done:
 	IPQ_UNLOCK(hash);
+#ifdef __rtems__
+	IPQ_HASH_RUNLOCK();
+#endif /* __rtems__ */
 	return (NULL);
 
 #undef GETIP
 }
 
+#ifdef __rtems__
+/*
+ * Allocate and initialize a hash table for the reassembly headers.
+ */
+static struct ipqbucket *
+ipreass_hash_alloc(u_int hashsize)
+{
+	struct ipqbucket *buckets;
+
+	buckets = malloc(hashsize * sizeof(*buckets), M_IPREASS,
+	    M_WAITOK | M_ZERO);
+	for (u_int i = 0; i < hashsize; i++) {
+		TAILQ_INIT(&buckets[i].head);
+		mtx_init(&buckets[i].lock, "IP reassembly", NULL,
+		    MTX_DEF | MTX_DUPOK);
+	}
+	return (buckets);
+}
+
+static void
+ipreass_hash_free(struct ipqbucket *buckets, u_int hashsize)
+{
+
+	for (u_int i = 0; i < hashsize; i++) {
+		KASSERT(TAILQ_EMPTY(&buckets[i].head),
+		    ("%s: bucket %u not empty", __func__, i));
+		mtx_destroy(&buckets[i].lock);
+	}
+	free(buckets, M_IPREASS);
+}
+#endif /* __rtems__ */
+
 /*
  * Initialize IP reassembly structures.
  */
@@ -465,16 +680,25 @@ void
 ipreass_init(void)
 {
 
+#ifndef __rtems__
 	for (int i = 0; i < IPREASS_NHASH; i++) {
 		TAILQ_INIT(&V_ipq[i].head);
 		mtx_init(&V_ipq[i].lock, "IP reassembly", NULL,
 		    MTX_DEF | MTX_DUPOK);
 	}
+#else /* __rtems__ */
+	V_ipq_hashsize = IPREASS_NHASH;
+	V_ipq = ipreass_hash_alloc(V_ipq_hashsize);
+	rm_init(&V_ipq_hashlock, "IP reassembly hash");
+#endif /* __rtems__ */
 	V_ipq_hashseed = arc4random();
 	V_maxfragsperpacket = 16;
 	V_ipq_zone = uma_zcreate("ipq", sizeof(struct ipq), NULL, NULL, NULL,
 	    NULL, UMA_ALIGN_PTR, 0);
 	uma_zone_set_max(V_ipq_zone, nmbclusters / 32);
+#ifdef __rtems__
+	ipreass_bucketmax_update();
+#endif /* __rtems__ */
 
 	if (IS_DEFAULT_VNET(curvnet))
 		EVENTHANDLER_REGISTER(nmbclusters_change, ipreass_zone_change,
@@ -487,15 +711,30 @@ ipreass_init(void)
 void
 ipreass_slowtimo(void)
 {
+#ifdef __rtems__
+	IPQ_HASH_RLOCK_TRACKER;
+#endif /* __rtems__ */
 	struct ipq *fp, *tmp;
 
+#ifndef __rtems__
 	for (int i = 0; i < IPREASS_NHASH; i++) {
+#else /* __rtems__ */
+	IPQ_HASH_RLOCK();
+	for (u_int i = 0; i < V_ipq_hashsize; i++) {
+#endif /* __rtems__ */
 		IPQ_LOCK(i);
 		TAILQ_FOREACH_SAFE(fp, &V_ipq[i].head, ipq_list, tmp)
 		if (--fp->ipq_ttl == 0)
+#ifndef __rtems__
 				ipq_timeout(&V_ipq[i].head, fp);
+#else /* __rtems__ */
+				ipq_timeout(&V_ipq[i], fp);
+#endif /* __rtems__ */
 		IPQ_UNLOCK(i);
 	}
+#ifdef __rtems__
+	IPQ_HASH_RUNLOCK();
+#endif /* __rtems__ */
 }
 
 /*
@@ -504,13 +743,28 @@ ipreass_slowtimo(void)
 void
 ipreass_drain(void)
 {
+#ifdef __rtems__
+	IPQ_HASH_RLOCK_TRACKER;
+#endif /* __rtems__ */
 
+#ifndef __rtems__
 	for (int i = 0; i < IPREASS_NHASH; i++) {
+#else /* __rtems__ */
+	IPQ_HASH_RLOCK();
+	for (u_int i = 0; i < V_ipq_hashsize; i++) {
+#endif /* __rtems__ */
 		IPQ_LOCK(i);
 		while(!TAILQ_EMPTY(&V_ipq[i].head))
+#ifndef __rtems__
 			ipq_drop(&V_ipq[i].head, TAILQ_FIRST(&V_ipq[i].head));
+#else /* __rtems__ */
+			ipq_drop(&V_ipq[i], TAILQ_FIRST(&V_ipq[i].head));
+#endif /* __rtems__ */
 		IPQ_UNLOCK(i);
 	}
+#ifdef __rtems__
+	IPQ_HASH_RUNLOCK();
+#endif /* __rtems__ */
 }
 
 #ifdef VIMAGE
@@ -523,8 +777,13 @@ ipreass_destroy(void)
 
 	ipreass_drain();
 	uma_zdestroy(V_ipq_zone);
+#ifndef __rtems__
 	for (int i = 0; i < IPREASS_NHASH; i++)
 		mtx_destroy(&V_ipq[i].lock);
+#else /* __rtems__ */
+	ipreass_hash_free(V_ipq, V_ipq_hashsize);
+	rm_destroy(&V_ipq_hashlock);
+#endif /* __rtems__ */
 }
 #endif
 
@@ -536,6 +795,9 @@ ipreass_destroy(void)
 static void
 ipreass_drain_tomax(void)
 {
+#ifdef __rtems__
+	IPQ_HASH_RLOCK_TRACKER;
+#endif /* __rtems__ */
 	int target;
 
 	/*
@@ -544,25 +806,65 @@ ipreass_drain_tomax(void)
 	 * stripping off last elements on queues.  Every
 	 * run we strip the oldest element from each bucket.
 	 */
+#ifdef __rtems__
+	IPQ_HASH_RLOCK();
+#endif /* __rtems__ */
 	target = uma_zone_get_max(V_ipq_zone);
 	while (uma_zone_get_cur(V_ipq_zone) > target) {
 		struct ipq *fp;
 
+#ifndef __rtems__
 		for (int i = 0; i < IPREASS_NHASH; i++) {
+#else /* __rtems__ */
+		for (u_int i = 0; i < V_ipq_hashsize; i++) {
+#endif /* __rtems__ */
 			IPQ_LOCK(i);
 			fp = TAILQ_LAST(&V_ipq[i].head, ipqhead);
 			if (fp != NULL)
+#ifndef __rtems__
 				ipq_timeout(&V_ipq[i].head, fp);
+#else /* __rtems__ */
+				ipq_timeout(&V_ipq[i], fp);
+#endif /* __rtems__ */
 			IPQ_UNLOCK(i);
 		}
 	}
+#ifdef __rtems__
+	IPQ_HASH_RUNLOCK();
+#endif /* __rtems__ */
 }
 
+#ifdef __rtems__
+/*
+ * Recompute the number of reassembly queues allowed per bucket.  Unless
+ * set explicitly, each bucket may hold twice its share of the maximum.
+ */
+static void
+ipreass_bucketmax_update(void)
+{
+	int max;
+
+	if (V_ipreass_maxbucketsize > 0) {
+		V_ipreass_bucketmax = V_ipreass_maxbucketsize;
+		return;
+	}
+	max = uma_zone_get_max(V_ipq_zone);
+	if (max == 0)
+		V_ipreass_bucketmax = INT_MAX;
+	else
+		V_ipreass_bucketmax = imax(max / imax(V_ipq_hashsize / 2, 1),
+		    1);
+}
+#endif /* __rtems__ */
+
 static void
 ipreass_zone_change(void *tag)
 {
 
 	uma_zone_set_max(V_ipq_zone, nmbclusters / 32);
+#ifdef __rtems__
+	ipreass_bucketmax_update();
+#endif /* __rtems__ */
 	ipreass_drain_tomax();
 }
 
@@ -591,6 +893,9 @@ sysctl_maxfragpackets(SYSCTL_HANDLER_ARGS)
 		 * and place an extreme upper bound.
 		 */
 		max = uma_zone_set_max(V_ipq_zone, max);
+#ifdef __rtems__
+		ipreass_bucketmax_update();
+#endif /* __rtems__ */
 		ipreass_drain_tomax();
 		V_noreass = 0;
 	} else if (max == 0) {
@@ -599,11 +904,76 @@ sysctl_maxfragpackets(SYSCTL_HANDLER_ARGS)
 	} else if (max == -1) {
 		V_noreass = 0;
 		uma_zone_set_max(V_ipq_zone, 0);
+#ifdef __rtems__
+		ipreass_bucketmax_update();
+#endif /* __rtems__ */
 	} else
 		return (EINVAL);
 	return (0);
 }
 
+#ifdef __rtems__
+static int
+sysctl_maxfragbucketsize(SYSCTL_HANDLER_ARGS)
+{
+	int error, max;
+
+	max = V_ipreass_maxbucketsize;
+	error = sysctl_handle_int(oidp, &max, 0, req);
+	if (error || !req->newptr)
+		return (error);
+	if (max < 0)
+		return (EINVAL);
+	V_ipreass_maxbucketsize = max;
+	ipreass_bucketmax_update();
+	return (0);
+}
+
+/*
+ * Replace the hash table.  The reassembly queues are moved to the new table
+ * with the oldest queue of each bucket first, so that the buckets of the new
+ * table keep the oldest queues at their tail.
+ */
+static int
+sysctl_reass_hashsize(SYSCTL_HANDLER_ARGS)
+{
+	struct ipqbucket *nbuckets, *obuckets;
+	struct ipq *fp;
+	u_int ohashsize;
+	uint32_t hash;
+	int error, hashsize;
+
+	hashsize = V_ipq_hashsize;
+	error = sysctl_handle_int(oidp, &hashsize, 0, req);
+	if (error || !req->newptr)
+		return (error);
+	if (hashsize <= 0 || hashsize > IPREASS_NHASH_MAX ||
+	    !powerof2(hashsize))
+		return (EINVAL);
+	if ((u_int)hashsize == V_ipq_hashsize)
+		return (0);
+
+	nbuckets = ipreass_hash_alloc(hashsize);
+	IPQ_HASH_WLOCK();
+	obuckets = V_ipq;
+	ohashsize = V_ipq_hashsize;
+	for (u_int i = 0; i < ohashsize; i++) {
+		while ((fp = TAILQ_LAST(&obuckets[i].head, ipqhead)) != NULL) {
+			TAILQ_REMOVE(&obuckets[i].head, fp, ipq_list);
+			hash = ipq_hash(fp->ipq_src, fp->ipq_id, hashsize);
+			TAILQ_INSERT_HEAD(&nbuckets[hash].head, fp, ipq_list);
+			nbuckets[hash].count++;
+		}
+	}
+	V_ipq = nbuckets;
+	V_ipq_hashsize = hashsize;
+	ipreass_bucketmax_update();
+	IPQ_HASH_WUNLOCK();
+	ipreass_hash_free(obuckets, ohashsize);
+	return (0);
+}
+#endif /* __rtems__ */
+
 /*
  * Seek for old fragment queue header that can be reused.  Try to
  * reuse a header from currently locked hash bucket.
@@ -617,7 +987,11 @@ ipq_reuse(int start)
 	IPQ_LOCK_ASSERT(start);
 
 	for (i = start;; i++) {
+#ifndef __rtems__
 		if (i == IPREASS_NHASH)
+#else /* __rtems__ */
+		if (i == (int)V_ipq_hashsize)
+#endif /* __rtems__ */
 			i = 0;
 		if (i != start && IPQ_TRYLOCK(i) == 0)
 			continue;
@@ -632,6 +1006,9 @@ ipq_reuse(int start)
 				m_freem(m);
 			}
 			TAILQ_REMOVE(&V_ipq[i].head, fp, ipq_list);
+#ifdef __rtems__
+			V_ipq[i].count--;
+#endif /* __rtems__ */
 			if (i != start)
 				IPQ_UNLOCK(i);
 			IPQ_LOCK_ASSERT(start);
@@ -645,8 +1022,13 @@ ipq_reuse(int start)
 /*
  * Free a fragment reassembly header and all associated datagrams.
  */
+#ifndef __rtems__
 static void
 ipq_free(struct ipqhead *fhp, struct ipq *fp)
+#else /* __rtems__ */
+static void
+ipq_free(struct ipqbucket *bucket, struct ipq *fp)
+#endif /* __rtems__ */
 {
 	struct mbuf *q;
 
@@ -655,6 +1037,11 @@ ipq_free(struct ipqhead *fhp, struct ipq *fp)
 		fp->ipq_frags = q->m_nextpkt;
 		m_freem(q);
 	}
+#ifndef __rtems__
 	TAILQ_REMOVE(fhp, fp, ipq_list);
+#else /* __rtems__ */
+	TAILQ_REMOVE(&bucket->head, fp, ipq_list);
+	bucket->count--;
+#endif /* __rtems__ */
 	uma_zfree(V_ipq_zone, fp);
 }
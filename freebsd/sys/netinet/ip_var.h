@@ -61,6 +61,10 @@ struct ipq {
 	struct mbuf *ipq_frags;		/* to ip headers of fragments */
 	struct	in_addr ipq_src,ipq_dst;
 	u_char	ipq_nfrags;		/* # frags in this packet */
+#ifdef __rtems__
+	u_char	ipq_hole;		/* frags are not contiguous */
+	struct mbuf *ipq_tail;		/* last fragment */
+#endif /* __rtems__ */
 	struct label *ipq_label;	/* MAC label */
 };
 #endif /* _KERNEL */
@@ -94,6 +98,10 @@ struct ip_moptions {
 	struct	in_multi **imo_membership;	/* group memberships */
 	struct	in_mfilter *imo_mfilters;	/* source filters */
 	STAILQ_ENTRY(ip_moptions) imo_link;
+#ifdef __rtems__
+	u_short	*imo_hash;		/* membership index + 1 by group */
+	u_short	imo_hashmask;		/* imo_hash size - 1 */
+#endif /* __rtems__ */
 };
 
 struct	ipstat {
@@ -126,6 +134,10 @@ struct	ipstat {
 	uint64_t ips_notmember;		/* multicasts for unregistered grps */
 	uint64_t ips_nogif;		/* no match gif found */
 	uint64_t ips_badaddr;		/* invalid address on header */
+#ifdef __rtems__
+	uint64_t ips_fragappended;	/* frags appended in order */
+	uint64_t ips_reassbucketfull;	/* reass queues dropped, bucket full */
+#endif /* __rtems__ */
 };
 
 #ifdef _KERNEL
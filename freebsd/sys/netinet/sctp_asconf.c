@@ -2435,6 +2435,7 @@ sctp_is_addr_pending(struct sctp_tcb *stcb, struct sctp_ifa *sctp_ifa)
 static struct sockaddr *
 sctp_find_valid_localaddr(struct sctp_tcb *stcb, int addr_locked)
 {
+	SCTP_IPI_ADDR_RLOCK_TRACKER;
 	struct sctp_vrf *vrf = NULL;
 	struct sctp_ifn *sctp_ifn;
 	struct sctp_ifa *sctp_ifa;
@@ -3055,6 +3056,7 @@ sctp_check_address_list_all(struct sctp_tcb *stcb, struct mbuf *m, int offset,
     uint16_t local_scope, uint16_t site_scope,
     uint16_t ipv4_scope, uint16_t loopback_scope)
 {
+	SCTP_IPI_ADDR_RLOCK_TRACKER;
 	struct sctp_vrf *vrf = NULL;
 	struct sctp_ifn *sctp_ifn;
 	struct sctp_ifa *sctp_ifa;
@@ -3275,6 +3277,7 @@ void
 sctp_asconf_send_nat_state_update(struct sctp_tcb *stcb,
     struct sctp_nets *net)
 {
+	SCTP_IPI_ADDR_RLOCK_TRACKER;
 	struct sctp_asconf_addr *aa;
 	struct sctp_ifa *sctp_ifap;
 	struct sctp_asconf_tag_param *vtag;
@@ -74,6 +74,18 @@ __FBSDID("$FreeBSD$");
  * SCTP_INP_INFO_RLOCK() and then when we want to add a new association to
  * the SCTP_BASE_INFO() list's we will do a SCTP_INP_INFO_WLOCK().
  */
+#ifdef __rtems__
+
+/*
+ * On RTEMS the rwlocks are exclusive, so the INP_INFO and the IPI_ADDR locks
+ * would serialize the lookups of all associations and the source address
+ * selection of all output.  They are read-mostly locks, so they use the
+ * rmlock instead.  Readers only touch a per-processor counter.  Each
+ * function which read locks them has to declare a tracker with
+ * SCTP_INP_INFO_RLOCK_TRACKER or SCTP_IPI_ADDR_RLOCK_TRACKER.  The locks are
+ * recursive, since some paths read lock them twice.
+ */
+#endif /* __rtems__ */
 
 extern struct sctp_foo_stuff sctp_logoff[];
 extern int sctp_logoff_stuff;
@@ -85,6 +97,7 @@ extern int sctp_logoff_stuff;
 #define SCTP_STATLOG_UNLOCK()
 #define SCTP_STATLOG_DESTROY()
 
+#ifndef __rtems__
 #define SCTP_INP_INFO_LOCK_DESTROY() do { \
         if(rw_wowned(&SCTP_BASE_INFO(ipi_ep_mtx))) { \
              rw_wunlock(&SCTP_BASE_INFO(ipi_ep_mtx)); \
@@ -96,9 +109,35 @@ extern int sctp_logoff_stuff;
         rw_init(&SCTP_BASE_INFO(ipi_ep_mtx), "sctp-info");
 
 
+#define SCTP_INP_INFO_RLOCK_TRACKER
 #define SCTP_INP_INFO_RLOCK()	do { 					\
              rw_rlock(&SCTP_BASE_INFO(ipi_ep_mtx));                         \
 } while (0)
+#define SCTP_INP_INFO_WOWNED()	rw_wowned(&SCTP_BASE_INFO(ipi_ep_mtx))
+#else /* __rtems__ */
+#define SCTP_INP_INFO_LOCK_DESTROY() do { \
+        if(rm_wowned(&SCTP_BASE_INFO(ipi_ep_mtx))) { \
+             rm_wunlock(&SCTP_BASE_INFO(ipi_ep_mtx)); \
+        } \
+        rm_destroy(&SCTP_BASE_INFO(ipi_ep_mtx)); \
+      }  while (0)
+
+#define SCTP_INP_INFO_LOCK_INIT() \
+        rm_init_flags(&SCTP_BASE_INFO(ipi_ep_mtx), "sctp-info", RM_RECURSE);
+
+/*
+ * The tracker is accessed through a pointer, so that a function may drop
+ * and retake the read lock of its caller, see
+ * sctp_sysctl_copy_out_local_addresses().
+ */
+#define SCTP_INP_INFO_RLOCK_TRACKER					\
+	struct rm_priotracker sctp_inp_info_tracker_store,		\
+	    *sctp_inp_info_tracker = &sctp_inp_info_tracker_store
+#define SCTP_INP_INFO_RLOCK()	do { 					\
+	rm_rlock(&SCTP_BASE_INFO(ipi_ep_mtx), sctp_inp_info_tracker);	\
+} while (0)
+#define SCTP_INP_INFO_WOWNED()	rm_wowned(&SCTP_BASE_INFO(ipi_ep_mtx))
+#endif /* __rtems__ */
 
 #define SCTP_MCORE_QLOCK_INIT(cpstr) do { \
 		mtx_init(&(cpstr)->que_mtx,	      \
@@ -143,6 +182,7 @@ extern int sctp_logoff_stuff;
 	mtx_destroy(&(cpstr)->core_mtx);	\
 } while (0)
 
+#ifndef __rtems__
 #define SCTP_INP_INFO_WLOCK()	do { 					\
             rw_wlock(&SCTP_BASE_INFO(ipi_ep_mtx));                         \
 } while (0)
@@ -160,6 +200,7 @@ extern int sctp_logoff_stuff;
         } \
 	rw_destroy(&SCTP_BASE_INFO(ipi_addr_mtx)); \
       }  while (0)
+#define SCTP_IPI_ADDR_RLOCK_TRACKER
 #define SCTP_IPI_ADDR_RLOCK()	do { 					\
              rw_rlock(&SCTP_BASE_INFO(ipi_addr_mtx));                         \
 } while (0)
@@ -169,6 +210,36 @@ extern int sctp_logoff_stuff;
 
 #define SCTP_IPI_ADDR_RUNLOCK()		rw_runlock(&SCTP_BASE_INFO(ipi_addr_mtx))
 #define SCTP_IPI_ADDR_WUNLOCK()		rw_wunlock(&SCTP_BASE_INFO(ipi_addr_mtx))
+#else /* __rtems__ */
+#define SCTP_INP_INFO_WLOCK()	do { 					\
+	rm_wlock(&SCTP_BASE_INFO(ipi_ep_mtx));				\
+} while (0)
+
+#define SCTP_INP_INFO_RUNLOCK()						\
+	rm_runlock(&SCTP_BASE_INFO(ipi_ep_mtx), sctp_inp_info_tracker)
+#define SCTP_INP_INFO_WUNLOCK()		rm_wunlock(&SCTP_BASE_INFO(ipi_ep_mtx))
+
+#define SCTP_IPI_ADDR_INIT()						\
+	rm_init_flags(&SCTP_BASE_INFO(ipi_addr_mtx), "sctp-addr", RM_RECURSE)
+#define SCTP_IPI_ADDR_DESTROY() do  { \
+        if(rm_wowned(&SCTP_BASE_INFO(ipi_addr_mtx))) { \
+             rm_wunlock(&SCTP_BASE_INFO(ipi_addr_mtx)); \
+        } \
+	rm_destroy(&SCTP_BASE_INFO(ipi_addr_mtx)); \
+      }  while (0)
+#define SCTP_IPI_ADDR_RLOCK_TRACKER					\
+	struct rm_priotracker sctp_ipi_addr_tracker
+#define SCTP_IPI_ADDR_RLOCK()	do { 					\
+	rm_rlock(&SCTP_BASE_INFO(ipi_addr_mtx), &sctp_ipi_addr_tracker); \
+} while (0)
+#define SCTP_IPI_ADDR_WLOCK()	do { 					\
+	rm_wlock(&SCTP_BASE_INFO(ipi_addr_mtx));			\
+} while (0)
+
+#define SCTP_IPI_ADDR_RUNLOCK()						\
+	rm_runlock(&SCTP_BASE_INFO(ipi_addr_mtx), &sctp_ipi_addr_tracker)
+#define SCTP_IPI_ADDR_WUNLOCK()		rm_wunlock(&SCTP_BASE_INFO(ipi_addr_mtx))
+#endif /* __rtems__ */
 
 
 #define SCTP_IPI_ITERATOR_WQ_INIT() \
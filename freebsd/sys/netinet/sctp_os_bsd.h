@@ -59,6 +59,9 @@ __FBSDID("$FreeBSD$");
 #include <sys/uio.h>
 #include <sys/lock.h>
 #include <sys/rwlock.h>
+#ifdef __rtems__
+#include <sys/rmlock.h>
+#endif /* __rtems__ */
 #include <sys/kthread.h>
 #include <sys/priv.h>
 #include <sys/random.h>
@@ -2032,6 +2032,7 @@ sctp_add_addresses_to_i_ia(struct sctp_inpcb *inp, struct sctp_tcb *stcb,
     struct mbuf *m_at, int cnt_inits_to,
     uint16_t *padding_len, uint16_t *chunk_len)
 {
+	SCTP_IPI_ADDR_RLOCK_TRACKER;
 	struct sctp_vrf *vrf = NULL;
 	int cnt, limit_out = 0, total_count;
 	uint32_t vrf_id;
@@ -3310,6 +3311,7 @@ sctp_source_address_selection(struct sctp_inpcb *inp,
     struct sctp_nets *net,
     int non_asoc_addr_ok, uint32_t vrf_id)
 {
+	SCTP_IPI_ADDR_RLOCK_TRACKER;
 	struct sctp_ifa *answer;
 	uint8_t dest_is_priv, dest_is_loop;
 	sa_family_t fam;
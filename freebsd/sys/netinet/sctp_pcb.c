@@ -84,6 +84,7 @@ SCTP6_ARE_ADDR_EQUAL(struct sockaddr_in6 *a, struct sockaddr_in6 *b)
 void
 sctp_fill_pcbinfo(struct sctp_pcbinfo *spcb)
 {
+	SCTP_INP_INFO_RLOCK_TRACKER;
 	/*
 	 * We really don't need to lock this, but I will just because it
 	 * does not hurt.
@@ -315,6 +316,7 @@ void
 sctp_mark_ifa_addr_down(uint32_t vrf_id, struct sockaddr *addr,
     const char *if_name, uint32_t ifn_index)
 {
+	SCTP_IPI_ADDR_RLOCK_TRACKER;
 	struct sctp_vrf *vrf;
 	struct sctp_ifa *sctp_ifap;
 
@@ -359,6 +361,7 @@ void
 sctp_mark_ifa_addr_up(uint32_t vrf_id, struct sockaddr *addr,
     const char *if_name, uint32_t ifn_index)
 {
+	SCTP_IPI_ADDR_RLOCK_TRACKER;
 	struct sctp_vrf *vrf;
 	struct sctp_ifa *sctp_ifap;
 
@@ -837,6 +840,7 @@ out_now:
 static int
 sctp_does_stcb_own_this_addr(struct sctp_tcb *stcb, struct sockaddr *to)
 {
+	SCTP_IPI_ADDR_RLOCK_TRACKER;
 	int loopback_scope;
 #if defined(INET)
 	int ipv4_local_scope, ipv4_addr_legal;
@@ -1274,6 +1278,7 @@ struct sctp_tcb *
 sctp_findassociation_ep_addr(struct sctp_inpcb **inp_p, struct sockaddr *remote,
     struct sctp_nets **netp, struct sockaddr *local, struct sctp_tcb *locked_tcb)
 {
+	SCTP_INP_INFO_RLOCK_TRACKER;
 	struct sctpasochead *head;
 	struct sctp_inpcb *inp;
 	struct sctp_tcb *stcb = NULL;
@@ -1913,6 +1918,7 @@ struct sctp_inpcb *
 sctp_pcb_findep(struct sockaddr *nam, int find_tcp_pool, int have_lock,
     uint32_t vrf_id)
 {
+	SCTP_INP_INFO_RLOCK_TRACKER;
 	/*
 	 * First we check the hash table to see if someone has this port
 	 * bound with just the port.
@@ -1996,6 +2002,7 @@ sctp_findassociation_addr_sa(struct sockaddr *from, struct sockaddr *to,
     struct sctp_inpcb **inp_p, struct sctp_nets **netp, int find_tcp_pool,
     uint32_t vrf_id)
 {
+	SCTP_INP_INFO_RLOCK_TRACKER;
 	struct sctp_inpcb *inp = NULL;
 	struct sctp_tcb *stcb;
 
@@ -2140,6 +2147,7 @@ sctp_findassoc_by_vtag(struct sockaddr *from, struct sockaddr *to, uint32_t vtag
     struct sctp_inpcb **inp_p, struct sctp_nets **netp, uint16_t rport,
     uint16_t lport, int skip_src_check, uint32_t vrf_id, uint32_t remote_tag)
 {
+	SCTP_INP_INFO_RLOCK_TRACKER;
 	/*
 	 * Use my vtag to hash. If we find it we then verify the source addr
 	 * is in the assoc. If all goes well we save a bit on rec of a
@@ -2153,6 +2161,15 @@ sctp_findassoc_by_vtag(struct sockaddr *from, struct sockaddr *to, uint32_t vtag
 	head = &SCTP_BASE_INFO(sctp_asochash)[SCTP_PCBHASH_ASOC(vtag,
 	    SCTP_BASE_INFO(hashasocmark))];
 	LIST_FOREACH(stcb, head, sctp_asocs) {
+#ifdef __rtems__
+		/*
+		 * Do not lock the other associations of the hash chain.  The
+		 * tag is checked again with the TCB lock held.
+		 */
+		if (stcb->asoc.my_vtag != vtag || stcb->rport != rport) {
+			continue;
+		}
+#endif /* __rtems__ */
 		SCTP_INP_RLOCK(stcb->sctp_ep);
 		if (stcb->sctp_ep->sctp_flags & SCTP_PCB_FLAGS_SOCKET_ALLGONE) {
 			SCTP_INP_RUNLOCK(stcb->sctp_ep);
@@ -6731,6 +6748,7 @@ sctp_set_primary_addr(struct sctp_tcb *stcb, struct sockaddr *sa,
 int
 sctp_is_vtag_good(uint32_t tag, uint16_t lport, uint16_t rport, struct timeval *now)
 {
+	SCTP_INP_INFO_RLOCK_TRACKER;
 	/*
 	 * This function serves two purposes. It will see if a TAG can be
 	 * re-used and return 1 for yes it is ok and 0 for don't use that
@@ -6968,6 +6986,7 @@ sctp_drain_mbufs(struct sctp_tcb *stcb)
 void
 sctp_drain()
 {
+	SCTP_INP_INFO_RLOCK_TRACKER;
 	/*
 	 * We must walk the PCB lists for ALL associations here. The system
 	 * is LOW on MBUF's and needs help. This is where reneging will
@@ -7028,6 +7047,7 @@ sctp_initiate_iterator(inp_func inpf,
     struct sctp_inpcb *s_inp,
     uint8_t chunk_output_off)
 {
+	SCTP_INP_INFO_RLOCK_TRACKER;
 	struct sctp_iterator *it = NULL;
 
 	if (af == NULL) {
@@ -193,9 +193,15 @@ struct sctp_epinfo {
 	sctp_zone_t ipi_zone_asconf;
 	sctp_zone_t ipi_zone_asconf_ack;
 
+#ifndef __rtems__
 	struct rwlock ipi_ep_mtx;
 	struct mtx ipi_iterator_wq_mtx;
 	struct rwlock ipi_addr_mtx;
+#else /* __rtems__ */
+	struct rmlock ipi_ep_mtx;
+	struct mtx ipi_iterator_wq_mtx;
+	struct rmlock ipi_addr_mtx;
+#endif /* __rtems__ */
 	struct mtx ipi_pktlog_mtx;
 	struct mtx wq_addr_mtx;
 	uint32_t ipi_count_ep;
@@ -187,7 +187,12 @@ sctp_sysctl_number_of_addresses(struct sctp_inpcb *inp)
 }
 
 static int
+#ifndef __rtems__
 sctp_sysctl_copy_out_local_addresses(struct sctp_inpcb *inp, struct sctp_tcb *stcb, struct sysctl_req *req)
+#else /* __rtems__ */
+sctp_sysctl_copy_out_local_addresses(struct sctp_inpcb *inp, struct sctp_tcb *stcb, struct sysctl_req *req,
+    struct rm_priotracker *sctp_inp_info_tracker)
+#endif /* __rtems__ */
 {
 	struct sctp_ifn *sctp_ifn;
 	struct sctp_ifa *sctp_ifa;
@@ -346,6 +351,7 @@ sctp_sysctl_copy_out_local_addresses(struct sctp_inpcb *inp, struct sctp_tcb *st
 static int
 sctp_sysctl_handle_assoclist(SYSCTL_HANDLER_ARGS)
 {
+	SCTP_INP_INFO_RLOCK_TRACKER;
 	unsigned int number_of_endpoints;
 	unsigned int number_of_local_addresses;
 	unsigned int number_of_associations;
@@ -433,7 +439,11 @@ sctp_sysctl_handle_assoclist(SYSCTL_HANDLER_ARGS)
 		}
 		SCTP_INP_INFO_RLOCK();
 		SCTP_INP_RLOCK(inp);
-		error = sctp_sysctl_copy_out_local_addresses(inp, NULL, req);
+		error = sctp_sysctl_copy_out_local_addresses(inp, NULL, req
+#ifdef __rtems__
+		    , sctp_inp_info_tracker
+#endif /* __rtems__ */
+		    );
 		if (error) {
 			SCTP_INP_DECR_REF(inp);
 			return (error);
@@ -484,7 +494,11 @@ sctp_sysctl_handle_assoclist(SYSCTL_HANDLER_ARGS)
 			}
 			SCTP_INP_INFO_RLOCK();
 			SCTP_INP_RLOCK(inp);
-			error = sctp_sysctl_copy_out_local_addresses(inp, stcb, req);
+			error = sctp_sysctl_copy_out_local_addresses(inp, stcb, req
+#ifdef __rtems__
+			    , sctp_inp_info_tracker
+#endif /* __rtems__ */
+			    );
 			if (error) {
 				SCTP_INP_DECR_REF(inp);
 				atomic_subtract_int(&stcb->asoc.refcnt, 1);
@@ -556,6 +570,7 @@ skip:
 static int
 sctp_sysctl_handle_udp_tunneling(SYSCTL_HANDLER_ARGS)
 {
+	SCTP_INP_INFO_RLOCK_TRACKER;
 	int error;
 	uint32_t old, new;
 
@@ -1247,6 +1247,7 @@ sctp_fill_up_addresses(struct sctp_inpcb *inp,
     size_t limit,
     struct sockaddr_storage *sas)
 {
+	SCTP_IPI_ADDR_RLOCK_TRACKER;
 	size_t size = 0;
 
 	SCTP_IPI_ADDR_RLOCK();
@@ -1340,6 +1341,7 @@ sctp_count_max_addresses_vrf(struct sctp_inpcb *inp, uint32_t vrf_id)
 static int
 sctp_count_max_addresses(struct sctp_inpcb *inp)
 {
+	SCTP_IPI_ADDR_RLOCK_TRACKER;
 	int cnt = 0;
 
 	SCTP_IPI_ADDR_RLOCK();
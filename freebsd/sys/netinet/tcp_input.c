@@ -1809,6 +1809,10 @@ tcp_do_segment(struct mbuf *m, struct tcphdr *th, struct socket *so,
 				else if (!tcp_timer_active(tp, TT_PERSIST))
 					tcp_timer_activate(tp, TT_REXMT,
 						      tp->t_rxtcur);
+#ifdef __rtems__
+				if ((tp->t_flags2 & (TF2_RACK | TF2_TLP)) != 0)
+					tcp_rack_ack(tp);
+#endif /* __rtems__ */
 				sowwakeup(so);
 				if (sbavail(&so->so_snd))
 					(void) tp->t_fb->tfb_tcp_output(tp);
@@ -2613,7 +2617,12 @@ tcp_do_segment(struct mbuf *m, struct tcphdr *th, struct socket *so,
 						tp->snd_cwnd += maxseg;
 					(void) tp->t_fb->tfb_tcp_output(tp);
 					goto drop;
+#ifndef __rtems__
 				} else if (tp->t_dupacks == tcprexmtthresh) {
+#else /* __rtems__ */
+				} else if (tp->t_dupacks == tcprexmtthresh ||
+				    tcp_rack_dupack(tp, &to)) {
+#endif /* __rtems__ */
 					tcp_seq onxt = tp->snd_nxt;
 
 					/*
@@ -2882,6 +2891,10 @@ process_ACK:
 		}
 		if (SEQ_LT(tp->snd_nxt, tp->snd_una))
 			tp->snd_nxt = tp->snd_una;
+#ifdef __rtems__
+		if ((tp->t_flags2 & (TF2_RACK | TF2_TLP)) != 0)
+			tcp_rack_ack(tp);
+#endif /* __rtems__ */
 
 		switch (tp->t_state) {
 
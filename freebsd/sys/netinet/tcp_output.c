@@ -1497,6 +1497,16 @@ out:
 				tp->t_rtseq = startseq;
 				TCPSTAT_INC(tcps_segstimed);
 			}
+#ifdef __rtems__
+			/*
+			 * A new tail was sent, probe it instead of waiting
+			 * for the retransmit timer.
+			 */
+			if ((tp->t_flags2 & TF2_TLP) != 0 &&
+			    (!tcp_timer_active(tp, TT_REXMT) ||
+			    (tp->t_flags2 & TF2_TLP_PTO) != 0))
+				tcp_rack_arm_tlp(tp);
+#endif /* __rtems__ */
 		}
 
 		/*
@@ -2403,6 +2403,15 @@ tcp_maxmtu(struct in_conninfo *inc, struct tcp_ifcap *cap)
 				cap->tsomaxsegcount = ifp->if_hw_tsomaxsegcount;
 				cap->tsomaxsegsize = ifp->if_hw_tsomaxsegsize;
 			}
+#ifdef __rtems__
+			else if (IF_GSO(ifp)) {
+				/* No limits on the mbuf chain in software */
+				cap->ifcap |= CSUM_TSO;
+				cap->tsomax = ifp->if_hw_tsomax;
+				cap->tsomaxsegcount = 0;
+				cap->tsomaxsegsize = 0;
+			}
+#endif /* __rtems__ */
 		}
 		fib4_free_nh_ext(inc->inc_fibnum, &nh4);
 	}
@@ -2440,6 +2449,15 @@ tcp_maxmtu6(struct in_conninfo *inc, struct tcp_ifcap *cap)
 				cap->tsomaxsegcount = ifp->if_hw_tsomaxsegcount;
 				cap->tsomaxsegsize = ifp->if_hw_tsomaxsegsize;
 			}
+#ifdef __rtems__
+			else if (IF_GSO(ifp)) {
+				/* No limits on the mbuf chain in software */
+				cap->ifcap |= CSUM_TSO;
+				cap->tsomax = ifp->if_hw_tsomax;
+				cap->tsomaxsegcount = 0;
+				cap->tsomaxsegsize = 0;
+			}
+#endif /* __rtems__ */
 		}
 		fib6_free_nh_ext(inc->inc_fibnum, &nh6);
 	}
@@ -53,9 +53,11 @@ __FBSDID("$FreeBSD$");
 #include <sys/mbuf.h>
 #include <sys/proc.h>		/* for proc0 declaration */
 #include <sys/random.h>
+#include <sys/rmlock.h>
 #include <sys/socket.h>
 #include <sys/socketvar.h>
 #include <sys/syslog.h>
+#include <sys/taskqueue.h>
 #include <sys/ucred.h>
 
 #include <sys/md5.h>
@@ -130,7 +132,12 @@ SYSCTL_INT(_net_inet_tcp, OID_AUTO, functions_inherit_listen_socket_stack,
 
 static void	 syncache_drop(struct syncache *, struct syncache_head *);
 static void	 syncache_free(struct syncache *);
+static struct syncache_head
+		**syncache_hash_alloc(struct tcp_syncache *, u_int, int);
+static void	 syncache_hash_free(struct tcp_syncache *,
+		    struct syncache_head **, u_int);
 static void	 syncache_insert(struct syncache *, struct syncache_head *);
+static void	 syncache_resize(void *, int);
 static int	 syncache_respond(struct syncache *, struct syncache_head *, int,
 		    const struct mbuf *);
 static struct	 socket *syncache_socket(struct syncache *, struct socket *,
@@ -164,6 +171,21 @@ static int	 syncookie_cmp(struct in_conninfo *inc, struct syncache_head *sch,
 #define TCP_SYNCACHE_HASHSIZE		512
 #define TCP_SYNCACHE_BUCKETLIMIT	30
 
+/*
+ * The hash table starts with TCP_SYNCACHE_HASHSIZE_MIN bucket rows and
+ * grows up to the configured hash size if the rows fill up.  It shrinks
+ * again if the load drops.  The bucket rows are allocated in chunks of
+ * TCP_SYNCACHE_HASHSIZE_MIN rows from the "syncache_head" zone, so the
+ * memory used by the hash table shows up in vmstat -z next to the
+ * "syncache" zone of the entries.
+ *
+ * The hash table and the entries together are limited to
+ * TCP_SYNCACHE_MEMLIMIT bytes.  The hash table may use a quarter of it.
+ * If the entries are exhausted, SYN cookies are used instead.
+ */
+#define TCP_SYNCACHE_HASHSIZE_MIN	16
+#define TCP_SYNCACHE_MEMLIMIT		(256 * 1024)
+
 static VNET_DEFINE(struct tcp_syncache, tcp_syncache);
 #define	V_tcp_syncache			VNET(tcp_syncache)
 
@@ -181,10 +203,22 @@ SYSCTL_UINT(_net_inet_tcp_syncache, OID_AUTO, cachelimit, CTLFLAG_VNET | CTLFLAG
 SYSCTL_UMA_CUR(_net_inet_tcp_syncache, OID_AUTO, count, CTLFLAG_VNET,
     &VNET_NAME(tcp_syncache.zone), "Current number of entries in syncache");
 
-SYSCTL_UINT(_net_inet_tcp_syncache, OID_AUTO, hashsize, CTLFLAG_VNET | CTLFLAG_RDTUN,
+SYSCTL_UINT(_net_inet_tcp_syncache, OID_AUTO, hashsize, CTLFLAG_VNET | CTLFLAG_RD,
     &VNET_NAME(tcp_syncache.hashsize), 0,
     "Size of TCP syncache hashtable");
 
+static int sysctl_syncache_hashsize_max(SYSCTL_HANDLER_ARGS);
+SYSCTL_PROC(_net_inet_tcp_syncache, OID_AUTO, hashsize_max,
+    CTLFLAG_VNET | CTLTYPE_UINT | CTLFLAG_RW, NULL, 0,
+    sysctl_syncache_hashsize_max, "IU",
+    "Maximum size of TCP syncache hashtable");
+
+static int sysctl_syncache_memlimit(SYSCTL_HANDLER_ARGS);
+SYSCTL_PROC(_net_inet_tcp_syncache, OID_AUTO, memlimit,
+    CTLFLAG_VNET | CTLTYPE_ULONG | CTLFLAG_RW, NULL, 0,
+    sysctl_syncache_memlimit, "LU",
+    "Memory limit of the TCP syncache in bytes");
+
 SYSCTL_UINT(_net_inet_tcp_syncache, OID_AUTO, rexmtlimit, CTLFLAG_VNET | CTLFLAG_RW,
     &VNET_NAME(tcp_syncache.rexmt_limit), 0,
     "Limit on SYN/ACK retransmissions");
@@ -200,6 +234,22 @@ static MALLOC_DEFINE(M_SYNCACHE, "syncache", "TCP syncache");
 #define	SCH_UNLOCK(sch)		mtx_unlock(&(sch)->sch_mtx)
 #define	SCH_LOCK_ASSERT(sch)	mtx_assert(&(sch)->sch_mtx, MA_OWNED)
 
+#define	SCH_HEAD(hashbase, i)						\
+	(&(hashbase)[(i) / TCP_SYNCACHE_HASHSIZE_MIN]			\
+	    [(i) % TCP_SYNCACHE_HASHSIZE_MIN])
+
+/*
+ * The bucket rows are only valid while the hash lock is read locked.  The
+ * write lock is taken to resize the hash table.
+ */
+#define	SYNCACHE_HASH_RLOCK_TRACKER	struct rm_priotracker syncache_hash_tracker
+#define	SYNCACHE_HASH_RLOCK()						\
+	rm_rlock(&V_tcp_syncache.hashlock, &syncache_hash_tracker)
+#define	SYNCACHE_HASH_RUNLOCK()						\
+	rm_runlock(&V_tcp_syncache.hashlock, &syncache_hash_tracker)
+#define	SYNCACHE_HASH_WLOCK(tsc)	rm_wlock(&(tsc)->hashlock)
+#define	SYNCACHE_HASH_WUNLOCK(tsc)	rm_wunlock(&(tsc)->hashlock)
+
 /*
  * Requires the syncache entry to be already removed from the bucket list.
  */
@@ -218,57 +268,147 @@ syncache_free(struct syncache *sc)
 	uma_zfree(V_tcp_syncache.zone, sc);
 }
 
+/*
+ * The hash is built on foreign port + local port + foreign address.
+ * We rely on the fact that struct in_conninfo starts with 16 bits
+ * of foreign port, then 16 bits of local port then followed by 128
+ * bits of foreign address.  In case of IPv4 address, the first 3
+ * 32-bit words of the address always are zeroes.
+ */
+static u_int
+syncache_hash(struct in_conninfo *inc, u_int hashmask)
+{
+
+	return (jenkins_hash32((uint32_t *)&inc->inc_ie, 5,
+	    V_tcp_syncache.hash_secret) & hashmask);
+}
+
+/*
+ * Allocates and initializes the bucket rows of a hash table.
+ */
+static struct syncache_head **
+syncache_hash_alloc(struct tcp_syncache *tsc, u_int hashsize, int how)
+{
+	struct syncache_head **hashbase;
+	struct syncache_head *sch;
+	u_int chunks, i;
+
+	chunks = hashsize / TCP_SYNCACHE_HASHSIZE_MIN;
+	hashbase = malloc(chunks * sizeof(*hashbase), M_SYNCACHE,
+	    how | M_ZERO);
+	if (hashbase == NULL)
+		return (NULL);
+
+	for (i = 0; i < chunks; i++) {
+		hashbase[i] = uma_zalloc(tsc->head_zone, how | M_ZERO);
+		if (hashbase[i] == NULL) {
+			while (i-- > 0)
+				uma_zfree(tsc->head_zone, hashbase[i]);
+			free(hashbase, M_SYNCACHE);
+			return (NULL);
+		}
+	}
+
+	for (i = 0; i < hashsize; i++) {
+		sch = SCH_HEAD(hashbase, i);
+		TAILQ_INIT(&sch->sch_bucket);
+		mtx_init(&sch->sch_mtx, "tcp_sc_head", NULL, MTX_DEF);
+		callout_init_mtx(&sch->sch_timer, &sch->sch_mtx, 0);
+		sch->sch_length = 0;
+		sch->sch_sc = tsc;
+	}
+
+	return (hashbase);
+}
+
+/*
+ * Frees the bucket rows of a hash table.  The bucket rows must be empty and
+ * their timers must be stopped.
+ */
+static void
+syncache_hash_free(struct tcp_syncache *tsc, struct syncache_head **hashbase,
+    u_int hashsize)
+{
+	u_int i;
+
+	for (i = 0; i < hashsize; i++)
+		mtx_destroy(&SCH_HEAD(hashbase, i)->sch_mtx);
+	for (i = 0; i < hashsize / TCP_SYNCACHE_HASHSIZE_MIN; i++)
+		uma_zfree(tsc->head_zone, hashbase[i]);
+	free(hashbase, M_SYNCACHE);
+}
+
+/*
+ * Derives the limits of the hash table and the entries from the memory
+ * limit.
+ */
+static void
+syncache_set_limits(struct tcp_syncache *tsc, u_int cache_limit)
+{
+	u_long entries;
+
+	tsc->hashsize_lim = tsc->hashsize_max;
+	while (tsc->hashsize_lim > TCP_SYNCACHE_HASHSIZE_MIN &&
+	    tsc->hashsize_lim * sizeof(struct syncache_head) >
+	    tsc->mem_limit / 4)
+		tsc->hashsize_lim /= 2;
+
+	entries = (tsc->mem_limit - tsc->mem_limit / 4) /
+	    sizeof(struct syncache);
+	if (entries < cache_limit)
+		cache_limit = (u_int)entries;
+	tsc->cache_limit = uma_zone_set_max(tsc->zone, cache_limit);
+}
+
 void
 syncache_init(void)
 {
-	int i;
+	u_int cache_limit;
 
-	V_tcp_syncache.hashsize = TCP_SYNCACHE_HASHSIZE;
+	V_tcp_syncache.hashsize = TCP_SYNCACHE_HASHSIZE_MIN;
+	V_tcp_syncache.hashsize_max = TCP_SYNCACHE_HASHSIZE;
 	V_tcp_syncache.bucket_limit = TCP_SYNCACHE_BUCKETLIMIT;
 	V_tcp_syncache.rexmt_limit = SYNCACHE_MAXREXMTS;
+	V_tcp_syncache.mem_limit = TCP_SYNCACHE_MEMLIMIT;
 	V_tcp_syncache.hash_secret = arc4random();
 
 	TUNABLE_INT_FETCH("net.inet.tcp.syncache.hashsize",
-	    &V_tcp_syncache.hashsize);
+	    &V_tcp_syncache.hashsize_max);
 	TUNABLE_INT_FETCH("net.inet.tcp.syncache.bucketlimit",
 	    &V_tcp_syncache.bucket_limit);
-	if (!powerof2(V_tcp_syncache.hashsize) ||
-	    V_tcp_syncache.hashsize == 0) {
+	TUNABLE_ULONG_FETCH("net.inet.tcp.syncache.memlimit",
+	    &V_tcp_syncache.mem_limit);
+	if (!powerof2(V_tcp_syncache.hashsize_max) ||
+	    V_tcp_syncache.hashsize_max < TCP_SYNCACHE_HASHSIZE_MIN) {
 		printf("WARNING: syncache hash size is not a power of 2.\n");
-		V_tcp_syncache.hashsize = TCP_SYNCACHE_HASHSIZE;
+		V_tcp_syncache.hashsize_max = TCP_SYNCACHE_HASHSIZE;
 	}
 	V_tcp_syncache.hashmask = V_tcp_syncache.hashsize - 1;
 
 	/* Set limits. */
-	V_tcp_syncache.cache_limit =
-	    V_tcp_syncache.hashsize * V_tcp_syncache.bucket_limit;
+	cache_limit =
+	    V_tcp_syncache.hashsize_max * V_tcp_syncache.bucket_limit;
 	TUNABLE_INT_FETCH("net.inet.tcp.syncache.cachelimit",
-	    &V_tcp_syncache.cache_limit);
-
-	/* Allocate the hash table. */
-	V_tcp_syncache.hashbase = malloc(V_tcp_syncache.hashsize *
-	    sizeof(struct syncache_head), M_SYNCACHE, M_WAITOK | M_ZERO);
+	    &cache_limit);
 
 #ifdef VIMAGE
 	V_tcp_syncache.vnet = curvnet;
 #endif
 
-	/* Initialize the hash buckets. */
-	for (i = 0; i < V_tcp_syncache.hashsize; i++) {
-		TAILQ_INIT(&V_tcp_syncache.hashbase[i].sch_bucket);
-		mtx_init(&V_tcp_syncache.hashbase[i].sch_mtx, "tcp_sc_head",
-			 NULL, MTX_DEF);
-		callout_init_mtx(&V_tcp_syncache.hashbase[i].sch_timer,
-			 &V_tcp_syncache.hashbase[i].sch_mtx, 0);
-		V_tcp_syncache.hashbase[i].sch_length = 0;
-		V_tcp_syncache.hashbase[i].sch_sc = &V_tcp_syncache;
-	}
-
-	/* Create the syncache entry zone. */
+	/* Create the syncache entry and bucket row zones. */
 	V_tcp_syncache.zone = uma_zcreate("syncache", sizeof(struct syncache),
 	    NULL, NULL, NULL, NULL, UMA_ALIGN_PTR, 0);
-	V_tcp_syncache.cache_limit = uma_zone_set_max(V_tcp_syncache.zone,
-	    V_tcp_syncache.cache_limit);
+	V_tcp_syncache.head_zone = uma_zcreate("syncache_head",
+	    TCP_SYNCACHE_HASHSIZE_MIN * sizeof(struct syncache_head),
+	    NULL, NULL, NULL, NULL, UMA_ALIGN_PTR, 0);
+	syncache_set_limits(&V_tcp_syncache, cache_limit);
+
+	/* Allocate the hash table. */
+	V_tcp_syncache.hashbase = syncache_hash_alloc(&V_tcp_syncache,
+	    V_tcp_syncache.hashsize, M_WAITOK);
+	rm_init_flags(&V_tcp_syncache.hashlock, "tcp_sc_hash", RM_RECURSE);
+	TASK_INIT(&V_tcp_syncache.resize_task, 0, syncache_resize,
+	    &V_tcp_syncache);
 
 	/* Start the SYN cookie reseeder callout. */
 	callout_init(&V_tcp_syncache.secret.reseed, 1);
@@ -284,18 +424,19 @@ syncache_destroy(void)
 {
 	struct syncache_head *sch;
 	struct syncache *sc, *nsc;
-	int i;
+	u_int i;
 
 	/*
 	 * Stop the re-seed timer before freeing resources.  No need to
 	 * possibly schedule it another time.
 	 */
 	callout_drain(&V_tcp_syncache.secret.reseed);
+	taskqueue_drain(taskqueue_thread, &V_tcp_syncache.resize_task);
 
-	/* Cleanup hash buckets: stop timers, free entries, destroy locks. */
+	/* Cleanup hash buckets: stop timers, free entries. */
 	for (i = 0; i < V_tcp_syncache.hashsize; i++) {
 
-		sch = &V_tcp_syncache.hashbase[i];
+		sch = SCH_HEAD(V_tcp_syncache.hashbase, i);
 		callout_drain(&sch->sch_timer);
 
 		SCH_LOCK(sch);
@@ -306,21 +447,165 @@ syncache_destroy(void)
 		    ("%s: sch->sch_bucket not empty", __func__));
 		KASSERT(sch->sch_length == 0, ("%s: sch->sch_length %d not 0",
 		    __func__, sch->sch_length));
-		mtx_destroy(&sch->sch_mtx);
 	}
 
 	KASSERT(uma_zone_get_cur(V_tcp_syncache.zone) == 0,
 	    ("%s: cache_count not 0", __func__));
 
 	/* Free the allocated global resources. */
+	syncache_hash_free(&V_tcp_syncache, V_tcp_syncache.hashbase,
+	    V_tcp_syncache.hashsize);
+	rm_destroy(&V_tcp_syncache.hashlock);
+	uma_zdestroy(V_tcp_syncache.head_zone);
 	uma_zdestroy(V_tcp_syncache.zone);
-	free(V_tcp_syncache.hashbase, M_SYNCACHE);
 }
 #endif
 
+/*
+ * Returns the hash table size for the current count of entries.  The rows
+ * should be filled to at most a quarter of the per-bucket limit on
+ * average.
+ */
+static u_int
+syncache_hashsize_target(struct tcp_syncache *tsc)
+{
+	u_int count, hashsize;
+
+	count = uma_zone_get_cur(tsc->zone);
+	hashsize = TCP_SYNCACHE_HASHSIZE_MIN;
+	while (hashsize < tsc->hashsize_lim &&
+	    hashsize * tsc->bucket_limit < count * 4)
+		hashsize *= 2;
+
+	return (hashsize);
+}
+
+/*
+ * Moves all entries to a new hash table with the target size.  Runs in the
+ * thread taskqueue, requested by syncache_insert() if a bucket row gets
+ * long and by syncookie_reseed() if the load dropped.
+ */
+static void
+syncache_resize(void *arg, int pending)
+{
+	struct tcp_syncache *tsc = arg;
+	struct syncache_head **hashbase, **oldbase;
+	struct syncache_head *sch, *nsch;
+	struct syncache *sc;
+	u_int hashsize, oldsize, i;
+
+	(void)pending;
+	CURVNET_SET(tsc->vnet);
+
+	hashsize = syncache_hashsize_target(tsc);
+	if (hashsize == tsc->hashsize)
+		goto out;
+
+	hashbase = syncache_hash_alloc(tsc, hashsize, M_NOWAIT);
+	if (hashbase == NULL)
+		goto out;
+
+	SYNCACHE_HASH_WLOCK(tsc);
+	oldbase = tsc->hashbase;
+	oldsize = tsc->hashsize;
+
+	/*
+	 * The new bucket rows are not visible to anyone else yet.  Move the
+	 * entries oldest first to keep the order of the rows.
+	 */
+	for (i = 0; i < oldsize; i++) {
+		sch = SCH_HEAD(oldbase, i);
+		SCH_LOCK(sch);
+		while ((sc = TAILQ_LAST(&sch->sch_bucket, sch_head)) != NULL) {
+			TAILQ_REMOVE(&sch->sch_bucket, sc, sc_hash);
+			nsch = SCH_HEAD(hashbase,
+			    syncache_hash(&sc->sc_inc, hashsize - 1));
+			if (nsch->sch_length == 0)
+				nsch->sch_nextc = ticks + INT_MAX;
+			TAILQ_INSERT_HEAD(&nsch->sch_bucket, sc, sc_hash);
+			nsch->sch_length++;
+			if (TSTMP_LT(sc->sc_rxttime, nsch->sch_nextc))
+				nsch->sch_nextc = sc->sc_rxttime;
+		}
+		sch->sch_length = 0;
+		callout_stop(&sch->sch_timer);
+		SCH_UNLOCK(sch);
+	}
+
+	for (i = 0; i < hashsize; i++) {
+		nsch = SCH_HEAD(hashbase, i);
+		if (nsch->sch_length == 0)
+			continue;
+		SCH_LOCK(nsch);
+		callout_reset(&nsch->sch_timer, nsch->sch_nextc - ticks,
+		    syncache_timer, (void *)nsch);
+		SCH_UNLOCK(nsch);
+	}
+
+	tsc->hashbase = hashbase;
+	tsc->hashsize = hashsize;
+	tsc->hashmask = hashsize - 1;
+	SYNCACHE_HASH_WUNLOCK(tsc);
+
+	/*
+	 * A timer of an old bucket row may still run.  It finds an empty
+	 * row and does not reschedule itself.
+	 */
+	for (i = 0; i < oldsize; i++)
+		callout_drain(&SCH_HEAD(oldbase, i)->sch_timer);
+	syncache_hash_free(tsc, oldbase, oldsize);
+
+	TCPSTAT_INC(tcps_sc_resized);
+out:
+	CURVNET_RESTORE();
+}
+
+static int
+sysctl_syncache_hashsize_max(SYSCTL_HANDLER_ARGS)
+{
+	u_int hashsize_max;
+	int error;
+
+	hashsize_max = V_tcp_syncache.hashsize_max;
+	error = sysctl_handle_int(oidp, &hashsize_max, 0, req);
+	if (error != 0 || req->newptr == NULL)
+		return (error);
+	if (!powerof2(hashsize_max) ||
+	    hashsize_max < TCP_SYNCACHE_HASHSIZE_MIN)
+		return (EINVAL);
+
+	V_tcp_syncache.hashsize_max = hashsize_max;
+	syncache_set_limits(&V_tcp_syncache,
+	    hashsize_max * V_tcp_syncache.bucket_limit);
+	taskqueue_enqueue(taskqueue_thread, &V_tcp_syncache.resize_task);
+	return (0);
+}
+
+static int
+sysctl_syncache_memlimit(SYSCTL_HANDLER_ARGS)
+{
+	u_long mem_limit;
+	int error;
+
+	mem_limit = V_tcp_syncache.mem_limit;
+	error = sysctl_handle_long(oidp, &mem_limit, 0, req);
+	if (error != 0 || req->newptr == NULL)
+		return (error);
+	if (mem_limit < 4 * TCP_SYNCACHE_HASHSIZE_MIN *
+	    sizeof(struct syncache_head))
+		return (EINVAL);
+
+	V_tcp_syncache.mem_limit = mem_limit;
+	syncache_set_limits(&V_tcp_syncache,
+	    V_tcp_syncache.hashsize_max * V_tcp_syncache.bucket_limit);
+	taskqueue_enqueue(taskqueue_thread, &V_tcp_syncache.resize_task);
+	return (0);
+}
+
 /*
  * Inserts a syncache entry into the specified bucket row.
  * Locks and unlocks the syncache_head autonomously.
+ * Expects the hash table to be read locked.
  */
 static void
 syncache_insert(struct syncache *sc, struct syncache_head *sch)
@@ -331,9 +616,10 @@ syncache_insert(struct syncache *sc, struct syncache_head *sch)
 
 	/*
 	 * Make sure that we don't overflow the per-bucket limit.
-	 * If the bucket is full, toss the oldest element.
+	 * If the bucket is full, toss the oldest element.  A shrink of
+	 * the hash table may have overfilled the bucket.
 	 */
-	if (sch->sch_length >= V_tcp_syncache.bucket_limit) {
+	while (sch->sch_length >= V_tcp_syncache.bucket_limit) {
 		KASSERT(!TAILQ_EMPTY(&sch->sch_bucket),
 			("sch->sch_length incorrect"));
 		sc2 = TAILQ_LAST(&sch->sch_bucket, sch_head);
@@ -341,6 +627,12 @@ syncache_insert(struct syncache *sc, struct syncache_head *sch)
 		TCPSTAT_INC(tcps_sc_bucketoverflow);
 	}
 
+	/* Grow the hash table before the buckets overflow. */
+	if (sch->sch_length >= V_tcp_syncache.bucket_limit / 2 &&
+	    V_tcp_syncache.hashsize < V_tcp_syncache.hashsize_lim)
+		taskqueue_enqueue(taskqueue_thread,
+		    &V_tcp_syncache.resize_task);
+
 	/* Put it into the bucket. */
 	TAILQ_INSERT_HEAD(&sch->sch_bucket, sc, sc_hash);
 	sch->sch_length++;
@@ -475,25 +767,16 @@ syncache_timer(void *xsch)
 /*
  * Find an entry in the syncache.
  * Returns always with locked syncache_head plus a matching entry or NULL.
+ * Expects the hash table to be read locked.
  */
 static struct syncache *
 syncache_lookup(struct in_conninfo *inc, struct syncache_head **schp)
 {
 	struct syncache *sc;
 	struct syncache_head *sch;
-	uint32_t hash;
 
-	/*
-	 * The hash is built on foreign port + local port + foreign address.
-	 * We rely on the fact that struct in_conninfo starts with 16 bits
-	 * of foreign port, then 16 bits of local port then followed by 128
-	 * bits of foreign address.  In case of IPv4 address, the first 3
-	 * 32-bit words of the address always are zeroes.
-	 */
-	hash = jenkins_hash32((uint32_t *)&inc->inc_ie, 5,
-	    V_tcp_syncache.hash_secret) & V_tcp_syncache.hashmask;
-
-	sch = &V_tcp_syncache.hashbase[hash];
+	sch = SCH_HEAD(V_tcp_syncache.hashbase,
+	    syncache_hash(inc, V_tcp_syncache.hashmask));
 	*schp = sch;
 	SCH_LOCK(sch);
 
@@ -514,10 +797,12 @@ syncache_lookup(struct in_conninfo *inc, struct syncache_head **schp)
 void
 syncache_chkrst(struct in_conninfo *inc, struct tcphdr *th)
 {
+	SYNCACHE_HASH_RLOCK_TRACKER;
 	struct syncache *sc;
 	struct syncache_head *sch;
 	char *s = NULL;
 
+	SYNCACHE_HASH_RLOCK();
 	sc = syncache_lookup(inc, &sch);	/* returns locked sch */
 	SCH_LOCK_ASSERT(sch);
 
@@ -583,14 +868,17 @@ done:
 	if (s != NULL)
 		free(s, M_TCPLOG);
 	SCH_UNLOCK(sch);
+	SYNCACHE_HASH_RUNLOCK();
 }
 
 void
 syncache_badack(struct in_conninfo *inc)
 {
+	SYNCACHE_HASH_RLOCK_TRACKER;
 	struct syncache *sc;
 	struct syncache_head *sch;
 
+	SYNCACHE_HASH_RLOCK();
 	sc = syncache_lookup(inc, &sch);	/* returns locked sch */
 	SCH_LOCK_ASSERT(sch);
 	if (sc != NULL) {
@@ -598,14 +886,17 @@ syncache_badack(struct in_conninfo *inc)
 		TCPSTAT_INC(tcps_sc_badack);
 	}
 	SCH_UNLOCK(sch);
+	SYNCACHE_HASH_RUNLOCK();
 }
 
 void
 syncache_unreach(struct in_conninfo *inc, struct tcphdr *th)
 {
+	SYNCACHE_HASH_RLOCK_TRACKER;
 	struct syncache *sc;
 	struct syncache_head *sch;
 
+	SYNCACHE_HASH_RLOCK();
 	sc = syncache_lookup(inc, &sch);	/* returns locked sch */
 	SCH_LOCK_ASSERT(sch);
 	if (sc == NULL)
@@ -631,6 +922,7 @@ syncache_unreach(struct in_conninfo *inc, struct tcphdr *th)
 	TCPSTAT_INC(tcps_sc_unreach);
 done:
 	SCH_UNLOCK(sch);
+	SYNCACHE_HASH_RUNLOCK();
 }
 
 /*
@@ -950,10 +1242,12 @@ abort2:
  *
  * On syncache_socket() success the newly created socket
  * has its underlying inp locked.
+ *
+ * Expects the hash table to be read locked, see syncache_expand().
  */
-int
-syncache_expand(struct in_conninfo *inc, struct tcpopt *to, struct tcphdr *th,
-    struct socket **lsop, struct mbuf *m)
+static int
+syncache_expand_hashed(struct in_conninfo *inc, struct tcpopt *to,
+    struct tcphdr *th, struct socket **lsop, struct mbuf *m)
 {
 	struct syncache *sc;
 	struct syncache_head *sch;
@@ -1169,6 +1463,19 @@ failed:
 	return (0);
 }
 
+int
+syncache_expand(struct in_conninfo *inc, struct tcpopt *to, struct tcphdr *th,
+    struct socket **lsop, struct mbuf *m)
+{
+	SYNCACHE_HASH_RLOCK_TRACKER;
+	int rv;
+
+	SYNCACHE_HASH_RLOCK();
+	rv = syncache_expand_hashed(inc, to, th, lsop, m);
+	SYNCACHE_HASH_RUNLOCK();
+	return (rv);
+}
+
 #ifdef TCP_RFC7413
 static void
 syncache_tfo_expand(struct syncache *sc, struct socket **lsop, struct mbuf *m,
@@ -1226,6 +1533,7 @@ syncache_add(struct in_conninfo *inc, struct tcpopt *to, struct tcphdr *th,
     struct inpcb *inp, struct socket **lsop, struct mbuf *m, void *tod,
     void *todctx)
 {
+	SYNCACHE_HASH_RLOCK_TRACKER;
 	struct tcpcb *tp;
 	struct socket *so;
 	struct syncache *sc = NULL;
@@ -1254,6 +1562,9 @@ syncache_add(struct in_conninfo *inc, struct tcpopt *to, struct tcphdr *th,
 	KASSERT((th->th_flags & (TH_RST|TH_ACK|TH_SYN)) == TH_SYN,
 	    ("%s: unexpected tcp flags", __func__));
 
+	/* The bucket row is used up to syncache_insert() */
+	SYNCACHE_HASH_RLOCK();
+
 	/*
 	 * Combine all so/tp operations very early to drop the INP lock as
 	 * soon as possible.
@@ -1416,19 +1727,23 @@ syncache_add(struct in_conninfo *inc, struct tcpopt *to, struct tcphdr *th,
 	sc = uma_zalloc(V_tcp_syncache.zone, M_NOWAIT | M_ZERO);
 	if (sc == NULL) {
 		/*
-		 * The zone allocator couldn't provide more entries.
-		 * Treat this as if the cache was full; drop the oldest
-		 * entry and insert the new one.
+		 * The zone allocator couldn't provide more entries, the
+		 * memory limit is exhausted.  Fall back to a SYN cookie,
+		 * so that no pending connection has to be dropped.
+		 * Without SYN cookies treat this as if the cache was full;
+		 * drop the oldest entry and insert the new one.
 		 */
 		TCPSTAT_INC(tcps_sc_zonefail);
-		if ((sc = TAILQ_LAST(&sch->sch_bucket, sch_head)) != NULL)
-			syncache_drop(sc, sch);
-		sc = uma_zalloc(V_tcp_syncache.zone, M_NOWAIT | M_ZERO);
-		if (sc == NULL) {
-			if (V_tcp_syncookies) {
-				bzero(&scs, sizeof(scs));
-				sc = &scs;
-			} else {
+		if (V_tcp_syncookies) {
+			bzero(&scs, sizeof(scs));
+			sc = &scs;
+		} else {
+			if ((sc = TAILQ_LAST(&sch->sch_bucket, sch_head)) !=
+			    NULL)
+				syncache_drop(sc, sch);
+			sc = uma_zalloc(V_tcp_syncache.zone,
+			    M_NOWAIT | M_ZERO);
+			if (sc == NULL) {
 				SCH_UNLOCK(sch);
 				if (ipopts)
 					(void) m_free(ipopts);
@@ -1592,6 +1907,7 @@ done:
 
 tfo_expanded:
 #endif
+	SYNCACHE_HASH_RUNLOCK();
 	if (cred != NULL)
 		crfree(cred);
 #ifdef MAC
@@ -2190,6 +2506,10 @@ syncookie_reseed(void *arg)
 	arc4rand(secbits, SYNCOOKIE_SECRET_SIZE, 0);
 	atomic_add_rel_int(&sc->secret.oddeven, 1);
 
+	/* Shrink the hash table if the load dropped. */
+	if (syncache_hashsize_target(sc) < sc->hashsize)
+		taskqueue_enqueue(taskqueue_thread, &sc->resize_task);
+
 	/* Reschedule ourself. */
 	callout_schedule(&sc->secret.reseed, SYNCOOKIE_LIFETIME * hz);
 }
@@ -2206,44 +2526,70 @@ syncookie_reseed(void *arg)
 int
 syncache_pcblist(struct sysctl_req *req, int max_pcbs, int *pcbs_exported)
 {
-	struct xtcpcb xt;
+	SYNCACHE_HASH_RLOCK_TRACKER;
+	struct xtcpcb *xt, *xts;
 	struct syncache *sc;
 	struct syncache_head *sch;
-	int count, error, i;
+	int count, error, i, n, nxts;
 
-	for (count = 0, error = 0, i = 0; i < V_tcp_syncache.hashsize; i++) {
-		sch = &V_tcp_syncache.hashbase[i];
+	/*
+	 * SYSCTL_OUT() may sleep, so the records of one bucket are built
+	 * while the hash and bucket locks are held and copied out after they
+	 * are released.  A hash table resize in between may cause entries to
+	 * be missed or reported twice.
+	 */
+	nxts = V_tcp_syncache.bucket_limit;
+	xts = malloc(nxts * sizeof(*xts), M_TEMP, M_WAITOK);
+	for (count = 0, error = 0, i = 0; count < max_pcbs; i++) {
+		SYNCACHE_HASH_RLOCK();
+		if (i >= V_tcp_syncache.hashsize) {
+			SYNCACHE_HASH_RUNLOCK();
+			break;
+		}
+		sch = SCH_HEAD(V_tcp_syncache.hashbase, i);
 		SCH_LOCK(sch);
+		if (sch->sch_length > nxts) {
+			/* A resize may overfill a bucket, retry with more room */
+			nxts = sch->sch_length;
+			SCH_UNLOCK(sch);
+			SYNCACHE_HASH_RUNLOCK();
+			free(xts, M_TEMP);
+			xts = malloc(nxts * sizeof(*xts), M_TEMP, M_WAITOK);
+			i--;
+			continue;
+		}
+		n = 0;
 		TAILQ_FOREACH(sc, &sch->sch_bucket, sc_hash) {
-			if (count >= max_pcbs) {
-				SCH_UNLOCK(sch);
-				goto exit;
-			}
+			if (count + n >= max_pcbs)
+				break;
 			if (cr_cansee(req->td->td_ucred, sc->sc_cred) != 0)
 				continue;
-			bzero(&xt, sizeof(xt));
-			xt.xt_len = sizeof(xt);
+			xt = &xts[n++];
+			bzero(xt, sizeof(*xt));
+			xt->xt_len = sizeof(*xt);
 			if (sc->sc_inc.inc_flags & INC_ISIPV6)
-				xt.xt_inp.inp_vflag = INP_IPV6;
+				xt->xt_inp.inp_vflag = INP_IPV6;
 			else
-				xt.xt_inp.inp_vflag = INP_IPV4;
-			bcopy(&sc->sc_inc, &xt.xt_inp.inp_inc,
+				xt->xt_inp.inp_vflag = INP_IPV4;
+			bcopy(&sc->sc_inc, &xt->xt_inp.inp_inc,
 			    sizeof (struct in_conninfo));
-			xt.t_state = TCPS_SYN_RECEIVED;
-			xt.xt_inp.xi_socket.xso_protocol = IPPROTO_TCP;
-			xt.xt_inp.xi_socket.xso_len = sizeof (struct xsocket);
-			xt.xt_inp.xi_socket.so_type = SOCK_STREAM;
-			xt.xt_inp.xi_socket.so_state = SS_ISCONNECTING;
-			error = SYSCTL_OUT(req, &xt, sizeof xt);
-			if (error) {
-				SCH_UNLOCK(sch);
-				goto exit;
-			}
-			count++;
+			xt->t_state = TCPS_SYN_RECEIVED;
+			xt->xt_inp.xi_socket.xso_protocol = IPPROTO_TCP;
+			xt->xt_inp.xi_socket.xso_len = sizeof (struct xsocket);
+			xt->xt_inp.xi_socket.so_type = SOCK_STREAM;
+			xt->xt_inp.xi_socket.so_state = SS_ISCONNECTING;
 		}
 		SCH_UNLOCK(sch);
+		SYNCACHE_HASH_RUNLOCK();
+
+		if (n > 0) {
+			error = SYSCTL_OUT(req, xts, n * sizeof(*xts));
+			if (error)
+				break;
+			count += n;
+		}
 	}
-exit:
+	free(xts, M_TEMP);
 	*pcbs_exported = count;
 	return error;
 }
@@ -34,6 +34,9 @@
 #define _NETINET_TCP_SYNCACHE_H_
 #ifdef _KERNEL
 
+#include <sys/_rmlock.h>
+#include <sys/_task.h>
+
 void	 syncache_init(void);
 #ifdef VIMAGE
 void	syncache_destroy(void);
@@ -112,13 +115,19 @@ struct syncookie_secret {
 };
 
 struct tcp_syncache {
-	struct	syncache_head *hashbase;
+	struct	syncache_head **hashbase;	/* chunks of bucket rows */
+	struct	rmlock hashlock;		/* protects hashbase */
+	struct	task resize_task;
 	uma_zone_t zone;
+	uma_zone_t head_zone;
 	u_int	hashsize;
 	u_int	hashmask;
+	u_int	hashsize_max;			/* configured maximum */
+	u_int	hashsize_lim;			/* maximum within mem_limit */
 	u_int	bucket_limit;
 	u_int	cache_limit;
 	u_int	rexmt_limit;
+	u_long	mem_limit;
 	uint32_t hash_secret;
 	struct vnet *vnet;
 	struct syncookie_secret secret;
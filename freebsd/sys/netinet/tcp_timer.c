@@ -668,6 +668,18 @@ tcp_timer_rexmt(void * xtp)
 	}
 	KASSERT((tp->t_timers->tt_flags & TT_STOPPED) == 0,
 		("%s: tp %p tcpcb can't be stopped here", __func__, tp));
+#ifdef __rtems__
+	/*
+	 * The retransmit timer may stand for the RACK reordering timer or
+	 * the tail loss probe timer.  These need the SACK scoreboard.
+	 */
+	if ((tp->t_flags2 & (TF2_RACK_REO | TF2_TLP_PTO)) != 0 &&
+	    tcp_rack_timeout(tp)) {
+		INP_WUNLOCK(inp);
+		CURVNET_RESTORE();
+		return;
+	}
+#endif /* __rtems__ */
 	tcp_free_sackholes(tp);
 	if (tp->t_fb->tfb_tcp_rexmit_tmr) {
 		/* The stack has a timer action too. */
@@ -908,6 +920,10 @@ tcp_timer_activate(struct tcpcb *tp, uint32_t timer_type, u_int delta)
 		case TT_REXMT:
 			t_callout = &tp->t_timers->tt_rexmt;
 			f_callout = tcp_timer_rexmt;
+#ifdef __rtems__
+			/* The caller sets these flags again if necessary */
+			tp->t_flags2 &= ~(TF2_RACK_REO | TF2_TLP_PTO);
+#endif /* __rtems__ */
 			break;
 		case TT_PERSIST:
 			t_callout = &tp->t_timers->tt_persist;
@@ -189,6 +189,11 @@ struct tcpcb {
 	u_int	t_flags2;		/* More tcpcb flags storage */
 	struct tcp_function_block *t_fb;/* TCP function call block */
 	void	*t_fb_ptr;		/* Pointer to t_fb specific data */
+#ifdef __rtems__
+	u_int	t_rack_ts;		/* RACK: first hole sent (ticks) */
+	tcp_seq	t_rack_una;		/* RACK: snd_una of t_rack_ts */
+	tcp_seq	t_tlp_high;		/* TLP: snd_max of last loss probe */
+#endif /* __rtems__ */
 #ifdef TCP_RFC7413
 	uint64_t t_tfo_cookie;		/* TCP Fast Open cookie */
 	unsigned int *t_tfo_pending;	/* TCP Fast Open pending counter */
@@ -345,6 +350,18 @@ TAILQ_HEAD(tcp_funchead, tcp_function);
 #define	TF2_PLPMTU_BLACKHOLE	0x00000001 /* Possible PLPMTUD Black Hole. */
 #define	TF2_PLPMTU_PMTUD	0x00000002 /* Allowed to attempt PLPMTUD. */
 #define	TF2_PLPMTU_MAXSEGSNT	0x00000004 /* Last seg sent was full seg. */
+#ifdef __rtems__
+
+/*
+ * Flags for RACK loss detection and tail loss probes, t_flags2
+ */
+#define	TF2_RACK		0x00000008 /* RACK loss detection enabled. */
+#define	TF2_TLP			0x00000010 /* Tail loss probes enabled. */
+#define	TF2_RACK_TS		0x00000020 /* t_rack_ts is valid. */
+#define	TF2_RACK_REO		0x00000040 /* Rexmt timer waits for reorder. */
+#define	TF2_TLP_PTO		0x00000080 /* Rexmt timer is loss probe. */
+#define	TF2_TLP_SENT		0x00000100 /* Loss probe not yet acked. */
+#endif /* __rtems__ */
 
 /*
  * Structure to hold TCP options that are only used during segment
@@ -579,7 +596,15 @@ struct	tcpstat {
 	uint64_t tcps_sig_err_sigopt;	/* No signature expected by socket */
 	uint64_t tcps_sig_err_nosigopt;	/* No signature provided by segment */
 
-	uint64_t _pad[12];		/* 6 UTO, 6 TBD */
+	uint64_t tcps_sc_resized;	/* syncache hash table resized */
+
+	/* RACK and tail loss probe related stats */
+	uint64_t tcps_rack_recovery;	/* recoveries started by RACK */
+	uint64_t tcps_rack_reordertmo;	/* RACK reordering timeouts */
+	uint64_t tcps_tlp_probes;	/* tail loss probes sent */
+	uint64_t tcps_tlp_acked;	/* tail loss probes acked */
+
+	uint64_t _pad[7];		/* 6 UTO, 1 TBD */
 };
 
 #define	tcps_rcvmemdrop	tcps_rcvreassfull	/* compat */
@@ -843,6 +868,12 @@ void	 tcp_sack_partialack(struct tcpcb *, struct tcphdr *);
 void	 tcp_free_sackholes(struct tcpcb *tp);
 int	 tcp_newreno(struct tcpcb *, struct tcphdr *);
 int	 tcp_compute_pipe(struct tcpcb *);
+#ifdef __rtems__
+void	 tcp_rack_ack(struct tcpcb *);
+void	 tcp_rack_arm_tlp(struct tcpcb *);
+int	 tcp_rack_dupack(struct tcpcb *, struct tcpopt *);
+int	 tcp_rack_timeout(struct tcpcb *);
+#endif /* __rtems__ */
 
 static inline void
 tcp_fields_to_host(struct tcphdr *th)
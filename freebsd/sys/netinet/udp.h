@@ -49,6 +49,7 @@ struct udphdr {
  * User-settable options (used with setsockopt).
  */
 #define	UDP_ENCAP			1
+#define	UDP_RCVLOWAT_TIMEO		8	/* us to defer wakeups, -1 default */
 
 /* Start of reserved space for third-party user-settable options. */
 #define	UDP_VENDOR			SO_VENDOR
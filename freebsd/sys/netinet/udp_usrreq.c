@@ -51,6 +51,7 @@ __FBSDID("$FreeBSD$");
 #include <rtems/bsd/local/opt_rss.h>
 
 #include <sys/param.h>
+#include <sys/callout.h>
 #include <sys/domain.h>
 #include <sys/eventhandler.h>
 #include <sys/jail.h>
@@ -135,6 +136,13 @@ SYSCTL_INT(_net_inet_udp, OID_AUTO, require_l2_bcast, CTLFLAG_VNET | CTLFLAG_RW,
     &VNET_NAME(udp_require_l2_bcast), 0,
     "Only treat packets sent to an L2 broadcast address as broadcast packets");
 
+static VNET_DEFINE(int, udp_rcvlowat_timeo) = 1000;
+#define	V_udp_rcvlowat_timeo		VNET(udp_rcvlowat_timeo)
+SYSCTL_INT(_net_inet_udp, OID_AUTO, rcvlowat_timeo, CTLFLAG_VNET | CTLFLAG_RW,
+    &VNET_NAME(udp_rcvlowat_timeo), 0,
+    "Microseconds a receive wakeup may be deferred below SO_RCVLOWAT, "
+    "0 disables the deferral");
+
 u_long	udp_sendspace = 9216;		/* really max datagram size */
 SYSCTL_ULONG(_net_inet_udp, UDPCTL_MAXDGRAM, maxdgram, CTLFLAG_RW,
     &udp_sendspace, 0, "Maximum outgoing UDP datagram size");
@@ -256,6 +264,9 @@ udp_newudpcb(struct inpcb *inp)
 	up = uma_zalloc(V_udpcb_zone, M_NOWAIT | M_ZERO);
 	if (up == NULL)
 		return (ENOBUFS);
+	callout_init_mtx(&up->u_rcvcallout,
+	    SOCKBUF_MTX(&inp->inp_socket->so_rcv), CALLOUT_RETURNUNLOCKED);
+	up->u_rcvtimeo = -1;
 	inp->inp_ppcb = up;
 	return (0);
 }
@@ -267,6 +278,65 @@ udp_discardcb(struct udpcb *up)
 	uma_zfree(V_udpcb_zone, up);
 }
 
+static void
+udp_rcvwakeup_timeout(void *arg)
+{
+	struct socket *so;
+
+	so = arg;
+	SOCKBUF_LOCK_ASSERT(&so->so_rcv);
+	so->so_rcv.sb_state |= SBS_LOWATEXPIRED;
+	sorwakeup_locked(so);
+}
+
+/*
+ * Wake up the reader after a datagram was appended to the receive buffer
+ * and release the receive buffer lock.  If the socket has a receive
+ * low-water mark (SO_RCVLOWAT), the wakeup is deferred until the mark is
+ * reached or until the deferral time limit expires, so that a reader gets
+ * several datagrams per wakeup.  Once the limit expired, SBS_LOWATEXPIRED
+ * makes the data below the mark readable for poll(), select() and kevent()
+ * until the reader drained the receive buffer.
+ */
+void
+udp_rcvwakeup(struct inpcb *inp, struct socket *so)
+{
+	struct sockbuf *sb;
+	struct udpcb *up;
+	int timeo;
+
+	sb = &so->so_rcv;
+	SOCKBUF_LOCK_ASSERT(sb);
+	up = intoudpcb(inp);
+	timeo = up->u_rcvtimeo >= 0 ? up->u_rcvtimeo : V_udp_rcvlowat_timeo;
+	if (sb->sb_mb == sb->sb_lastrecord) {
+		/* The buffer was empty, start a new deferral */
+		sb->sb_state &= ~SBS_LOWATEXPIRED;
+	}
+	if (sb->sb_lowat <= 1 || timeo <= 0 || sbavail(sb) >= sb->sb_lowat ||
+	    (sb->sb_state & SBS_LOWATEXPIRED) != 0 ||
+	    sbspace(sb) < (long)(sb->sb_lowat - sbavail(sb))) {
+		if (callout_pending(&up->u_rcvcallout))
+			callout_stop(&up->u_rcvcallout);
+		sorwakeup_locked(so);
+		return;
+	}
+	UDPSTAT_INC(udps_rcvdeferred);
+	if (!callout_pending(&up->u_rcvcallout))
+		callout_reset_sbt(&up->u_rcvcallout, SBT_1US * timeo, 0,
+		    udp_rcvwakeup_timeout, so, 0);
+	SOCKBUF_UNLOCK(sb);
+}
+
+void
+udp_rcvwakeup_stop(struct udpcb *up, struct socket *so)
+{
+
+	SOCKBUF_LOCK(&so->so_rcv);
+	callout_stop(&up->u_rcvcallout);
+	SOCKBUF_UNLOCK(&so->so_rcv);
+}
+
 #ifdef VIMAGE
 static void
 udp_destroy(void *unused __unused)
@@ -393,10 +463,53 @@ udp_append(struct inpcb *inp, struct ip *ip, struct mbuf *n, int off,
 			m_freem(opts);
 		UDPSTAT_INC(udps_fullsock);
 	} else
-		sorwakeup_locked(so);
+		udp_rcvwakeup(inp, so);
 	return (0);
 }
 
+#ifdef __rtems__
+/*
+ * Walk the PCBs bound to a local port for multicast and broadcast
+ * delivery.  The caller holds the pcbinfo lock, which keeps the PCBs on
+ * the port list.  The hash lock ranks after the PCB locks, so it is only
+ * held to take a step.
+ */
+static struct inpcb *
+udp_port_first(struct inpcbinfo *pcbinfo, u_short lport)
+{
+	struct inpcbporthead *porthash;
+	struct inpcbport *phd;
+	struct inpcb *inp;
+
+	INP_INFO_RLOCK_ASSERT(pcbinfo);
+
+	inp = NULL;
+	INP_HASH_RLOCK(pcbinfo);
+	porthash = &pcbinfo->ipi_porthashbase[INP_PCBPORTHASH(lport,
+	    pcbinfo->ipi_porthashmask)];
+	LIST_FOREACH(phd, porthash, phd_hash) {
+		if (phd->phd_port == lport) {
+			inp = LIST_FIRST(&phd->phd_pcblist);
+			break;
+		}
+	}
+	INP_HASH_RUNLOCK(pcbinfo);
+	return (inp);
+}
+
+static struct inpcb *
+udp_port_next(struct inpcbinfo *pcbinfo, struct inpcb *inp)
+{
+
+	INP_INFO_RLOCK_ASSERT(pcbinfo);
+
+	INP_HASH_RLOCK(pcbinfo);
+	inp = LIST_NEXT(inp, inp_portlist);
+	INP_HASH_RUNLOCK(pcbinfo);
+	return (inp);
+}
+#endif /* __rtems__ */
+
 int
 udp_input(struct mbuf **mp, int *offp, int proto)
 {
@@ -538,13 +651,28 @@ udp_input(struct mbuf **mp, int *offp, int proto)
 	    ((!V_udp_require_l2_bcast || m->m_flags & M_BCAST) &&
 	    in_broadcast(ip->ip_dst, ifp))) {
 		struct inpcb *last;
+#ifndef __rtems__
 		struct inpcbhead *pcblist;
+#endif /* __rtems__ */
 		struct ip_moptions *imo;
 
 		INP_INFO_RLOCK(pcbinfo);
+#ifndef __rtems__
 		pcblist = udp_get_pcblist(proto);
+#endif /* __rtems__ */
 		last = NULL;
+#ifndef __rtems__
 		LIST_FOREACH(inp, pcblist, inp_list) {
+#else /* __rtems__ */
+		/*
+		 * Only the PCBs bound to the destination port may match, so
+		 * walk its port hash chain instead of every PCB.  Together
+		 * with the per-socket membership hash used by
+		 * imo_multi_filter() this demultiplexes by (group, port).
+		 */
+		for (inp = udp_port_first(pcbinfo, uh->uh_dport); inp != NULL;
+		    inp = udp_port_next(pcbinfo, inp)) {
+#endif /* __rtems__ */
 			if (inp->inp_lport != uh->uh_dport)
 				continue;
 #ifdef INET6
@@ -1060,6 +1188,25 @@ udp_ctloutput(struct socket *so, struct sockopt *sopt)
 				up->u_rxcslen = optval;
 			INP_WUNLOCK(inp);
 			break;
+		case UDP_RCVLOWAT_TIMEO:
+			INP_WUNLOCK(inp);
+			error = sooptcopyin(sopt, &optval, sizeof(optval),
+			    sizeof(optval));
+			if (error != 0)
+				break;
+			/* -1 selects net.inet.udp.rcvlowat_timeo */
+			if (optval < -1) {
+				error = EINVAL;
+				break;
+			}
+			inp = sotoinpcb(so);
+			KASSERT(inp != NULL, ("%s: inp == NULL", __func__));
+			INP_WLOCK(inp);
+			up = intoudpcb(inp);
+			KASSERT(up != NULL, ("%s: up == NULL", __func__));
+			up->u_rcvtimeo = optval;
+			INP_WUNLOCK(inp);
+			break;
 		default:
 			INP_WUNLOCK(inp);
 			error = ENOPROTOOPT;
@@ -1095,6 +1242,13 @@ udp_ctloutput(struct socket *so, struct sockopt *sopt)
 			INP_WUNLOCK(inp);
 			error = sooptcopyout(sopt, &optval, sizeof(optval));
 			break;
+		case UDP_RCVLOWAT_TIMEO:
+			up = intoudpcb(inp);
+			KASSERT(up != NULL, ("%s: up == NULL", __func__));
+			optval = up->u_rcvtimeo;
+			INP_WUNLOCK(inp);
+			error = sooptcopyout(sopt, &optval, sizeof(optval));
+			break;
 		default:
 			INP_WUNLOCK(inp);
 			error = ENOPROTOOPT;
@@ -1729,6 +1883,7 @@ udp_detach(struct socket *so)
 	INP_WLOCK(inp);
 	up = intoudpcb(inp);
 	KASSERT(up != NULL, ("%s: up == NULL", __func__));
+	udp_rcvwakeup_stop(up, so);
 	inp->inp_ppcb = NULL;
 	in_pcbdetach(inp);
 	in_pcbfree(inp);
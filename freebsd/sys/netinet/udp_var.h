@@ -34,6 +34,8 @@
 #ifndef _NETINET_UDP_VAR_H_
 #define	_NETINET_UDP_VAR_H_
 
+#include <sys/_callout.h>
+
 /*
  * UDP kernel structures and variables.
  */
@@ -69,6 +71,8 @@ struct udpcb {
 	uint16_t	u_rxcslen;	/* Coverage for incoming datagrams. */
 	uint16_t	u_txcslen;	/* Coverage for outgoing datagrams. */
 	void 		*u_tun_ctx;	/* Tunneling callback context. */
+	struct callout	u_rcvcallout;	/* Deferred receive wakeup. */
+	int		u_rcvtimeo;	/* Deferral limit in us, -1 default. */
 };
 
 #define	intoudpcb(ip)	((struct udpcb *)(ip)->inp_ppcb)
@@ -98,6 +102,7 @@ struct udpstat {
 	/* of no socket on port, arrived as multicast */
 	uint64_t udps_noportmcast;
 	uint64_t udps_filtermcast;	/* blocked by multicast filter */
+	uint64_t udps_rcvdeferred;	/* queued without reader wakeup */
 };
 
 #ifdef _KERNEL
@@ -169,6 +174,8 @@ udp_get_pcblist(int protocol)
 
 int		udp_newudpcb(struct inpcb *);
 void		udp_discardcb(struct udpcb *);
+void		udp_rcvwakeup(struct inpcb *, struct socket *);
+void		udp_rcvwakeup_stop(struct udpcb *, struct socket *);
 
 void		udp_ctlinput(int, struct sockaddr *, void *);
 void		udplite_ctlinput(int, struct sockaddr *, void *);
@@ -38,17 +38,34 @@ __FBSDID("$FreeBSD$");
 
 #include <sys/param.h>
 #include <sys/systm.h>
+#ifdef __rtems__
+#include <sys/hash.h>
+#endif /* __rtems__ */
 #include <sys/malloc.h>
 #include <sys/mbuf.h>
 #include <sys/domain.h>
 #include <sys/eventhandler.h>
+#ifdef __rtems__
+#include <sys/lock.h>
+#include <sys/mutex.h>
+#endif /* __rtems__ */
 #include <sys/protosw.h>
+#ifdef __rtems__
+#include <sys/rmlock.h>
+#endif /* __rtems__ */
 #include <sys/socket.h>
+#ifdef __rtems__
+#include <sys/sysctl.h>
+#endif /* __rtems__ */
 #include <sys/errno.h>
 #include <sys/time.h>
 #include <sys/kernel.h>
 #include <sys/syslog.h>
 
+#ifdef __rtems__
+#include <machine/atomic.h>
+#endif /* __rtems__ */
+
 #include <net/if.h>
 #include <net/if_var.h>
 #include <net/netisr.h>
@@ -65,6 +82,7 @@ __FBSDID("$FreeBSD$");
 
 #include <security/mac/mac_framework.h>
 
+#ifndef __rtems__
 static void frag6_enq(struct ip6asfrag *, struct ip6asfrag *);
 static void frag6_deq(struct ip6asfrag *);
 static void frag6_insque(struct ip6q *, struct ip6q *);
@@ -78,19 +96,133 @@ static struct mtx ip6qlock;
 static VNET_DEFINE(u_int, frag6_nfragpackets);
 static VNET_DEFINE(u_int, frag6_nfrags);
 static VNET_DEFINE(struct ip6q, ip6q);	/* ip6 reassemble queue */
+#else /* __rtems__ */
+/*
+ * Reassembly headers are stored in hash buckets.  The number of buckets
+ * can be changed at run time, the table is protected by a read-mostly
+ * lock which is only write locked to replace the table.
+ */
+#define	IP6REASS_NHASH_LOG2	8
+#define	IP6REASS_NHASH		(1 << IP6REASS_NHASH_LOG2)
+#define	IP6REASS_NHASH_MAX	(1 << 16)
+
+struct ip6qbucket {
+	struct ip6q	ip6q;		/* reassembly queue head */
+	struct mtx	lock;
+	int		count;
+};
+
+static void frag6_enq(struct ip6asfrag *, struct ip6asfrag *, uint32_t);
+static void frag6_deq(struct ip6asfrag *, uint32_t);
+static void frag6_insque(struct ip6q *, struct ip6q *, uint32_t);
+static void frag6_remque(struct ip6q *, uint32_t);
+static void frag6_freef(struct ip6q *, uint32_t);
+static int sysctl_ip6_reass_hashsize(SYSCTL_HANDLER_ARGS);
+
+/*
+ * The counters are updated atomically, the queues are protected by the
+ * lock of their bucket.
+ */
+static VNET_DEFINE(volatile u_int, frag6_nfragpackets);
+static VNET_DEFINE(volatile u_int, frag6_nfrags);
+static VNET_DEFINE(struct ip6qbucket *, ip6q);
+static VNET_DEFINE(u_int, ip6q_hashsize);
+static VNET_DEFINE(uint32_t, ip6q_hashseed);
+static VNET_DEFINE(struct rmlock, ip6q_hashlock);
+static VNET_DEFINE(int, ip6_maxfragbucketsize);
+#endif /* __rtems__ */
 
 #define	V_frag6_nfragpackets		VNET(frag6_nfragpackets)
 #define	V_frag6_nfrags			VNET(frag6_nfrags)
 #define	V_ip6q				VNET(ip6q)
 
+#ifndef __rtems__
 #define	IP6Q_LOCK_INIT()	mtx_init(&ip6qlock, "ip6qlock", NULL, MTX_DEF);
 #define	IP6Q_LOCK()		mtx_lock(&ip6qlock)
 #define	IP6Q_TRYLOCK()		mtx_trylock(&ip6qlock)
 #define	IP6Q_LOCK_ASSERT()	mtx_assert(&ip6qlock, MA_OWNED)
 #define	IP6Q_UNLOCK()		mtx_unlock(&ip6qlock)
+#else /* __rtems__ */
+#define	V_ip6q_hashsize			VNET(ip6q_hashsize)
+#define	V_ip6q_hashseed			VNET(ip6q_hashseed)
+#define	V_ip6q_hashlock			VNET(ip6q_hashlock)
+#define	V_ip6_maxfragbucketsize		VNET(ip6_maxfragbucketsize)
+
+#define	IP6Q_LOCK(i)		mtx_lock(&V_ip6q[(i)].lock)
+#define	IP6Q_TRYLOCK(i)		mtx_trylock(&V_ip6q[(i)].lock)
+#define	IP6Q_LOCK_ASSERT(i)	mtx_assert(&V_ip6q[(i)].lock, MA_OWNED)
+#define	IP6Q_UNLOCK(i)		mtx_unlock(&V_ip6q[(i)].lock)
+#define	IP6Q_HEAD(i)		(&V_ip6q[(i)].ip6q)
+
+#define	IP6Q_HASH_RLOCK_TRACKER	struct rm_priotracker ip6q_hash_tracker
+#define	IP6Q_HASH_RLOCK()	rm_rlock(&V_ip6q_hashlock, &ip6q_hash_tracker)
+#define	IP6Q_HASH_RUNLOCK()	rm_runlock(&V_ip6q_hashlock, &ip6q_hash_tracker)
+#define	IP6Q_HASH_WLOCK()	rm_wlock(&V_ip6q_hashlock)
+#define	IP6Q_HASH_WUNLOCK()	rm_wunlock(&V_ip6q_hashlock)
+#endif /* __rtems__ */
 
 static MALLOC_DEFINE(M_FTABLE, "fragment", "fragment reassembly header");
 
+#ifdef __rtems__
+SYSCTL_DECL(_net_inet6_ip6);
+
+SYSCTL_INT(_net_inet6_ip6, OID_AUTO, maxfragbucketsize,
+    CTLFLAG_VNET | CTLFLAG_RW, &VNET_NAME(ip6_maxfragbucketsize), 0,
+    "Maximum number of IPv6 fragment reassembly queue entries per bucket"
+    " (0 derives it from maxfragpackets)");
+
+SYSCTL_PROC(_net_inet6_ip6, OID_AUTO, reass_hashsize, CTLFLAG_VNET |
+    CTLTYPE_INT | CTLFLAG_RW, NULL, 0, sysctl_ip6_reass_hashsize, "I",
+    "Number of IPv6 fragment reassembly hash buckets (power of 2)");
+
+static uint32_t
+frag6_hash(const struct in6_addr *src, const struct in6_addr *dst,
+    uint32_t ident, u_int hashsize)
+{
+	uint32_t hashkey[(sizeof(struct in6_addr) * 2 +
+	    sizeof(uint32_t)) / sizeof(uint32_t)];
+
+	memcpy(&hashkey[0], src, sizeof(*src));
+	memcpy(&hashkey[4], dst, sizeof(*dst));
+	hashkey[8] = ident;
+	return (jenkins_hash32(hashkey, nitems(hashkey), V_ip6q_hashseed) &
+	    (hashsize - 1));
+}
+
+/*
+ * Limit of reassembly queues per hash bucket.  A new queue in a full bucket
+ * replaces the oldest queue of the bucket.  Unless set explicitly, each
+ * bucket may hold twice its share of ip6_maxfragpackets.
+ */
+static int
+frag6_bucketmax(void)
+{
+
+	if (V_ip6_maxfragbucketsize > 0)
+		return (V_ip6_maxfragbucketsize);
+	if (V_ip6_maxfragpackets < 0)
+		return (INT_MAX);
+	return (imax(V_ip6_maxfragpackets / imax(V_ip6q_hashsize / 2, 1), 1));
+}
+
+static struct ip6qbucket *
+frag6_hash_alloc(u_int hashsize)
+{
+	struct ip6qbucket *buckets;
+	struct ip6q *head;
+
+	buckets = malloc(hashsize * sizeof(*buckets), M_FTABLE,
+	    M_WAITOK | M_ZERO);
+	for (u_int i = 0; i < hashsize; i++) {
+		head = &buckets[i].ip6q;
+		head->ip6q_next = head->ip6q_prev = head;
+		mtx_init(&buckets[i].lock, "ip6qlock", NULL,
+		    MTX_DEF | MTX_DUPOK);
+	}
+	return (buckets);
+}
+#endif /* __rtems__ */
+
 /*
  * Initialise reassembly queue and fragment identifier.
  */
@@ -108,7 +240,14 @@ frag6_init(void)
 
 	V_ip6_maxfragpackets = nmbclusters / 4;
 	V_ip6_maxfrags = nmbclusters / 4;
+#ifndef __rtems__
 	V_ip6q.ip6q_next = V_ip6q.ip6q_prev = &V_ip6q;
+#else /* __rtems__ */
+	V_ip6q_hashsize = IP6REASS_NHASH;
+	V_ip6q = frag6_hash_alloc(V_ip6q_hashsize);
+	V_ip6q_hashseed = arc4random();
+	rm_init(&V_ip6q_hashlock, "IPv6 reassembly hash");
+#endif /* __rtems__ */
 
 	if (!IS_DEFAULT_VNET(curvnet))
 		return;
@@ -116,8 +255,63 @@ frag6_init(void)
 	EVENTHANDLER_REGISTER(nmbclusters_change,
 	    frag6_change, NULL, EVENTHANDLER_PRI_ANY);
 
+#ifndef __rtems__
 	IP6Q_LOCK_INIT();
+#endif /* __rtems__ */
+}
+
+#ifdef __rtems__
+/*
+ * Replace the hash table.  The reassembly queues are moved to the new table
+ * with the oldest queue of each bucket first, so that the buckets of the new
+ * table keep the oldest queues at their tail.
+ */
+static int
+sysctl_ip6_reass_hashsize(SYSCTL_HANDLER_ARGS)
+{
+	struct ip6qbucket *nbuckets, *obuckets;
+	struct ip6q *head, *q6;
+	u_int ohashsize;
+	uint32_t hash;
+	int error, hashsize;
+
+	hashsize = V_ip6q_hashsize;
+	error = sysctl_handle_int(oidp, &hashsize, 0, req);
+	if (error || !req->newptr)
+		return (error);
+	if (hashsize <= 0 || hashsize > IP6REASS_NHASH_MAX ||
+	    !powerof2(hashsize))
+		return (EINVAL);
+	if ((u_int)hashsize == V_ip6q_hashsize)
+		return (0);
+
+	nbuckets = frag6_hash_alloc(hashsize);
+	IP6Q_HASH_WLOCK();
+	obuckets = V_ip6q;
+	ohashsize = V_ip6q_hashsize;
+	for (u_int i = 0; i < ohashsize; i++) {
+		head = &obuckets[i].ip6q;
+		while ((q6 = head->ip6q_prev) != head) {
+			q6->ip6q_prev->ip6q_next = head;
+			head->ip6q_prev = q6->ip6q_prev;
+			hash = frag6_hash(&q6->ip6q_src, &q6->ip6q_dst,
+			    q6->ip6q_ident, hashsize);
+			q6->ip6q_prev = &nbuckets[hash].ip6q;
+			q6->ip6q_next = nbuckets[hash].ip6q.ip6q_next;
+			nbuckets[hash].ip6q.ip6q_next->ip6q_prev = q6;
+			nbuckets[hash].ip6q.ip6q_next = q6;
+			nbuckets[hash].count++;
+		}
+	}
+	V_ip6q = nbuckets;
+	V_ip6q_hashsize = hashsize;
+	IP6Q_HASH_WUNLOCK();
+	for (u_int i = 0; i < ohashsize; i++)
+		mtx_destroy(&obuckets[i].lock);
+	free(obuckets, M_FTABLE);
+	return (0);
 }
+#endif /* __rtems__ */
 
 /*
  * In RFC2460, fragment and reassembly rule do not agree with each other,
@@ -165,6 +359,10 @@ frag6_input(struct mbuf **mp, int *offp, int proto)
 	int fragoff, frgpartlen;	/* must be larger than u_int16_t */
 	struct ifnet *dstifp;
 	u_int8_t ecn, ecn0;
+#ifdef __rtems__
+	uint32_t hash;
+	IP6Q_HASH_RLOCK_TRACKER;
+#endif /* __rtems__ */
 #ifdef RSS
 	struct m_tag *mtag;
 	struct ip6_direct_ctx *ip6dc;
@@ -230,7 +428,14 @@ frag6_input(struct mbuf **mp, int *offp, int proto)
 		return (ip6f->ip6f_nxt);
 	}
 
+#ifndef __rtems__
 	IP6Q_LOCK();
+#else /* __rtems__ */
+	IP6Q_HASH_RLOCK();
+	hash = frag6_hash(&ip6->ip6_src, &ip6->ip6_dst, ip6f->ip6f_ident,
+	    V_ip6q_hashsize);
+	IP6Q_LOCK(hash);
+#endif /* __rtems__ */
 
 	/*
 	 * Enforce upper bound on number of fragments.
@@ -242,7 +447,12 @@ frag6_input(struct mbuf **mp, int *offp, int proto)
 	else if (V_frag6_nfrags >= (u_int)V_ip6_maxfrags)
 		goto dropfrag;
 
+#ifndef __rtems__
 	for (q6 = V_ip6q.ip6q_next; q6 != &V_ip6q; q6 = q6->ip6q_next)
+#else /* __rtems__ */
+	for (q6 = IP6Q_HEAD(hash)->ip6q_next; q6 != IP6Q_HEAD(hash);
+	     q6 = q6->ip6q_next)
+#endif /* __rtems__ */
 		if (ip6f->ip6f_ident == q6->ip6q_ident &&
 		    IN6_ARE_ADDR_EQUAL(&ip6->ip6_src, &q6->ip6q_src) &&
 		    IN6_ARE_ADDR_EQUAL(&ip6->ip6_dst, &q6->ip6q_dst)
@@ -252,7 +462,11 @@ frag6_input(struct mbuf **mp, int *offp, int proto)
 		    )
 			break;
 
+#ifndef __rtems__
 	if (q6 == &V_ip6q) {
+#else /* __rtems__ */
+	if (q6 == IP6Q_HEAD(hash)) {
+#endif /* __rtems__ */
 		/*
 		 * the first fragment to arrive, create a reassembly queue.
 		 */
@@ -269,20 +483,48 @@ frag6_input(struct mbuf **mp, int *offp, int proto)
 			;
 		else if (V_frag6_nfragpackets >= (u_int)V_ip6_maxfragpackets)
 			goto dropfrag;
+#ifndef __rtems__
 		V_frag6_nfragpackets++;
 		q6 = (struct ip6q *)malloc(sizeof(struct ip6q), M_FTABLE,
 		    M_NOWAIT);
 		if (q6 == NULL)
 			goto dropfrag;
+#else /* __rtems__ */
+		/*
+		 * Make room in a full bucket by dropping its oldest
+		 * reassembly queue.
+		 */
+		if (V_ip6q[hash].count >= frag6_bucketmax()) {
+			IP6STAT_INC(ip6s_reassbucketfull);
+			IP6STAT_ADD(ip6s_fragdropped,
+			    IP6Q_HEAD(hash)->ip6q_prev->ip6q_nfrag);
+			frag6_freef(IP6Q_HEAD(hash)->ip6q_prev, hash);
+		}
+
+		atomic_add_int(&V_frag6_nfragpackets, 1);
+		q6 = (struct ip6q *)malloc(sizeof(struct ip6q), M_FTABLE,
+		    M_NOWAIT);
+		if (q6 == NULL) {
+			atomic_subtract_int(&V_frag6_nfragpackets, 1);
+			goto dropfrag;
+		}
+#endif /* __rtems__ */
 		bzero(q6, sizeof(*q6));
 #ifdef MAC
 		if (mac_ip6q_init(q6, M_NOWAIT) != 0) {
 			free(q6, M_FTABLE);
+#ifdef __rtems__
+			atomic_subtract_int(&V_frag6_nfragpackets, 1);
+#endif /* __rtems__ */
 			goto dropfrag;
 		}
 		mac_ip6q_create(m, q6);
 #endif
+#ifndef __rtems__
 		frag6_insque(q6, &V_ip6q);
+#else /* __rtems__ */
+		frag6_insque(q6, IP6Q_HEAD(hash), hash);
+#endif /* __rtems__ */
 
 		/* ip6q_nxt will be filled afterwards, from 1st fragment */
 		q6->ip6q_down	= q6->ip6q_up = (struct ip6asfrag *)q6;
@@ -323,14 +565,24 @@ frag6_input(struct mbuf **mp, int *offp, int proto)
 			icmp6_error(m, ICMP6_PARAM_PROB, ICMP6_PARAMPROB_HEADER,
 			    offset - sizeof(struct ip6_frag) +
 			    offsetof(struct ip6_frag, ip6f_offlg));
+#ifndef __rtems__
 			IP6Q_UNLOCK();
+#else /* __rtems__ */
+			IP6Q_UNLOCK(hash);
+			IP6Q_HASH_RUNLOCK();
+#endif /* __rtems__ */
 			return (IPPROTO_DONE);
 		}
 	} else if (fragoff + frgpartlen > IPV6_MAXPACKET) {
 		icmp6_error(m, ICMP6_PARAM_PROB, ICMP6_PARAMPROB_HEADER,
 		    offset - sizeof(struct ip6_frag) +
 		    offsetof(struct ip6_frag, ip6f_offlg));
+#ifndef __rtems__
 		IP6Q_UNLOCK();
+#else /* __rtems__ */
+		IP6Q_UNLOCK(hash);
+		IP6Q_HASH_RUNLOCK();
+#endif /* __rtems__ */
 		return (IPPROTO_DONE);
 	}
 	/*
@@ -349,8 +601,17 @@ frag6_input(struct mbuf **mp, int *offp, int proto)
 				int erroff = af6->ip6af_offset;
 
 				/* dequeue the fragment. */
+#ifndef __rtems__
 				frag6_deq(af6);
+#else /* __rtems__ */
+				frag6_deq(af6, hash);
+#endif /* __rtems__ */
 				free(af6, M_FTABLE);
+#ifdef __rtems__
+				q6->ip6q_nfrag--;
+				atomic_subtract_int(&V_frag6_nfrags, 1);
+				q6->ip6q_hole = 1;
+#endif /* __rtems__ */
 
 				/* adjust pointer. */
 				ip6err = mtod(merr, struct ip6_hdr *);
@@ -382,6 +643,9 @@ frag6_input(struct mbuf **mp, int *offp, int proto)
 	IP6_REASS_MBUF(ip6af) = m;
 
 	if (first_frag) {
+#ifdef __rtems__
+		q6->ip6q_hole = fragoff != 0;
+#endif /* __rtems__ */
 		af6 = (struct ip6asfrag *)q6;
 		goto insert;
 	}
@@ -406,6 +670,22 @@ frag6_input(struct mbuf **mp, int *offp, int proto)
 		goto dropfrag;
 	}
 
+#ifdef __rtems__
+	/*
+	 * Fragments usually arrive in order.  If this one begins at or after
+	 * the end of the last fragment, append it without walking the queue.
+	 */
+	af6 = q6->ip6q_up;
+	if (af6 != (struct ip6asfrag *)q6 &&
+	    af6->ip6af_off + af6->ip6af_frglen <= ip6af->ip6af_off) {
+		if (af6->ip6af_off + af6->ip6af_frglen < ip6af->ip6af_off)
+			q6->ip6q_hole = 1;
+		IP6STAT_INC(ip6s_fragappended);
+		af6 = (struct ip6asfrag *)q6;
+		goto insert;
+	}
+
+#endif /* __rtems__ */
 	/*
 	 * Find a segment which begins after this one does.
 	 */
@@ -486,6 +766,10 @@ frag6_input(struct mbuf **mp, int *offp, int proto)
 		}
 	}
 #endif
+#ifdef __rtems__
+	/* Inserted in the middle, check the whole queue below. */
+	q6->ip6q_hole = 1;
+#endif /* __rtems__ */
 
 insert:
 #ifdef MAC
@@ -499,8 +783,13 @@ insert:
 	 * Move to front of packet queue, as we are
 	 * the most recently active fragmented packet.
 	 */
+#ifndef __rtems__
 	frag6_enq(ip6af, af6->ip6af_up);
 	V_frag6_nfrags++;
+#else /* __rtems__ */
+	frag6_enq(ip6af, af6->ip6af_up, hash);
+	atomic_add_int(&V_frag6_nfrags, 1);
+#endif /* __rtems__ */
 	q6->ip6q_nfrag++;
 #if 0 /* xxx */
 	if (q6 != V_ip6q.ip6q_next) {
@@ -508,6 +797,7 @@ insert:
 		frag6_insque(q6, &V_ip6q);
 	}
 #endif
+#ifndef __rtems__
 	next = 0;
 	for (af6 = q6->ip6q_down; af6 != (struct ip6asfrag *)q6;
 	     af6 = af6->ip6af_down) {
@@ -521,6 +811,27 @@ insert:
 		IP6Q_UNLOCK();
 		return IPPROTO_DONE;
 	}
+#else /* __rtems__ */
+	if (q6->ip6q_hole) {
+		next = 0;
+		for (af6 = q6->ip6q_down; af6 != (struct ip6asfrag *)q6;
+		     af6 = af6->ip6af_down) {
+			if (af6->ip6af_off != next) {
+				IP6Q_UNLOCK(hash);
+				IP6Q_HASH_RUNLOCK();
+				return IPPROTO_DONE;
+			}
+			next += af6->ip6af_frglen;
+		}
+		q6->ip6q_hole = 0;
+	} else
+		next = q6->ip6q_up->ip6af_off + q6->ip6q_up->ip6af_frglen;
+	if (q6->ip6q_up->ip6af_mff) {
+		IP6Q_UNLOCK(hash);
+		IP6Q_HASH_RUNLOCK();
+		return IPPROTO_DONE;
+	}
+#endif /* __rtems__ */
 
 	/*
 	 * Reassembly is complete; concatenate fragments.
@@ -528,7 +839,11 @@ insert:
 	ip6af = q6->ip6q_down;
 	t = m = IP6_REASS_MBUF(ip6af);
 	af6 = ip6af->ip6af_down;
+#ifndef __rtems__
 	frag6_deq(ip6af);
+#else /* __rtems__ */
+	frag6_deq(ip6af, hash);
+#endif /* __rtems__ */
 	while (af6 != (struct ip6asfrag *)q6) {
 		m->m_pkthdr.csum_flags &=
 		    IP6_REASS_MBUF(af6)->m_pkthdr.csum_flags;
@@ -536,7 +851,11 @@ insert:
 		    IP6_REASS_MBUF(af6)->m_pkthdr.csum_data;
 
 		af6dwn = af6->ip6af_down;
+#ifndef __rtems__
 		frag6_deq(af6);
+#else /* __rtems__ */
+		frag6_deq(af6, hash);
+#endif /* __rtems__ */
 		while (t->m_next)
 			t = t->m_next;
 		m_adj(IP6_REASS_MBUF(af6), af6->ip6af_offset);
@@ -562,13 +881,22 @@ insert:
 #endif
 
 	if (ip6_deletefraghdr(m, offset, M_NOWAIT) != 0) {
+#ifndef __rtems__
 		frag6_remque(q6);
 		V_frag6_nfrags -= q6->ip6q_nfrag;
+#else /* __rtems__ */
+		frag6_remque(q6, hash);
+		atomic_subtract_int(&V_frag6_nfrags, q6->ip6q_nfrag);
+#endif /* __rtems__ */
 #ifdef MAC
 		mac_ip6q_destroy(q6);
 #endif
 		free(q6, M_FTABLE);
+#ifndef __rtems__
 		V_frag6_nfragpackets--;
+#else /* __rtems__ */
+		atomic_subtract_int(&V_frag6_nfragpackets, 1);
+#endif /* __rtems__ */
 
 		goto dropfrag;
 	}
@@ -581,14 +909,23 @@ insert:
 		*prvnxtp = nxt;
 	}
 
+#ifndef __rtems__
 	frag6_remque(q6);
 	V_frag6_nfrags -= q6->ip6q_nfrag;
+#else /* __rtems__ */
+	frag6_remque(q6, hash);
+	atomic_subtract_int(&V_frag6_nfrags, q6->ip6q_nfrag);
+#endif /* __rtems__ */
 #ifdef MAC
 	mac_ip6q_reassemble(q6, m);
 	mac_ip6q_destroy(q6);
 #endif
 	free(q6, M_FTABLE);
+#ifndef __rtems__
 	V_frag6_nfragpackets--;
+#else /* __rtems__ */
+	atomic_subtract_int(&V_frag6_nfragpackets, 1);
+#endif /* __rtems__ */
 
 	if (m->m_flags & M_PKTHDR) { /* Isn't it always true? */
 		int plen = 0;
@@ -610,7 +947,12 @@ insert:
 	m_tag_prepend(m, mtag);
 #endif
 
+#ifndef __rtems__
 	IP6Q_UNLOCK();
+#else /* __rtems__ */
+	IP6Q_UNLOCK(hash);
+	IP6Q_HASH_RUNLOCK();
+#endif /* __rtems__ */
 	IP6STAT_INC(ip6s_reassembled);
 	in6_ifstat_inc(dstifp, ifs6_reass_ok);
 
@@ -632,7 +974,12 @@ insert:
 	return nxt;
 
  dropfrag:
+#ifndef __rtems__
 	IP6Q_UNLOCK();
+#else /* __rtems__ */
+	IP6Q_UNLOCK(hash);
+	IP6Q_HASH_RUNLOCK();
+#endif /* __rtems__ */
 	in6_ifstat_inc(dstifp, ifs6_reass_fail);
 	IP6STAT_INC(ip6s_fragdropped);
 	m_freem(m);
@@ -643,19 +990,32 @@ insert:
  * Free a fragment reassembly header and all
  * associated datagrams.
  */
+#ifndef __rtems__
 void
 frag6_freef(struct ip6q *q6)
+#else /* __rtems__ */
+void
+frag6_freef(struct ip6q *q6, uint32_t bucket)
+#endif /* __rtems__ */
 {
 	struct ip6asfrag *af6, *down6;
 
+#ifndef __rtems__
 	IP6Q_LOCK_ASSERT();
+#else /* __rtems__ */
+	IP6Q_LOCK_ASSERT(bucket);
+#endif /* __rtems__ */
 
 	for (af6 = q6->ip6q_down; af6 != (struct ip6asfrag *)q6;
 	     af6 = down6) {
 		struct mbuf *m = IP6_REASS_MBUF(af6);
 
 		down6 = af6->ip6af_down;
+#ifndef __rtems__
 		frag6_deq(af6);
+#else /* __rtems__ */
+		frag6_deq(af6, bucket);
+#endif /* __rtems__ */
 
 		/*
 		 * Return ICMP time exceeded error for the 1st fragment.
@@ -677,24 +1037,42 @@ frag6_freef(struct ip6q *q6)
 			m_freem(m);
 		free(af6, M_FTABLE);
 	}
+#ifndef __rtems__
 	frag6_remque(q6);
 	V_frag6_nfrags -= q6->ip6q_nfrag;
+#else /* __rtems__ */
+	frag6_remque(q6, bucket);
+	atomic_subtract_int(&V_frag6_nfrags, q6->ip6q_nfrag);
+#endif /* __rtems__ */
 #ifdef MAC
 	mac_ip6q_destroy(q6);
 #endif
 	free(q6, M_FTABLE);
+#ifndef __rtems__
 	V_frag6_nfragpackets--;
+#else /* __rtems__ */
+	atomic_subtract_int(&V_frag6_nfragpackets, 1);
+#endif /* __rtems__ */
 }
 
 /*
  * Put an ip fragment on a reassembly chain.
  * Like insque, but pointers in middle of structure.
  */
+#ifndef __rtems__
 void
 frag6_enq(struct ip6asfrag *af6, struct ip6asfrag *up6)
+#else /* __rtems__ */
+void
+frag6_enq(struct ip6asfrag *af6, struct ip6asfrag *up6, uint32_t bucket)
+#endif /* __rtems__ */
 {
 
+#ifndef __rtems__
 	IP6Q_LOCK_ASSERT();
+#else /* __rtems__ */
+	IP6Q_LOCK_ASSERT(bucket);
+#endif /* __rtems__ */
 
 	af6->ip6af_up = up6;
 	af6->ip6af_down = up6->ip6af_down;
@@ -705,36 +1083,69 @@ frag6_enq(struct ip6asfrag *af6, struct ip6asfrag *up6)
 /*
  * To frag6_enq as remque is to insque.
  */
+#ifndef __rtems__
 void
 frag6_deq(struct ip6asfrag *af6)
+#else /* __rtems__ */
+void
+frag6_deq(struct ip6asfrag *af6, uint32_t bucket)
+#endif /* __rtems__ */
 {
 
+#ifndef __rtems__
 	IP6Q_LOCK_ASSERT();
+#else /* __rtems__ */
+	IP6Q_LOCK_ASSERT(bucket);
+#endif /* __rtems__ */
 
 	af6->ip6af_up->ip6af_down = af6->ip6af_down;
 	af6->ip6af_down->ip6af_up = af6->ip6af_up;
 }
 
+#ifndef __rtems__
 void
 frag6_insque(struct ip6q *new, struct ip6q *old)
+#else /* __rtems__ */
+void
+frag6_insque(struct ip6q *new, struct ip6q *old, uint32_t bucket)
+#endif /* __rtems__ */
 {
 
+#ifndef __rtems__
 	IP6Q_LOCK_ASSERT();
+#else /* __rtems__ */
+	IP6Q_LOCK_ASSERT(bucket);
+#endif /* __rtems__ */
 
 	new->ip6q_prev = old;
 	new->ip6q_next = old->ip6q_next;
 	old->ip6q_next->ip6q_prev= new;
 	old->ip6q_next = new;
+#ifdef __rtems__
+	V_ip6q[bucket].count++;
+#endif /* __rtems__ */
 }
 
+#ifndef __rtems__
 void
 frag6_remque(struct ip6q *p6)
+#else /* __rtems__ */
+void
+frag6_remque(struct ip6q *p6, uint32_t bucket)
+#endif /* __rtems__ */
 {
 
+#ifndef __rtems__
 	IP6Q_LOCK_ASSERT();
+#else /* __rtems__ */
+	IP6Q_LOCK_ASSERT(bucket);
+#endif /* __rtems__ */
 
 	p6->ip6q_prev->ip6q_next = p6->ip6q_next;
 	p6->ip6q_next->ip6q_prev = p6->ip6q_prev;
+#ifdef __rtems__
+	V_ip6q[bucket].count--;
+#endif /* __rtems__ */
 }
 
 /*
@@ -746,8 +1157,15 @@ void
 frag6_slowtimo(void)
 {
 	VNET_ITERATOR_DECL(vnet_iter);
+#ifndef __rtems__
 	struct ip6q *q6;
+#else /* __rtems__ */
+	struct ip6q *head, *q6;
+	u_int i;
+	IP6Q_HASH_RLOCK_TRACKER;
+#endif /* __rtems__ */
 
+#ifndef __rtems__
 	VNET_LIST_RLOCK_NOSLEEP();
 	IP6Q_LOCK();
 	VNET_FOREACH(vnet_iter) {
@@ -778,6 +1196,43 @@ frag6_slowtimo(void)
 	}
 	IP6Q_UNLOCK();
 	VNET_LIST_RUNLOCK_NOSLEEP();
+#else /* __rtems__ */
+	VNET_LIST_RLOCK_NOSLEEP();
+	VNET_FOREACH(vnet_iter) {
+		CURVNET_SET(vnet_iter);
+		IP6Q_HASH_RLOCK();
+		for (i = 0; i < V_ip6q_hashsize; i++) {
+			IP6Q_LOCK(i);
+			head = IP6Q_HEAD(i);
+			q6 = head->ip6q_next;
+			while (q6 != head) {
+				--q6->ip6q_ttl;
+				q6 = q6->ip6q_next;
+				if (q6->ip6q_prev->ip6q_ttl == 0) {
+					IP6STAT_INC(ip6s_fragtimeout);
+					/* XXX in6_ifstat_inc(ifp, ifs6_reass_fail) */
+					frag6_freef(q6->ip6q_prev, i);
+				}
+			}
+			/*
+			 * If we are over the maximum number of fragments
+			 * (due to the limit being lowered), drain off
+			 * enough to get down to the new limit.
+			 */
+			while (V_ip6_maxfragpackets >= 0 &&
+			    V_frag6_nfragpackets > (u_int)V_ip6_maxfragpackets &&
+			    head->ip6q_prev != head) {
+				IP6STAT_INC(ip6s_fragoverflow);
+				/* XXX in6_ifstat_inc(ifp, ifs6_reass_fail) */
+				frag6_freef(head->ip6q_prev, i);
+			}
+			IP6Q_UNLOCK(i);
+		}
+		IP6Q_HASH_RUNLOCK();
+		CURVNET_RESTORE();
+	}
+	VNET_LIST_RUNLOCK_NOSLEEP();
+#endif /* __rtems__ */
 }
 
 /*
@@ -787,7 +1242,13 @@ void
 frag6_drain(void)
 {
 	VNET_ITERATOR_DECL(vnet_iter);
+#ifdef __rtems__
+	struct ip6q *head;
+	u_int i;
+	IP6Q_HASH_RLOCK_TRACKER;
+#endif /* __rtems__ */
 
+#ifndef __rtems__
 	VNET_LIST_RLOCK_NOSLEEP();
 	if (IP6Q_TRYLOCK() == 0) {
 		VNET_LIST_RUNLOCK_NOSLEEP();
@@ -804,6 +1265,27 @@ frag6_drain(void)
 	}
 	IP6Q_UNLOCK();
 	VNET_LIST_RUNLOCK_NOSLEEP();
+#else /* __rtems__ */
+	VNET_LIST_RLOCK_NOSLEEP();
+	VNET_FOREACH(vnet_iter) {
+		CURVNET_SET(vnet_iter);
+		IP6Q_HASH_RLOCK();
+		for (i = 0; i < V_ip6q_hashsize; i++) {
+			if (IP6Q_TRYLOCK(i) == 0)
+				continue;
+			head = IP6Q_HEAD(i);
+			while (head->ip6q_next != head) {
+				IP6STAT_INC(ip6s_fragdropped);
+				/* XXX in6_ifstat_inc(ifp, ifs6_reass_fail) */
+				frag6_freef(head->ip6q_next, i);
+			}
+			IP6Q_UNLOCK(i);
+		}
+		IP6Q_HASH_RUNLOCK();
+		CURVNET_RESTORE();
+	}
+	VNET_LIST_RUNLOCK_NOSLEEP();
+#endif /* __rtems__ */
 }
 
 int
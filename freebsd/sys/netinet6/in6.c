@@ -1093,6 +1093,10 @@ in6_alloc_ifa(struct ifnet *ifp, struct in6_aliasreq *ifra, int flags)
 	ia->ia_ifp = ifp;
 	ifa_ref(&ia->ia_ifa);			/* if_addrhead */
 	IF_ADDR_WLOCK(ifp);
+#ifdef __rtems__
+	/* Publish the initialized address to network epoch readers */
+	atomic_thread_fence_rel();
+#endif /* __rtems__ */
 	TAILQ_INSERT_TAIL(&ifp->if_addrhead, &ia->ia_ifa, ifa_link);
 	IF_ADDR_WUNLOCK(ifp);
 
@@ -2021,6 +2025,9 @@ static void
 in6_lltable_destroy_lle_unlocked(struct llentry *lle)
 {
 
+#ifdef __rtems__
+	lltable_read_synchronize();
+#endif /* __rtems__ */
 	LLE_LOCK_DESTROY(lle);
 	LLE_REQ_DESTROY(lle);
 	free(lle, M_LLTABLE);
@@ -2261,7 +2268,12 @@ in6_lltable_lookup(struct lltable *llt, u_int flags,
 	const struct sockaddr_in6 *sin6 = (const struct sockaddr_in6 *)l3addr;
 	struct llentry *lle;
 
+#ifndef __rtems__
 	IF_AFDATA_LOCK_ASSERT(llt->llt_ifp);
+#else /* __rtems__ */
+	if ((flags & LLE_UNLOCKED) == 0)
+		IF_AFDATA_LOCK_ASSERT(llt->llt_ifp);
+#endif /* __rtems__ */
 	KASSERT(l3addr->sa_family == AF_INET6,
 	    ("sin_family %d", l3addr->sa_family));
 
@@ -319,6 +319,9 @@ ip6_output(struct mbuf *m0, struct ip6_pktopts *opt,
 	struct route_in6 *ro_pmtu = NULL;
 	int hdrsplit = 0;
 	int sw_csum, tso;
+#ifdef __rtems__
+	uint64_t hwassist;
+#endif /* __rtems__ */
 	int needfiblookup;
 	uint32_t fibnum;
 	struct m_tag *fwd_tag = NULL;
@@ -885,11 +888,22 @@ passout:
 	 *	error, as we cannot handle this conflicting request
 	 */
 	sw_csum = m->m_pkthdr.csum_flags;
+#ifndef __rtems__
 	if (!hdrsplit) {
 		tso = ((sw_csum & ifp->if_hwassist & CSUM_TSO) != 0) ? 1 : 0;
 		sw_csum &= ~ifp->if_hwassist;
 	} else
 		tso = 0;
+#else /* __rtems__ */
+	if (!hdrsplit) {
+		hwassist = IF_GSO_HWASSIST(ifp, m);
+		tso = ((sw_csum & hwassist & CSUM_TSO) != 0) ? 1 : 0;
+		sw_csum &= ~hwassist;
+	} else {
+		hwassist = ifp->if_hwassist;
+		tso = 0;
+	}
+#endif /* __rtems__ */
 	/*
 	 * If we added extension headers, we will not do TSO and calculate the
 	 * checksums ourselves for now.
@@ -906,7 +920,11 @@ passout:
 		sctp_delayed_cksum(m, sizeof(struct ip6_hdr));
 	}
 #endif
+#ifndef __rtems__
 	m->m_pkthdr.csum_flags &= ifp->if_hwassist;
+#else /* __rtems__ */
+	m->m_pkthdr.csum_flags &= hwassist;
+#endif /* __rtems__ */
 	tlen = m->m_pkthdr.len;
 
 	if ((opt && (opt->ip6po_flags & IP6PO_DONTFRAG)) || tso)
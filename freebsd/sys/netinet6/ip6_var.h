@@ -75,6 +75,9 @@ struct	ip6q {
 	u_int8_t	ip6q_nxt;
 	u_int8_t	ip6q_ecn;
 	u_int8_t	ip6q_ttl;
+#ifdef __rtems__
+	u_int8_t	ip6q_hole;	/* fragments are not contiguous */
+#endif /* __rtems__ */
 	struct in6_addr ip6q_src, ip6q_dst;
 	struct ip6q	*ip6q_next;
 	struct ip6q	*ip6q_prev;
@@ -251,6 +254,11 @@ struct	ip6stat {
 
 	/* number of times that each rule of source selection is applied. */
 	uint64_t ip6s_sources_rule[IP6S_RULESMAX];
+
+#ifdef __rtems__
+	uint64_t ip6s_fragappended;	/* fragments appended in order */
+	uint64_t ip6s_reassbucketfull;	/* reass queues dropped, bucket full */
+#endif /* __rtems__ */
 };
 
 #ifdef _KERNEL
@@ -2288,6 +2288,29 @@ nd6_resolve(struct ifnet *ifp, int is_gw, struct mbuf *m,
 		}
 	}
 
+#ifdef __rtems__
+	if (plle == NULL) {
+		lltable_read_enter();
+		ln = lla_lookup(LLTABLE6(ifp), LLE_UNLOCKED, sa_dst);
+		if (ln != NULL && (ln->r_flags & RLLE_VALID) != 0 &&
+		    ln->r_skip_req == 0) {
+			atomic_thread_fence_acq();
+			if (lltable_read_linkhdr(ln, desten) != 0) {
+				if (pflags != NULL)
+					*pflags = LLE_VALID |
+					    (ln->r_flags & RLLE_IFADDR);
+				lltable_read_exit();
+				return (0);
+			}
+		}
+		lltable_read_exit();
+		/*
+		 * Use the locked path below to resolve the entry, to answer
+		 * the feedback request from the nd6 timer or if the header
+		 * changed during the copy.
+		 */
+	}
+#endif /* __rtems__ */
 	IF_AFDATA_RLOCK(ifp);
 	ln = nd6_lookup(&dst6->sin6_addr, plle ? LLE_EXCLUSIVE : LLE_UNLOCKED,
 	    ifp);
@@ -199,7 +199,7 @@ udp6_append(struct inpcb *inp, struct mbuf *n, int off,
 			m_freem(opts);
 		UDPSTAT_INC(udps_fullsock);
 	} else
-		sorwakeup_locked(so);
+		udp_rcvwakeup(inp, so);
 	return (0);
 }
 
@@ -1174,6 +1174,7 @@ udp6_detach(struct socket *so)
 	INP_WLOCK(inp);
 	up = intoudpcb(inp);
 	KASSERT(up != NULL, ("%s: up == NULL", __func__));
+	udp_rcvwakeup_stop(up, so);
 	in_pcbdetach(inp);
 	in_pcbfree(inp);
 	INP_INFO_WUNLOCK(pcbinfo);
@@ -173,6 +173,52 @@ static VNET_DEFINE(u_long, sphash_mask);
 #define	SPHASH_HASHVAL(id)	(key_u32hash(id) & V_sphash_mask)
 #define	SPHASH_HASH(id)		&V_sphashtbl[SPHASH_HASHVAL(id)]
 
+/*
+ * SPD cache.  Outbound and inbound packets of the same flow share the same
+ * exact secpolicyindex, so the result of the linear SPD scan is cached per
+ * index.  An entry is only valid for the SPD generation it was looked up
+ * in, any change of the SPD invalidates all entries.
+ */
+struct spdcache_entry {
+	struct secpolicyindex spidx;	/* secpolicyindex */
+	struct secpolicy *sp;		/* cached policy to be used */
+	uint32_t genid;			/* SPD generation of the lookup */
+
+	LIST_ENTRY(spdcache_entry) chain;
+};
+LIST_HEAD(spdcache_entry_list, spdcache_entry);
+
+#define	SPDCACHE_MAX_ENTRIES_PER_HASH	8
+
+static VNET_DEFINE(u_int, key_spdcache_maxentries) = 2048;
+#define	V_key_spdcache_maxentries	VNET(key_spdcache_maxentries)
+static VNET_DEFINE(u_int, key_spdcache_threshold) = 32;
+#define	V_key_spdcache_threshold	VNET(key_spdcache_threshold)
+static VNET_DEFINE(u_long, spd_size) = 0;
+#define	V_spd_size		VNET(spd_size)
+
+#define	SPDCACHE_ENABLED()	(V_key_spdcache_maxentries != 0)
+#define	SPDCACHE_ACTIVE()	\
+    (SPDCACHE_ENABLED() && V_spd_size >= V_key_spdcache_threshold)
+
+static VNET_DEFINE(struct spdcache_entry_list *, spdcachehashtbl);
+static VNET_DEFINE(u_long, spdcachehash_mask);
+#define	V_spdcachehashtbl	VNET(spdcachehashtbl)
+#define	V_spdcachehash_mask	VNET(spdcachehash_mask)
+
+#define	SPDCACHE_HASHVAL(idx)	\
+    (key_spidxhash(idx) & V_spdcachehash_mask)
+
+/* Each cache line is protected by a mutex */
+static VNET_DEFINE(struct mtx *, spdcache_lock);
+#define	V_spdcache_lock		VNET(spdcache_lock)
+#define	SPDCACHE_LOCK_INIT(a) \
+	mtx_init(&V_spdcache_lock[a], "spdcache", \
+	    "fast ipsec SPD cache", MTX_DEF|MTX_DUPOK)
+#define	SPDCACHE_LOCK_DESTROY(a)	mtx_destroy(&V_spdcache_lock[a])
+#define	SPDCACHE_LOCK(a)		mtx_lock(&V_spdcache_lock[a])
+#define	SPDCACHE_UNLOCK(a)		mtx_unlock(&V_spdcache_lock[a])
+
 /* SAD */
 TAILQ_HEAD(secashead_queue, secashead);
 LIST_HEAD(secashead_list, secashead);
@@ -253,6 +299,44 @@ key_u32hash(uint32_t val)
 	return (fnv_32_buf(&val, sizeof(val), FNV1_32_INIT));
 }
 
+static uint32_t
+key_spidxhash(const struct secpolicyindex *spidx)
+{
+	uint32_t hval;
+
+	hval = fnv_32_buf(&spidx->ul_proto, sizeof(spidx->ul_proto),
+	    FNV1_32_INIT);
+	switch (spidx->dst.sa.sa_family) {
+#ifdef INET
+	case AF_INET:
+		hval = fnv_32_buf(&spidx->src.sin.sin_addr,
+		    sizeof(in_addr_t), hval);
+		hval = fnv_32_buf(&spidx->dst.sin.sin_addr,
+		    sizeof(in_addr_t), hval);
+		hval = fnv_32_buf(&spidx->src.sin.sin_port,
+		    sizeof(in_port_t), hval);
+		hval = fnv_32_buf(&spidx->dst.sin.sin_port,
+		    sizeof(in_port_t), hval);
+		break;
+#endif
+#ifdef INET6
+	case AF_INET6:
+		hval = fnv_32_buf(&spidx->src.sin6.sin6_addr,
+		    sizeof(struct in6_addr), hval);
+		hval = fnv_32_buf(&spidx->dst.sin6.sin6_addr,
+		    sizeof(struct in6_addr), hval);
+		hval = fnv_32_buf(&spidx->src.sin6.sin6_port,
+		    sizeof(in_port_t), hval);
+		hval = fnv_32_buf(&spidx->dst.sin6.sin6_port,
+		    sizeof(in_port_t), hval);
+		break;
+#endif
+	default:
+		hval = 0;
+	}
+	return (hval);
+}
+
 							/* registed list */
 static VNET_DEFINE(LIST_HEAD(_regtree, secreg), regtree[SADB_SATYPE_MAX + 1]);
 #define	V_regtree		VNET(regtree)
@@ -463,6 +547,17 @@ SYSCTL_INT(_net_key, KEYCTL_AH_KEYMIN, ah_keymin,
 SYSCTL_INT(_net_key, KEYCTL_PREFERED_OLDSA, preferred_oldsa,
 	CTLFLAG_VNET | CTLFLAG_RW, &VNET_NAME(key_preferred_oldsa), 0, "");
 
+static SYSCTL_NODE(_net_key, OID_AUTO, spdcache, CTLFLAG_RW, 0, "SPD cache");
+
+SYSCTL_UINT(_net_key_spdcache, OID_AUTO, maxentries,
+	CTLFLAG_VNET | CTLFLAG_RDTUN, &VNET_NAME(key_spdcache_maxentries), 0,
+	"Maximum number of entries in the SPD cache"
+	" (power of 2, 0 to disable)");
+
+SYSCTL_UINT(_net_key_spdcache, OID_AUTO, threshold,
+	CTLFLAG_VNET | CTLFLAG_RW, &VNET_NAME(key_spdcache_threshold), 0,
+	"Number of SPs that make the SPD cache active");
+
 #define __LIST_CHAINED(elm) \
 	(!((elm)->chain.le_next == NULL && (elm)->chain.le_prev == NULL))
 
@@ -473,6 +568,7 @@ MALLOC_DEFINE(M_IPSEC_SR, "ipsecrequest", "ipsec security request");
 MALLOC_DEFINE(M_IPSEC_MISC, "ipsec-misc", "ipsec miscellaneous");
 MALLOC_DEFINE(M_IPSEC_SAQ, "ipsec-saq", "ipsec sa acquire");
 MALLOC_DEFINE(M_IPSEC_SAR, "ipsec-reg", "ipsec sa acquire");
+MALLOC_DEFINE(M_IPSEC_SPDCACHE, "ipsec-spdcache", "ipsec SPD cache");
 
 static VNET_DEFINE(uma_zone_t, key_lft_zone);
 #define	V_key_lft_zone		VNET(key_lft_zone)
@@ -805,16 +901,12 @@ key_checksockaddrs(struct sockaddr *src, struct sockaddr *dst)
  * OUT:	NULL:	not found
  *	others:	found and return the pointer.
  */
-struct secpolicy *
-key_allocsp(struct secpolicyindex *spidx, u_int dir)
+static struct secpolicy *
+key_do_allocsp(struct secpolicyindex *spidx, u_int dir, uint32_t *genid)
 {
 	SPTREE_RLOCK_TRACKER;
 	struct secpolicy *sp;
 
-	IPSEC_ASSERT(spidx != NULL, ("null spidx"));
-	IPSEC_ASSERT(dir == IPSEC_DIR_INBOUND || dir == IPSEC_DIR_OUTBOUND,
-		("invalid direction %u", dir));
-
 	SPTREE_RLOCK();
 	TAILQ_FOREACH(sp, &V_sptree[dir], chain) {
 		if (key_cmpspidx_withmask(&sp->spidx, spidx)) {
@@ -822,8 +914,172 @@ key_allocsp(struct secpolicyindex *spidx, u_int dir)
 			break;
 		}
 	}
+	*genid = V_sp_genid;
 	SPTREE_RUNLOCK();
+	return (sp);
+}
+
+static struct spdcache_entry *
+spdcache_entry_alloc(const struct secpolicyindex *spidx, struct secpolicy *sp,
+    uint32_t genid)
+{
+	struct spdcache_entry *entry;
+
+	entry = malloc(sizeof(struct spdcache_entry), M_IPSEC_SPDCACHE,
+	    M_NOWAIT | M_ZERO);
+	if (entry == NULL)
+		return (NULL);
+
+	if (sp != NULL)
+		SP_ADDREF(sp);
+
+	entry->spidx = *spidx;
+	entry->sp = sp;
+	entry->genid = genid;
+
+	return (entry);
+}
+
+static void
+spdcache_entry_free(struct spdcache_entry *entry)
+{
+
+	if (entry->sp != NULL)
+		key_freesp(&entry->sp);
+	free(entry, M_IPSEC_SPDCACHE);
+}
+
+/*
+ * Remove all entries from the SPD cache.  Stale entries are also dropped
+ * lazily during lookups, this is used to release the references to the
+ * cached SPs early.
+ */
+static void
+spdcache_clear(void)
+{
+	struct spdcache_entry *entry;
+	int i;
+
+	if (!SPDCACHE_ENABLED())
+		return;
+
+	for (i = 0; i < V_spdcachehash_mask + 1; ++i) {
+		SPDCACHE_LOCK(i);
+		while (!LIST_EMPTY(&V_spdcachehashtbl[i])) {
+			entry = LIST_FIRST(&V_spdcachehashtbl[i]);
+			LIST_REMOVE(entry, chain);
+			spdcache_entry_free(entry);
+		}
+		SPDCACHE_UNLOCK(i);
+	}
+}
+
+static void
+spdcache_init(void)
+{
+	int i;
+
+	TUNABLE_INT_FETCH("net.key.spdcache.maxentries",
+	    &V_key_spdcache_maxentries);
+	TUNABLE_INT_FETCH("net.key.spdcache.threshold",
+	    &V_key_spdcache_threshold);
+
+	if (!SPDCACHE_ENABLED())
+		return;
+
+	/* Round up to the next power of 2 */
+	V_key_spdcache_maxentries = (u_int)1 <<
+	    fls(V_key_spdcache_maxentries - 1);
+	V_spdcachehashtbl = hashinit(MAX(V_key_spdcache_maxentries /
+	    SPDCACHE_MAX_ENTRIES_PER_HASH, 1), M_IPSEC_SPDCACHE,
+	    &V_spdcachehash_mask);
+	V_spdcache_lock = malloc(sizeof(struct mtx) *
+	    (V_spdcachehash_mask + 1), M_IPSEC_SPDCACHE, M_WAITOK | M_ZERO);
+	for (i = 0; i < V_spdcachehash_mask + 1; ++i)
+		SPDCACHE_LOCK_INIT(i);
+}
+
+#ifdef VIMAGE
+static void
+spdcache_destroy(void)
+{
+	int i;
+
+	if (!SPDCACHE_ENABLED())
+		return;
+
+	spdcache_clear();
+	hashdestroy(V_spdcachehashtbl, M_IPSEC_SPDCACHE, V_spdcachehash_mask);
+	for (i = 0; i < V_spdcachehash_mask + 1; ++i)
+		SPDCACHE_LOCK_DESTROY(i);
+	free(V_spdcache_lock, M_IPSEC_SPDCACHE);
+}
+#endif
+
+struct secpolicy *
+key_allocsp(struct secpolicyindex *spidx, u_int dir)
+{
+	struct spdcache_entry *entry, *lastentry, *tmpentry;
+	struct secpolicy *sp;
+	uint32_t hashv, genid;
+	int nb_entries;
+
+	IPSEC_ASSERT(spidx != NULL, ("null spidx"));
+	IPSEC_ASSERT(dir == IPSEC_DIR_INBOUND || dir == IPSEC_DIR_OUTBOUND,
+		("invalid direction %u", dir));
+
+	if (!SPDCACHE_ACTIVE()) {
+		sp = key_do_allocsp(spidx, dir, &genid);
+		goto out;
+	}
+
+	hashv = SPDCACHE_HASHVAL(spidx);
+	genid = V_sp_genid;
+	lastentry = NULL;
+	nb_entries = 0;
+	SPDCACHE_LOCK(hashv);
+	LIST_FOREACH_SAFE(entry, &V_spdcachehashtbl[hashv], chain, tmpentry) {
+		/* Remove entries of an older SPD generation */
+		if (entry->genid != genid) {
+			LIST_REMOVE(entry, chain);
+			spdcache_entry_free(entry);
+			continue;
+		}
+
+		nb_entries++;
+		if (entry->spidx.dir != dir ||
+		    !key_cmpspidx_exactly(&entry->spidx, spidx)) {
+			lastentry = entry;
+			continue;
+		}
+
+		sp = entry->sp;
+		if (sp != NULL)
+			SP_ADDREF(sp);
+		SPDCACHE_UNLOCK(hashv);
+
+		IPSECSTAT_INC(ips_spdcache_hits);
+		goto out;
+	}
+
+	IPSECSTAT_INC(ips_spdcache_misses);
+
+	sp = key_do_allocsp(spidx, dir, &genid);
+	entry = spdcache_entry_alloc(spidx, sp, genid);
+	if (entry != NULL) {
+		entry->spidx.dir = dir;
+		if (nb_entries >= SPDCACHE_MAX_ENTRIES_PER_HASH &&
+		    lastentry != NULL) {
+			LIST_REMOVE(lastentry, chain);
+			spdcache_entry_free(lastentry);
+		}
+
+		LIST_INSERT_HEAD(&V_spdcachehashtbl[hashv], entry, chain);
+	}
+
+	SPDCACHE_UNLOCK(hashv);
 
+out:
 	if (sp != NULL) {	/* found a SPD entry */
 		sp->lastused = time_second;
 		KEYDBG(IPSEC_STAMP,
@@ -1106,6 +1362,7 @@ key_unlink(struct secpolicy *sp)
 	}
 	sp->state = IPSEC_SPSTATE_DEAD;
 	TAILQ_REMOVE(&V_sptree[sp->spidx.dir], sp, chain);
+	V_spd_size--;
 	LIST_REMOVE(sp, idhash);
 	V_sp_genid++;
 	SPTREE_WUNLOCK();
@@ -1131,6 +1388,7 @@ key_insertsp(struct secpolicy *newsp)
 done:
 	LIST_INSERT_HEAD(SPHASH_HASH(newsp->id), newsp, idhash);
 	newsp->state = IPSEC_SPSTATE_ALIVE;
+	V_spd_size++;
 	V_sp_genid++;
 }
 
@@ -2375,8 +2633,10 @@ key_spdflush(struct socket *so, struct mbuf *m, const struct sadb_msghdr *mhp)
 		sp->state = IPSEC_SPSTATE_DEAD;
 		LIST_REMOVE(sp, idhash);
 	}
+	V_spd_size = 0;
 	V_sp_genid++;
 	SPTREE_WUNLOCK();
+	spdcache_clear();
 	sp = TAILQ_FIRST(&drainq);
 	while (sp != NULL) {
 		nextsp = TAILQ_NEXT(sp, chain);
@@ -4321,6 +4581,7 @@ key_flush_spd(time_t now)
 			continue;
 		}
 		TAILQ_REMOVE(&V_sptree[sp->spidx.dir], sp, chain);
+		V_spd_size--;
 		LIST_REMOVE(sp, idhash);
 		sp->state = IPSEC_SPSTATE_DEAD;
 		sp = nextsp;
@@ -8076,6 +8337,7 @@ key_init(void)
 	    &V_acqaddrhash_mask);
 	V_acqseqhashtbl = hashinit(ACQHASH_NHASH, M_IPSEC_SAQ,
 	    &V_acqseqhash_mask);
+	spdcache_init();
 
 	for (i = 0; i <= SADB_SATYPE_MAX; i++)
 		LIST_INIT(&V_regtree[i]);
@@ -8130,6 +8392,7 @@ key_destroy(void)
 		TAILQ_CONCAT(&drainq, &V_sptree_ifnet[i], chain);
 	}
 	SPTREE_WUNLOCK();
+	spdcache_destroy();
 	sp = TAILQ_FIRST(&drainq);
 	while (sp != NULL) {
 		nextsp = TAILQ_NEXT(sp, chain);
@@ -1884,6 +1884,780 @@ struct table_algo addr_hash = {
 	.modify		= ta_modify_chash,
 	.flush_mod	= ta_flush_mod_chash,
 };
+#ifdef __rtems__
+/*
+ * addr:dir16_8 cmds
+ *
+ *
+ * IPv4 multibit trie with 16/8/8 strides. This is the DIR-24-8 scheme
+ * with the first level split so that the always present level 1 array
+ * stays at 64k slots instead of 16M slots. Any lookup costs at most
+ * three dependent memory reads regardless of the number of prefixes in
+ * the table. IPv6 keys are not supported.
+ *
+ * Every prefix longer than /16 needs a chunk of DIR_CHUNK_SIZE slots
+ * per distinct /16 (and /24 for prefixes longer than /24) it falls
+ * into, so the memory footprint depends on how the prefixes are spread
+ * over the address space rather than on their number only.
+ *
+ * ti->state: level 1 array of DIR_L1_SIZE slots.
+ *
+ * Each slot is either
+ * 0: no match;
+ * struct dir_pfx pointer with DIR_SLOT_PFX bit set: longest match;
+ * struct dir_chunk pointer: next level array of DIR_CHUNK_SIZE slots.
+ *
+ * Prefixes are also linked into the cfg->head hash keyed by address and
+ * mask length. The hash is used by the control path only to detect
+ * duplicates and to find the covering prefix which has to be restored
+ * in the trie on deletion.
+ *
+ * All trie modifications are done under IPFW_WLOCK. Lookups from
+ * ipfw_chk() run with the IPFW read lock held, so they never observe a
+ * partially updated trie and the table is updated in place instead of
+ * building and swapping a new copy, which would need another 64k slot
+ * array per update. New chunks are completely filled in before they get
+ * linked into the trie.
+ *
+ * pflags:
+ * [hsize]
+ * [   32]
+ */
+
+#define	DIR_L1_BITS	16
+#define	DIR_L1_SIZE	(1 << DIR_L1_BITS)
+#define	DIR_CHUNK_BITS	8
+#define	DIR_CHUNK_SIZE	(1 << DIR_CHUNK_BITS)
+#define	DIR_HASH_MAX	(1 << 20)
+
+#define	DIR_SLOT_PFX		((uintptr_t)1)
+#define	DIR_IS_CHUNK(s)		((s) != 0 && ((s) & DIR_SLOT_PFX) == 0)
+#define	DIR_PFX2SLOT(p)		((uintptr_t)(p) | DIR_SLOT_PFX)
+#define	DIR_SLOT2PFX(s)		((struct dir_pfx *)((s) & ~DIR_SLOT_PFX))
+#define	DIR_SLOT2CHUNK(s)	((struct dir_chunk *)(s))
+
+struct dir_pfx;
+
+SLIST_HEAD(dir_bhead, dir_pfx);
+
+struct dir_pfx {
+	SLIST_ENTRY(dir_pfx)	next;
+	uint32_t	addr;		/* Host format, masked */
+	uint32_t	value;
+	uint8_t		masklen;
+};
+
+struct dir_chunk {
+	uintptr_t	slot[DIR_CHUNK_SIZE];
+};
+
+struct dir_cfg {
+	uintptr_t	*l1;
+	struct dir_bhead *head;
+	size_t		size;
+	size_t		items;
+	size_t		chunks;
+};
+
+struct ta_buf_dir
+{
+	struct dir_pfx *ent_ptr;
+	struct dir_chunk *chunk[2];
+	struct dir_pfx ent;
+};
+
+static __inline uint32_t hash_dir(uint32_t addr, uint8_t masklen,
+    size_t hsize);
+static int ta_lookup_dir(struct table_info *ti, void *key, uint32_t keylen,
+    uint32_t *val);
+static int ta_init_dir(struct ip_fw_chain *ch, void **ta_state,
+    struct table_info *ti, char *data, uint8_t tflags);
+static void ta_destroy_dir(void *ta_state, struct table_info *ti);
+static void ta_dump_dir_tinfo(void *ta_state, struct table_info *ti,
+    ipfw_ta_tinfo *tinfo);
+static int ta_dump_dir_tentry(void *ta_state, struct table_info *ti,
+    void *e, ipfw_obj_tentry *tent);
+static int tei_to_dir_ent(struct tentry_info *tei, struct dir_pfx *ent);
+static struct dir_pfx *dir_find(struct dir_cfg *cfg, uint32_t addr,
+    uint8_t masklen);
+static struct dir_pfx *dir_find_covering(struct dir_cfg *cfg,
+    struct dir_pfx *ent);
+static void dir_collapse(struct dir_cfg *cfg, uintptr_t *s);
+static void dir_insert_slot(uintptr_t *s, struct dir_pfx *ent);
+static void dir_remove_slot(struct dir_cfg *cfg, uintptr_t *s, uintptr_t old,
+    uintptr_t new);
+static void dir_insert(struct dir_cfg *cfg, struct ta_buf_dir *tb,
+    struct dir_pfx *ent);
+static void dir_remove(struct dir_cfg *cfg, struct dir_pfx *ent,
+    struct dir_pfx *cover);
+static int ta_find_dir_tentry(void *ta_state, struct table_info *ti,
+    ipfw_obj_tentry *tent);
+static void ta_foreach_dir(void *ta_state, struct table_info *ti,
+    ta_foreach_f *f, void *arg);
+static int ta_prepare_add_dir(struct ip_fw_chain *ch, struct tentry_info *tei,
+    void *ta_buf);
+static int ta_add_dir(void *ta_state, struct table_info *ti,
+    struct tentry_info *tei, void *ta_buf, uint32_t *pnum);
+static int ta_prepare_del_dir(struct ip_fw_chain *ch, struct tentry_info *tei,
+    void *ta_buf);
+static int ta_del_dir(void *ta_state, struct table_info *ti,
+    struct tentry_info *tei, void *ta_buf, uint32_t *pnum);
+static void ta_flush_dir_entry(struct ip_fw_chain *ch, struct tentry_info *tei,
+    void *ta_buf);
+static int ta_need_modify_dir(void *ta_state, struct table_info *ti,
+    uint32_t count, uint64_t *pflags);
+static int ta_prepare_mod_dir(void *ta_buf, uint64_t *pflags);
+static int ta_fill_mod_dir(void *ta_state, struct table_info *ti, void *ta_buf,
+    uint64_t *pflags);
+static void ta_modify_dir(void *ta_state, struct table_info *ti, void *ta_buf,
+    uint64_t pflags);
+static void ta_flush_mod_dir(void *ta_buf);
+
+static __inline uint32_t
+hash_dir(uint32_t addr, uint8_t masklen, size_t hsize)
+{
+	uint32_t h;
+
+	h = addr ^ masklen;
+	h ^= h >> 16;
+	h *= 0x45d9f3b;
+	h ^= h >> 16;
+
+	return (h & (hsize - 1));
+}
+
+static int
+ta_lookup_dir(struct table_info *ti, void *key, uint32_t keylen,
+    uint32_t *val)
+{
+	uintptr_t slot;
+	uint32_t a;
+
+	if (keylen != sizeof(in_addr_t))
+		return (0);
+
+	a = ntohl(*((in_addr_t *)key));
+	slot = ((uintptr_t *)ti->state)[a >> DIR_L1_BITS];
+	if (DIR_IS_CHUNK(slot)) {
+		slot = DIR_SLOT2CHUNK(slot)->slot[(a >> 8) & 0xFF];
+		if (DIR_IS_CHUNK(slot))
+			slot = DIR_SLOT2CHUNK(slot)->slot[a & 0xFF];
+	}
+
+	if (slot == 0)
+		return (0);
+
+	*val = DIR_SLOT2PFX(slot)->value;
+	return (1);
+}
+
+/*
+ * New table.
+ */
+static int
+ta_init_dir(struct ip_fw_chain *ch, void **ta_state, struct table_info *ti,
+    char *data, uint8_t tflags)
+{
+	struct dir_cfg *cfg;
+	int i;
+
+	cfg = malloc(sizeof(struct dir_cfg), M_IPFW, M_WAITOK | M_ZERO);
+
+	cfg->l1 = malloc(sizeof(uintptr_t) * DIR_L1_SIZE, M_IPFW,
+	    M_WAITOK | M_ZERO);
+	cfg->size = 128;
+	cfg->head = malloc(sizeof(struct dir_bhead) * cfg->size, M_IPFW,
+	    M_WAITOK | M_ZERO);
+	for (i = 0; i < cfg->size; i++)
+		SLIST_INIT(&cfg->head[i]);
+
+	*ta_state = cfg;
+	ti->state = cfg->l1;
+	ti->lookup = ta_lookup_dir;
+
+	return (0);
+}
+
+static void
+ta_destroy_dir(void *ta_state, struct table_info *ti)
+{
+	struct dir_cfg *cfg;
+	struct dir_chunk *c;
+	struct dir_pfx *ent, *ent_next;
+	int i, j;
+
+	cfg = (struct dir_cfg *)ta_state;
+
+	for (i = 0; i < DIR_L1_SIZE; i++) {
+		if (!DIR_IS_CHUNK(cfg->l1[i]))
+			continue;
+		c = DIR_SLOT2CHUNK(cfg->l1[i]);
+		for (j = 0; j < DIR_CHUNK_SIZE; j++)
+			if (DIR_IS_CHUNK(c->slot[j]))
+				free(DIR_SLOT2CHUNK(c->slot[j]), M_IPFW_TBL);
+		free(c, M_IPFW_TBL);
+	}
+
+	for (i = 0; i < cfg->size; i++)
+		SLIST_FOREACH_SAFE(ent, &cfg->head[i], next, ent_next)
+			free(ent, M_IPFW_TBL);
+
+	free(cfg->head, M_IPFW);
+	free(cfg->l1, M_IPFW);
+
+	free(cfg, M_IPFW);
+}
+
+static void
+ta_dump_dir_tinfo(void *ta_state, struct table_info *ti, ipfw_ta_tinfo *tinfo)
+{
+	struct dir_cfg *cfg;
+
+	cfg = (struct dir_cfg *)ta_state;
+
+	tinfo->flags = IPFW_TATFLAGS_AFDATA | IPFW_TATFLAGS_AFITEM;
+	tinfo->taclass4 = IPFW_TACLASS_ARRAY;
+	tinfo->size4 = DIR_L1_SIZE + cfg->chunks * DIR_CHUNK_SIZE;
+	tinfo->count4 = cfg->items;
+	tinfo->itemsize4 = sizeof(struct dir_pfx);
+}
+
+static int
+ta_dump_dir_tentry(void *ta_state, struct table_info *ti, void *e,
+    ipfw_obj_tentry *tent)
+{
+	struct dir_pfx *ent;
+
+	ent = (struct dir_pfx *)e;
+
+	tent->k.addr.s_addr = htonl(ent->addr);
+	tent->masklen = ent->masklen;
+	tent->subtype = AF_INET;
+	tent->v.kidx = ent->value;
+
+	return (0);
+}
+
+static int
+tei_to_dir_ent(struct tentry_info *tei, struct dir_pfx *ent)
+{
+	int mlen;
+
+	/* IPv6 is not supported */
+	if (tei->subtype != AF_INET)
+		return (EINVAL);
+
+	mlen = tei->masklen;
+	if (mlen > 32)
+		return (EINVAL);
+
+	ent->masklen = mlen;
+	if (mlen == 0)
+		ent->addr = 0;
+	else
+		ent->addr = ntohl(*((in_addr_t *)tei->paddr)) &
+		    (0xFFFFFFFF << (32 - mlen));
+
+	return (0);
+}
+
+static struct dir_pfx *
+dir_find(struct dir_cfg *cfg, uint32_t addr, uint8_t masklen)
+{
+	struct dir_pfx *tmp;
+	uint32_t hash;
+
+	hash = hash_dir(addr, masklen, cfg->size);
+	SLIST_FOREACH(tmp, &cfg->head[hash], next) {
+		if (tmp->addr == addr && tmp->masklen == masklen)
+			return (tmp);
+	}
+
+	return (NULL);
+}
+
+/*
+ * Finds the longest prefix strictly covering @ent.
+ */
+static struct dir_pfx *
+dir_find_covering(struct dir_cfg *cfg, struct dir_pfx *ent)
+{
+	struct dir_pfx *tmp;
+	uint32_t addr;
+	int mlen;
+
+	for (mlen = ent->masklen - 1; mlen >= 0; mlen--) {
+		addr = mlen == 0 ? 0 : ent->addr & (0xFFFFFFFF << (32 - mlen));
+		if ((tmp = dir_find(cfg, addr, mlen)) != NULL)
+			return (tmp);
+	}
+
+	return (NULL);
+}
+
+/*
+ * Replaces chunk referenced by @s with a single slot if all of its
+ * slots are equal.
+ */
+static void
+dir_collapse(struct dir_cfg *cfg, uintptr_t *s)
+{
+	struct dir_chunk *c;
+	int i;
+
+	if (!DIR_IS_CHUNK(*s))
+		return;
+
+	c = DIR_SLOT2CHUNK(*s);
+	if (DIR_IS_CHUNK(c->slot[0]))
+		return;
+	for (i = 1; i < DIR_CHUNK_SIZE; i++)
+		if (c->slot[i] != c->slot[0])
+			return;
+
+	*s = c->slot[0];
+	free(c, M_IPFW_TBL);
+	cfg->chunks--;
+}
+
+static void
+dir_insert_slot(uintptr_t *s, struct dir_pfx *ent)
+{
+	struct dir_chunk *c;
+	int i;
+
+	if (DIR_IS_CHUNK(*s)) {
+		c = DIR_SLOT2CHUNK(*s);
+		for (i = 0; i < DIR_CHUNK_SIZE; i++)
+			dir_insert_slot(&c->slot[i], ent);
+		return;
+	}
+
+	/* Do not override more specific prefixes */
+	if (*s == 0 || DIR_SLOT2PFX(*s)->masklen < ent->masklen)
+		*s = DIR_PFX2SLOT(ent);
+}
+
+static void
+dir_remove_slot(struct dir_cfg *cfg, uintptr_t *s, uintptr_t old,
+    uintptr_t new)
+{
+	struct dir_chunk *c;
+	int i;
+
+	if (DIR_IS_CHUNK(*s)) {
+		c = DIR_SLOT2CHUNK(*s);
+		for (i = 0; i < DIR_CHUNK_SIZE; i++)
+			dir_remove_slot(cfg, &c->slot[i], old, new);
+		dir_collapse(cfg, s);
+		return;
+	}
+
+	if (*s == old)
+		*s = new;
+}
+
+/*
+ * Returns the chunk referenced by @s. Converts the slot to a chunk
+ * using preallocated @pc if necessary.
+ */
+static struct dir_chunk *
+dir_get_chunk(struct dir_cfg *cfg, uintptr_t *s, struct dir_chunk **pc)
+{
+	struct dir_chunk *c;
+	int i;
+
+	if (DIR_IS_CHUNK(*s))
+		return (DIR_SLOT2CHUNK(*s));
+
+	c = *pc;
+	*pc = NULL;
+	KASSERT(c != NULL, ("%s: no chunk preallocated", __func__));
+	for (i = 0; i < DIR_CHUNK_SIZE; i++)
+		c->slot[i] = *s;
+	*s = (uintptr_t)c;
+	cfg->chunks++;
+
+	return (c);
+}
+
+static void
+dir_insert(struct dir_cfg *cfg, struct ta_buf_dir *tb, struct dir_pfx *ent)
+{
+	struct dir_chunk *c;
+	uintptr_t *base;
+	uint32_t a, count, first, i;
+
+	a = ent->addr;
+	if (ent->masklen <= DIR_L1_BITS) {
+		base = cfg->l1;
+		first = a >> DIR_L1_BITS;
+		count = 1 << (DIR_L1_BITS - ent->masklen);
+	} else {
+		c = dir_get_chunk(cfg, &cfg->l1[a >> DIR_L1_BITS],
+		    &tb->chunk[0]);
+		if (ent->masklen > DIR_L1_BITS + DIR_CHUNK_BITS) {
+			c = dir_get_chunk(cfg, &c->slot[(a >> 8) & 0xFF],
+			    &tb->chunk[1]);
+			first = a & 0xFF;
+			count = 1 << (32 - ent->masklen);
+		} else {
+			first = (a >> 8) & 0xFF;
+			count = 1 << (DIR_L1_BITS + DIR_CHUNK_BITS -
+			    ent->masklen);
+		}
+		base = c->slot;
+	}
+
+	for (i = first; i < first + count; i++)
+		dir_insert_slot(&base[i], ent);
+}
+
+static void
+dir_remove(struct dir_cfg *cfg, struct dir_pfx *ent, struct dir_pfx *cover)
+{
+	struct dir_chunk *c;
+	uintptr_t *base, *s1, *s2;
+	uintptr_t old, new;
+	uint32_t a, count, first, i;
+
+	a = ent->addr;
+	old = DIR_PFX2SLOT(ent);
+	new = cover != NULL ? DIR_PFX2SLOT(cover) : 0;
+	s1 = &cfg->l1[a >> DIR_L1_BITS];
+	s2 = NULL;
+
+	if (ent->masklen <= DIR_L1_BITS) {
+		base = cfg->l1;
+		first = a >> DIR_L1_BITS;
+		count = 1 << (DIR_L1_BITS - ent->masklen);
+	} else {
+		KASSERT(DIR_IS_CHUNK(*s1), ("%s: no level 2 chunk", __func__));
+		c = DIR_SLOT2CHUNK(*s1);
+		if (ent->masklen > DIR_L1_BITS + DIR_CHUNK_BITS) {
+			s2 = &c->slot[(a >> 8) & 0xFF];
+			KASSERT(DIR_IS_CHUNK(*s2),
+			    ("%s: no level 3 chunk", __func__));
+			c = DIR_SLOT2CHUNK(*s2);
+			first = a & 0xFF;
+			count = 1 << (32 - ent->masklen);
+		} else {
+			first = (a >> 8) & 0xFF;
+			count = 1 << (DIR_L1_BITS + DIR_CHUNK_BITS -
+			    ent->masklen);
+		}
+		base = c->slot;
+	}
+
+	for (i = first; i < first + count; i++)
+		dir_remove_slot(cfg, &base[i], old, new);
+
+	/* Release chunks which became redundant */
+	if (ent->masklen > DIR_L1_BITS) {
+		if (s2 != NULL)
+			dir_collapse(cfg, s2);
+		dir_collapse(cfg, s1);
+	}
+}
+
+static int
+ta_find_dir_tentry(void *ta_state, struct table_info *ti,
+    ipfw_obj_tentry *tent)
+{
+	uintptr_t slot;
+	uint32_t a;
+
+	if (tent->subtype != AF_INET)
+		return (ENOENT);
+
+	a = ntohl(tent->k.addr.s_addr);
+	slot = ((uintptr_t *)ti->state)[a >> DIR_L1_BITS];
+	if (DIR_IS_CHUNK(slot)) {
+		slot = DIR_SLOT2CHUNK(slot)->slot[(a >> 8) & 0xFF];
+		if (DIR_IS_CHUNK(slot))
+			slot = DIR_SLOT2CHUNK(slot)->slot[a & 0xFF];
+	}
+
+	if (slot == 0)
+		return (ENOENT);
+
+	ta_dump_dir_tentry(ta_state, ti, DIR_SLOT2PFX(slot), tent);
+	return (0);
+}
+
+static void
+ta_foreach_dir(void *ta_state, struct table_info *ti, ta_foreach_f *f,
+    void *arg)
+{
+	struct dir_cfg *cfg;
+	struct dir_pfx *ent, *ent_next;
+	int i;
+
+	cfg = (struct dir_cfg *)ta_state;
+
+	for (i = 0; i < cfg->size; i++)
+		SLIST_FOREACH_SAFE(ent, &cfg->head[i], next, ent_next)
+			f(ent, arg);
+}
+
+static int
+ta_prepare_add_dir(struct ip_fw_chain *ch, struct tentry_info *tei,
+    void *ta_buf)
+{
+	struct ta_buf_dir *tb;
+	struct dir_pfx *ent;
+	int error;
+
+	tb = (struct ta_buf_dir *)ta_buf;
+
+	ent = malloc(sizeof(*ent), M_IPFW_TBL, M_WAITOK | M_ZERO);
+
+	error = tei_to_dir_ent(tei, ent);
+	if (error != 0) {
+		free(ent, M_IPFW_TBL);
+		return (error);
+	}
+	tb->ent_ptr = ent;
+
+	/*
+	 * Prefixes longer than level 1 stride may need new chunks.
+	 * Allocate them here since -add is not allowed to sleep.
+	 */
+	if (ent->masklen > DIR_L1_BITS)
+		tb->chunk[0] = malloc(sizeof(struct dir_chunk), M_IPFW_TBL,
+		    M_WAITOK);
+	if (ent->masklen > DIR_L1_BITS + DIR_CHUNK_BITS)
+		tb->chunk[1] = malloc(sizeof(struct dir_chunk), M_IPFW_TBL,
+		    M_WAITOK);
+
+	return (0);
+}
+
+static int
+ta_add_dir(void *ta_state, struct table_info *ti, struct tentry_info *tei,
+    void *ta_buf, uint32_t *pnum)
+{
+	struct dir_cfg *cfg;
+	struct dir_pfx *ent, *tmp;
+	struct ta_buf_dir *tb;
+	uint32_t hash, value;
+
+	cfg = (struct dir_cfg *)ta_state;
+	tb = (struct ta_buf_dir *)ta_buf;
+	ent = tb->ent_ptr;
+
+	if (tei->subtype != AF_INET)
+		return (EINVAL);
+
+	/* Read current value from @tei */
+	ent->value = tei->value;
+
+	tmp = dir_find(cfg, ent->addr, ent->masklen);
+	if (tmp != NULL) {
+		if ((tei->flags & TEI_FLAGS_UPDATE) == 0)
+			return (EEXIST);
+		/* Record already exists. Update value if we're asked to */
+		value = tmp->value;
+		tmp->value = tei->value;
+		tei->value = value;
+		/* Indicate that update has happened instead of addition */
+		tei->flags |= TEI_FLAGS_UPDATED;
+		*pnum = 0;
+	} else {
+		if ((tei->flags & TEI_FLAGS_DONTADD) != 0)
+			return (EFBIG);
+		hash = hash_dir(ent->addr, ent->masklen, cfg->size);
+		SLIST_INSERT_HEAD(&cfg->head[hash], ent, next);
+		dir_insert(cfg, tb, ent);
+		tb->ent_ptr = NULL;
+		cfg->items++;
+		*pnum = 1;
+	}
+
+	return (0);
+}
+
+static int
+ta_prepare_del_dir(struct ip_fw_chain *ch, struct tentry_info *tei,
+    void *ta_buf)
+{
+	struct ta_buf_dir *tb;
+
+	tb = (struct ta_buf_dir *)ta_buf;
+
+	return (tei_to_dir_ent(tei, &tb->ent));
+}
+
+static int
+ta_del_dir(void *ta_state, struct table_info *ti, struct tentry_info *tei,
+    void *ta_buf, uint32_t *pnum)
+{
+	struct dir_cfg *cfg;
+	struct dir_pfx *tmp;
+	struct ta_buf_dir *tb;
+	uint32_t hash;
+
+	cfg = (struct dir_cfg *)ta_state;
+	tb = (struct ta_buf_dir *)ta_buf;
+
+	if (tei->subtype != AF_INET)
+		return (EINVAL);
+
+	tmp = dir_find(cfg, tb->ent.addr, tb->ent.masklen);
+	if (tmp == NULL)
+		return (ENOENT);
+
+	hash = hash_dir(tmp->addr, tmp->masklen, cfg->size);
+	SLIST_REMOVE(&cfg->head[hash], tmp, dir_pfx, next);
+	dir_remove(cfg, tmp, dir_find_covering(cfg, tmp));
+	cfg->items--;
+	tb->ent_ptr = tmp;
+	tei->value = tmp->value;
+	*pnum = 1;
+
+	return (0);
+}
+
+static void
+ta_flush_dir_entry(struct ip_fw_chain *ch, struct tentry_info *tei,
+    void *ta_buf)
+{
+	struct ta_buf_dir *tb;
+
+	tb = (struct ta_buf_dir *)ta_buf;
+
+	if (tb->ent_ptr != NULL)
+		free(tb->ent_ptr, M_IPFW_TBL);
+	if (tb->chunk[0] != NULL)
+		free(tb->chunk[0], M_IPFW_TBL);
+	if (tb->chunk[1] != NULL)
+		free(tb->chunk[1], M_IPFW_TBL);
+}
+
+/*
+ * Prefix hash growing callbacks.
+ */
+
+static int
+ta_need_modify_dir(void *ta_state, struct table_info *ti, uint32_t count,
+    uint64_t *pflags)
+{
+	struct dir_cfg *cfg;
+
+	cfg = (struct dir_cfg *)ta_state;
+
+	if (cfg->items + count > cfg->size && cfg->size < DIR_HASH_MAX) {
+		*pflags = cfg->size * 2;
+		return (1);
+	}
+
+	return (0);
+}
+
+/*
+ * Allocate new, larger prefix hash.
+ */
+static int
+ta_prepare_mod_dir(void *ta_buf, uint64_t *pflags)
+{
+	struct mod_item *mi;
+	struct dir_bhead *head;
+	int i;
+
+	mi = (struct mod_item *)ta_buf;
+
+	memset(mi, 0, sizeof(struct mod_item));
+	mi->size = *pflags;
+	head = malloc(sizeof(struct dir_bhead) * mi->size, M_IPFW,
+	    M_WAITOK | M_ZERO);
+	for (i = 0; i < mi->size; i++)
+		SLIST_INIT(&head[i]);
+	mi->main_ptr = head;
+
+	return (0);
+}
+
+static int
+ta_fill_mod_dir(void *ta_state, struct table_info *ti, void *ta_buf,
+    uint64_t *pflags)
+{
+
+	return (0);
+}
+
+/*
+ * Switch old & new hashes. Lookups never use the prefix hash, so
+ * the trie itself is not touched.
+ */
+static void
+ta_modify_dir(void *ta_state, struct table_info *ti, void *ta_buf,
+    uint64_t pflags)
+{
+	struct mod_item *mi;
+	struct dir_cfg *cfg;
+	struct dir_bhead *old_head, *new_head;
+	struct dir_pfx *ent, *ent_next;
+	size_t old_size;
+	uint32_t nhash;
+	int i;
+
+	mi = (struct mod_item *)ta_buf;
+	cfg = (struct dir_cfg *)ta_state;
+
+	if (cfg->size >= mi->size)
+		return;
+
+	new_head = (struct dir_bhead *)mi->main_ptr;
+	old_head = cfg->head;
+	old_size = cfg->size;
+
+	for (i = 0; i < old_size; i++) {
+		SLIST_FOREACH_SAFE(ent, &old_head[i], next, ent_next) {
+			nhash = hash_dir(ent->addr, ent->masklen, mi->size);
+			SLIST_INSERT_HEAD(&new_head[nhash], ent, next);
+		}
+	}
+
+	cfg->head = new_head;
+	cfg->size = mi->size;
+	mi->main_ptr = old_head;
+}
+
+/*
+ * Free unneded array.
+ */
+static void
+ta_flush_mod_dir(void *ta_buf)
+{
+	struct mod_item *mi;
+
+	mi = (struct mod_item *)ta_buf;
+	if (mi->main_ptr != NULL)
+		free(mi->main_ptr, M_IPFW);
+}
+
+struct table_algo addr_dir = {
+	.name		= "addr:dir16_8",
+	.type		= IPFW_TABLE_ADDR,
+	.ta_buf_size	= sizeof(struct ta_buf_dir),
+	.init		= ta_init_dir,
+	.destroy	= ta_destroy_dir,
+	.prepare_add	= ta_prepare_add_dir,
+	.prepare_del	= ta_prepare_del_dir,
+	.add		= ta_add_dir,
+	.del		= ta_del_dir,
+	.flush_entry	= ta_flush_dir_entry,
+	.foreach	= ta_foreach_dir,
+	.dump_tentry	= ta_dump_dir_tentry,
+	.find_tentry	= ta_find_dir_tentry,
+	.dump_tinfo	= ta_dump_dir_tinfo,
+	.need_modify	= ta_need_modify_dir,
+	.prepare_mod	= ta_prepare_mod_dir,
+	.fill_mod	= ta_fill_mod_dir,
+	.modify		= ta_modify_dir,
+	.flush_mod	= ta_flush_mod_dir,
+};
+#endif /* __rtems__ */
 
 
 /*
@@ -4095,6 +4869,9 @@ ipfw_table_algo_init(struct ip_fw_chain *ch)
 	ipfw_add_table_algo(ch, &number_array, sz, &number_array.idx);
 	ipfw_add_table_algo(ch, &flow_hash, sz, &flow_hash.idx);
 	ipfw_add_table_algo(ch, &addr_kfib, sz, &addr_kfib.idx);
+#ifdef __rtems__
+	ipfw_add_table_algo(ch, &addr_dir, sz, &addr_dir.idx);
+#endif /* __rtems__ */
 }
 
 void
@@ -4107,6 +4884,9 @@ ipfw_table_algo_destroy(struct ip_fw_chain *ch)
 	ipfw_del_table_algo(ch, number_array.idx);
 	ipfw_del_table_algo(ch, flow_hash.idx);
 	ipfw_del_table_algo(ch, addr_kfib.idx);
+#ifdef __rtems__
+	ipfw_del_table_algo(ch, addr_dir.idx);
+#endif /* __rtems__ */
 }
 
 
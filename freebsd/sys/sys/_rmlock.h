@@ -59,8 +59,17 @@ struct rmlock {
 #define	rm_lock_mtx	_rm_lock._rm_lock_mtx
 #define	rm_lock_sx	_rm_lock._rm_lock_sx
 #else /* __rtems__ */
-#include <sys/_rwlock.h>
-#define	rmlock rwlock
+#include <sys/_lock.h>
+#include <sys/_mutex.h>
+
+struct rm_reader;
+
+struct rmlock {
+	struct lock_object lock_object;
+	struct mtx rm_mtx;
+	volatile u_int rm_writer;
+	struct rm_reader *rm_readers;
+};
 #endif /* __rtems__ */
 
 struct rm_priotracker {
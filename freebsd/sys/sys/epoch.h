@@ -0,0 +1,75 @@
+/*-
+ * Copyright (c) 2026 embedded brains GmbH.  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $FreeBSD$
+ */
+
+#ifndef _SYS_EPOCH_H_
+#define	_SYS_EPOCH_H_
+
+/*
+ * Epoch based reclamation.  Readers enclose lookups of shared objects in an
+ * epoch section.  Writers unlink objects under their usual lock and release
+ * the memory with epoch_call() or after epoch_wait(), once all sections
+ * which could still see the object are left.
+ *
+ * Sections of a preemptible epoch (EPOCH_PREEMPT) may block and use a
+ * tracker provided by the caller.  Sections of other epochs run with thread
+ * dispatching disabled and must not block.  epoch_call() must not be used
+ * inside a section of a non-preemptible epoch.
+ */
+
+struct epoch;
+typedef struct epoch *epoch_t;
+
+#define	EPOCH_PREEMPT	0x1
+
+typedef struct epoch_context {
+	struct epoch_context	*ec_next;
+	void			(*ec_callback)(struct epoch_context *);
+} *epoch_context_t;
+
+typedef struct epoch_tracker {
+	u_int	et_cpu;		/* Processor of the reader counter */
+	u_int	et_gen;		/* Generation of the reader counter */
+} *epoch_tracker_t;
+
+#ifdef _KERNEL
+extern epoch_t global_epoch;
+extern epoch_t global_epoch_preempt;
+
+epoch_t	epoch_alloc(int flags);
+void	epoch_free(epoch_t epoch);
+void	epoch_enter(epoch_t epoch);
+void	epoch_exit(epoch_t epoch);
+void	epoch_enter_preempt(epoch_t epoch, epoch_tracker_t et);
+void	epoch_exit_preempt(epoch_t epoch, epoch_tracker_t et);
+void	epoch_wait(epoch_t epoch);
+void	epoch_wait_preempt(epoch_t epoch);
+void	epoch_call(epoch_t epoch, epoch_context_t ctx,
+	    void (*callback)(epoch_context_t));
+int	in_epoch(epoch_t epoch);
+#endif /* _KERNEL */
+
+#endif /* !_SYS_EPOCH_H_ */
@@ -559,6 +559,24 @@ void sf_ext_free_nocache(void *, void *);
 #define	MBUF_TAG_MEM_NAME	"mbuf_tag"
 #define	MBUF_EXTREFCNT_MEM_NAME	"mbuf_ext_refcnt"
 
+#ifdef __rtems__
+/*
+ * Statistics of a per-interface receive buffer pool.  The kern.ipc.rxpool
+ * sysctl returns an array of these, one for each pool.
+ */
+#define	RXPOOL_NAMELEN	16
+
+struct rxpool_stat {
+	char		rps_name[RXPOOL_NAMELEN];
+	uint64_t	rps_bufsize;	/* size of each buffer */
+	uint64_t	rps_size;	/* buffers owned by the pool */
+	uint64_t	rps_free;	/* buffers on the free list */
+	uint64_t	rps_allocs;	/* buffers handed out by the pool */
+	uint64_t	rps_recycled;	/* buffers returned by the stack */
+	uint64_t	rps_fallbacks;	/* pool empty, used m_getcl() */
+};
+#endif /* __rtems__ */
+
 #ifdef _KERNEL
 
 #ifdef WITNESS
@@ -629,6 +647,12 @@ int		 m_sanity(struct mbuf *, int);
 struct mbuf	*m_split(struct mbuf *, int, int);
 struct mbuf	*m_uiotombuf(struct uio *, int, int, int, int);
 struct mbuf	*m_unshare(struct mbuf *, int);
+#ifdef __rtems__
+struct rxpool;
+struct rxpool	*rxpool_create(const char *, u_int, u_int);
+void		 rxpool_destroy(struct rxpool *);
+struct mbuf	*rxpool_getcl(struct rxpool *, int);
+#endif /* __rtems__ */
 
 static __inline int
 m_gettype(int size)
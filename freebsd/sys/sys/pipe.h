@@ -83,6 +83,8 @@ struct pipemapping {
 	int		npages;		/* number of pages */
 #ifndef __rtems__
 	vm_page_t	ms[PIPENPAGES];	/* pages in source process */
+#else /* __rtems__ */
+	const void	*kva;		/* buffer of the writer */
 #endif /* __rtems__ */
 };
 
@@ -258,6 +258,8 @@ struct thread {
 #endif /* __rtems__ */
 #ifdef __rtems__
 	enum thread_sq_states td_sq_state;
+	LIST_HEAD(, rm_priotracker) td_rmtrackers; /* (k) Recursable rm reads. */
+	u_int		td_epochnest;	/* (k) Preemptible epoch sections. */
 #endif /* __rtems__ */
 	int		td_sqqueue;	/* (t) Sleepqueue queue blocked on. */
 	void		*td_wchan;	/* (t) Sleep address. */
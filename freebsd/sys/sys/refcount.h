@@ -63,5 +63,26 @@ refcount_release(volatile u_int *count)
 	KASSERT(old > 0, ("negative refcount %p", count));
 	return (old == 1);
 }
+#ifdef __rtems__
+
+/*
+ * Acquire a reference only if the object is still referenced.  This allows
+ * lookups without a lock, e.g. in an epoch section, to skip objects which
+ * are about to be freed.
+ */
+static __inline int
+refcount_acquire_if_not_zero(volatile u_int *count)
+{
+	u_int old;
+
+	for (;;) {
+		old = *count;
+		if (old == 0)
+			return (0);
+		if (atomic_cmpset_int((volatile int *)count, old, old + 1))
+			return (1);
+	}
+}
+#endif /* __rtems__ */
 
 #endif	/* ! __SYS_REFCOUNT_H__ */
@@ -47,7 +47,6 @@
 #define	RM_SLEEPABLE	0x00000004
 #define	RM_NEW		0x00000008
 
-#ifndef __rtems__
 void	rm_init(struct rmlock *rm, const char *name);
 void	rm_init_flags(struct rmlock *rm, const char *name, int opts);
 void	rm_destroy(struct rmlock *rm);
@@ -55,12 +54,14 @@ int	rm_wowned(const struct rmlock *rm);
 void	rm_sysinit(void *arg);
 void	rm_sysinit_flags(void *arg);
 
+#ifndef __rtems__
 void	_rm_wlock_debug(struct rmlock *rm, const char *file, int line);
 void	_rm_wunlock_debug(struct rmlock *rm, const char *file, int line);
 int	_rm_rlock_debug(struct rmlock *rm, struct rm_priotracker *tracker,
 	    int trylock, const char *file, int line);
 void	_rm_runlock_debug(struct rmlock *rm,  struct rm_priotracker *tracker,
 	    const char *file, int line);
+#endif /* __rtems__ */
 
 void	_rm_wlock(struct rmlock *rm);
 void	_rm_wunlock(struct rmlock *rm);
@@ -79,7 +80,7 @@ void	_rm_assert(const struct rmlock *rm, int what, const char *file,
 #error LOCK_DEBUG not defined, include <sys/lock.h> before <sys/rmlock.h>
 #endif
 
-#if LOCK_DEBUG > 0
+#if LOCK_DEBUG > 0 && !defined(__rtems__)
 #define	rm_wlock(rm)	_rm_wlock_debug((rm), LOCK_FILE, LOCK_LINE)
 #define	rm_wunlock(rm)	_rm_wunlock_debug((rm), LOCK_FILE, LOCK_LINE)
 #define	rm_rlock(rm,tracker)  \
@@ -99,21 +100,6 @@ void	_rm_assert(const struct rmlock *rm, int what, const char *file,
 	_sleep((chan), &(rm)->lock_object, (pri), (wmesg),		\
 	    tick_sbt * (timo), 0, C_HARDCLOCK)
 
-#else /* __rtems__ */
-#include <sys/rwlock.h>
-#define	rm_init rw_init
-#define	rm_init_flags rw_init_flags
-#define	rm_destroy rw_destroy
-#define	rm_wowned rw_wowned
-#define	rm_sysinit rw_sysinit
-#define	rm_sysinit_flags rw_sysinit_flags
-#define	rm_wlock rw_wlock
-#define	rm_wunlock rw_wunlock
-#define	rm_rlock(rm, tracker) do { (void)tracker; rw_rlock(rm); } while (0)
-#define	rm_runlock(rm, tracker) do { (void)tracker; rw_runlock(rm); } while (0)
-#define	rm_sleep rw_sleep
-#endif /* __rtems__ */
-
 
 
 struct rm_args {
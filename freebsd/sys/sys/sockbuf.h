@@ -55,10 +55,17 @@
 #define	SB_AUTOSIZE	0x800		/* automatically size socket buffer */
 #define	SB_STOP		0x1000		/* backpressure indicator */
 #define	SB_AIO_RUNNING	0x2000		/* AIO operation running */
+#ifdef __rtems__
+#define	SB_SLEEPING	0x4000		/* sblock owner sleeps in sbwait() */
+#endif /* __rtems__ */
 
 #define	SBS_CANTSENDMORE	0x0010	/* can't send more data to peer */
 #define	SBS_CANTRCVMORE		0x0020	/* can't receive more data from peer */
 #define	SBS_RCVATMARK		0x0040	/* at mark on input */
+#ifdef __rtems__
+#define	SBS_LOWATEXPIRED	0x0080	/* deferred wakeup expired, data
+					   below sb_lowat is readable */
+#endif /* __rtems__ */
 
 struct mbuf;
 struct sockaddr;
@@ -211,9 +211,17 @@ struct xsocket {
     ((so)->so_proto->pr_flags & PR_ATOMIC)
 
 /* can we read something from so? */
+#ifndef __rtems__
+#define	soreadabledata(so) \
+    (sbavail(&(so)->so_rcv) >= (so)->so_rcv.sb_lowat || \
+	!TAILQ_EMPTY(&(so)->so_comp) || (so)->so_error)
+#else /* __rtems__ */
 #define	soreadabledata(so) \
     (sbavail(&(so)->so_rcv) >= (so)->so_rcv.sb_lowat || \
+	(((so)->so_rcv.sb_state & SBS_LOWATEXPIRED) != 0 && \
+	sbavail(&(so)->so_rcv) != 0) || \
 	!TAILQ_EMPTY(&(so)->so_comp) || (so)->so_error)
+#endif /* __rtems__ */
 #define	soreadable(so) \
 	(soreadabledata(so) || ((so)->so_rcv.sb_state & SBS_CANTRCVMORE))
 
@@ -715,6 +715,7 @@ tcp_stats(u_long off, const char *name, int af1 __unused, int proto __unused)
 	p1a(tcps_sc_badack, "\t\t{:bad-ack/%ju} {N:/badack}\n");
 	p1a(tcps_sc_unreach, "\t\t{:unreachable/%ju} {N:/unreach}\n");
 	p(tcps_sc_zonefail, "\t\t{:zone-failures/%ju} {N:/zone failure%s}\n");
+	p(tcps_sc_resized, "\t\t{:resized/%ju} {N:/hash table resize%s}\n");
 	p(tcps_sc_sendcookie, "\t{:sent-cookies/%ju} {N:/cookie%s sent}\n");
 	p(tcps_sc_recvcookie, "\t{:receivd-cookies/%ju} "
 	    "{N:/cookie%s received}\n");
@@ -746,6 +747,18 @@ tcp_stats(u_long off, const char *name, int af1 __unused, int proto __unused)
 	    "{N:/SACK scoreboard overflow}\n");
 
 	xo_close_container("sack");
+	xo_open_container("rack");
+
+	p(tcps_rack_recovery, "\t{:recovery-episodes/%ju} "
+	    "{N:/recovery episode%s started by RACK}\n");
+	p(tcps_rack_reordertmo, "\t{:reorder-timeouts/%ju} "
+	    "{N:/RACK reordering timeout%s}\n");
+	p(tcps_tlp_probes, "\t{:tail-loss-probes/%ju} "
+	    "{N:/tail loss probe%s sent}\n");
+	p(tcps_tlp_acked, "\t\t{:tail-loss-probes-acked/%ju} "
+	    "{N:/tail loss probe%s acknowledged}\n");
+
+	xo_close_container("rack");
 	xo_open_container("ecn");
 
 	p(tcps_ecn_ce, "\t{:ce-packets/%ju} "
@@ -858,6 +871,8 @@ udp_stats(u_long off, const char *name, int af1 __unused, int proto __unused)
 	if (delivered || sflag <= 1)
 		xo_emit("\t{:delivered-packets/%ju} {N:/delivered}\n",
 		    (uint64_t)delivered);
+	p(udps_rcvdeferred, "{:deferred-wakeups/%ju} "
+	    "{N:/datagram%s queued below the receive low-water mark}\n");
 	p(udps_opackets, "{:output-packets/%ju} {N:/datagram%s output}\n");
 	/* the next statistic is cumulative in udps_noportbcast */
 	p(udps_filtermcast, "{:multicast-source-filter-matches/%ju} "
@@ -966,6 +981,12 @@ ip_stats(u_long off, const char *name, int af1 __unused, int proto __unused)
 	    "{N:/fragment%s dropped (dup or out of space)}\n");
 	p(ips_fragtimeout, "\t{:dropped-fragments-after-timeout/%ju} "
 	    "{N:/fragment%s dropped after timeout}\n");
+#ifdef __rtems__
+	p(ips_fragappended, "\t{:appended-fragments/%ju} "
+	    "{N:/fragment%s appended in order}\n");
+	p(ips_reassbucketfull, "\t{:dropped-queues-bucket-full/%ju} "
+	    "{N:/reassembly queue%s dropped (hash bucket full)}\n");
+#endif /* __rtems__ */
 	p(ips_reassembled, "\t{:reassembled-packets/%ju} "
 	    "{N:/packet%s reassembled ok}\n");
 	p(ips_delivered, "\t{:received-local-packets/%ju} "
@@ -401,6 +401,12 @@ ip6_stats(u_long off, const char *name, int af1 __unused, int proto __unused)
 	    "{N:/fragment%s dropped after timeout}\n");
 	p(ip6s_fragoverflow, "\t{:dropped-fragments-overflow/%ju} "
 	    "{N:/fragment%s that exceeded limit}\n");
+#ifdef __rtems__
+	p(ip6s_fragappended, "\t{:appended-fragments/%ju} "
+	    "{N:/fragment%s appended in order}\n");
+	p(ip6s_reassbucketfull, "\t{:dropped-queues-bucket-full/%ju} "
+	    "{N:/reassembly queue%s dropped (hash bucket full)}\n");
+#endif /* __rtems__ */
 	p(ip6s_reassembled, "\t{:reassembled-packets/%ju} "
 	    "{N:/packet%s reassembled ok}\n");
 	p(ip6s_delivered, "\t{:received-local-packets/%ju} "
@@ -219,6 +219,10 @@ print_ipsecstats(const struct ipsecstat *ipsecstat)
 	    "{N:/cluster%s copied during clone}\n");
 	p(ips_mbinserted, "\t{:mbufs-inserted/%ju} "
 	    "{N:/mbuf%s inserted during makespace}\n");
+	p(ips_spdcache_hits, "\t{:spdcache-hits/%ju} "
+	    "{N:/SPD lookup%s served from the cache}\n");
+	p(ips_spdcache_misses, "\t{:spdcache-misses/%ju} "
+	    "{N:/SPD lookup%s missed the cache}\n");
 #undef p
 	xo_close_container("ipsec-statistics");
 }
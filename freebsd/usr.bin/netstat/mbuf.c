@@ -73,6 +73,52 @@ __FBSDID("$FreeBSD$");
 #include "rtems-bsd-netstat-mbuf-data.h"
 #endif /* __rtems__ */
 
+#ifdef __rtems__
+/*
+ * Print the per-interface receive buffer pool statistics.
+ */
+static void
+rxpoolpr(void)
+{
+	struct rxpool_stat *rps;
+	size_t len;
+	size_t i;
+
+	if (sysctlbyname("kern.ipc.rxpool", NULL, &len, NULL, 0) != 0 ||
+	    len == 0)
+		return;
+
+	rps = malloc(len);
+	if (rps == NULL) {
+		xo_warn("malloc");
+		return;
+	}
+
+	if (sysctlbyname("kern.ipc.rxpool", rps, &len, NULL, 0) == 0) {
+		xo_open_list("rx-pool");
+		for (i = 0; i < len / sizeof(*rps); ++i) {
+			xo_open_instance("rx-pool");
+			xo_emit("{:free/%ju}/{:size/%ju}/{:allocs/%ju}/"
+			    "{:recycled/%ju}/{:fallbacks/%ju} "
+			    "{N:receive buffers free\\/total\\/allocated\\/"
+			    "recycled\\/fallback in pool} {k:name/%s} "
+			    "({:buffer-size/%ju} {N:bytes})\n",
+			    (uintmax_t)rps[i].rps_free,
+			    (uintmax_t)rps[i].rps_size,
+			    (uintmax_t)rps[i].rps_allocs,
+			    (uintmax_t)rps[i].rps_recycled,
+			    (uintmax_t)rps[i].rps_fallbacks,
+			    rps[i].rps_name,
+			    (uintmax_t)rps[i].rps_bufsize);
+			xo_close_instance("rx-pool");
+		}
+		xo_close_list("rx-pool");
+	}
+
+	free(rps);
+}
+#endif /* __rtems__ */
+
 /*
  * Print mbuf statistics.
  */
@@ -331,6 +377,11 @@ mbpr(void *kvmd, u_long mbaddr)
 	    jumbop_failures, jumbo9_failures, jumbo16_failures,
 	    jumbop_size / 1024);
 
+#ifdef __rtems__
+	if (live)
+		rxpoolpr();
+
+#endif /* __rtems__ */
 	mlen = sizeof(nsfbufs);
 	if (live &&
 	    sysctlbyname("kern.ipc.nsfbufs", &nsfbufs, &mlen, NULL, 0) == 0 &&
@@ -63,16 +63,20 @@ def rtems(mm):
             'local/gpio_if.c',
             'rtems/ipsec_get_policylen.c',
             'rtems/rtems-bsd-arp-processor.c',
+            'rtems/rtems-bsd-allocator-domain-jumbo-size.c',
             'rtems/rtems-bsd-allocator-domain-size.c',
             'rtems/rtems-bsd-get-allocator-domain-size.c',
             'rtems/rtems-bsd-get-ethernet-addr.c',
             'rtems/rtems-bsd-get-mac-address.c',
             'rtems/rtems-bsd-get-task-priority.c',
             'rtems/rtems-bsd-get-task-stack-size.c',
+            'rtems/rtems-bsd-parallel-attach-tasks.c',
+            'rtems/rtems-bsd-rc-conf-dummynet.c',
             'rtems/rtems-bsd-rc-conf-net.c',
             'rtems/rtems-bsd-rc-conf-pf.c',
             'rtems/rtems-bsd-rc-conf.c',
             'rtems/rtems-bsd-shell-arp.c',
+            'rtems/rtems-bsd-shell-bootprof.c',
             'rtems/rtems-bsd-shell-ifconfig.c',
             'rtems/rtems-bsd-shell-netstat.c',
             'rtems/rtems-bsd-shell-pfctl.c',
@@ -86,6 +90,7 @@ def rtems(mm):
             'rtems/rtems-bsd-syscall-api.c',
             'rtems/rtems-kernel-assert.c',
             'rtems/rtems-kernel-autoconf.c',
+            'rtems/rtems-kernel-bootprof.c',
             'rtems/rtems-kernel-bus-dma.c',
             'rtems/rtems-kernel-bus-dma-mbuf.c',
             'rtems/rtems-kernel-bus-root.c',
@@ -93,10 +98,12 @@ def rtems(mm):
             'rtems/rtems-kernel-chunk.c',
             'rtems/rtems-kernel-configintrhook.c',
             'rtems/rtems-kernel-delay.c',
+            'rtems/rtems-kernel-epoch.c',
             'rtems/rtems-kernel-get-file.c',
             'rtems/rtems-kernel-init.c',
             'rtems/rtems-kernel-irqs.c',
             'rtems/rtems-kernel-jail.c',
+            'rtems/rtems-kernel-kqueue.c',
             'rtems/rtems-kernel-malloc.c',
             'rtems/rtems-kernel-mbuf.c',
             'rtems/rtems-kernel-mutex.c',
@@ -107,6 +114,7 @@ def rtems(mm):
             'rtems/rtems-kernel-pci_bus.c',
             'rtems/rtems-kernel-pci_cfgreg.c',
             'rtems/rtems-kernel-program.c',
+            'rtems/rtems-kernel-rmlock.c',
             'rtems/rtems-kernel-rwlock.c',
             'rtems/rtems-kernel-signal.c',
             'rtems/rtems-kernel-sx.c',
@@ -162,8 +170,12 @@ def rtems(mm):
             'sys/dev/ffec/if_ffec_mcf548x.c',
             'sys/dev/dw_mmc/dw_mmc.c',
             'sys/fs/devfs/devfs_devs.c',
+            'sys/libkern/crc32c.c',
+            'sys/net/bpf_zerocopy.c',
+            'sys/net/if_gso.c',
             'sys/net/if_ppp.c',
             'sys/net/ppp_tty.c',
+            'sys/netinet/tcp_rack.c',
             'telnetd/check_passwd.c',
             'telnetd/des.c',
             'telnetd/pty.c',
@@ -237,6 +249,7 @@ def base(mm):
             'sys/sys/cpu.h',
             'sys/sys/ctype.h',
             'sys/sys/domain.h',
+            'sys/sys/epoch.h',
             'sys/sys/eventhandler.h',
             'sys/sys/fail.h',
             'sys/sys/filedesc.h',
@@ -654,6 +667,7 @@ def dev_usb_controller(mm):
             'sys/dev/usb/controller/ehci.h',
             'sys/dev/usb/controller/ehcireg.h',
             'sys/dev/usb/controller/uhcireg.h',
+            'sys/dev/usb/controller/xhci.h',
             'sys/dev/usb/controller/xhcireg.h',
             'sys/dev/usb/controller/dwc_otg.h',
             'sys/dev/usb/controller/dwc_otgreg.h',
@@ -663,6 +677,8 @@ def dev_usb_controller(mm):
         [
             'sys/dev/usb/controller/ohci.c',
             'sys/dev/usb/controller/ehci.c',
+            'sys/dev/usb/controller/xhci.c',
+            'sys/dev/usb/controller/xhci_pci.c',
             'sys/dev/usb/controller/usb_controller.c',
             'sys/dev/usb/controller/dwc_otg.c',
         ],
@@ -1704,6 +1720,12 @@ def netinet(mm):
         ],
         mm.generator['source']()
     )
+    mod.addRTEMSSourceFiles(
+        [
+            'sys/net/flowtable.c',
+        ],
+        mm.generator['source']()
+    )
     return mod
 
 #
@@ -2104,6 +2126,14 @@ def ipfw(mm):
     )
     mod.addKernelSpaceSourceFiles(
         [
+            'sys/netpfil/ipfw/dn_aqm_codel.c',
+            'sys/netpfil/ipfw/dn_aqm_pie.c',
+            'sys/netpfil/ipfw/dn_heap.c',
+            'sys/netpfil/ipfw/dn_sched_fifo.c',
+            'sys/netpfil/ipfw/dn_sched_fq_codel.c',
+            'sys/netpfil/ipfw/dn_sched_wf2q.c',
+            'sys/netpfil/ipfw/ip_dn_io.c',
+            'sys/netpfil/ipfw/ip_dummynet.c',
             'sys/netpfil/ipfw/ip_fw2.c',
             'sys/netpfil/ipfw/ip_fw_bpf.c',
             'sys/netpfil/ipfw/ip_fw_dynamic.c',
@@ -2647,7 +2677,7 @@ def contrib_libpcap(mm):
               '-DHAVE_SNPRINTF=1',
               '-DHAVE_VSNPRINTF=1',
               '-DHAVE_SOCKADDR_SA_LEN=1',
-              #'-DHAVE_ZEROCOPY_BPF=1',
+              '-DHAVE_ZEROCOPY_BPF=1',
               '-DHAVE_NET_IF_MEDIA_H=1',
               '-DHAVE_SYS_IOCCOM_H=1']
     mod.addUserSpaceHeaderFiles(
@@ -3035,6 +3065,7 @@ def tests(mm):
     mod.addTest(mm.generator['test']('ftpd02', ['test_main']))
     mod.addTest(mm.generator['test']('ping01', ['test_main'], netTest = True))
     mod.addTest(mm.generator['test']('selectpollkqueue01', ['test_main']))
+    mod.addTest(mm.generator['test']('pipe01', ['test_main']))
     mod.addTest(mm.generator['test']('rwlock01', ['test_main']))
     mod.addTest(mm.generator['test']('sleep01', ['test_main']))
     mod.addTest(mm.generator['test']('syscalls01', ['test_main']))
@@ -3042,16 +3073,24 @@ def tests(mm):
     mod.addTest(mm.generator['test']('commands01', ['test_main']))
     mod.addTest(mm.generator['test']('usb01', ['init'], False))
     mod.addTest(mm.generator['test']('usbserial01', ['init'], False))
+    mod.addTest(mm.generator['test']('cdce01', ['test_main'],
+                                     runTest = False, netTest = True))
     mod.addTest(mm.generator['test']('usbkbd01', ['init'], False))
     mod.addTest(mm.generator['test']('usbmouse01', ['init'], False))
     mod.addTest(mm.generator['test']('evdev01', ['init'], False))
     mod.addTest(mm.generator['test']('loopback01', ['test_main']))
+    mod.addTest(mm.generator['test']('sctp01', ['test_main']))
+    mod.addTest(mm.generator['test']('syncache01', ['test_main']))
+    mod.addTest(mm.generator['test']('mcast01', ['test_main']))
+    mod.addTest(mm.generator['test']('udplowat01', ['test_main']))
     mod.addTest(mm.generator['test']('netshell01', ['test_main', 'shellconfig'], False))
     mod.addTest(mm.generator['test']('swi01', ['init', 'swi_test']))
     mod.addTest(mm.generator['test']('timeout01', ['init', 'timeout_test']))
     mod.addTest(mm.generator['test']('init01', ['test_main']))
     mod.addTest(mm.generator['test']('thread01', ['test_main']))
     mod.addTest(mm.generator['test']('mutex01', ['test_main']))
+    mod.addTest(mm.generator['test']('rmlock01', ['test_main']))
+    mod.addTest(mm.generator['test']('epoch01', ['test_main']))
     mod.addTest(mm.generator['test']('condvar01', ['test_main']))
     mod.addTest(mm.generator['test']('ppp01', ['test_main'], runTest = False))
     mod.addTest(mm.generator['test']('zerocopy01', ['test_main'],
@@ -3059,6 +3098,10 @@ def tests(mm):
     mod.addTest(mm.generator['test']('smp01', ['test_main']))
     mod.addTest(mm.generator['test']('media01', ['test_main'], runTest = False))
     mod.addTest(mm.generator['test']('vlan01', ['test_main'], netTest = True))
+    mod.addTest(mm.generator['test']('epair01', ['test_main']))
+    mod.addTest(mm.generator['test']('gso01', ['test_main']))
+    mod.addTest(mm.generator['test']('reass01', ['test_main']))
+    mod.addTest(mm.generator['test']('flowtable01', ['test_main']))
     mod.addTest(mm.generator['test']('lagg01', ['test_main'], netTest = True))
     mod.addTest(mm.generator['test']('log01', ['test_main']))
     mod.addTest(mm.generator['test']('rcconf01', ['test_main']))
@@ -3066,6 +3109,10 @@ def tests(mm):
     mod.addTest(mm.generator['test']('cdev01', ['test_main', 'test_cdev']))
     mod.addTest(mm.generator['test']('pf01', ['test_main']))
     mod.addTest(mm.generator['test']('pf02', ['test_main'], runTest = False))
+    mod.addTest(mm.generator['test']('ipfw01', ['test_main']))
+    mod.addTest(mm.generator['test']('crc32c01', ['test_main']))
+    mod.addTest(mm.generator['test']('dummynet01', ['test_main']))
+    mod.addTest(mm.generator['test']('tcprack01', ['test_main']))
     mod.addTest(mm.generator['test']('termios', ['test_main',
                                      'test_termios_driver',
                                      'test_termios_utilities']))
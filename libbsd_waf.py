@@ -158,7 +158,7 @@ def build(bld):
                 features = "c",
                 cflags = cflags,
                 includes = [] + includes,
-                defines = defines + ['__FreeBSD__=1', 'BSD=1', 'INET6', '_U_=__attribute__((unused))', 'HAVE_LIMITS_H=1', 'HAVE_INTTYPES=1', 'HAVE_STDINT=1', 'HAVE_STRERROR=1', 'HAVE_STRLCPY=1', 'HAVE_SNPRINTF=1', 'HAVE_VSNPRINTF=1', 'HAVE_SOCKADDR_SA_LEN=1', 'HAVE_NET_IF_MEDIA_H=1', 'HAVE_SYS_IOCCOM_H=1', 'NEED_YYPARSE_WRAPPER=1', 'yylval=pcap_lval'],
+                defines = defines + ['__FreeBSD__=1', 'BSD=1', 'INET6', '_U_=__attribute__((unused))', 'HAVE_LIMITS_H=1', 'HAVE_INTTYPES=1', 'HAVE_STDINT=1', 'HAVE_STRERROR=1', 'HAVE_STRLCPY=1', 'HAVE_SNPRINTF=1', 'HAVE_VSNPRINTF=1', 'HAVE_SOCKADDR_SA_LEN=1', 'HAVE_ZEROCOPY_BPF=1', 'HAVE_NET_IF_MEDIA_H=1', 'HAVE_SYS_IOCCOM_H=1', 'NEED_YYPARSE_WRAPPER=1', 'yylval=pcap_lval'],
                 source = "freebsd/contrib/libpcap/scanner.c")
     libbsd_use += ["lex_pcap"]
 
@@ -195,7 +195,7 @@ def build(bld):
                 features = "c",
                 cflags = cflags,
                 includes = [] + includes,
-                defines = defines + ['__FreeBSD__=1', 'BSD=1', 'INET6', '_U_=__attribute__((unused))', 'HAVE_LIMITS_H=1', 'HAVE_INTTYPES=1', 'HAVE_STDINT=1', 'HAVE_STRERROR=1', 'HAVE_STRLCPY=1', 'HAVE_SNPRINTF=1', 'HAVE_VSNPRINTF=1', 'HAVE_SOCKADDR_SA_LEN=1', 'HAVE_NET_IF_MEDIA_H=1', 'HAVE_SYS_IOCCOM_H=1', 'NEED_YYPARSE_WRAPPER=1', 'yylval=pcap_lval'],
+                defines = defines + ['__FreeBSD__=1', 'BSD=1', 'INET6', '_U_=__attribute__((unused))', 'HAVE_LIMITS_H=1', 'HAVE_INTTYPES=1', 'HAVE_STDINT=1', 'HAVE_STRERROR=1', 'HAVE_STRLCPY=1', 'HAVE_SNPRINTF=1', 'HAVE_VSNPRINTF=1', 'HAVE_SOCKADDR_SA_LEN=1', 'HAVE_ZEROCOPY_BPF=1', 'HAVE_NET_IF_MEDIA_H=1', 'HAVE_SYS_IOCCOM_H=1', 'NEED_YYPARSE_WRAPPER=1', 'yylval=pcap_lval'],
                 source = "freebsd/contrib/libpcap/grammar.c")
     libbsd_use += ["yacc_pcap"]
     if bld.env.AUTO_REGEN:
@@ -574,7 +574,7 @@ def build(bld):
                 features = "c",
                 cflags = cflags,
                 includes = [] + includes,
-                defines = defines + ['BSD=1', 'HAVE_INTTYPES=1', 'HAVE_LIMITS_H=1', 'HAVE_NET_IF_MEDIA_H=1', 'HAVE_SNPRINTF=1', 'HAVE_SOCKADDR_SA_LEN=1', 'HAVE_STDINT=1', 'HAVE_STRERROR=1', 'HAVE_STRLCPY=1', 'HAVE_SYS_IOCCOM_H=1', 'HAVE_VSNPRINTF=1', 'INET6', '_U_=__attribute__((unused))', '__FreeBSD__=1'],
+                defines = defines + ['BSD=1', 'HAVE_INTTYPES=1', 'HAVE_LIMITS_H=1', 'HAVE_NET_IF_MEDIA_H=1', 'HAVE_SNPRINTF=1', 'HAVE_SOCKADDR_SA_LEN=1', 'HAVE_STDINT=1', 'HAVE_STRERROR=1', 'HAVE_STRLCPY=1', 'HAVE_SYS_IOCCOM_H=1', 'HAVE_VSNPRINTF=1', 'HAVE_ZEROCOPY_BPF=1', 'INET6', '_U_=__attribute__((unused))', '__FreeBSD__=1'],
                 source = objs06_source)
     libbsd_use += ["objs06"]
 
@@ -898,6 +898,8 @@ def build(bld):
               'freebsd/sys/dev/usb/controller/ehci.c',
               'freebsd/sys/dev/usb/controller/ohci.c',
               'freebsd/sys/dev/usb/controller/usb_controller.c',
+              'freebsd/sys/dev/usb/controller/xhci.c',
+              'freebsd/sys/dev/usb/controller/xhci_pci.c',
               'freebsd/sys/dev/usb/input/atp.c',
               'freebsd/sys/dev/usb/input/uep.c',
               'freebsd/sys/dev/usb/input/uhid.c',
@@ -1216,6 +1218,14 @@ def build(bld):
               'freebsd/sys/netinet6/scope6.c',
               'freebsd/sys/netinet6/sctp6_usrreq.c',
               'freebsd/sys/netinet6/udp6_usrreq.c',
+              'freebsd/sys/netpfil/ipfw/dn_aqm_codel.c',
+              'freebsd/sys/netpfil/ipfw/dn_aqm_pie.c',
+              'freebsd/sys/netpfil/ipfw/dn_heap.c',
+              'freebsd/sys/netpfil/ipfw/dn_sched_fifo.c',
+              'freebsd/sys/netpfil/ipfw/dn_sched_fq_codel.c',
+              'freebsd/sys/netpfil/ipfw/dn_sched_wf2q.c',
+              'freebsd/sys/netpfil/ipfw/ip_dn_io.c',
+              'freebsd/sys/netpfil/ipfw/ip_dummynet.c',
               'freebsd/sys/netpfil/ipfw/ip_fw2.c',
               'freebsd/sys/netpfil/ipfw/ip_fw_bpf.c',
               'freebsd/sys/netpfil/ipfw/ip_fw_dynamic.c',
@@ -1315,6 +1325,7 @@ def build(bld):
               'rtemsbsd/pppd/utils.c',
               'rtemsbsd/rtems/ipsec_get_policylen.c',
               'rtemsbsd/rtems/ofw_machdep.c',
+              'rtemsbsd/rtems/rtems-bsd-allocator-domain-jumbo-size.c',
               'rtemsbsd/rtems/rtems-bsd-allocator-domain-size.c',
               'rtemsbsd/rtems/rtems-bsd-arp-processor.c',
               'rtemsbsd/rtems/rtems-bsd-get-allocator-domain-size.c',
@@ -1322,11 +1333,14 @@ def build(bld):
               'rtemsbsd/rtems/rtems-bsd-get-mac-address.c',
               'rtemsbsd/rtems/rtems-bsd-get-task-priority.c',
               'rtemsbsd/rtems/rtems-bsd-get-task-stack-size.c',
+              'rtemsbsd/rtems/rtems-bsd-parallel-attach-tasks.c',
+              'rtemsbsd/rtems/rtems-bsd-rc-conf-dummynet.c',
               'rtemsbsd/rtems/rtems-bsd-rc-conf-net.c',
               'rtemsbsd/rtems/rtems-bsd-rc-conf-pf.c',
               'rtemsbsd/rtems/rtems-bsd-rc-conf.c',
               'rtemsbsd/rtems/rtems-bsd-regdomain.c',
               'rtemsbsd/rtems/rtems-bsd-shell-arp.c',
+              'rtemsbsd/rtems/rtems-bsd-shell-bootprof.c',
               'rtemsbsd/rtems/rtems-bsd-shell-dhcpcd.c',
               'rtemsbsd/rtems/rtems-bsd-shell-ifconfig.c',
               'rtemsbsd/rtems/rtems-bsd-shell-netstat.c',
@@ -1341,6 +1355,7 @@ def build(bld):
               'rtemsbsd/rtems/rtems-bsd-syscall-api.c',
               'rtemsbsd/rtems/rtems-kernel-assert.c',
               'rtemsbsd/rtems/rtems-kernel-autoconf.c',
+              'rtemsbsd/rtems/rtems-kernel-bootprof.c',
               'rtemsbsd/rtems/rtems-kernel-bus-dma-mbuf.c',
               'rtemsbsd/rtems/rtems-kernel-bus-dma.c',
               'rtemsbsd/rtems/rtems-kernel-bus-root.c',
@@ -1348,10 +1363,12 @@ def build(bld):
               'rtemsbsd/rtems/rtems-kernel-chunk.c',
               'rtemsbsd/rtems/rtems-kernel-configintrhook.c',
               'rtemsbsd/rtems/rtems-kernel-delay.c',
+              'rtemsbsd/rtems/rtems-kernel-epoch.c',
               'rtemsbsd/rtems/rtems-kernel-get-file.c',
               'rtemsbsd/rtems/rtems-kernel-init.c',
               'rtemsbsd/rtems/rtems-kernel-irqs.c',
               'rtemsbsd/rtems/rtems-kernel-jail.c',
+              'rtemsbsd/rtems/rtems-kernel-kqueue.c',
               'rtemsbsd/rtems/rtems-kernel-malloc.c',
               'rtemsbsd/rtems/rtems-kernel-mbuf.c',
               'rtemsbsd/rtems/rtems-kernel-mutex.c',
@@ -1362,6 +1379,7 @@ def build(bld):
               'rtemsbsd/rtems/rtems-kernel-pci_bus.c',
               'rtemsbsd/rtems/rtems-kernel-pci_cfgreg.c',
               'rtemsbsd/rtems/rtems-kernel-program.c',
+              'rtemsbsd/rtems/rtems-kernel-rmlock.c',
               'rtemsbsd/rtems/rtems-kernel-rwlock.c',
               'rtemsbsd/rtems/rtems-kernel-signal.c',
               'rtemsbsd/rtems/rtems-kernel-sx.c',
@@ -1392,8 +1410,13 @@ def build(bld):
               'rtemsbsd/sys/dev/usb/controller/usb_otg_transceiver.c',
               'rtemsbsd/sys/dev/usb/controller/usb_otg_transceiver_dump.c',
               'rtemsbsd/sys/fs/devfs/devfs_devs.c',
+              'rtemsbsd/sys/libkern/crc32c.c',
+              'rtemsbsd/sys/net/bpf_zerocopy.c',
+              'rtemsbsd/sys/net/flowtable.c',
+              'rtemsbsd/sys/net/if_gso.c',
               'rtemsbsd/sys/net/if_ppp.c',
               'rtemsbsd/sys/net/ppp_tty.c',
+              'rtemsbsd/sys/netinet/tcp_rack.c',
               'rtemsbsd/telnetd/check_passwd.c',
               'rtemsbsd/telnetd/des.c',
               'rtemsbsd/telnetd/pty.c',
@@ -1486,6 +1509,16 @@ def build(bld):
                 lib = ["m", "z"],
                 install_path = None)
 
+    test_cdce01 = ['testsuite/cdce01/test_main.c']
+    bld.program(target = "cdce01.exe",
+                features = "cprogram",
+                cflags = cflags,
+                includes = includes,
+                source = test_cdce01,
+                use = ["bsd"],
+                lib = ["m", "z"],
+                install_path = None)
+
     test_cdev01 = ['testsuite/cdev01/test_cdev.c',
                    'testsuite/cdev01/test_main.c']
     bld.program(target = "cdev01.exe",
@@ -1517,6 +1550,16 @@ def build(bld):
                 lib = ["m", "z"],
                 install_path = None)
 
+    test_crc32c01 = ['testsuite/crc32c01/test_main.c']
+    bld.program(target = "crc32c01.exe",
+                features = "cprogram",
+                cflags = cflags,
+                includes = includes,
+                source = test_crc32c01,
+                use = ["bsd"],
+                lib = ["m", "z"],
+                install_path = None)
+
     if bld.env["HAVE_RTEMS_RTEMS_DEBUGGER_H"]:
         test_debugger01 = ['testsuite/debugger01/test_main.c']
         bld.program(target = "debugger01.exe",
@@ -1548,6 +1591,36 @@ def build(bld):
                 lib = ["m", "z"],
                 install_path = None)
 
+    test_dummynet01 = ['testsuite/dummynet01/test_main.c']
+    bld.program(target = "dummynet01.exe",
+                features = "cprogram",
+                cflags = cflags,
+                includes = includes,
+                source = test_dummynet01,
+                use = ["bsd"],
+                lib = ["m", "z"],
+                install_path = None)
+
+    test_epair01 = ['testsuite/epair01/test_main.c']
+    bld.program(target = "epair01.exe",
+                features = "cprogram",
+                cflags = cflags,
+                includes = includes,
+                source = test_epair01,
+                use = ["bsd"],
+                lib = ["m", "z"],
+                install_path = None)
+
+    test_epoch01 = ['testsuite/epoch01/test_main.c']
+    bld.program(target = "epoch01.exe",
+                features = "cprogram",
+                cflags = cflags,
+                includes = includes,
+                source = test_epoch01,
+                use = ["bsd"],
+                lib = ["m", "z"],
+                install_path = None)
+
     test_evdev01 = ['testsuite/evdev01/init.c']
     bld.program(target = "evdev01.exe",
                 features = "cprogram",
@@ -1558,6 +1631,16 @@ def build(bld):
                 lib = ["m", "z"],
                 install_path = None)
 
+    test_flowtable01 = ['testsuite/flowtable01/test_main.c']
+    bld.program(target = "flowtable01.exe",
+                features = "cprogram",
+                cflags = cflags,
+                includes = includes,
+                source = test_flowtable01,
+                use = ["bsd"],
+                lib = ["m", "z"],
+                install_path = None)
+
     test_foobarclient = ['testsuite/foobarclient/test_main.c']
     bld.program(target = "foobarclient.exe",
                 features = "cprogram",
@@ -1598,6 +1681,16 @@ def build(bld):
                 lib = ["m", "z"],
                 install_path = None)
 
+    test_gso01 = ['testsuite/gso01/test_main.c']
+    bld.program(target = "gso01.exe",
+                features = "cprogram",
+                cflags = cflags,
+                includes = includes,
+                source = test_gso01,
+                use = ["bsd"],
+                lib = ["m", "z"],
+                install_path = None)
+
     test_init01 = ['testsuite/init01/test_main.c']
     bld.program(target = "init01.exe",
                 features = "cprogram",
@@ -1608,6 +1701,16 @@ def build(bld):
                 lib = ["m", "z"],
                 install_path = None)
 
+    test_ipfw01 = ['testsuite/ipfw01/test_main.c']
+    bld.program(target = "ipfw01.exe",
+                features = "cprogram",
+                cflags = cflags,
+                includes = includes,
+                source = test_ipfw01,
+                use = ["bsd"],
+                lib = ["m", "z"],
+                install_path = None)
+
     test_lagg01 = ['testsuite/lagg01/test_main.c']
     bld.program(target = "lagg01.exe",
                 features = "cprogram",
@@ -1638,6 +1741,16 @@ def build(bld):
                 lib = ["m", "z"],
                 install_path = None)
 
+    test_mcast01 = ['testsuite/mcast01/test_main.c']
+    bld.program(target = "mcast01.exe",
+                features = "cprogram",
+                cflags = cflags,
+                includes = includes,
+                source = test_mcast01,
+                use = ["bsd"],
+                lib = ["m", "z"],
+                install_path = None)
+
     test_media01 = ['testsuite/media01/test_main.c']
     bld.program(target = "media01.exe",
                 features = "cprogram",
@@ -1709,6 +1822,16 @@ def build(bld):
                 lib = ["m", "z"],
                 install_path = None)
 
+    test_pipe01 = ['testsuite/pipe01/test_main.c']
+    bld.program(target = "pipe01.exe",
+                features = "cprogram",
+                cflags = cflags,
+                includes = includes,
+                source = test_pipe01,
+                use = ["bsd"],
+                lib = ["m", "z"],
+                install_path = None)
+
     test_ppp01 = ['testsuite/ppp01/test_main.c']
     bld.program(target = "ppp01.exe",
                 features = "cprogram",
@@ -1749,6 +1872,26 @@ def build(bld):
                 lib = ["m", "z"],
                 install_path = None)
 
+    test_reass01 = ['testsuite/reass01/test_main.c']
+    bld.program(target = "reass01.exe",
+                features = "cprogram",
+                cflags = cflags,
+                includes = includes,
+                source = test_reass01,
+                use = ["bsd"],
+                lib = ["m", "z"],
+                install_path = None)
+
+    test_rmlock01 = ['testsuite/rmlock01/test_main.c']
+    bld.program(target = "rmlock01.exe",
+                features = "cprogram",
+                cflags = cflags,
+                includes = includes,
+                source = test_rmlock01,
+                use = ["bsd"],
+                lib = ["m", "z"],
+                install_path = None)
+
     test_rwlock01 = ['testsuite/rwlock01/test_main.c']
     bld.program(target = "rwlock01.exe",
                 features = "cprogram",
@@ -1759,6 +1902,16 @@ def build(bld):
                 lib = ["m", "z"],
                 install_path = None)
 
+    test_sctp01 = ['testsuite/sctp01/test_main.c']
+    bld.program(target = "sctp01.exe",
+                features = "cprogram",
+                cflags = cflags,
+                includes = includes,
+                source = test_sctp01,
+                use = ["bsd"],
+                lib = ["m", "z"],
+                install_path = None)
+
     test_selectpollkqueue01 = ['testsuite/selectpollkqueue01/test_main.c']
     bld.program(target = "selectpollkqueue01.exe",
                 features = "cprogram",
@@ -1800,6 +1953,16 @@ def build(bld):
                 lib = ["m", "z"],
                 install_path = None)
 
+    test_syncache01 = ['testsuite/syncache01/test_main.c']
+    bld.program(target = "syncache01.exe",
+                features = "cprogram",
+                cflags = cflags,
+                includes = includes,
+                source = test_syncache01,
+                use = ["bsd"],
+                lib = ["m", "z"],
+                install_path = None)
+
     test_syscalls01 = ['testsuite/syscalls01/test_main.c']
     bld.program(target = "syscalls01.exe",
                 features = "cprogram",
@@ -1810,6 +1973,16 @@ def build(bld):
                 lib = ["m", "z"],
                 install_path = None)
 
+    test_tcprack01 = ['testsuite/tcprack01/test_main.c']
+    bld.program(target = "tcprack01.exe",
+                features = "cprogram",
+                cflags = cflags,
+                includes = includes,
+                source = test_tcprack01,
+                use = ["bsd"],
+                lib = ["m", "z"],
+                install_path = None)
+
     test_telnetd01 = ['testsuite/telnetd01/test_main.c']
     bld.program(target = "telnetd01.exe",
                 features = "cprogram",
@@ -1925,6 +2098,16 @@ def build(bld):
                 lib = ["m", "z"],
                 install_path = None)
 
+    test_udplowat01 = ['testsuite/udplowat01/test_main.c']
+    bld.program(target = "udplowat01.exe",
+                features = "cprogram",
+                cflags = cflags,
+                includes = includes,
+                source = test_udplowat01,
+                use = ["bsd"],
+                lib = ["m", "z"],
+                install_path = None)
+
     test_unix01 = ['testsuite/unix01/test_main.c']
     bld.program(target = "unix01.exe",
                 features = "cprogram",
@@ -107,6 +107,12 @@ RTEMS_BSD_DRIVER_PCI_EM;
 RTEMS_BSD_DRIVER_PCI_RE;
 RTEMS_BSD_DRIVER_REPHY;
 
+#if defined(RTEMS_BSD_CONFIG_USB_XHCI)
+RTEMS_BSD_DRIVER_PCI_XHCI;
+RTEMS_BSD_DRIVER_USB;
+RTEMS_BSD_DRIVER_USB_MASS;
+#endif /* RTEMS_BSD_CONFIG_USB_XHCI */
+
 #elif defined(LIBBSP_POWERPC_QORIQ_BSP_H)
 
 #if !QORIQ_CHIP_IS_T_VARIANT(QORIQ_CHIP_VARIANT)
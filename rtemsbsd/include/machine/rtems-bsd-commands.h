@@ -48,6 +48,8 @@ __BEGIN_DECLS
 
 int rtems_bsd_command_arp(int argc, char **argv);
 
+int rtems_bsd_command_bootprof(int argc, char **argv);
+
 int rtems_bsd_command_ifconfig(int argc, char **argv);
 
 int rtems_bsd_command_netstat(int argc, char **argv);
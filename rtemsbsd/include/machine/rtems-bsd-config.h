@@ -29,13 +29,17 @@
  * Configuration defines:
  *
  *  RTEMS_BSD_CONFIG_DOMAIN_PAGE_MBUFS_SIZE : Memory in bytes for mbufs
+ *  RTEMS_BSD_CONFIG_DOMAIN_JUMBO_SIZE      : Memory in bytes for jumbo clusters
+ *  RTEMS_BSD_CONFIG_PARALLEL_ATTACH_TASKS  : Tasks to attach Nexus devices.
  *  RTEMS_BSD_CONFIG_NET_PF_UNIX            : Packet Filter.
  *  RTEMS_BSD_CONFIG_NET_IF_LAGG            : Link Aggregetion and Failover.
  *  RTEMS_BSD_CONFIG_NET_IF_VLAN            : Virtual LAN.
+ *  RTEMS_BSD_CONFIG_NET_IF_EPAIR           : Virtual Ethernet pairs.
  *  RTEMS_BSD_CONFIG_SERVICE_TELNETD        : Telnet Protocol (TELNET).
  *   RTEMS_BSD_CONFIG_TELNETD_STACK_SIZE    : Telnet shell task stack size.
  *  RTEMS_BSD_CONFIG_SERVICE_FTPD           : File Transfer Protocol (FTP).
  *  RTEMS_BSD_CONFIG_BSP_CONFIG             : Configure default BSP devices.
+ *   RTEMS_BSD_CONFIG_USB_XHCI              : Add the PCI xHCI USB host (pc386).
  *  RTEMS_BSD_CONFIG_INIT                   : Configure the LibBSD support.
  *
  * Rules for adding to this file:
@@ -84,6 +88,18 @@ extern "C" {
   #define RTEMS_BSD_CFGDECL_DOMAIN_PAGE_MBUFS_SIZE RTEMS_BSD_ALLOCATOR_DOMAIN_PAGE_MBUF_DEFAULT
 #endif
 
+#if defined(RTEMS_BSD_CONFIG_DOMAIN_JUMBO_SIZE)
+  #define RTEMS_BSD_CFGDECL_DOMAIN_JUMBO_SIZE RTEMS_BSD_CONFIG_DOMAIN_JUMBO_SIZE
+#else
+  #define RTEMS_BSD_CFGDECL_DOMAIN_JUMBO_SIZE RTEMS_BSD_ALLOCATOR_DOMAIN_JUMBO_DEFAULT
+#endif
+
+#if defined(RTEMS_BSD_CONFIG_PARALLEL_ATTACH_TASKS)
+  #define RTEMS_BSD_CFGDECL_PARALLEL_ATTACH_TASKS RTEMS_BSD_CONFIG_PARALLEL_ATTACH_TASKS
+#else
+  #define RTEMS_BSD_CFGDECL_PARALLEL_ATTACH_TASKS 0
+#endif
+
 /*
  * BSD Kernel modules.
  */
@@ -140,6 +156,28 @@ extern "C" {
   #define RTEMS_BSD_CFGDECL_NET_IF_VLAN
 #endif /* RTEMS_BSD_CONFIG_NET_IF_VLAN */
 
+/*
+ * Virtual Ethernet interface pairs
+ *  https://www.freebsd.org/cgi/man.cgi?query=epair
+ */
+#if defined(RTEMS_BSD_CONFIG_NET_IF_EPAIR)
+  #define RTEMS_BSD_CFGDECL_NET_IF_EPAIR SYSINIT_NEED_NET_IF_EPAIR
+#else
+  #define RTEMS_BSD_CFGDECL_NET_IF_EPAIR
+#endif /* RTEMS_BSD_CONFIG_NET_IF_EPAIR */
+
+/*
+ * Firewall IPFW with dummynet traffic shaping
+ */
+#if defined(RTEMS_BSD_CONFIG_FIREWALL_DUMMYNET)
+  #define RTEMS_BSD_CFGDECL_FIREWALL_DUMMYNET SYSINIT_NEED_FIREWALL_DUMMYNET
+  #define RTEMS_BSD_CFGDECL_FIREWALL_DUMMYNET_SERVICE \
+      RTEMS_BSD_RC_CONF_SYSINT(rc_conf_firewall_dummynet)
+#else
+  #define RTEMS_BSD_CFGDECL_FIREWALL_DUMMYNET
+  #define RTEMS_BSD_CFGDECL_FIREWALL_DUMMYNET_SERVICE
+#endif /* RTEMS_BSD_CONFIG_FIREWALL_DUMMYNET */
+
 /*
  * Firewall PF
  */
@@ -206,6 +244,14 @@ extern "C" {
    */
   uintptr_t rtems_bsd_allocator_domain_page_mbuf_size = \
     RTEMS_BSD_CFGDECL_DOMAIN_PAGE_MBUFS_SIZE;
+  uintptr_t rtems_bsd_allocator_domain_jumbo_size = \
+    RTEMS_BSD_CFGDECL_DOMAIN_JUMBO_SIZE;
+
+  /*
+   * Configure the count of tasks which attach the Nexus devices.
+   */
+  int rtems_bsd_parallel_attach_tasks = \
+    RTEMS_BSD_CFGDECL_PARALLEL_ATTACH_TASKS;
 
   /*
    * If a BSP configuration is requested include the Nexus bus BSP
@@ -224,6 +270,7 @@ extern "C" {
   RTEMS_BSD_CFGDECL_NET_IF_BRIDGE;
   RTEMS_BSD_CFGDECL_NET_IF_LAGG;
   RTEMS_BSD_CFGDECL_NET_IF_VLAN;
+  RTEMS_BSD_CFGDECL_NET_IF_EPAIR;
 
   /*
    * Create the firewall
@@ -232,6 +279,8 @@ extern "C" {
   RTEMS_BSD_CFGDECL_FIREWALL_PF_SERVICE;
   RTEMS_BSD_CFGDECL_FIREWALL_PFLOG;
   RTEMS_BSD_CFGDECL_FIREWALL_PFSYNC;
+  RTEMS_BSD_CFGDECL_FIREWALL_DUMMYNET;
+  RTEMS_BSD_CFGDECL_FIREWALL_DUMMYNET_SERVICE;
 
   /*
    * Create the services.
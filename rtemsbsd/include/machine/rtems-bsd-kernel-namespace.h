@@ -10,6 +10,7 @@
 #define	AddFragmentPtrLink _bsd_AddFragmentPtrLink
 #define	AddLink _bsd_AddLink
 #define	AddPptp _bsd_AddPptp
+#define	addr_dir _bsd_addr_dir
 #define	addr_hash _bsd_addr_hash
 #define	addr_kfib _bsd_addr_kfib
 #define	addr_radix _bsd_addr_radix
@@ -334,6 +335,17 @@
 #define	bpf_mtap _bsd_bpf_mtap
 #define	bpf_mtap2 _bsd_bpf_mtap2
 #define	bpf_tap _bsd_bpf_tap
+#define	bpf_zerocopy_append_bytes _bsd_bpf_zerocopy_append_bytes
+#define	bpf_zerocopy_append_mbuf _bsd_bpf_zerocopy_append_mbuf
+#define	bpf_zerocopy_buffull _bsd_bpf_zerocopy_buffull
+#define	bpf_zerocopy_bufheld _bsd_bpf_zerocopy_bufheld
+#define	bpf_zerocopy_buf_reclaimed _bsd_bpf_zerocopy_buf_reclaimed
+#define	bpf_zerocopy_canfreebuf _bsd_bpf_zerocopy_canfreebuf
+#define	bpf_zerocopy_canwritebuf _bsd_bpf_zerocopy_canwritebuf
+#define	bpf_zerocopy_free _bsd_bpf_zerocopy_free
+#define	bpf_zerocopy_ioctl_getzmax _bsd_bpf_zerocopy_ioctl_getzmax
+#define	bpf_zerocopy_ioctl_rotzbuf _bsd_bpf_zerocopy_ioctl_rotzbuf
+#define	bpf_zerocopy_ioctl_setzbuf _bsd_bpf_zerocopy_ioctl_setzbuf
 #define	bridge_control_table _bsd_bridge_control_table
 #define	bridge_control_table_size _bsd_bridge_control_table_size
 #define	bridge_dn_p _bsd_bridge_dn_p
@@ -455,6 +467,7 @@
 #define	bus_setup_intr _bsd_bus_setup_intr
 #define	bus_teardown_intr _bsd_bus_teardown_intr
 #define	bus_unmap_resource _bsd_bus_unmap_resource
+#define	calculate_crc32c _bsd_calculate_crc32c
 #define	callout_handle_init _bsd_callout_handle_init
 #define	callout_init _bsd_callout_init
 #define	_callout_init_lock _bsd__callout_init_lock
@@ -533,11 +546,14 @@
 #define	clean_unrhdrl _bsd_clean_unrhdrl
 #define	ClearCheckNewLink _bsd_ClearCheckNewLink
 #define	clk_intr_event _bsd_clk_intr_event
+#define	codel_extract_head _bsd_codel_extract_head
+#define	codel_sysctl _bsd_codel_sysctl
 #define	comp_algo_deflate _bsd_comp_algo_deflate
 #define	compare_ifidx _bsd_compare_ifidx
 #define	compare_numarray _bsd_compare_numarray
 #define	config_intrhook_disestablish _bsd_config_intrhook_disestablish
 #define	config_intrhook_establish _bsd_config_intrhook_establish
+#define	control_law _bsd_control_law
 #define	copyiniov _bsd_copyiniov
 #define	counter_ratecheck _bsd_counter_ratecheck
 #define	counter_u64_alloc _bsd_counter_u64_alloc
@@ -703,6 +719,21 @@
 #define	DifferentialChecksum _bsd_DifferentialChecksum
 #define	div_protosw _bsd_div_protosw
 #define	div_usrreqs _bsd_div_usrreqs
+#define	dn_aqm_modevent _bsd_dn_aqm_modevent
+#define	dn_cfg _bsd_dn_cfg
+#define	dn_drain_queue _bsd_dn_drain_queue
+#define	dn_drain_scheduler _bsd_dn_drain_scheduler
+#define	dn_enqueue _bsd_dn_enqueue
+#define	dn_free_pkts _bsd_dn_free_pkts
+#define	dn_ht_entries _bsd_dn_ht_entries
+#define	dn_ht_find _bsd_dn_ht_find
+#define	dn_ht_free _bsd_dn_ht_free
+#define	dn_ht_init _bsd_dn_ht_init
+#define	dn_ht_scan _bsd_dn_ht_scan
+#define	dn_ht_scan_bucket _bsd_dn_ht_scan_bucket
+#define	dn_reschedule _bsd_dn_reschedule
+#define	dn_sched_modevent _bsd_dn_sched_modevent
+#define	do_config _bsd_do_config
 #define	do_getopt_accept_filter _bsd_do_getopt_accept_filter
 #define	domain_add _bsd_domain_add
 #define	domain_init _bsd_domain_init
@@ -715,6 +746,9 @@
 #define	drbr_needs_enqueue_drv _bsd_drbr_needs_enqueue_drv
 #define	driver_module_handler _bsd_driver_module_handler
 #define	dummy_def _bsd_dummy_def
+#define	dummynet_get _bsd_dummynet_get
+#define	dummynet_io _bsd_dummynet_io
+#define	dummynet_task _bsd_dummynet_task
 #define	dwc_driver _bsd_dwc_driver
 #define	dwc_otg_filter_interrupt _bsd_dwc_otg_filter_interrupt
 #define	dwc_otg_init _bsd_dwc_otg_init
@@ -1025,6 +1059,7 @@
 #define	e1000_write_vfta_generic _bsd_e1000_write_vfta_generic
 #define	e1000_write_vfta_i350 _bsd_e1000_write_vfta_i350
 #define	e1000_write_xmdio_reg _bsd_e1000_write_xmdio_reg
+#define	ecn_mark _bsd_ecn_mark
 #define	ehci_detach _bsd_ehci_detach
 #define	ehci_get_port_speed_hostc _bsd_ehci_get_port_speed_hostc
 #define	ehci_get_port_speed_portsc _bsd_ehci_get_port_speed_portsc
@@ -1060,9 +1095,19 @@
 #define	enc_xform_rijndael128 _bsd_enc_xform_rijndael128
 #define	enc_xform_skipjack _bsd_enc_xform_skipjack
 #define	eopnotsupp _bsd_eopnotsupp
+#define	epoch_alloc _bsd_epoch_alloc
+#define	epoch_call _bsd_epoch_call
+#define	epoch_enter _bsd_epoch_enter
+#define	epoch_enter_preempt _bsd_epoch_enter_preempt
+#define	epoch_exit _bsd_epoch_exit
+#define	epoch_exit_preempt _bsd_epoch_exit_preempt
+#define	epoch_free _bsd_epoch_free
+#define	epoch_wait _bsd_epoch_wait
+#define	epoch_wait_preempt _bsd_epoch_wait_preempt
 #define	ether_crc32_be _bsd_ether_crc32_be
 #define	ether_crc32_le _bsd_ether_crc32_le
 #define	ether_demux _bsd_ether_demux
+#define	ether_gso_output _bsd_ether_gso_output
 #define	ether_ifattach _bsd_ether_ifattach
 #define	ether_ifdetach _bsd_ether_ifdetach
 #define	ether_ioctl _bsd_ether_ioctl
@@ -1141,7 +1186,11 @@
 #define	firmware_unregister _bsd_firmware_unregister
 #define	first_handler _bsd_first_handler
 #define	flow_hash _bsd_flow_hash
+#define	flowtable_gen _bsd_flowtable_gen
+#define	flowtable_insert_nh4 _bsd_flowtable_insert_nh4
+#define	flowtable_lookup_nh4 _bsd_flowtable_lookup_nh4
 #define	flush_table _bsd_flush_table
+#define	fq_codel_sysctl _bsd_fq_codel_sysctl
 #define	frag6_drain _bsd_frag6_drain
 #define	frag6_init _bsd_frag6_init
 #define	frag6_input _bsd_frag6_input
@@ -1182,11 +1231,18 @@
 #define	gif_encapcheck _bsd_gif_encapcheck
 #define	gif_input _bsd_gif_input
 #define	gif_output _bsd_gif_output
+#define	global_epoch _bsd_global_epoch
+#define	global_epoch_preempt _bsd_global_epoch_preempt
 #define	gre_input _bsd_gre_input
 #define	handlers _bsd_handlers
 #define	hashdestroy _bsd_hashdestroy
 #define	hashinit _bsd_hashinit
 #define	hashinit_flags _bsd_hashinit_flags
+#define	heap_extract _bsd_heap_extract
+#define	heap_free _bsd_heap_free
+#define	heap_init _bsd_heap_init
+#define	heap_insert _bsd_heap_insert
+#define	heap_scan _bsd_heap_scan
 #define	hex2ascii_data _bsd_hex2ascii_data
 #define	hhook_add_hook _bsd_hhook_add_hook
 #define	hhook_add_hook_lookup _bsd_hhook_add_hook_lookup
@@ -1944,6 +2000,7 @@
 #define	in_delmulti _bsd_in_delmulti
 #define	in_domifattach _bsd_in_domifattach
 #define	in_domifdetach _bsd_in_domifdetach
+#define	in_epoch _bsd_in_epoch
 #define	inet6ctlerrmap _bsd_inet6ctlerrmap
 #define	inet6domain _bsd_inet6domain
 #define	inet6_pfil_hook _bsd_inet6_pfil_hook
@@ -2042,6 +2099,7 @@
 #define	intr_event_add_handler _bsd_intr_event_add_handler
 #define	intr_event_create _bsd_intr_event_create
 #define	intr_event_execute_handlers _bsd_intr_event_execute_handlers
+#define	io_pkt_drop _bsd_io_pkt_drop
 #define	ip6_accept_rtadv _bsd_ip6_accept_rtadv
 #define	ip6_auto_flowlabel _bsd_ip6_auto_flowlabel
 #define	ip6_auto_linklocal _bsd_ip6_auto_linklocal
@@ -2132,6 +2190,9 @@
 #define	ip_ecn_ingress _bsd_ip_ecn_ingress
 #define	ip_fillid _bsd_ip_fillid
 #define	ip_forward _bsd_ip_forward
+#define	ipdn_bound_var _bsd_ipdn_bound_var
+#define	ipdn_q_find _bsd_ipdn_q_find
+#define	ipdn_si_find _bsd_ipdn_si_find
 #define	ipforwarding _bsd_ipforwarding
 #define	ip_fragment _bsd_ip_fragment
 #define	ipfw_add_eaction _bsd_ipfw_add_eaction
@@ -2454,11 +2515,14 @@
 #define	lltable_foreach_lle _bsd_lltable_foreach_lle
 #define	lltable_free _bsd_lltable_free
 #define	lltable_free_entry _bsd_lltable_free_entry
+#define	lltable_gen _bsd_lltable_gen
 #define	lltable_get_af _bsd_lltable_get_af
 #define	lltable_get_ifp _bsd_lltable_get_ifp
 #define	lltable_link _bsd_lltable_link
 #define	lltable_link_entry _bsd_lltable_link_entry
 #define	lltable_prefix_free _bsd_lltable_prefix_free
+#define	lltable_readers _bsd_lltable_readers
+#define	lltable_read_synchronize _bsd_lltable_read_synchronize
 #define	lltable_set_entry_addr _bsd_lltable_set_entry_addr
 #define	lltable_sysctl_dumparp _bsd_lltable_sysctl_dumparp
 #define	lltable_try_set_entry_addr _bsd_lltable_try_set_entry_addr
@@ -2467,6 +2531,7 @@
 #define	lock_classes _bsd_lock_classes
 #define	lock_class_mtx_sleep _bsd_lock_class_mtx_sleep
 #define	lock_class_mtx_spin _bsd_lock_class_mtx_spin
+#define	lock_class_rm _bsd_lock_class_rm
 #define	lock_class_rw _bsd_lock_class_rw
 #define	lock_class_sx _bsd_lock_class_sx
 #define	lock_destroy _bsd_lock_destroy
@@ -2490,6 +2555,7 @@
 #define	M_80211_SCAN _bsd_M_80211_SCAN
 #define	M_80211_VAP _bsd_M_80211_VAP
 #define	M_ACCF _bsd_M_ACCF
+#define	M_DUMMYNET _bsd_M_DUMMYNET
 #define	machclk_freq _bsd_machclk_freq
 #define	machclk_per_tick _bsd_machclk_per_tick
 #define	machclk_usepcc _bsd_machclk_usepcc
@@ -2716,6 +2782,7 @@
 #define	nd6_timer_ch _bsd_nd6_timer_ch
 #define	nd_defrouter _bsd_nd_defrouter
 #define	nd_prefix _bsd_nd_prefix
+#define	net_epoch_preempt _bsd_net_epoch_preempt
 #define	netisr_clearqdrops _bsd_netisr_clearqdrops
 #define	netisr_dispatch _bsd_netisr_dispatch
 #define	netisr_dispatch_src _bsd_netisr_dispatch_src
@@ -3204,6 +3271,7 @@
 #define	pgsigio _bsd_pgsigio
 #define	phashinit _bsd_phashinit
 #define	phashinit_flags _bsd_phashinit_flags
+#define	pie_sysctl _bsd_pie_sysctl
 #define	pim6_input _bsd_pim6_input
 #define	pim_input _bsd_pim_input
 #define	pipe_dtor _bsd_pipe_dtor
@@ -3554,10 +3622,21 @@
 #define	rman_set_rid _bsd_rman_set_rid
 #define	rman_set_start _bsd_rman_set_start
 #define	rman_set_virtual _bsd_rman_set_virtual
+#define	_rm_assert _bsd__rm_assert
 #define	RMD160Final _bsd_RMD160Final
 #define	RMD160Init _bsd_RMD160Init
 #define	RMD160Transform _bsd_RMD160Transform
 #define	RMD160Update _bsd_RMD160Update
+#define	rm_destroy _bsd_rm_destroy
+#define	rm_init _bsd_rm_init
+#define	rm_init_flags _bsd_rm_init_flags
+#define	_rm_rlock _bsd__rm_rlock
+#define	_rm_runlock _bsd__rm_runlock
+#define	rm_sysinit _bsd_rm_sysinit
+#define	rm_sysinit_flags _bsd_rm_sysinit_flags
+#define	_rm_wlock _bsd__rm_wlock
+#define	rm_wowned _bsd_rm_wowned
+#define	_rm_wunlock _bsd__rm_wunlock
 #define	rn4_mpath_inithead _bsd_rn4_mpath_inithead
 #define	rn6_mpath_inithead _bsd_rn6_mpath_inithead
 #define	rn_addroute _bsd_rn_addroute
@@ -3705,6 +3784,9 @@
 #define	_rw_wlock _bsd__rw_wlock
 #define	rw_wowned _bsd_rw_wowned
 #define	_rw_wunlock _bsd__rw_wunlock
+#define	rxpool_create _bsd_rxpool_create
+#define	rxpool_destroy _bsd_rxpool_destroy
+#define	rxpool_getcl _bsd_rxpool_getcl
 #define	sa6_any _bsd_sa6_any
 #define	sa6_checkzone _bsd_sa6_checkzone
 #define	sa6_checkzone_ifp _bsd_sa6_checkzone_ifp
@@ -4359,6 +4441,7 @@
 #define	sppp_isempty _bsd_sppp_isempty
 #define	sppp_pick _bsd_sppp_pick
 #define	sprintf _bsd_sprintf
+#define	sse42_crc32c _bsd_sse42_crc32c
 #define	_start_set_ieee80211_ioctl_getset _bsd__start_set_ieee80211_ioctl_getset
 #define	_start_set_ieee80211_ioctl_setset _bsd__start_set_ieee80211_ioctl_setset
 #define	_start_set_modmetadata_set _bsd__start_set_modmetadata_set
@@ -5021,6 +5104,13 @@
 #define	X_ip6_mrouter_get _bsd_X_ip6_mrouter_get
 #define	X_ip6_mrouter_set _bsd_X_ip6_mrouter_set
 #define	X_mrt6_ioctl _bsd_X_mrt6_ioctl
+#define	xhci_halt_controller _bsd_xhci_halt_controller
+#define	xhci_init _bsd_xhci_init
+#define	xhci_interrupt _bsd_xhci_interrupt
+#define	xhci_reset_controller _bsd_xhci_reset_controller
+#define	xhci_start_controller _bsd_xhci_start_controller
+#define	xhci_uninit _bsd_xhci_uninit
+#define	xhci_use_polling _bsd_xhci_use_polling
 #define	xpt_bus_deregister _bsd_xpt_bus_deregister
 #define	xpt_bus_register _bsd_xpt_bus_register
 #define	xpt_done _bsd_xpt_done
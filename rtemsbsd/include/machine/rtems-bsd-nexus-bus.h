@@ -74,6 +74,7 @@
  *   RTEMS_BSD_DRIVER_PCI_IGB
  *   RTEMS_BSD_DRIVER_PCI_EM
  *   RTEMS_BSD_DRIVER_PCI_RE
+ *   RTEMS_BSD_DRIVER_PCI_XHCI
  *
  *  MMI PHY:
  *   RTEMS_BSD_DRIVER_E1000PHY
@@ -420,6 +421,15 @@ extern "C" {
     SYSINIT_DRIVER_REFERENCE(re, pci);
 #endif /* RTEMS_BSD_DRIVER_PCI_RE */
 
+/*
+ * USB 3.0 eXtensible Host Controller.
+ */
+#if !defined(RTEMS_BSD_DRIVER_PCI_XHCI)
+  #define RTEMS_BSD_DRIVER_PCI_XHCI               \
+    SYSINIT_DRIVER_REFERENCE(xhci, pci);          \
+    SYSINIT_DRIVER_REFERENCE(usbus, xhci);
+#endif /* RTEMS_BSD_DRIVER_PCI_XHCI */
+
 /**
  ** MMI Physical Layer Support.
  **/
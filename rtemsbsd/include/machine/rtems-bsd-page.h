@@ -61,6 +61,10 @@ void *rtems_bsd_page_alloc(uintptr_t size_in_bytes, int wait);
 
 void rtems_bsd_page_free(void *addr);
 
+void *rtems_bsd_jumbo_alloc(uintptr_t size_in_bytes, int wait);
+
+void rtems_bsd_jumbo_free(void *addr);
+
 static inline void **
 rtems_bsd_page_get_object_entry(void *addr)
 {
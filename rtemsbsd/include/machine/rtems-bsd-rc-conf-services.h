@@ -156,6 +156,7 @@ extern void rtems_bsd_rc_conf_print_cmd(rtems_bsd_rc_conf* rc_conf,
  */
 void rc_conf_net_init(void* arg);           /* Installed by default. */
 void rc_conf_firewall_pf_init(void* arg);   /* pf_enabled="YES" */
+void rc_conf_firewall_dummynet_init(void* arg); /* dummynet_enable="YES" */
 void rc_conf_telnetd_init(void* arg);       /* telnetd_enabled="YES" */
 void rc_conf_ftpd_init(void* arg);          /* ftpd_enabled="YES" */
 
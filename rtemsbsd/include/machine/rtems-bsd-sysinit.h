@@ -72,6 +72,15 @@
 	SYSINIT_DRIVER_REFERENCE(pcib, legacy);  \
 	SYSINIT_DRIVER_REFERENCE(pci, pcib);
 
+#define SYSINIT_NEED_FIREWALL_DUMMYNET \
+	SYSINIT_MODULE_REFERENCE(ipfw); \
+	SYSINIT_MODULE_REFERENCE(dummynet); \
+	SYSINIT_MODULE_REFERENCE(dn_fifo); \
+	SYSINIT_MODULE_REFERENCE(dn_wf2qp); \
+	SYSINIT_MODULE_REFERENCE(dn_fq_codel); \
+	SYSINIT_MODULE_REFERENCE(dn_aqm_codel); \
+	SYSINIT_MODULE_REFERENCE(dn_aqm_pie)
+
 #define SYSINIT_NEED_FIREWALL_PF \
 	SYSINIT_MODULE_REFERENCE(pf)
 
@@ -126,4 +135,7 @@
 #define SYSINIT_NEED_NET_IF_VLAN \
 	SYSINIT_MODULE_REFERENCE(if_vlan)
 
+#define SYSINIT_NEED_NET_IF_EPAIR \
+	SYSINIT_MODULE_REFERENCE(if_epair)
+
 #endif /* _RTEMS_BSD_MACHINE_RTEMS_BSD_SYSINIT_H_ */
@@ -58,6 +58,13 @@ extern "C" {
  */
 #define RTEMS_BSD_ALLOCATOR_DOMAIN_PAGE_MBUF_DEFAULT (8 * 1024 * 1024)
 
+/*
+ * The default jumbo cluster region size.  There is no dedicated region by
+ * default, use RTEMS_BSD_CONFIG_DOMAIN_JUMBO_SIZE to reserve one for your
+ * application.
+ */
+#define RTEMS_BSD_ALLOCATOR_DOMAIN_JUMBO_DEFAULT 0
+
 typedef enum {
 	RTEMS_BSD_RES_IRQ = 1,
 	RTEMS_BSD_RES_MEMORY = 3
@@ -120,7 +127,8 @@ size_t rtems_bsd_get_task_stack_size(const char *name);
 typedef enum {
 	RTEMS_BSD_ALLOCATOR_DOMAIN_PAGE,
 	RTEMS_BSD_ALLOCATOR_DOMAIN_MBUF,
-	RTEMS_BSD_ALLOCATOR_DOMAIN_MALLOC
+	RTEMS_BSD_ALLOCATOR_DOMAIN_MALLOC,
+	RTEMS_BSD_ALLOCATOR_DOMAIN_JUMBO
 } rtems_bsd_allocator_domain;
 
 /**
@@ -130,6 +138,33 @@ typedef enum {
  */
 extern uintptr_t rtems_bsd_allocator_domain_page_mbuf_size;
 
+/**
+ * @brief The size for the jumbo cluster allocator domain.
+ *
+ * The 9k and 16k mbuf clusters are allocated from a contiguous region of this
+ * size which is reserved during system initialization.  If the region is
+ * exhausted or its size is zero, then the clusters are allocated from the
+ * malloc() heap.
+ *
+ * Applications may set this value to change the value returned by the default.
+ */
+extern uintptr_t rtems_bsd_allocator_domain_jumbo_size;
+
+/**
+ * @brief The count of tasks which attach the Nexus devices.
+ *
+ * If this value is positive, then the devices of the Nexus bus and their
+ * subtrees are attached concurrently by this count of tasks.  Attach handlers
+ * which sleep release the Giant lock, so that other devices may proceed
+ * meanwhile.  In this mode, MII PHY resets during attach sleep instead of
+ * busy waiting.  Use this only if the Nexus devices do not depend on each
+ * other.  With the default value of zero the devices are attached
+ * sequentially.
+ *
+ * Applications may set this value before rtems_bsd_initialize().
+ */
+extern int rtems_bsd_parallel_attach_tasks;
+
 /**
  * @brief Returns the size for a specific allocator domain.
  *
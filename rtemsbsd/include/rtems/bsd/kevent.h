@@ -0,0 +1,94 @@
+/**
+ * @file
+ *
+ * @ingroup rtems_bsd
+ *
+ * @brief Kqueue filters for RTEMS objects.
+ */
+
+/*
+ * Copyright (c) 2026 embedded brains GmbH.  All rights reserved.
+ *
+ *  embedded brains GmbH
+ *  Dornierstr. 4
+ *  82178 Puchheim
+ *  Germany
+ *  <rtems@embedded-brains.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _RTEMS_BSD_KEVENT_H_
+#define _RTEMS_BSD_KEVENT_H_
+
+#include <sys/event.h>
+
+#include <rtems.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * Filters for Classic API objects.  The ident of the kevent is the object
+ * identifier.  The filters only report events, the objects must be consumed
+ * with the Classic API, e.g. rtems_event_receive() with RTEMS_NO_WAIT.
+ *
+ * EVFILT_RTEMS_EVENT: Events sent to a task with rtems_bsd_event_send().  An
+ * ident of RTEMS_SELF selects the registering task.  The fflags select the
+ * events of interest, zero selects all events.  The fflags of the returned
+ * kevent contain the events sent since the last report.  EV_CLEAR is
+ * implied.
+ *
+ * EVFILT_RTEMS_MQ: A message queue with pending messages.  The data of the
+ * returned kevent is the count of pending messages.  The filter uses the
+ * notification handler of the message queue, so only one kqueue mechanism
+ * may watch a message queue at a time.
+ *
+ * EVFILT_RTEMS_SEM: Releases of a semaphore with
+ * rtems_bsd_semaphore_release().  The data of the returned kevent is the
+ * count of releases since the last report.  EV_CLEAR is implied.
+ */
+#define	EVFILT_RTEMS_EVENT	(-14)
+#define	EVFILT_RTEMS_MQ		(-15)
+#define	EVFILT_RTEMS_SEM	(-16)
+
+#define	RTEMS_BSD_EVFILT_SYSCOUNT	16
+
+/*
+ * Sends the events to the task like rtems_event_send() and notifies the
+ * EVFILT_RTEMS_EVENT knotes of the task.  May be called from interrupt
+ * context.
+ */
+rtems_status_code rtems_bsd_event_send(rtems_id id, rtems_event_set event_in);
+
+/*
+ * Releases the semaphore like rtems_semaphore_release() and notifies the
+ * EVFILT_RTEMS_SEM knotes of the semaphore.
+ */
+rtems_status_code rtems_bsd_semaphore_release(rtems_id id);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _RTEMS_BSD_KEVENT_H_ */
@@ -47,6 +47,8 @@ extern rtems_shell_cmd_t rtems_shell_WLANSTATS_Command;
 
 extern rtems_shell_cmd_t rtems_shell_STTY_Command;
 
+extern rtems_shell_cmd_t rtems_shell_BOOTPROF_Command;
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
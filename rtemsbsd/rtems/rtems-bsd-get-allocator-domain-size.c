@@ -49,6 +49,9 @@ rtems_bsd_get_allocator_domain_size(rtems_bsd_allocator_domain domain)
 		case RTEMS_BSD_ALLOCATOR_DOMAIN_MBUF:
 			size = rtems_bsd_allocator_domain_page_mbuf_size;
 			break;
+		case RTEMS_BSD_ALLOCATOR_DOMAIN_JUMBO:
+			size = rtems_bsd_allocator_domain_jumbo_size;
+			break;
 		default:
 			size = 0;
 			break;
@@ -0,0 +1,582 @@
+/*
+ * Copyright (c) 2026 embedded brains GmbH.  All rights reserved.
+ *
+ *  embedded brains GmbH
+ *  Dornierstr. 4
+ *  82178 Puchheim
+ *  Germany
+ *  <rtems@embedded-brains.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Handle the dummynet traffic shaper directives found in rc.conf.
+ * - dummynet_enable
+ * - dummynet_pipes
+ * - dummynet_pipe_<N>
+ * - dummynet_pipe_<N>_ifname
+ * - dummynet_accept
+ *
+ * There is no ipfw(8) on RTEMS so the pipes and the rules sending traffic
+ * into them are set up directly through the IP_DUMMYNET3 and IP_FW3 socket
+ * options.  For example:
+ *
+ *   dummynet_enable="YES"
+ *   dummynet_pipes="1"
+ *   dummynet_pipe_1="bw 2Mbit/s queue 100 type fq_codel target 5ms"
+ *   dummynet_pipe_1_ifname="cgem0"
+ *
+ * The pipe specification understands:
+ *
+ *   bw <n>[K|M|G]bit/s  delay <ms>  queue <slots>|<n>KBytes  plr <0..1>
+ *   type fifo|wf2q+|fq_codel [target <t>] [interval <t>] [quantum <n>]
+ *                            [limit <n>] [flows <n>] [ecn|noecn]
+ *   codel [target <t>] [interval <t>] [ecn|noecn]
+ *   pie [target <t>] [tupdate <t>] [max_burst <t>] [ecn|noecn]
+ *
+ * Times are in milliseconds unless they have a "us", "ms" or "s" suffix.
+ * With a "type" the traffic of the interface is sent to a queue on the
+ * scheduler of the pipe.  Otherwise it is sent to the pipe itself, which
+ * optionally uses the "codel" or "pie" AQM instead of tail drop.
+ *
+ * The rule set is otherwise left to the user.  If the firewall denies by
+ * default and all other traffic should pass, set:
+ *
+ *   dummynet_accept="YES"
+ *
+ * This adds "allow ip from any to any" as rule 65000.  It is not added if
+ * the firewall accepts by default.
+ */
+
+#include <sys/param.h>
+#include <sys/socket.h>
+#include <sys/sysctl.h>
+
+#include <net/if.h>
+#include <netinet/in.h>
+#include <netinet/ip_fw.h>
+#include <netinet/ip_dummynet.h>
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+
+#include <machine/rtems-bsd-rc-conf-services.h>
+
+/*
+ * Values of the kernel AQM and scheduler interface, see
+ * <netpfil/ipfw/dn_aqm_codel.h> and <netpfil/ipfw/dn_aqm_pie.h>.
+ */
+#define DUMMYNET_CODEL_ECN_ENABLED 1
+#define DUMMYNET_PIE_ECN_ENABLED 1
+#define DUMMYNET_PIE_DEFAULT_FLAGS (2 | 8 | 16)
+
+#define DUMMYNET_ACCEPT_RULE 65000
+
+#define DUMMYNET_RULE_BASE 64000
+
+typedef struct {
+  struct dn_id           header;
+  struct dn_extra_parms  sch_extra;
+  struct dn_sch          sch;
+  struct dn_link         link;
+  struct dn_extra_parms  aqm_extra;
+  struct dn_fs           fs;
+} dummynet_pipe_config;
+
+static void
+dummynet_oid(struct dn_id* oid, size_t len, int type)
+{
+  memset(oid, 0, len);
+  oid->len = len;
+  oid->type = type;
+  oid->id = DN_API_VERSION;
+}
+
+static void
+dummynet_extra_init(struct dn_extra_parms* ep, int subtype)
+{
+  int i;
+
+  dummynet_oid(&ep->oid, sizeof(*ep), DN_TEXT);
+  ep->oid.subtype = subtype;
+  for (i = 0; i < DN_MAX_EXTRA_PARM; ++i)
+    ep->par[i] = -1;
+}
+
+static int
+dummynet_parse_number(const char* s, long* value, char** end)
+{
+  errno = 0;
+  *value = strtol(s, end, 10);
+  if (errno != 0 || *end == s || *value < 0)
+    return -1;
+  return 0;
+}
+
+static int
+dummynet_parse_bandwidth(const char* s, int* bw)
+{
+  char* end;
+  long  value;
+
+  if (dummynet_parse_number(s, &value, &end) < 0)
+    return -1;
+  switch (*end) {
+  case 'K':
+  case 'k':
+    value *= 1000;
+    ++end;
+    break;
+  case 'M':
+  case 'm':
+    value *= 1000000;
+    ++end;
+    break;
+  case 'G':
+  case 'g':
+    value *= 1000000000;
+    ++end;
+    break;
+  default:
+    break;
+  }
+  if (*end != '\0' && strcasecmp(end, "bit/s") != 0)
+    return -1;
+  if (value > INT32_MAX)
+    return -1;
+  *bw = (int) value;
+  return 0;
+}
+
+/*
+ * Parse a time into microseconds.
+ */
+static int
+dummynet_parse_time(const char* s, int64_t* us)
+{
+  char* end;
+  long  value;
+
+  if (dummynet_parse_number(s, &value, &end) < 0)
+    return -1;
+  if (*end == '\0' || strcmp(end, "ms") == 0)
+    *us = (int64_t) value * 1000;
+  else if (strcmp(end, "us") == 0)
+    *us = value;
+  else if (strcmp(end, "s") == 0)
+    *us = (int64_t) value * 1000000;
+  else
+    return -1;
+  return 0;
+}
+
+static int
+dummynet_parse_pipe(
+    int                   argc,
+    const char**          argv,
+    dummynet_pipe_config* cfg,
+    bool*                 has_type)
+{
+  struct dn_extra_parms* params = NULL;
+  bool                   is_fq_codel = false;
+  bool                   is_pie = false;
+  int                    arg;
+
+  for (arg = 1; arg < argc; ++arg) {
+    const char* key = argv[arg];
+    const char* value = arg + 1 < argc ? argv[arg + 1] : NULL;
+    long        n;
+    char*       end;
+    int64_t     us;
+
+    if (strcasecmp(key, "ecn") == 0 || strcasecmp(key, "noecn") == 0) {
+      bool ecn = strcasecmp(key, "ecn") == 0;
+      if (params == NULL)
+        return -1;
+      if (is_pie)
+        params->par[6] = DUMMYNET_PIE_DEFAULT_FLAGS |
+          (ecn ? DUMMYNET_PIE_ECN_ENABLED : 0);
+      else
+        params->par[2] = ecn ? DUMMYNET_CODEL_ECN_ENABLED : 0;
+      continue;
+    }
+
+    if (strcasecmp(key, "codel") == 0 || strcasecmp(key, "pie") == 0) {
+      params = &cfg->aqm_extra;
+      is_pie = strcasecmp(key, "pie") == 0;
+      strlcpy(params->name, is_pie ? "PIE" : "CODEL", sizeof(params->name));
+      cfg->fs.flags |= DN_IS_AQM;
+      continue;
+    }
+
+    if (value == NULL)
+      return -1;
+    ++arg;
+
+    if (strcasecmp(key, "bw") == 0) {
+      if (dummynet_parse_bandwidth(value, &cfg->link.bandwidth) < 0)
+        return -1;
+    } else if (strcasecmp(key, "delay") == 0) {
+      if (dummynet_parse_number(value, &n, &end) < 0 || *end != '\0')
+        return -1;
+      cfg->link.delay = n;
+    } else if (strcasecmp(key, "plr") == 0) {
+      double plr;
+
+      errno = 0;
+      plr = strtod(value, &end);
+      if (errno != 0 || end == value || *end != '\0' || plr < 0.0 ||
+          plr > 1.0)
+        return -1;
+      cfg->fs.plr = (int32_t) (plr * 0x7fffffff);
+    } else if (strcasecmp(key, "queue") == 0) {
+      if (dummynet_parse_number(value, &n, &end) < 0)
+        return -1;
+      if (strcasecmp(end, "KBytes") == 0) {
+        cfg->fs.qsize = n * 1024;
+        cfg->fs.flags |= DN_QSIZE_BYTES;
+      } else if (strcasecmp(end, "Bytes") == 0) {
+        cfg->fs.qsize = n;
+        cfg->fs.flags |= DN_QSIZE_BYTES;
+      } else if (*end == '\0') {
+        cfg->fs.qsize = n;
+      } else {
+        return -1;
+      }
+    } else if (strcasecmp(key, "type") == 0) {
+      if (strcasecmp(value, "fifo") == 0)
+        strlcpy(cfg->sch.name, "FIFO", sizeof(cfg->sch.name));
+      else if (strcasecmp(value, "wf2q+") == 0)
+        strlcpy(cfg->sch.name, "WF2Q+", sizeof(cfg->sch.name));
+      else if (strcasecmp(value, "fq_codel") == 0) {
+        strlcpy(cfg->sch.name, "FQ_CODEL", sizeof(cfg->sch.name));
+        strlcpy(cfg->sch_extra.name, "FQ_CODEL",
+                sizeof(cfg->sch_extra.name));
+        cfg->sch_extra.oid.subtype = DN_SCH_PARAMS;
+        params = &cfg->sch_extra;
+        is_fq_codel = true;
+        is_pie = false;
+      } else
+        return -1;
+      *has_type = true;
+    } else if (strcasecmp(key, "target") == 0 ||
+               strcasecmp(key, "interval") == 0 ||
+               strcasecmp(key, "tupdate") == 0 ||
+               strcasecmp(key, "max_burst") == 0) {
+      int idx;
+      if (params == NULL || dummynet_parse_time(value, &us) < 0)
+        return -1;
+      if (strcasecmp(key, "target") == 0)
+        idx = 0;
+      else if (strcasecmp(key, "interval") == 0 && !is_pie)
+        idx = 1;
+      else if (strcasecmp(key, "tupdate") == 0 && is_pie)
+        idx = 1;
+      else if (strcasecmp(key, "max_burst") == 0 && is_pie)
+        idx = 2;
+      else
+        return -1;
+      params->par[idx] = us;
+    } else if (strcasecmp(key, "quantum") == 0 ||
+               strcasecmp(key, "limit") == 0 ||
+               strcasecmp(key, "flows") == 0) {
+      int idx;
+      if (params != &cfg->sch_extra || !is_fq_codel ||
+          dummynet_parse_number(value, &n, &end) < 0 || *end != '\0')
+        return -1;
+      if (strcasecmp(key, "quantum") == 0)
+        idx = 3;
+      else if (strcasecmp(key, "limit") == 0)
+        idx = 4;
+      else
+        idx = 5;
+      params->par[idx] = n;
+    } else {
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+/*
+ * Configure pipe N.  Without a scheduler type this is the equivalent of
+ * "ipfw pipe N config ...", with a type it is additionally the equivalent
+ * of "ipfw queue N config pipe N".
+ */
+static int
+dummynet_config_pipe(
+    int          s,
+    uint32_t     nr,
+    int          argc,
+    const char** argv,
+    bool*        has_type)
+{
+  dummynet_pipe_config cfg;
+  int                  i;
+
+  dummynet_oid(&cfg.header, sizeof(cfg.header), DN_CMD_CONFIG);
+  dummynet_extra_init(&cfg.sch_extra, 0);
+  dummynet_oid(&cfg.sch.oid, sizeof(cfg.sch), DN_SCH);
+  dummynet_oid(&cfg.link.oid, sizeof(cfg.link), DN_LINK);
+  dummynet_extra_init(&cfg.aqm_extra, DN_AQM_PARAMS);
+  dummynet_oid(&cfg.fs.oid, sizeof(cfg.fs), DN_FS);
+
+  cfg.sch.sched_nr = nr;
+  cfg.sch.flags = DN_PIPE_CMD;
+  cfg.link.link_nr = nr;
+  cfg.fs.fs_nr = nr + 2 * DN_MAX_ID;
+  cfg.fs.sched_nr = nr + DN_MAX_ID;
+  for (i = 0; i < nitems(cfg.fs.par); ++i)
+    cfg.fs.par[i] = -1;
+
+  *has_type = false;
+  if (dummynet_parse_pipe(argc, argv, &cfg, has_type) < 0) {
+    fprintf(stderr,
+            "error: dummynet: Syntax error in dummynet_pipe_%" PRIu32
+            " directive.\n", nr);
+    errno = EINVAL;
+    return -1;
+  }
+
+  if (*has_type) {
+    cfg.fs.fs_nr = nr;
+    cfg.fs.sched_nr = nr;
+  }
+
+  return setsockopt(s, IPPROTO_IP, IP_DUMMYNET3, &cfg, sizeof(cfg));
+}
+
+/*
+ * Add the equivalent of one of
+ *
+ *   ipfw add <rulenum> pipe|queue <N> ip from any to any out xmit <ifname>
+ *   ipfw add <rulenum> allow ip from any to any
+ *
+ * The pipe or queue is used if ifname is not NULL.
+ */
+static int
+dummynet_add_rule(
+    int         s,
+    uint32_t    rulenum,
+    const char* ifname,
+    uint16_t    nr,
+    bool        queue)
+{
+  struct {
+    ip_fw3_opheader    op3;
+    ipfw_obj_ctlv      ctlv;
+    struct ip_fw_rule  rule;
+    uint32_t           cmd[F_INSN_SIZE(ipfw_insn_if) + 2];
+  } req;
+  ipfw_insn* cmd;
+  size_t     rsize;
+
+  memset(&req, 0, sizeof(req));
+  req.op3.opcode = IP_FW_XADD;
+  req.rule.rulenum = rulenum;
+  cmd = req.rule.cmd;
+
+  if (ifname != NULL) {
+    ipfw_insn_if* cmd_if = (ipfw_insn_if*) cmd;
+
+    cmd_if->o.opcode = O_XMIT;
+    cmd_if->o.len = F_INSN_SIZE(ipfw_insn_if);
+    strlcpy(cmd_if->name, ifname, sizeof(cmd_if->name));
+    cmd += F_INSN_SIZE(ipfw_insn_if);
+    req.rule.act_ofs = F_INSN_SIZE(ipfw_insn_if);
+
+    cmd->opcode = queue ? O_QUEUE : O_PIPE;
+    cmd->arg1 = nr;
+  } else {
+    req.rule.flags = IPFW_RULE_NOOPT;
+    cmd->opcode = O_ACCEPT;
+  }
+  cmd->len = F_INSN_SIZE(ipfw_insn);
+  req.rule.cmd_len = req.rule.act_ofs + F_INSN_SIZE(ipfw_insn);
+
+  rsize = roundup2(RULESIZE(&req.rule), sizeof(uint64_t));
+  req.ctlv.head.type = IPFW_TLV_RULE_LIST;
+  req.ctlv.head.length = sizeof(req.ctlv) + rsize;
+  req.ctlv.count = 1;
+  req.ctlv.objsize = rsize;
+
+  return setsockopt(s, IPPROTO_IP, IP_FW3, &req,
+                    sizeof(req.op3) + req.ctlv.head.length);
+}
+
+/*
+ * The accept rule is only needed if the firewall denies by default and the
+ * user asked for it.
+ */
+static bool
+dummynet_want_accept_rule(
+    rtems_bsd_rc_conf*           rc_conf,
+    rtems_bsd_rc_conf_argc_argv* aa)
+{
+  int    default_to_accept;
+  size_t len;
+  int    r;
+
+  r = rtems_bsd_rc_conf_find(rc_conf, "dummynet_accept", aa);
+  if (r < 0 || aa->argc != 2 || strcasecmp("YES", aa->argv[1]) != 0)
+    return false;
+
+  len = sizeof(default_to_accept);
+  r = sysctlbyname("net.inet.ip.fw.default_to_accept", &default_to_accept,
+                   &len, NULL, 0);
+  if (r < 0)
+    return true;
+  return default_to_accept == 0;
+}
+
+static int
+firewall_dummynet_service(rtems_bsd_rc_conf* rc_conf)
+{
+  rtems_bsd_rc_conf_argc_argv* aa;
+  rtems_bsd_rc_conf_argc_argv* pa;
+  char**                       pipes = NULL;
+  int                          pipe_count = 0;
+  int                          s = -1;
+  int                          r;
+  int                          p;
+  int                          erroroccured = 0;
+
+  aa = rtems_bsd_rc_conf_argc_argv_create();
+  if (aa == NULL)
+    return -1;
+  pa = rtems_bsd_rc_conf_argc_argv_create();
+  if (pa == NULL) {
+    rtems_bsd_rc_conf_argc_argv_destroy(aa);
+    return -1;
+  }
+
+  r = rtems_bsd_rc_conf_find(rc_conf, "dummynet_enable", aa);
+  if (r < 0 || aa->argc != 2 || strcasecmp("YES", aa->argv[1]) != 0)
+    goto out;
+
+  r = rtems_bsd_rc_conf_find(rc_conf, "dummynet_pipes", aa);
+  if (r < 0) {
+    fprintf(stderr, "error: dummynet: no dummynet_pipes directive.\n");
+    erroroccured = -1;
+    goto out;
+  }
+  pipes = (char**) aa->argv;
+  pipe_count = aa->argc;
+
+  s = socket(AF_INET, SOCK_RAW, IPPROTO_RAW);
+  if (s < 0) {
+    fprintf(stderr, "error: dummynet: socket: %s\n", strerror(errno));
+    erroroccured = -1;
+    goto out;
+  }
+
+  for (p = 1; p < pipe_count && erroroccured == 0; ++p) {
+    char     name[64];
+    char*    end;
+    long     nr;
+    bool     has_type;
+    uint32_t rulenum;
+
+    errno = 0;
+    nr = strtol(pipes[p], &end, 10);
+    if (errno != 0 || *end != '\0' || nr < 1 || nr >= DN_MAX_ID) {
+      fprintf(stderr, "error: dummynet: invalid pipe number: %s\n",
+              pipes[p]);
+      erroroccured = -1;
+      break;
+    }
+
+    snprintf(name, sizeof(name), "dummynet_pipe_%ld", nr);
+    r = rtems_bsd_rc_conf_find(rc_conf, name, pa);
+    if (r < 0) {
+      fprintf(stderr, "error: dummynet: no %s directive.\n", name);
+      erroroccured = -1;
+      break;
+    }
+
+    rtems_bsd_rc_conf_print_cmd(rc_conf, name, pa->argc, pa->argv);
+    r = dummynet_config_pipe(s, nr, pa->argc, pa->argv, &has_type);
+    if (r < 0) {
+      fprintf(stderr, "error: dummynet: pipe %ld: %s\n", nr,
+              strerror(errno));
+      erroroccured = -1;
+      break;
+    }
+
+    snprintf(name, sizeof(name), "dummynet_pipe_%ld_ifname", nr);
+    r = rtems_bsd_rc_conf_find(rc_conf, name, pa);
+    if (r == 0) {
+      if (pa->argc != 2) {
+        fprintf(stderr,
+                "error: dummynet: Syntax error in %s directive.\n", name);
+        erroroccured = -1;
+        break;
+      }
+      rulenum = DUMMYNET_RULE_BASE + p;
+      r = dummynet_add_rule(s, rulenum, pa->argv[1], nr, has_type);
+      if (r < 0) {
+        fprintf(stderr, "error: dummynet: rule %" PRIu32 ": %s\n",
+                rulenum, strerror(errno));
+        erroroccured = -1;
+        break;
+      }
+    }
+  }
+
+  if (erroroccured == 0 && dummynet_want_accept_rule(rc_conf, pa)) {
+    r = dummynet_add_rule(s, DUMMYNET_ACCEPT_RULE, NULL, 0, false);
+    if (r < 0) {
+      fprintf(stderr, "error: dummynet: rule %d: %s\n",
+              DUMMYNET_ACCEPT_RULE, strerror(errno));
+      erroroccured = -1;
+    }
+  }
+
+out:
+  if (s >= 0)
+    close(s);
+  rtems_bsd_rc_conf_argc_argv_destroy(pa);
+  rtems_bsd_rc_conf_argc_argv_destroy(aa);
+
+  return erroroccured;
+}
+
+void
+rc_conf_firewall_dummynet_init(void* arg)
+{
+  int r;
+  r = rtems_bsd_rc_conf_service_add("dummynet",
+                                    "after:network;before:telnetd;",
+                                    firewall_dummynet_service);
+  if (r < 0)
+    fprintf(stderr,
+            "error: dummynet service add failed: %s\n", strerror(errno));
+}
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2026 embedded brains GmbH.  All rights reserved.
+ *
+ *  embedded brains GmbH
+ *  Dornierstr. 4
+ *  82178 Puchheim
+ *  Germany
+ *  <rtems@embedded-brains.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/sysctl.h>
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <rtems/netcmds-config.h>
+#include <machine/rtems-bsd-commands.h>
+
+static int
+bootprof_print(const char *name)
+{
+	char *buf;
+	size_t len;
+	int rv;
+
+	buf = NULL;
+	len = 0;
+
+	do {
+		free(buf);
+
+		rv = sysctlbyname(name, NULL, &len, NULL, 0);
+		if (rv != 0)
+			break;
+
+		/* Leave room for records added meanwhile */
+		len += len / 4;
+		buf = malloc(len);
+		if (buf == NULL) {
+			errno = ENOMEM;
+			rv = -1;
+			break;
+		}
+
+		rv = sysctlbyname(name, buf, &len, NULL, 0);
+	} while (rv != 0 && errno == ENOMEM);
+
+	if (rv == 0)
+		printf("%s:%s\n", name, buf);
+	else
+		fprintf(stderr, "bootprof: %s: %s\n", name, strerror(errno));
+
+	free(buf);
+	return (rv);
+}
+
+int
+rtems_bsd_command_bootprof(int argc, char **argv)
+{
+	int sysinit;
+	int attach;
+	int rv;
+	int i;
+
+	sysinit = 0;
+	attach = 0;
+
+	for (i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "-s") == 0) {
+			sysinit = 1;
+		} else if (strcmp(argv[i], "-a") == 0) {
+			attach = 1;
+		} else {
+			fprintf(stderr, "usage: bootprof [-a] [-s]\n");
+			return (EXIT_FAILURE);
+		}
+	}
+
+	if (sysinit == 0 && attach == 0) {
+		sysinit = 1;
+		attach = 1;
+	}
+
+	rv = 0;
+
+	if (sysinit != 0)
+		rv |= bootprof_print("kern.bootprof.sysinit");
+
+	if (attach != 0)
+		rv |= bootprof_print("kern.bootprof.attach");
+
+	return (rv == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+rtems_shell_cmd_t rtems_shell_BOOTPROF_Command = {
+  .name = "bootprof",
+  .usage = "bootprof [-a] [-s]",
+  .topic = "misc",
+  .command = rtems_bsd_command_bootprof
+};
@@ -0,0 +1,225 @@
+/**
+ * @file
+ *
+ * @ingroup rtems_bsd_rtems
+ *
+ * @brief Boot time profile of the system initialization and device attach.
+ */
+
+/*
+ * Copyright (c) 2026 embedded brains GmbH.  All rights reserved.
+ *
+ *  embedded brains GmbH
+ *  Dornierstr. 4
+ *  82178 Puchheim
+ *  Germany
+ *  <rtems@embedded-brains.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * The execution time of each system initialization handler and each device
+ * attach is recorded with the uptime at its begin and end.  The records are
+ * available through the kern.bootprof sysctl tree, see also the bootprof
+ * shell command.  Device attach records nest, the time of a bus includes the
+ * time of its children.
+ */
+
+#include <machine/rtems-bsd-kernel-space.h>
+#include <machine/rtems-bsd-bootprof.h>
+
+#include <sys/param.h>
+#include <sys/types.h>
+#include <sys/systm.h>
+#include <sys/bus.h>
+#include <sys/kernel.h>
+#include <sys/lock.h>
+#include <sys/malloc.h>
+#include <sys/mutex.h>
+#include <sys/queue.h>
+#include <sys/sbuf.h>
+#include <sys/sysctl.h>
+
+/* Limits the records of devices attached after the system initialization */
+#define	BOOTPROF_ATTACH_MAX	256
+
+struct bootprof_sysinit {
+	STAILQ_ENTRY(bootprof_sysinit) bs_link;
+	sysinit_cfunc_t		 bs_func;
+	const void		*bs_udata;
+	u_int			 bs_subsystem;
+	u_int			 bs_order;
+	sbintime_t		 bs_begin;
+	sbintime_t		 bs_end;
+};
+
+struct bootprof_attach {
+	STAILQ_ENTRY(bootprof_attach) ba_link;
+	char			 ba_name[16];
+	char			 ba_parent[16];
+	sbintime_t		 ba_begin;
+	sbintime_t		 ba_end;
+	int			 ba_error;
+};
+
+static MALLOC_DEFINE(M_BOOTPROF, "bootprof", "boot time profile");
+
+/* Only mi_startup() appends to this list, it is stable afterwards */
+static STAILQ_HEAD(, bootprof_sysinit) bootprof_sysinits =
+    STAILQ_HEAD_INITIALIZER(bootprof_sysinits);
+
+/* Devices may attach concurrently, see rtems_bsd_parallel_attach_tasks */
+static STAILQ_HEAD(, bootprof_attach) bootprof_attaches =
+    STAILQ_HEAD_INITIALIZER(bootprof_attaches);
+
+static u_int bootprof_attach_count;
+
+static struct mtx bootprof_mtx;
+MTX_SYSINIT(bootprof, &bootprof_mtx, "boot profile", MTX_DEF);
+
+static SYSCTL_NODE(_kern, OID_AUTO, bootprof, CTLFLAG_RD, 0,
+    "Boot time profile");
+
+static uint64_t
+bootprof_us(sbintime_t sbt)
+{
+
+	return ((uint64_t)(sbt >> 32) * 1000000 +
+	    (((uint64_t)sbt & 0xffffffff) * 1000000 >> 32));
+}
+
+void
+rtems_bsd_bootprof_sysinit(const struct sysinit *sip, sbintime_t begin)
+{
+	struct bootprof_sysinit *bs;
+
+	bs = malloc(sizeof(*bs), M_BOOTPROF, M_NOWAIT);
+	if (bs == NULL)
+		return;
+
+	bs->bs_func = sip->func;
+	bs->bs_udata = sip->udata;
+	bs->bs_subsystem = sip->subsystem;
+	bs->bs_order = sip->order;
+	bs->bs_begin = begin;
+	bs->bs_end = sbinuptime();
+	STAILQ_INSERT_TAIL(&bootprof_sysinits, bs, bs_link);
+}
+
+void
+rtems_bsd_bootprof_attach(device_t dev, sbintime_t begin, int error)
+{
+	struct bootprof_attach *ba;
+	device_t parent;
+
+	ba = malloc(sizeof(*ba), M_BOOTPROF, M_NOWAIT);
+	if (ba == NULL)
+		return;
+
+	ba->ba_end = sbinuptime();
+	ba->ba_begin = begin;
+	ba->ba_error = error;
+	snprintf(ba->ba_name, sizeof(ba->ba_name), "%s%d",
+	    device_get_name(dev), device_get_unit(dev));
+	parent = device_get_parent(dev);
+	if (parent != NULL)
+		strlcpy(ba->ba_parent, device_get_nameunit(parent),
+		    sizeof(ba->ba_parent));
+	else
+		ba->ba_parent[0] = '\0';
+
+	mtx_lock(&bootprof_mtx);
+	if (bootprof_attach_count < BOOTPROF_ATTACH_MAX) {
+		++bootprof_attach_count;
+		STAILQ_INSERT_TAIL(&bootprof_attaches, ba, ba_link);
+		ba = NULL;
+	}
+	mtx_unlock(&bootprof_mtx);
+
+	free(ba, M_BOOTPROF);
+}
+
+static int
+sysctl_bootprof_sysinit(SYSCTL_HANDLER_ARGS)
+{
+	struct bootprof_sysinit *bs;
+	struct sbuf sb;
+	int error;
+
+	error = sysctl_wire_old_buffer(req, 0);
+	if (error != 0)
+		return (error);
+
+	sbuf_new_for_sysctl(&sb, NULL, 128, req);
+	sbuf_printf(&sb, "\n%12s %10s %9s %9s %10s %10s\n", "begin [us]",
+	    "time [us]", "subsystem", "order", "function", "argument");
+
+	STAILQ_FOREACH(bs, &bootprof_sysinits, bs_link) {
+		sbuf_printf(&sb, "%12ju %10ju 0x%07x 0x%07x %10p %10p\n",
+		    (uintmax_t)bootprof_us(bs->bs_begin),
+		    (uintmax_t)bootprof_us(bs->bs_end - bs->bs_begin),
+		    bs->bs_subsystem, bs->bs_order, bs->bs_func,
+		    bs->bs_udata);
+	}
+
+	error = sbuf_finish(&sb);
+	sbuf_delete(&sb);
+	return (error);
+}
+SYSCTL_PROC(_kern_bootprof, OID_AUTO, sysinit,
+    CTLTYPE_STRING | CTLFLAG_RD | CTLFLAG_MPSAFE, NULL, 0,
+    sysctl_bootprof_sysinit, "A",
+    "Execution time of the system initialization handlers");
+
+static int
+sysctl_bootprof_attach(SYSCTL_HANDLER_ARGS)
+{
+	struct bootprof_attach *ba;
+	struct sbuf sb;
+	int error;
+
+	error = sysctl_wire_old_buffer(req, 0);
+	if (error != 0)
+		return (error);
+
+	sbuf_new_for_sysctl(&sb, NULL, 128, req);
+	sbuf_printf(&sb, "\n%12s %10s %-15s %-15s %5s\n", "begin [us]",
+	    "time [us]", "device", "parent", "error");
+
+	mtx_lock(&bootprof_mtx);
+	STAILQ_FOREACH(ba, &bootprof_attaches, ba_link) {
+		sbuf_printf(&sb, "%12ju %10ju %-15s %-15s %5d\n",
+		    (uintmax_t)bootprof_us(ba->ba_begin),
+		    (uintmax_t)bootprof_us(ba->ba_end - ba->ba_begin),
+		    ba->ba_name, ba->ba_parent, ba->ba_error);
+	}
+	mtx_unlock(&bootprof_mtx);
+
+	error = sbuf_finish(&sb);
+	sbuf_delete(&sb);
+	return (error);
+}
+SYSCTL_PROC(_kern_bootprof, OID_AUTO, attach,
+    CTLTYPE_STRING | CTLFLAG_RD | CTLFLAG_MPSAFE, NULL, 0,
+    sysctl_bootprof_attach, "A",
+    "Execution time of the device attach");
@@ -72,6 +72,13 @@
 
 #define BSD_SCSI_MIN_COMMAND_SIZE 10
 
+/*
+ * Adjacent buffers are merged up to the bulk buffer size of umass(4).  This
+ * is also the size of the bounce buffer used to merge buffers which are not
+ * contiguous in memory.
+ */
+#define BSD_SCSI_MAX_TRANSFER (128 * 1024)
+
 MALLOC_DEFINE(M_CAMSIM, "CAM SIM", "CAM SIM buffers");
 
 static void
@@ -205,79 +212,204 @@ rtems_bsd_scsi_read_capacity(union ccb *ccb, uint32_t *block_count, uint32_t *bl
 	return RTEMS_SUCCESSFUL;
 }
 
+static void rtems_bsd_csio_callback(struct cam_periph *periph, union ccb *ccb);
+
+/*
+ * Determines the buffers which can be transferred with one command starting
+ * at the current buffer.  The buffers must be adjacent on the media.  If they
+ * are not contiguous in memory, then they are transferred through the bounce
+ * buffer.
+ */
+static rtems_blkdev_sg_buffer *
+rtems_bsd_csio_merge(struct cam_sim *sim, rtems_blkdev_sg_buffer *sg,
+    rtems_blkdev_sg_buffer *end, uint32_t *length, bool *contiguous)
+{
+	const rtems_blkdev_sg_buffer *prev = sg;
+	uint32_t len = sg->length;
+	bool contig = true;
+
+	for (++sg; sg != end; prev = sg, ++sg) {
+		if (sg->block != prev->block + prev->length / sim->block_size) {
+			break;
+		}
+
+		if (len + sg->length > BSD_SCSI_MAX_TRANSFER) {
+			break;
+		}
+
+		if ((const char *) prev->buffer + prev->length != sg->buffer) {
+			if (sim->bounce == NULL) {
+				break;
+			}
+
+			contig = false;
+		}
+
+		len += sg->length;
+	}
+
+	*length = len;
+	*contiguous = contig;
+
+	return sg;
+}
+
+static void
+rtems_bsd_csio_submit(struct cam_sim *sim, union ccb *ccb)
+{
+	rtems_blkdev_sg_buffer *sg = ccb->csio.sg_current;
+	rtems_blkdev_sg_buffer *next;
+	uint32_t length;
+	bool contiguous;
+	u_int8_t *data;
+
+	next = rtems_bsd_csio_merge(sim, sg, ccb->csio.sg_end, &length,
+	    &contiguous);
+
+	if (contiguous) {
+		data = sg->buffer;
+		sim->bounce_sg = NULL;
+	} else {
+		rtems_blkdev_sg_buffer *cur;
+
+		data = sim->bounce;
+		sim->bounce_sg = sg;
+
+		if (!ccb->csio.readop) {
+			for (cur = sg; cur != next; ++cur) {
+				memcpy(data, cur->buffer, cur->length);
+				data += cur->length;
+			}
+
+			data = sim->bounce;
+		}
+	}
+
+	scsi_read_write(
+		&ccb->csio,
+		BSD_SCSI_RETRIES,
+		rtems_bsd_csio_callback,
+		BSD_SCSI_TAG,
+		ccb->csio.readop,
+		0,
+		BSD_SCSI_MIN_COMMAND_SIZE,
+		sg->block,
+		length / sim->block_size,
+		data,
+		length,
+		SSD_FULL_SIZE,
+		BSD_SCSI_TIMEOUT
+	);
+	ccb->csio.sg_current = next;
+	(*sim->sim_action)(sim, ccb);
+}
+
+static void
+rtems_bsd_csio_start(struct cam_sim *sim, rtems_blkdev_request *req)
+{
+	union ccb *ccb = &sim->ccb;
+
+	ccb->csio.readop = req->req == RTEMS_BLKDEV_REQ_READ;
+	ccb->csio.sg_current = req->bufs;
+	ccb->csio.sg_end = req->bufs + req->bufnum;
+	ccb->csio.req = req;
+
+	rtems_bsd_csio_submit(sim, ccb);
+}
+
+static rtems_blkdev_request *
+rtems_bsd_sim_dequeue(struct cam_sim *sim)
+{
+	rtems_blkdev_request *req;
+
+	if (sim->queue_count == 0) {
+		return NULL;
+	}
+
+	req = sim->queue[sim->queue_first];
+	sim->queue_first = (sim->queue_first + 1) % BSD_SIM_QUEUE_DEPTH;
+	--sim->queue_count;
+
+	return req;
+}
+
 static void
 rtems_bsd_csio_callback(struct cam_periph *periph, union ccb *ccb)
 {
-	rtems_status_code sc = RTEMS_SUCCESSFUL;
-	bool done = false;
+	rtems_status_code sc;
 	struct cam_sim *sim = ccb->ccb_h.sim;
+	rtems_blkdev_request *req;
 
 	BSD_ASSERT(periph == NULL && sim->state == BSD_SIM_BUSY);
 
 	if (ccb->ccb_h.status == CAM_REQ_CMP) {
-		rtems_blkdev_sg_buffer *sg = ccb->csio.sg_current;
-
-		if (sg != ccb->csio.sg_end) {
-			scsi_read_write(
-				&ccb->csio,
-				BSD_SCSI_RETRIES,
-				rtems_bsd_csio_callback,
-				BSD_SCSI_TAG,
-				ccb->csio.readop,
-				0,
-				BSD_SCSI_MIN_COMMAND_SIZE,
-				sg->block,
-				sg->length / 512, /* FIXME */
-				sg->buffer,
-				sg->length,
-				SSD_FULL_SIZE,
-				BSD_SCSI_TIMEOUT
-			);
-			ccb->csio.sg_current = sg + 1;
-			(*sim->sim_action)(sim, ccb);
-		} else {
-			done = true;
+		rtems_blkdev_sg_buffer *sg = sim->bounce_sg;
+
+		if (sg != NULL && ccb->csio.readop) {
+			const u_int8_t *data = sim->bounce;
+
+			for (; sg != ccb->csio.sg_current; ++sg) {
+				memcpy(sg->buffer, data, sg->length);
+				data += sg->length;
+			}
+		}
+
+		if (ccb->csio.sg_current != ccb->csio.sg_end) {
+			rtems_bsd_csio_submit(sim, ccb);
+			return;
 		}
+
+		sc = RTEMS_SUCCESSFUL;
 	} else if (ccb->ccb_h.status == CAM_SEL_TIMEOUT) {
 		sc = RTEMS_UNSATISFIED;
-		done = true;
 	} else {
 		sc = RTEMS_IO_ERROR;
-		done = true;
 	}
 
-	if (done) {
-		rtems_blkdev_request_done(ccb->csio.req, sc);
+	rtems_blkdev_request_done(ccb->csio.req, sc);
+
+	/* The device is gone, so fail the queued requests immediately */
+	if (sc == RTEMS_UNSATISFIED) {
+		while ((req = rtems_bsd_sim_dequeue(sim)) != NULL) {
+			rtems_blkdev_request_done(req, sc);
+		}
+	}
+
+	req = rtems_bsd_sim_dequeue(sim);
+	if (req != NULL) {
+		/* Wake up submitters waiting for a free queue entry */
+		cv_broadcast(&sim->state_changed);
+		rtems_bsd_csio_start(sim, req);
+	} else {
 		rtems_bsd_sim_set_state_and_notify(sim, BSD_SIM_IDLE);
 	}
 }
 
+/*
+ * Starts the request if the SIM is idle, otherwise the request is queued and
+ * started by the completion of the previous request.  The request completion
+ * is reported asynchronously through rtems_blkdev_request_done().
+ */
 static int rtems_bsd_sim_disk_read_write(struct cam_sim *sim, rtems_blkdev_request *req)
 {
-	mtx_lock(sim->mtx);
-
-	rtems_bsd_sim_wait_for_state(sim, BSD_SIM_IDLE);
-	rtems_bsd_sim_set_state(sim, BSD_SIM_BUSY);
-
-	switch (req->req) {
-		case RTEMS_BLKDEV_REQ_READ:
-			sim->ccb.csio.readop = TRUE;
-			break;
-		case RTEMS_BLKDEV_REQ_WRITE:
-			sim->ccb.csio.readop = FALSE;
-			break;
-		default:
-			mtx_unlock(sim->mtx);
-			return -1;
+	if (req->req != RTEMS_BLKDEV_REQ_READ && req->req != RTEMS_BLKDEV_REQ_WRITE) {
+		return -1;
 	}
 
-	sim->ccb.csio.sg_current = req->bufs;
-	sim->ccb.csio.sg_end = req->bufs + req->bufnum;
-	sim->ccb.csio.req = req;
+	mtx_lock(sim->mtx);
 
-	sim->ccb.ccb_h.status = CAM_REQ_CMP;
+	while (sim->state != BSD_SIM_IDLE &&
+	    (sim->state != BSD_SIM_BUSY || sim->queue_count == BSD_SIM_QUEUE_DEPTH)) {
+		cv_wait(&sim->state_changed, sim->mtx);
+	}
 
-	rtems_bsd_csio_callback(NULL, &sim->ccb);
+	if (sim->state == BSD_SIM_IDLE) {
+		rtems_bsd_sim_set_state(sim, BSD_SIM_BUSY);
+		rtems_bsd_csio_start(sim, req);
+	} else {
+		sim->queue[(sim->queue_first + sim->queue_count) % BSD_SIM_QUEUE_DEPTH] = req;
+		++sim->queue_count;
+	}
 
 	mtx_unlock(sim->mtx);
 
@@ -308,11 +440,19 @@ static int rtems_bsd_sim_disk_ioctl(rtems_disk_device *dd, uint32_t req, void *a
 }
 
 static void
-rtems_bsd_sim_disk_initialized(struct cam_sim *sim, char *disk)
+rtems_bsd_sim_disk_initialized(struct cam_sim *sim, char *disk, uint32_t block_size)
 {
+	u_int8_t *bounce = NULL;
+
+	if (disk != NULL) {
+		bounce = malloc(BSD_SCSI_MAX_TRANSFER, M_CAMSIM, M_WAITOK);
+	}
+
 	mtx_lock(sim->mtx);
 
 	sim->disk = disk;
+	sim->block_size = block_size;
+	sim->bounce = bounce;
 	rtems_bsd_sim_set_state_and_notify(sim, BSD_SIM_IDLE);
 
 	mtx_unlock(sim->mtx);
@@ -380,7 +520,7 @@ rtems_bsd_sim_attach_worker(rtems_media_state state, const char *src, char **des
 		rtems_disk_release(dd);
 #endif
 
-		rtems_bsd_sim_disk_initialized(sim, disk);
+		rtems_bsd_sim_disk_initialized(sim, disk, block_size);
 
 		*dest = strdup(disk, M_RTEMS_HEAP);
 	}
@@ -391,7 +531,7 @@ error:
 
 	free(disk, M_RTEMS_HEAP);
 
-	rtems_bsd_sim_disk_initialized(sim, NULL);
+	rtems_bsd_sim_disk_initialized(sim, NULL, 0);
 
 	return RTEMS_IO_ERROR;
 }
@@ -460,6 +600,7 @@ cam_sim_free(struct cam_sim *sim, int free_devq)
 	}
 
 	cv_destroy(&sim->state_changed);
+	free(sim->bounce, M_CAMSIM);
 	free(sim, M_CAMSIM);
 }
 
@@ -0,0 +1,352 @@
+/**
+ * @file
+ *
+ * @ingroup rtems_bsd_rtems
+ *
+ * @brief Epoch based reclamation with per-processor reader counters.
+ */
+
+/*
+ * Copyright (c) 2026 embedded brains GmbH.  All rights reserved.
+ *
+ *  embedded brains GmbH
+ *  Dornierstr. 4
+ *  82178 Puchheim
+ *  Germany
+ *  <rtems@embedded-brains.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Each processor has two reader counters in its own cache line, one for
+ * each parity of the epoch generation.  A reader increments the counter of
+ * the current generation on the processor it runs on and checks afterwards
+ * that the generation did not change.  The tracker records the counter, so
+ * that the section may migrate to another processor.
+ *
+ * epoch_wait() advances the generation and waits until the counters of the
+ * previous generation are zero.  New sections account to the new
+ * generation, so the wait is not prolonged by later readers.  Callbacks
+ * registered by epoch_call() are collected and run by a task after an
+ * epoch_wait().
+ */
+
+#include <machine/rtems-bsd-kernel-space.h>
+
+#include <sys/param.h>
+#include <sys/types.h>
+#include <sys/systm.h>
+#include <sys/epoch.h>
+#include <sys/kernel.h>
+#include <sys/lock.h>
+#include <sys/malloc.h>
+#include <sys/mutex.h>
+#include <sys/proc.h>
+#include <sys/sx.h>
+#include <sys/taskqueue.h>
+
+#include <machine/atomic.h>
+#include <machine/cpu.h>
+
+#include <rtems/malloc.h>
+#include <rtems/score/smp.h>
+
+/* Busy wait iterations of epoch_wait() before it starts to sleep */
+#define	EPOCH_SPIN_MAX	1000
+
+struct epoch_record {
+	volatile u_int	er_count[2];	/* Sections per generation parity */
+	u_int		er_nest;	/* Nesting of non-preemptible sections */
+	u_int		er_gen;		/* Parity of the outermost section */
+} __aligned(CACHE_LINE_SIZE);
+
+struct epoch {
+	struct epoch_record	*e_records;
+	volatile u_int		 e_gen;
+	int			 e_flags;
+	struct sx		 e_wait_sx;
+	struct mtx		 e_call_mtx;
+	epoch_context_t		 e_call_head;
+	struct task		 e_call_task;
+};
+
+static MALLOC_DEFINE(M_EPOCH, "epoch", "epoch based reclamation");
+
+epoch_t global_epoch;
+
+epoch_t global_epoch_preempt;
+
+static u_int
+epoch_record_enter(epoch_t epoch, uint32_t cpu)
+{
+	volatile u_int *count;
+	u_int gen;
+
+	while (true) {
+		gen = epoch->e_gen;
+		count = &epoch->e_records[cpu].er_count[gen & 1];
+		atomic_add_int(count, 1);
+		atomic_thread_fence_seq_cst();
+
+		if (__predict_true(epoch->e_gen == gen))
+			return (gen & 1);
+
+		/* Raced with epoch_wait(), account to the new generation */
+		atomic_subtract_int(count, 1);
+	}
+}
+
+static void
+epoch_record_exit(epoch_t epoch, uint32_t cpu, u_int gen)
+{
+
+	atomic_thread_fence_rel();
+	atomic_subtract_int(&epoch->e_records[cpu].er_count[gen], 1);
+}
+
+static u_int
+epoch_readers(epoch_t epoch, u_int gen)
+{
+	uint32_t cpu_count;
+	uint32_t cpu;
+	u_int sum;
+
+	cpu_count = _SMP_Get_processor_count();
+	sum = 0;
+
+	for (cpu = 0; cpu < cpu_count; ++cpu) {
+		sum += epoch->e_records[cpu].er_count[gen];
+	}
+
+	return (sum);
+}
+
+static void
+epoch_synchronize(epoch_t epoch)
+{
+	u_int gen;
+	int spins;
+
+	sx_xlock(&epoch->e_wait_sx);
+
+	gen = epoch->e_gen;
+	atomic_store_rel_int(&epoch->e_gen, gen + 1);
+	atomic_thread_fence_seq_cst();
+
+	spins = 0;
+	while (epoch_readers(epoch, gen & 1) != 0) {
+		if (spins < EPOCH_SPIN_MAX) {
+			++spins;
+			cpu_spinwait();
+		} else {
+			/* Let preempted readers on this processor continue */
+			pause("epoch", 1);
+		}
+	}
+
+	atomic_thread_fence_seq_cst();
+	sx_xunlock(&epoch->e_wait_sx);
+}
+
+static void
+epoch_call_task(void *arg, int pending)
+{
+	epoch_t epoch;
+	epoch_context_t ctx;
+	epoch_context_t next;
+
+	(void)pending;
+	epoch = arg;
+
+	mtx_lock(&epoch->e_call_mtx);
+	ctx = epoch->e_call_head;
+	epoch->e_call_head = NULL;
+	mtx_unlock(&epoch->e_call_mtx);
+
+	if (ctx == NULL)
+		return;
+
+	epoch_synchronize(epoch);
+
+	while (ctx != NULL) {
+		next = ctx->ec_next;
+		(*ctx->ec_callback)(ctx);
+		ctx = next;
+	}
+}
+
+epoch_t
+epoch_alloc(int flags)
+{
+	epoch_t epoch;
+	size_t size;
+
+	epoch = malloc(sizeof(*epoch), M_EPOCH, M_WAITOK | M_ZERO);
+
+	size = _SMP_Get_processor_count() * sizeof(*epoch->e_records);
+	epoch->e_records = rtems_heap_allocate_aligned_with_boundary(size,
+	    CACHE_LINE_SIZE, 0);
+	if (epoch->e_records == NULL)
+		panic("epoch_alloc: cannot allocate reader counters");
+	memset(epoch->e_records, 0, size);
+
+	epoch->e_flags = flags;
+	sx_init(&epoch->e_wait_sx, "epoch wait");
+	mtx_init(&epoch->e_call_mtx, "epoch call", NULL, MTX_DEF);
+	TASK_INIT(&epoch->e_call_task, 0, epoch_call_task, epoch);
+
+	return (epoch);
+}
+
+void
+epoch_free(epoch_t epoch)
+{
+
+	taskqueue_drain(taskqueue_thread, &epoch->e_call_task);
+	epoch_call_task(epoch, 0);
+	KASSERT(epoch_readers(epoch, 0) == 0 && epoch_readers(epoch, 1) == 0,
+	    ("epoch_free: epoch in use"));
+
+	mtx_destroy(&epoch->e_call_mtx);
+	sx_destroy(&epoch->e_wait_sx);
+	free(epoch->e_records, M_TEMP);
+	free(epoch, M_EPOCH);
+}
+
+void
+epoch_enter(epoch_t epoch)
+{
+	struct epoch_record *er;
+	uint32_t cpu;
+
+	MPASS((epoch->e_flags & EPOCH_PREEMPT) == 0);
+
+	critical_enter();
+	cpu = _SMP_Get_current_processor();
+	er = &epoch->e_records[cpu];
+
+	if (er->er_nest++ == 0)
+		er->er_gen = epoch_record_enter(epoch, cpu);
+}
+
+void
+epoch_exit(epoch_t epoch)
+{
+	struct epoch_record *er;
+	uint32_t cpu;
+
+	cpu = _SMP_Get_current_processor();
+	er = &epoch->e_records[cpu];
+	MPASS(er->er_nest > 0);
+
+	if (--er->er_nest == 0)
+		epoch_record_exit(epoch, cpu, er->er_gen);
+
+	critical_exit();
+}
+
+void
+epoch_enter_preempt(epoch_t epoch, epoch_tracker_t et)
+{
+	uint32_t cpu;
+
+	MPASS((epoch->e_flags & EPOCH_PREEMPT) != 0);
+
+	++curthread->td_epochnest;
+	cpu = _SMP_Get_current_processor();
+	et->et_cpu = cpu;
+	et->et_gen = epoch_record_enter(epoch, cpu);
+}
+
+void
+epoch_exit_preempt(epoch_t epoch, epoch_tracker_t et)
+{
+
+	epoch_record_exit(epoch, et->et_cpu, et->et_gen);
+	MPASS(curthread->td_epochnest > 0);
+	--curthread->td_epochnest;
+}
+
+void
+epoch_wait(epoch_t epoch)
+{
+
+	KASSERT(!in_epoch(epoch), ("epoch_wait: in epoch section"));
+	epoch_synchronize(epoch);
+}
+
+void
+epoch_wait_preempt(epoch_t epoch)
+{
+
+	KASSERT(!in_epoch(epoch), ("epoch_wait_preempt: in epoch section"));
+	epoch_synchronize(epoch);
+}
+
+void
+epoch_call(epoch_t epoch, epoch_context_t ctx,
+    void (*callback)(epoch_context_t))
+{
+	bool first;
+
+	ctx->ec_callback = callback;
+
+	mtx_lock(&epoch->e_call_mtx);
+	ctx->ec_next = epoch->e_call_head;
+	epoch->e_call_head = ctx;
+	first = ctx->ec_next == NULL;
+	mtx_unlock(&epoch->e_call_mtx);
+
+	if (first)
+		taskqueue_enqueue(taskqueue_thread, &epoch->e_call_task);
+}
+
+/*
+ * For preemptible epochs this only tells whether the executing thread is in
+ * a section of any preemptible epoch.
+ */
+int
+in_epoch(epoch_t epoch)
+{
+	u_int nest;
+
+	if ((epoch->e_flags & EPOCH_PREEMPT) != 0)
+		return (curthread->td_epochnest != 0);
+
+	critical_enter();
+	nest = epoch->e_records[_SMP_Get_current_processor()].er_nest;
+	critical_exit();
+
+	return (nest != 0);
+}
+
+static void
+epoch_init(void *arg)
+{
+
+	(void)arg;
+
+	global_epoch = epoch_alloc(0);
+	global_epoch_preempt = epoch_alloc(EPOCH_PREEMPT);
+}
+SYSINIT(epoch, SI_SUB_TASKQ, SI_ORDER_FIRST, epoch_init, NULL);
@@ -0,0 +1,425 @@
+/**
+ * @file
+ *
+ * @ingroup rtems_bsd_rtems
+ *
+ * @brief Kqueue filters for Classic API events, message queues and
+ * semaphores.
+ */
+
+/*
+ * Copyright (c) 2026 embedded brains GmbH.  All rights reserved.
+ *
+ *  embedded brains GmbH
+ *  Dornierstr. 4
+ *  82178 Puchheim
+ *  Germany
+ *  <rtems@embedded-brains.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Each watched object has a record with the knote list of all knotes for the
+ * object.  Notifications may originate in interrupt context, so they only
+ * accumulate the hint in the record under an interrupt lock and submit an
+ * interrupt server request.  The request activates the knotes in thread
+ * context.
+ *
+ * Message queues are watched through the notification handler of the
+ * message queue, so any rtems_message_queue_send() or
+ * rtems_message_queue_urgent() which makes a message pending triggers the
+ * knotes.  RTEMS provides no notification for events and semaphores, so
+ * these are triggered by rtems_bsd_event_send() and
+ * rtems_bsd_semaphore_release().
+ */
+
+#include <machine/rtems-bsd-kernel-space.h>
+
+#include <sys/param.h>
+#include <sys/types.h>
+#include <sys/systm.h>
+#include <sys/event.h>
+#include <sys/kernel.h>
+#include <sys/lock.h>
+#include <sys/malloc.h>
+#include <sys/mutex.h>
+#include <sys/queue.h>
+#include <sys/sx.h>
+
+#include <machine/rtems-bsd-support.h>
+
+#include <rtems/bsd/kevent.h>
+#include <rtems/irq-extension.h>
+#include <rtems/rtems/messageimpl.h>
+#include <rtems/score/coremsgimpl.h>
+
+SYSINIT_REFERENCE(irqs);
+
+struct kq_rtems_object {
+	LIST_ENTRY(kq_rtems_object) ko_link;	/* (i) Object list */
+	rtems_id		ko_id;		/* Object identifier */
+	short			ko_filter;	/* Filter of the knotes */
+	u_int			ko_refs;	/* (s) Knotes of the object */
+	long			ko_hint;	/* (i) Pending notification */
+	struct mtx		ko_mtx;		/* Protects the knote list */
+	struct knlist		ko_note;	/* Knotes of the object */
+	rtems_interrupt_server_request ko_request;
+};
+
+/*
+ * Locking key:
+ * (i)	Locked using the interrupt lock
+ * (s)	Locked using the object sx lock
+ */
+static LIST_HEAD(, kq_rtems_object) kq_rtems_objects =
+    LIST_HEAD_INITIALIZER(kq_rtems_objects);
+
+RTEMS_INTERRUPT_LOCK_DEFINE(static, kq_rtems_lock, "kqueue RTEMS objects");
+
+static struct sx kq_rtems_sx;
+SX_SYSINIT(kq_rtems_sx, &kq_rtems_sx, "kqueue RTEMS objects");
+
+static MALLOC_DEFINE(M_KQRTEMS, "kqrtems", "kqueue RTEMS object records");
+
+static struct kq_rtems_object *
+kq_rtems_find(short filter, rtems_id id)
+{
+	struct kq_rtems_object *ko;
+
+	LIST_FOREACH(ko, &kq_rtems_objects, ko_link) {
+		if (ko->ko_id == id && ko->ko_filter == filter)
+			return (ko);
+	}
+
+	return (NULL);
+}
+
+/*
+ * Records the notification and defers the knote activation to the interrupt
+ * server.  May be called from interrupt context.
+ */
+static void
+kq_rtems_notify(short filter, rtems_id id, long hint)
+{
+	rtems_interrupt_lock_context lock_context;
+	struct kq_rtems_object *ko;
+
+	rtems_interrupt_lock_acquire(&kq_rtems_lock, &lock_context);
+	ko = kq_rtems_find(filter, id);
+	if (ko != NULL) {
+		if (filter == EVFILT_RTEMS_EVENT)
+			ko->ko_hint |= hint;
+		else
+			ko->ko_hint += hint;
+		rtems_interrupt_server_request_submit(RTEMS_ID_NONE,
+		    &ko->ko_request);
+	}
+	rtems_interrupt_lock_release(&kq_rtems_lock, &lock_context);
+}
+
+static void
+kq_rtems_request(void *arg)
+{
+	rtems_interrupt_lock_context lock_context;
+	struct kq_rtems_object *ko;
+	long hint;
+
+	ko = arg;
+
+	rtems_interrupt_lock_acquire(&kq_rtems_lock, &lock_context);
+	hint = ko->ko_hint;
+	ko->ko_hint = 0;
+	rtems_interrupt_lock_release(&kq_rtems_lock, &lock_context);
+
+	if (hint != 0) {
+		mtx_lock(&ko->ko_mtx);
+		KNOTE_LOCKED(&ko->ko_note, hint);
+		mtx_unlock(&ko->ko_mtx);
+	}
+}
+
+#ifdef RTEMS_SCORE_COREMSG_ENABLE_NOTIFICATION
+static void
+kq_rtems_mq_notify(CORE_message_queue_Control *the_message_queue,
+    Thread_queue_Context *queue_context)
+{
+	Message_queue_Control *the_mq;
+	rtems_id id;
+
+	the_mq = RTEMS_CONTAINER_OF(the_message_queue, Message_queue_Control,
+	    message_queue);
+	id = the_mq->Object.id;
+	_CORE_message_queue_Release(the_message_queue, queue_context);
+
+	kq_rtems_notify(EVFILT_RTEMS_MQ, id, 1);
+}
+
+static int
+kq_rtems_mq_set_notify(rtems_id id, bool enable)
+{
+	Message_queue_Control *the_mq;
+	Thread_queue_Context queue_context;
+	CORE_message_queue_Notify_Handler handler;
+	int error;
+
+	the_mq = _Message_queue_Get(id, &queue_context);
+	if (the_mq == NULL)
+		return (ESRCH);
+
+	_CORE_message_queue_Acquire_critical(&the_mq->message_queue,
+	    &queue_context);
+	handler = the_mq->message_queue.notify_handler;
+	error = 0;
+
+	if (enable) {
+		if (handler == NULL)
+			_CORE_message_queue_Set_notify(&the_mq->message_queue,
+			    kq_rtems_mq_notify);
+		else
+			error = EBUSY;
+	} else if (handler == kq_rtems_mq_notify) {
+		_CORE_message_queue_Set_notify(&the_mq->message_queue, NULL);
+	}
+
+	_CORE_message_queue_Release(&the_mq->message_queue, &queue_context);
+	return (error);
+}
+#else /* RTEMS_SCORE_COREMSG_ENABLE_NOTIFICATION */
+static int
+kq_rtems_mq_set_notify(rtems_id id, bool enable)
+{
+
+	return (enable ? EOPNOTSUPP : 0);
+}
+#endif /* RTEMS_SCORE_COREMSG_ENABLE_NOTIFICATION */
+
+static int
+kq_rtems_object_get(short filter, rtems_id id, struct kq_rtems_object **kop)
+{
+	rtems_interrupt_lock_context lock_context;
+	struct kq_rtems_object *ko;
+	int error;
+
+	sx_xlock(&kq_rtems_sx);
+
+	ko = kq_rtems_find(filter, id);
+	if (ko != NULL) {
+		++ko->ko_refs;
+		sx_xunlock(&kq_rtems_sx);
+		*kop = ko;
+		return (0);
+	}
+
+	if (filter == EVFILT_RTEMS_MQ) {
+		error = kq_rtems_mq_set_notify(id, true);
+		if (error != 0) {
+			sx_xunlock(&kq_rtems_sx);
+			return (error);
+		}
+	}
+
+	ko = malloc(sizeof(*ko), M_KQRTEMS, M_WAITOK | M_ZERO);
+	ko->ko_id = id;
+	ko->ko_filter = filter;
+	ko->ko_refs = 1;
+	mtx_init(&ko->ko_mtx, "kqueue RTEMS object", NULL, MTX_DEF);
+	knlist_init_mtx(&ko->ko_note, &ko->ko_mtx);
+	rtems_interrupt_server_request_initialize(&ko->ko_request,
+	    kq_rtems_request, ko);
+
+	rtems_interrupt_lock_acquire(&kq_rtems_lock, &lock_context);
+	LIST_INSERT_HEAD(&kq_rtems_objects, ko, ko_link);
+	rtems_interrupt_lock_release(&kq_rtems_lock, &lock_context);
+
+	sx_xunlock(&kq_rtems_sx);
+	*kop = ko;
+	return (0);
+}
+
+static void
+kq_rtems_object_release(struct kq_rtems_object *ko)
+{
+	rtems_interrupt_lock_context lock_context;
+
+	sx_xlock(&kq_rtems_sx);
+
+	if (--ko->ko_refs > 0) {
+		sx_xunlock(&kq_rtems_sx);
+		return;
+	}
+
+	if (ko->ko_filter == EVFILT_RTEMS_MQ)
+		(void)kq_rtems_mq_set_notify(ko->ko_id, false);
+
+	rtems_interrupt_lock_acquire(&kq_rtems_lock, &lock_context);
+	LIST_REMOVE(ko, ko_link);
+	rtems_interrupt_lock_release(&kq_rtems_lock, &lock_context);
+
+	sx_xunlock(&kq_rtems_sx);
+
+	/* Waits for a request in progress */
+	rtems_interrupt_server_request_destroy(&ko->ko_request);
+	knlist_destroy(&ko->ko_note);
+	mtx_destroy(&ko->ko_mtx);
+	free(ko, M_KQRTEMS);
+}
+
+static int
+filt_rtems_attach(struct knote *kn)
+{
+	struct kq_rtems_object *ko;
+	rtems_id id;
+	int error;
+
+	id = (rtems_id)kn->kn_id;
+
+	switch (kn->kn_filter) {
+	case EVFILT_RTEMS_EVENT:
+		if (id == RTEMS_SELF)
+			id = rtems_task_self();
+		if (kn->kn_sfflags == 0)
+			kn->kn_sfflags = RTEMS_ALL_EVENTS;
+		kn->kn_flags |= EV_CLEAR;
+		break;
+	case EVFILT_RTEMS_SEM:
+		kn->kn_flags |= EV_CLEAR;
+		break;
+	default:
+		break;
+	}
+
+	error = kq_rtems_object_get(kn->kn_filter, id, &ko);
+	if (error != 0)
+		return (error);
+
+	kn->kn_hook = ko;
+	knlist_add(&ko->ko_note, kn, 0);
+	return (0);
+}
+
+static void
+filt_rtems_detach(struct knote *kn)
+{
+	struct kq_rtems_object *ko;
+
+	ko = kn->kn_hook;
+	knlist_remove(&ko->ko_note, kn, 0);
+	kq_rtems_object_release(ko);
+}
+
+static int
+filt_rtems_event(struct knote *kn, long hint)
+{
+
+	kn->kn_fflags |= (u_int)hint & kn->kn_sfflags;
+	return (kn->kn_fflags != 0);
+}
+
+static int
+filt_rtems_mq(struct knote *kn, long hint)
+{
+	struct kq_rtems_object *ko;
+	uint32_t count;
+
+	ko = kn->kn_hook;
+	if (rtems_message_queue_get_number_pending(ko->ko_id, &count) !=
+	    RTEMS_SUCCESSFUL) {
+		kn->kn_flags |= EV_EOF;
+		return (1);
+	}
+
+	kn->kn_data = count;
+	return (count > 0);
+}
+
+static int
+filt_rtems_sem(struct knote *kn, long hint)
+{
+
+	kn->kn_data += hint;
+	return (kn->kn_data > 0);
+}
+
+static struct filterops rtems_event_filtops = {
+	.f_isfd = 0,
+	.f_attach = filt_rtems_attach,
+	.f_detach = filt_rtems_detach,
+	.f_event = filt_rtems_event,
+};
+
+static struct filterops rtems_mq_filtops = {
+	.f_isfd = 0,
+	.f_attach = filt_rtems_attach,
+	.f_detach = filt_rtems_detach,
+	.f_event = filt_rtems_mq,
+};
+
+static struct filterops rtems_sem_filtops = {
+	.f_isfd = 0,
+	.f_attach = filt_rtems_attach,
+	.f_detach = filt_rtems_detach,
+	.f_event = filt_rtems_sem,
+};
+
+rtems_status_code
+rtems_bsd_event_send(rtems_id id, rtems_event_set event_in)
+{
+	rtems_status_code sc;
+
+	sc = rtems_event_send(id, event_in);
+	if (sc == RTEMS_SUCCESSFUL) {
+		if (id == RTEMS_SELF)
+			id = rtems_task_self();
+		kq_rtems_notify(EVFILT_RTEMS_EVENT, id, (long)event_in);
+	}
+
+	return (sc);
+}
+
+rtems_status_code
+rtems_bsd_semaphore_release(rtems_id id)
+{
+	rtems_status_code sc;
+
+	sc = rtems_semaphore_release(id);
+	if (sc == RTEMS_SUCCESSFUL)
+		kq_rtems_notify(EVFILT_RTEMS_SEM, id, 1);
+
+	return (sc);
+}
+
+static void
+kq_rtems_init(void *arg)
+{
+	int error;
+
+	(void)arg;
+
+	error = kqueue_add_filteropts(EVFILT_RTEMS_EVENT, &rtems_event_filtops);
+	BSD_ASSERT(error == 0);
+	error = kqueue_add_filteropts(EVFILT_RTEMS_MQ, &rtems_mq_filtops);
+	BSD_ASSERT(error == 0);
+	error = kqueue_add_filteropts(EVFILT_RTEMS_SEM, &rtems_sem_filtops);
+	BSD_ASSERT(error == 0);
+}
+SYSINIT(kq_rtems, SI_SUB_PSEUDO, SI_ORDER_ANY, kq_rtems_init, NULL);
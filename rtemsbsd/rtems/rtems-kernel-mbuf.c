@@ -38,6 +38,16 @@
  */
 
 #include <machine/rtems-bsd-kernel-space.h>
+#include <machine/rtems-bsd-page.h>
+
+#include <sys/param.h>
+#include <sys/kernel.h>
+#include <sys/lock.h>
+#include <sys/malloc.h>
+#include <sys/mbuf.h>
+#include <sys/mutex.h>
+#include <sys/queue.h>
+#include <sys/sysctl.h>
 
 #include <rtems/bsd/zerocopy.h>
 
@@ -66,3 +76,234 @@ rtems_bsd_m_free(struct mbuf *m)
 {
 	m_free(m);
 }
+
+/*
+ * Per-interface receive buffer pools.  A network driver creates a pool sized
+ * from its receive ring and allocates its receive buffers from it.  The
+ * buffers are attached to the mbufs as external storage with a free callback
+ * which puts them back to the pool once the stack is done with the packet.
+ * Thus, the receive path does not contend on the cluster zone and the page
+ * heap.  Buffers up to the page size are carved out of pages, larger buffers
+ * come from the jumbo region.  In both cases they are cache line aligned.  In
+ * case the pool is empty, we fall back to m_getjcl().
+ */
+
+struct rxpool {
+	struct mtx		rp_mtx;
+	void			*rp_free;
+	bool			rp_dying;
+	u_int			rp_bufsize;
+	u_int			rp_chunksize;
+	u_int			rp_nchunks;
+	void			**rp_chunks;
+	LIST_ENTRY(rxpool)	rp_link;
+	struct rxpool_stat	rp_stat;
+};
+
+static MALLOC_DEFINE(M_RXPOOL, "rxpool", "receive buffer pools");
+
+static LIST_HEAD(, rxpool) rxpool_list = LIST_HEAD_INITIALIZER(rxpool_list);
+
+static u_int rxpool_count;
+
+static struct mtx rxpool_list_mtx;
+
+MTX_SYSINIT(rxpool_list, &rxpool_list_mtx, "rxpool list", MTX_DEF);
+
+static void
+rxpool_put_locked(struct rxpool *rp, void *buf)
+{
+
+	mtx_assert(&rp->rp_mtx, MA_OWNED);
+	*(void **)buf = rp->rp_free;
+	rp->rp_free = buf;
+	++rp->rp_stat.rps_free;
+}
+
+static void
+rxpool_free(struct rxpool *rp)
+{
+	u_int i;
+
+	for (i = 0; i < rp->rp_nchunks; ++i) {
+		if (rp->rp_chunksize == PAGE_SIZE)
+			rtems_bsd_page_free(rp->rp_chunks[i]);
+		else
+			rtems_bsd_jumbo_free(rp->rp_chunks[i]);
+	}
+
+	mtx_destroy(&rp->rp_mtx);
+	free(rp->rp_chunks, M_RXPOOL);
+	free(rp, M_RXPOOL);
+}
+
+static void
+rxpool_ext_free(struct mbuf *m, void *arg1, void *arg2)
+{
+	struct rxpool *rp;
+	bool done;
+
+	rp = arg1;
+	mtx_lock(&rp->rp_mtx);
+	rxpool_put_locked(rp, arg2);
+	++rp->rp_stat.rps_recycled;
+	done = rp->rp_dying && rp->rp_stat.rps_free == rp->rp_stat.rps_size;
+	mtx_unlock(&rp->rp_mtx);
+
+	if (done)
+		rxpool_free(rp);
+}
+
+struct rxpool *
+rxpool_create(const char *name, u_int nbufs, u_int bufsize)
+{
+	struct rxpool *rp;
+	u_int bufs_per_chunk;
+	u_int i;
+	u_int j;
+
+	KASSERT(bufsize == MCLBYTES || bufsize == MJUMPAGESIZE ||
+	    bufsize == MJUM9BYTES || bufsize == MJUM16BYTES,
+	    ("%s: invalid buffer size %u", __func__, bufsize));
+
+	rp = malloc(sizeof(*rp), M_RXPOOL, M_WAITOK | M_ZERO);
+	mtx_init(&rp->rp_mtx, "rxpool", NULL, MTX_DEF);
+	strlcpy(rp->rp_stat.rps_name, name, sizeof(rp->rp_stat.rps_name));
+	rp->rp_stat.rps_bufsize = bufsize;
+	rp->rp_bufsize = bufsize;
+	rp->rp_chunksize = MAX(bufsize, PAGE_SIZE);
+	bufs_per_chunk = rp->rp_chunksize / bufsize;
+	rp->rp_nchunks = howmany(nbufs, bufs_per_chunk);
+	rp->rp_chunks = malloc(rp->rp_nchunks * sizeof(rp->rp_chunks[0]),
+	    M_RXPOOL, M_WAITOK | M_ZERO);
+
+	/*
+	 * A short pool is not fatal, the allocation falls back to m_getjcl()
+	 * if it runs empty.
+	 */
+	mtx_lock(&rp->rp_mtx);
+	for (i = 0; i < rp->rp_nchunks; ++i) {
+		char *chunk;
+
+		if (rp->rp_chunksize == PAGE_SIZE)
+			chunk = rtems_bsd_page_alloc(PAGE_SIZE, 0);
+		else
+			chunk = rtems_bsd_jumbo_alloc(rp->rp_chunksize, 0);
+		if (chunk == NULL)
+			break;
+
+		rp->rp_chunks[i] = chunk;
+		for (j = 0; j < bufs_per_chunk; ++j)
+			rxpool_put_locked(rp, chunk + j * bufsize);
+	}
+	rp->rp_nchunks = i;
+	rp->rp_stat.rps_size = rp->rp_stat.rps_free;
+	mtx_unlock(&rp->rp_mtx);
+
+	mtx_lock(&rxpool_list_mtx);
+	LIST_INSERT_HEAD(&rxpool_list, rp, rp_link);
+	++rxpool_count;
+	mtx_unlock(&rxpool_list_mtx);
+
+	return (rp);
+}
+
+void
+rxpool_destroy(struct rxpool *rp)
+{
+	bool done;
+
+	mtx_lock(&rxpool_list_mtx);
+	LIST_REMOVE(rp, rp_link);
+	--rxpool_count;
+	mtx_unlock(&rxpool_list_mtx);
+
+	/* Buffers still in use by the stack free the pool on return */
+	mtx_lock(&rp->rp_mtx);
+	rp->rp_dying = true;
+	done = rp->rp_stat.rps_free == rp->rp_stat.rps_size;
+	mtx_unlock(&rp->rp_mtx);
+
+	if (done)
+		rxpool_free(rp);
+}
+
+struct mbuf *
+rxpool_getcl(struct rxpool *rp, int how)
+{
+	struct mbuf *m;
+	void *buf;
+
+	mtx_lock(&rp->rp_mtx);
+	buf = rp->rp_free;
+	if (buf != NULL) {
+		rp->rp_free = *(void **)buf;
+		--rp->rp_stat.rps_free;
+		++rp->rp_stat.rps_allocs;
+	} else
+		++rp->rp_stat.rps_fallbacks;
+	mtx_unlock(&rp->rp_mtx);
+
+	if (buf == NULL)
+		return (m_getjcl(how, MT_DATA, M_PKTHDR, rp->rp_bufsize));
+
+	m = m_gethdr(how, MT_DATA);
+	if (m == NULL) {
+		mtx_lock(&rp->rp_mtx);
+		rxpool_put_locked(rp, buf);
+		--rp->rp_stat.rps_allocs;
+		mtx_unlock(&rp->rp_mtx);
+		return (NULL);
+	}
+
+	m_extadd(m, buf, rp->rp_bufsize, rxpool_ext_free, rp, buf, 0,
+	    EXT_NET_DRV);
+	return (m);
+}
+
+static int
+rxpool_sysctl(SYSCTL_HANDLER_ARGS)
+{
+	struct rxpool_stat *rps;
+	struct rxpool *rp;
+	u_int n;
+	u_int i;
+	int error;
+
+	mtx_lock(&rxpool_list_mtx);
+	n = rxpool_count;
+	mtx_unlock(&rxpool_list_mtx);
+
+	/* Leave some room for pools created meanwhile */
+	if (req->oldptr == NULL)
+		return (SYSCTL_OUT(req, NULL, (n + 1) * sizeof(*rps)));
+
+	if (n == 0)
+		return (0);
+
+	/*
+	 * SYSCTL_OUT() may sleep while it copies to user space, so take a
+	 * snapshot under the list mutex and copy it out afterwards.
+	 */
+	rps = malloc(n * sizeof(*rps), M_TEMP, M_WAITOK);
+	i = 0;
+	mtx_lock(&rxpool_list_mtx);
+	LIST_FOREACH(rp, &rxpool_list, rp_link) {
+		if (i == n)
+			break;
+
+		mtx_lock(&rp->rp_mtx);
+		rps[i] = rp->rp_stat;
+		mtx_unlock(&rp->rp_mtx);
+		++i;
+	}
+	mtx_unlock(&rxpool_list_mtx);
+
+	error = SYSCTL_OUT(req, rps, i * sizeof(*rps));
+	free(rps, M_TEMP);
+
+	return (error);
+}
+SYSCTL_PROC(_kern_ipc, OID_AUTO, rxpool,
+    CTLTYPE_OPAQUE | CTLFLAG_RD | CTLFLAG_MPSAFE, NULL, 0, rxpool_sysctl,
+    "S,rxpool_stat", "Receive buffer pool statistics");
@@ -45,9 +45,12 @@
 #include <sys/systm.h>
 #include <sys/bus.h>
 #include <sys/kernel.h>
+#include <sys/lock.h>
 #include <sys/module.h>
+#include <sys/mutex.h>
 #include <sys/rman.h>
 #include <sys/malloc.h>
+#include <sys/taskqueue.h>
 #include <machine/bus.h>
 
 #include <rtems/bsd/local/opt_platform.h>
@@ -130,6 +133,73 @@ nexus_probe(device_t dev)
 	return (0);
 }
 
+struct nexus_attach_request {
+	struct task	task;
+	device_t	child;
+};
+
+static void
+nexus_attach_child(void *arg, int pending)
+{
+	struct nexus_attach_request *req;
+
+	(void)pending;
+	req = arg;
+
+	mtx_lock(&Giant);
+	device_probe_and_attach(req->child);
+	mtx_unlock(&Giant);
+}
+
+/*
+ * Attaches each child with its subtree in a task of a dedicated task queue.
+ * The Giant lock serializes the attach handlers, however, it is released
+ * while a handler sleeps, e.g. to wait for a hardware reset.  The caller
+ * releases the Giant lock while it waits for the tasks.
+ */
+static int
+nexus_attach_parallel(device_t dev)
+{
+	struct nexus_attach_request *reqs;
+	struct taskqueue *tq;
+	device_t *children;
+	int count;
+	int error;
+	int i;
+
+	error = device_get_children(dev, &children, &count);
+	if (error != 0 || count == 0)
+		return (error);
+
+	reqs = malloc(count * sizeof(*reqs), M_TEMP, M_WAITOK);
+	tq = taskqueue_create("nexus attach", M_WAITOK,
+	    taskqueue_thread_enqueue, &tq);
+	taskqueue_start_threads(&tq,
+	    min(count, rtems_bsd_parallel_attach_tasks), PWAIT, "nexus attach");
+
+	for (i = 0; i < count; ++i) {
+		reqs[i].child = children[i];
+		TASK_INIT(&reqs[i].task, 0, nexus_attach_child, &reqs[i]);
+		taskqueue_enqueue(tq, &reqs[i].task);
+	}
+
+	taskqueue_drain_all(tq);
+	taskqueue_free(tq);
+	free(reqs, M_TEMP);
+	free(children, M_TEMP);
+	return (0);
+}
+
+static int
+nexus_attach(device_t dev)
+{
+
+	if (rtems_bsd_parallel_attach_tasks > 0)
+		return (nexus_attach_parallel(dev));
+
+	return (bus_generic_attach(dev));
+}
+
 static bool
 nexus_get_start(const rtems_bsd_device *nd, int type, rman_res_t *start)
 {
@@ -360,7 +430,7 @@ nexus_ofw_map_intr(device_t dev, device_t child, phandle_t iparent, int icells,
 static device_method_t nexus_methods[] = {
 	/* Device interface */
 	DEVMETHOD(device_probe, nexus_probe),
-	DEVMETHOD(device_attach, bus_generic_attach),
+	DEVMETHOD(device_attach, nexus_attach),
 	DEVMETHOD(device_detach, bus_generic_detach),
 	DEVMETHOD(device_shutdown, bus_generic_shutdown),
 	DEVMETHOD(device_suspend, bus_generic_suspend),
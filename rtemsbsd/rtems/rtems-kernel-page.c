@@ -46,6 +46,7 @@
 #include <sys/mutex.h>
 #include <sys/systm.h>
 #include <sys/kernel.h>
+#include <sys/malloc.h>
 #include <vm/uma.h>
 
 #include <stdlib.h>
@@ -157,3 +158,103 @@ rtems_bsd_page_init(void *arg)
 }
 
 SYSINIT(rtems_bsd_page, SI_SUB_VM, SI_ORDER_FIRST, rtems_bsd_page_init, NULL);
+
+/*
+ * The jumbo clusters are allocated from a dedicated region, so that large
+ * contiguous allocations do not fragment the heaps.  Without a region or if
+ * it is exhausted, we fall back to the malloc() heap with cache line
+ * alignment, since the clusters are used for DMA.
+ */
+static rtems_rbheap_control jumbo_heap;
+
+static uintptr_t jumbo_area_begin;
+
+static uintptr_t jumbo_area_end;
+
+static struct mtx jumbo_heap_mtx;
+
+void *
+rtems_bsd_jumbo_alloc(uintptr_t size_in_bytes, int wait)
+{
+	void *addr;
+
+	addr = NULL;
+
+	if (jumbo_area_begin != jumbo_area_end) {
+		mtx_lock(&jumbo_heap_mtx);
+		addr = rtems_rbheap_allocate(&jumbo_heap, size_in_bytes);
+		mtx_unlock(&jumbo_heap_mtx);
+	}
+
+	if (addr == NULL) {
+		addr = rtems_heap_allocate_aligned_with_boundary(size_in_bytes,
+		    CACHE_LINE_SIZE, 0);
+	}
+
+	if (addr != NULL && (wait & M_ZERO) != 0) {
+		memset(addr, 0, size_in_bytes);
+	}
+
+	return (addr);
+}
+
+void
+rtems_bsd_jumbo_free(void *addr)
+{
+	uintptr_t a = (uintptr_t)addr;
+
+	if (a >= jumbo_area_begin && a < jumbo_area_end) {
+		mtx_lock(&jumbo_heap_mtx);
+		rtems_rbheap_free(&jumbo_heap, addr);
+		mtx_unlock(&jumbo_heap_mtx);
+	} else {
+		free(addr, M_TEMP);
+	}
+}
+
+static void
+rtems_bsd_jumbo_init(void *arg)
+{
+	rtems_status_code sc;
+	void *area;
+	rtems_rbheap_chunk *chunks;
+	size_t i;
+	size_t n;
+	uintptr_t heap_size;
+
+	heap_size = rtems_bsd_get_allocator_domain_size(
+	    RTEMS_BSD_ALLOCATOR_DOMAIN_JUMBO);
+	heap_size = rounddown(heap_size, PAGE_SIZE);
+	if (heap_size == 0) {
+		return;
+	}
+
+	mtx_init(&jumbo_heap_mtx, "jumbo heap", NULL, MTX_DEF);
+
+	area = rtems_heap_allocate_aligned_with_boundary(heap_size, PAGE_SIZE,
+	    0);
+	BSD_ASSERT(area != NULL);
+
+	sc = rtems_rbheap_initialize(&jumbo_heap, area, heap_size, PAGE_SIZE,
+	    rtems_rbheap_extend_descriptors_with_malloc, NULL);
+	BSD_ASSERT(sc == RTEMS_SUCCESSFUL);
+
+	rtems_rbheap_set_extend_descriptors(&jumbo_heap,
+	    rtems_rbheap_extend_descriptors_never);
+
+	n = heap_size / PAGE_SIZE;
+
+	chunks = malloc(n * sizeof(*chunks), M_RTEMS_HEAP, M_NOWAIT);
+	BSD_ASSERT(chunks != NULL);
+
+	for (i = 0; i < n; ++i) {
+		rtems_rbheap_add_to_spare_descriptor_chain(&jumbo_heap,
+		    &chunks[i]);
+	}
+
+	jumbo_area_begin = (uintptr_t)area;
+	jumbo_area_end = (uintptr_t)area + heap_size;
+}
+
+SYSINIT(rtems_bsd_jumbo, SI_SUB_VM, SI_ORDER_SECOND, rtems_bsd_jumbo_init,
+    NULL);
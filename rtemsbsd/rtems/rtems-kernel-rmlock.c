@@ -0,0 +1,393 @@
+/**
+ * @file
+ *
+ * @ingroup rtems_bsd_rtems
+ *
+ * @brief Read-mostly locks with a per-processor reader fast path.
+ */
+
+/*
+ * Copyright (c) 2026 embedded brains GmbH.  All rights reserved.
+ *
+ *  embedded brains GmbH
+ *  Dornierstr. 4
+ *  82178 Puchheim
+ *  Germany
+ *  <rtems@embedded-brains.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Each processor has its own reader counter in a separate cache line.  A
+ * reader increments the counter of the processor it runs on and checks the
+ * writer flag afterwards.  As long as no writer is present, readers do not
+ * share any modified cache line.  A writer sets the writer flag under the
+ * writer mutex and waits until the sum of all reader counters drops to zero.
+ * Readers which observe the writer flag back off and wait for the writer to
+ * finish.
+ *
+ * A reader may migrate to another processor before it releases the lock.
+ * The tracker records the counter which was incremented and the release
+ * decrements this counter, so no counter ever drops below the number of
+ * readers accounted to it.
+ */
+
+#include <machine/rtems-bsd-kernel-space.h>
+
+#include <sys/param.h>
+#include <sys/types.h>
+#include <sys/systm.h>
+#include <sys/lock.h>
+#include <sys/mutex.h>
+#include <sys/proc.h>
+#include <sys/rmlock.h>
+
+#include <machine/atomic.h>
+
+#include <rtems/malloc.h>
+#include <rtems/score/smp.h>
+
+#ifndef INVARIANTS
+#define	_rm_assert(rm, what, file, line)
+#endif
+
+/* The tracker did not increment a reader counter */
+#define	RMPF_NOCOUNT	(-1)
+
+struct rm_reader {
+	volatile u_int rr_count;
+} __aligned(CACHE_LINE_SIZE);
+
+static void assert_rm(struct lock_object *lock, int what);
+static void lock_rm(struct lock_object *lock, int how);
+static int unlock_rm(struct lock_object *lock);
+
+struct lock_class lock_class_rm = {
+	.lc_name = "rm",
+	.lc_flags = LC_SLEEPLOCK | LC_SLEEPABLE | LC_RECURSABLE,
+	.lc_assert = assert_rm,
+	.lc_lock = lock_rm,
+	.lc_unlock = unlock_rm,
+};
+
+static void
+assert_rm(struct lock_object *lock, int what)
+{
+
+	rm_assert((struct rmlock *)lock, what);
+}
+
+static void
+lock_rm(struct lock_object *lock, int how)
+{
+
+	rm_wlock((struct rmlock *)lock);
+}
+
+static int
+unlock_rm(struct lock_object *lock)
+{
+
+	rm_wunlock((struct rmlock *)lock);
+	return (0);
+}
+
+static u_int
+rm_readers_sum(const struct rmlock *rm)
+{
+	uint32_t cpu_count;
+	uint32_t cpu;
+	u_int sum;
+
+	cpu_count = _SMP_Get_processor_count();
+	sum = 0;
+
+	for (cpu = 0; cpu < cpu_count; ++cpu) {
+		sum += rm->rm_readers[cpu].rr_count;
+	}
+
+	return (sum);
+}
+
+static bool
+rm_trackers_contain(struct thread *td, const struct rmlock *rm)
+{
+	struct rm_priotracker *tracker;
+
+	LIST_FOREACH(tracker, &td->td_rmtrackers, rmp_qentry) {
+		if (tracker->rmp_rmlock == rm) {
+			return (true);
+		}
+	}
+
+	return (false);
+}
+
+void
+rm_init_flags(struct rmlock *rm, const char *name, int opts)
+{
+	size_t size;
+	int flags;
+
+	KASSERT((opts & ~(RM_NOWITNESS | RM_RECURSE | RM_SLEEPABLE |
+	    RM_NEW)) == 0, ("%s: unsupported options 0x%x", __func__, opts));
+
+	/*
+	 * FreeBSD uses an sx lock instead of a mutex for the writers of
+	 * RM_SLEEPABLE locks.  This is not necessary here, since readers only
+	 * hold a counter and the owner of an RTEMS mutex may block.  Thus,
+	 * both variants share the implementation and differ only in
+	 * LO_SLEEPABLE.
+	 */
+	flags = 0;
+	if (opts & RM_RECURSE)
+		flags |= LO_RECURSABLE;
+	if (opts & RM_SLEEPABLE)
+		flags |= LO_SLEEPABLE;
+
+	size = _SMP_Get_processor_count() * sizeof(*rm->rm_readers);
+	rm->rm_readers = rtems_heap_allocate_aligned_with_boundary(size,
+	    CACHE_LINE_SIZE, 0);
+	if (rm->rm_readers == NULL)
+		panic("rm_init: cannot allocate reader counters");
+	memset(rm->rm_readers, 0, size);
+
+	rm->rm_writer = 0;
+	mtx_init(&rm->rm_mtx, name, "rmlock writer", MTX_DEF | MTX_NOWITNESS);
+	lock_init(&rm->lock_object, &lock_class_rm, name, NULL, flags);
+}
+
+void
+rm_init(struct rmlock *rm, const char *name)
+{
+
+	rm_init_flags(rm, name, 0);
+}
+
+void
+rm_destroy(struct rmlock *rm)
+{
+
+	rm_assert(rm, RA_UNLOCKED);
+	lock_destroy(&rm->lock_object);
+	mtx_destroy(&rm->rm_mtx);
+	free(rm->rm_readers, M_TEMP);
+	rm->rm_readers = NULL;
+}
+
+void
+rm_sysinit(void *arg)
+{
+	struct rm_args *args = arg;
+
+	rm_init(args->ra_rm, args->ra_desc);
+}
+
+void
+rm_sysinit_flags(void *arg)
+{
+	struct rm_args_flags *args = arg;
+
+	rm_init_flags(args->ra_rm, args->ra_desc, args->ra_opts);
+}
+
+int
+rm_wowned(const struct rmlock *rm)
+{
+
+	return (mtx_owned(__DECONST(struct mtx *, &rm->rm_mtx)) &&
+	    rm->rm_writer != 0);
+}
+
+void
+_rm_wlock(struct rmlock *rm)
+{
+
+	mtx_lock(&rm->rm_mtx);
+
+	while (rm->rm_writer != 0) {
+		mtx_sleep(&rm->rm_writer, &rm->rm_mtx, 0, "rmwlock", 0);
+	}
+
+	rm->rm_writer = 1;
+	atomic_thread_fence_seq_cst();
+
+	while (rm_readers_sum(rm) != 0) {
+		mtx_sleep(&rm->rm_readers, &rm->rm_mtx, 0, "rmdrain", 0);
+	}
+}
+
+void
+_rm_wunlock(struct rmlock *rm)
+{
+
+	rm_assert(rm, RA_WLOCKED);
+	atomic_store_rel_int(&rm->rm_writer, 0);
+	wakeup(&rm->rm_writer);
+	mtx_unlock(&rm->rm_mtx);
+}
+
+static int
+_rm_rlock_hard(struct rmlock *rm, struct rm_priotracker *tracker,
+    int trylock)
+{
+	bool recursed;
+
+	/* Back off, a writer is present or waits for the readers to drain */
+	atomic_subtract_int(&rm->rm_readers[tracker->rmp_flags].rr_count, 1);
+
+	if (mtx_owned(&rm->rm_mtx)) {
+		/* Read lock acquired while holding the write lock */
+		tracker->rmp_flags = RMPF_NOCOUNT;
+		return (1);
+	}
+
+	mtx_lock(&rm->rm_mtx);
+	wakeup(&rm->rm_readers);
+
+	/*
+	 * A recursive read must not wait for a writer which waits for our
+	 * outer read to drain.
+	 */
+	recursed = (rm->lock_object.lo_flags & LO_RECURSABLE) != 0 &&
+	    rm_trackers_contain(tracker->rmp_thread, rm);
+
+	if (!recursed) {
+		if (trylock && rm->rm_writer != 0) {
+			mtx_unlock(&rm->rm_mtx);
+			return (0);
+		}
+
+		while (rm->rm_writer != 0) {
+			mtx_sleep(&rm->rm_writer, &rm->rm_mtx, 0, "rmrlock",
+			    0);
+		}
+	}
+
+	atomic_add_int(&rm->rm_readers[tracker->rmp_flags].rr_count, 1);
+	mtx_unlock(&rm->rm_mtx);
+	return (1);
+}
+
+int
+_rm_rlock(struct rmlock *rm, struct rm_priotracker *tracker, int trylock)
+{
+	struct thread *td;
+	uint32_t cpu;
+
+	tracker->rmp_rmlock = rm;
+	td = NULL;
+	if ((rm->lock_object.lo_flags & LO_RECURSABLE) != 0)
+		td = curthread;
+	tracker->rmp_thread = td;
+
+	cpu = _SMP_Get_current_processor();
+	tracker->rmp_flags = (int)cpu;
+	atomic_add_int(&rm->rm_readers[cpu].rr_count, 1);
+	atomic_thread_fence_seq_cst();
+
+	if (__predict_false(rm->rm_writer != 0) &&
+	    !_rm_rlock_hard(rm, tracker, trylock))
+		return (0);
+
+	if (td != NULL)
+		LIST_INSERT_HEAD(&td->td_rmtrackers, tracker, rmp_qentry);
+
+	return (1);
+}
+
+void
+_rm_runlock(struct rmlock *rm, struct rm_priotracker *tracker)
+{
+
+	if (tracker->rmp_thread != NULL)
+		LIST_REMOVE(tracker, rmp_qentry);
+
+	if (tracker->rmp_flags == RMPF_NOCOUNT)
+		return;
+
+	atomic_thread_fence_rel();
+	atomic_subtract_int(&rm->rm_readers[tracker->rmp_flags].rr_count, 1);
+	atomic_thread_fence_seq_cst();
+
+	if (__predict_false(rm->rm_writer != 0)) {
+		mtx_lock(&rm->rm_mtx);
+		wakeup(&rm->rm_readers);
+		mtx_unlock(&rm->rm_mtx);
+	}
+}
+
+#ifdef INVARIANT_SUPPORT
+#ifndef INVARIANTS
+#undef _rm_assert
+#endif
+
+/*
+ * Read ownership can only be verified for recursable locks, since only
+ * these record the trackers of the reading thread.
+ */
+void
+_rm_assert(const struct rmlock *rm, int what, const char *file, int line)
+{
+
+	if (panicstr != NULL)
+		return;
+	switch (what) {
+	case RA_LOCKED:
+	case RA_LOCKED | RA_RECURSED:
+	case RA_LOCKED | RA_NOTRECURSED:
+	case RA_RLOCKED:
+	case RA_RLOCKED | RA_RECURSED:
+	case RA_RLOCKED | RA_NOTRECURSED:
+		if (rm_wowned(rm)) {
+			if (what & RA_RLOCKED)
+				panic("Lock %s exclusively locked @ %s:%d\n",
+				    rm->lock_object.lo_name, file, line);
+			break;
+		}
+		if ((rm->lock_object.lo_flags & LO_RECURSABLE) != 0 &&
+		    !rm_trackers_contain(curthread, rm))
+			panic("Lock %s not %slocked @ %s:%d\n",
+			    rm->lock_object.lo_name,
+			    (what & RA_RLOCKED) ? "read " : "", file, line);
+		break;
+	case RA_WLOCKED:
+		if (!rm_wowned(rm))
+			panic("Lock %s not exclusively locked @ %s:%d\n",
+			    rm->lock_object.lo_name, file, line);
+		break;
+	case RA_UNLOCKED:
+		if (rm_wowned(rm))
+			panic("Lock %s exclusively locked @ %s:%d\n",
+			    rm->lock_object.lo_name, file, line);
+		if ((rm->lock_object.lo_flags & LO_RECURSABLE) != 0 &&
+		    rm_trackers_contain(curthread, rm))
+			panic("Lock %s read locked @ %s:%d\n",
+			    rm->lock_object.lo_name, file, line);
+		break;
+	default:
+		panic("Unknown rm lock assertion: %d @ %s:%d", what, file,
+		    line);
+	}
+}
+#endif /* INVARIANT_SUPPORT */
@@ -0,0 +1,399 @@
+/**
+ * @file
+ *
+ * @ingroup rtems_bsd_rtems
+ *
+ * @brief Zero-copy BPF buffers shared between the kernel and applications.
+ */
+
+/*
+ * Copyright (c) 2026 embedded brains GmbH.  All rights reserved.
+ *
+ *  embedded brains GmbH
+ *  Dornierstr. 4
+ *  82178 Puchheim
+ *  Germany
+ *  <rtems@embedded-brains.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * This implements the FreeBSD zero-copy buffer model for BPF (see bpf(4)).
+ * The application provides two buffers with BIOCSETZBUF.  Each buffer starts
+ * with a struct bpf_zbuf_header followed by the packet data.  The kernel
+ * hands a buffer over to the application by an increment of the kernel
+ * generation number and the application returns it with a copy of the
+ * kernel generation number to the user generation number.
+ *
+ * FreeBSD wires the user pages and maps them into the kernel address space
+ * with sf_bufs.  There is only one address space on RTEMS, so the buffers
+ * are used directly and packets are copied once from the mbuf chain to the
+ * application buffer.
+ */
+
+#include <machine/rtems-bsd-kernel-space.h>
+
+#include <rtems/bsd/local/opt_bpf.h>
+
+#include <sys/param.h>
+#include <sys/systm.h>
+#include <sys/lock.h>
+#include <sys/malloc.h>
+#include <sys/mbuf.h>
+#include <sys/mutex.h>
+#include <sys/socket.h>
+
+#include <machine/atomic.h>
+
+#include <net/if.h>
+#include <net/bpf.h>
+#include <net/bpf_zerocopy.h>
+#include <net/bpfdesc.h>
+
+/* Maximum size of each zero-copy buffer including the header */
+#define	BPF_MAX_ZBUF	(512 * PAGE_SIZE)
+
+#define	ZBUF_FLAG_ASSIGNED	0x00000001	/* Set when owned by user */
+
+struct zbuf {
+	u_char			*zb_uaddr;	/* Buffer of the application */
+	size_t			 zb_size;	/* Size of the buffer */
+	int			 zb_flags;	/* Flags on zbuf */
+	struct bpf_zbuf_header	*zb_header;	/* Shared header */
+};
+
+static struct zbuf *
+zbuf_setup(void *uaddr, size_t len)
+{
+	struct zbuf *zb;
+
+	zb = malloc(sizeof(*zb), M_BPF, M_WAITOK | M_ZERO);
+	zb->zb_uaddr = uaddr;
+	zb->zb_size = len;
+	zb->zb_header = uaddr;
+	bzero(zb->zb_header, sizeof(*zb->zb_header));
+	return (zb);
+}
+
+static void
+zbuf_free(struct zbuf *zb)
+{
+
+	free(zb, M_BPF);
+}
+
+/*
+ * Copy bytes from a source into the specified zbuf.  The caller is
+ * responsible for performing bounds checking, etc.
+ */
+void
+bpf_zerocopy_append_bytes(struct bpf_d *d, caddr_t buf, u_int offset,
+    void *src, u_int len)
+{
+	struct zbuf *zb;
+
+	KASSERT(d->bd_bufmode == BPF_BUFMODE_ZBUF,
+	    ("bpf_zerocopy_append_bytes: not in zbuf mode"));
+	KASSERT(buf != NULL, ("bpf_zerocopy_append_bytes: NULL buf"));
+
+	zb = (struct zbuf *)buf;
+	offset += sizeof(struct bpf_zbuf_header);
+	KASSERT(offset + len <= zb->zb_size,
+	    ("bpf_zerocopy_append_bytes: overflow"));
+	bcopy(src, zb->zb_uaddr + offset, len);
+}
+
+/*
+ * Copy bytes from an mbuf chain to the specified zbuf.  The caller is
+ * responsible for performing bounds checking, etc.
+ */
+void
+bpf_zerocopy_append_mbuf(struct bpf_d *d, caddr_t buf, u_int offset,
+    void *src, u_int len)
+{
+	const struct mbuf *m;
+	struct zbuf *zb;
+	u_char *dst;
+	u_int count;
+
+	KASSERT(d->bd_bufmode == BPF_BUFMODE_ZBUF,
+	    ("bpf_zerocopy_append_mbuf: not in zbuf mode"));
+	KASSERT(buf != NULL, ("bpf_zerocopy_append_mbuf: NULL buf"));
+
+	m = (struct mbuf *)src;
+	zb = (struct zbuf *)buf;
+	offset += sizeof(struct bpf_zbuf_header);
+	KASSERT(offset + len <= zb->zb_size,
+	    ("bpf_zerocopy_append_mbuf: overflow"));
+	dst = zb->zb_uaddr + offset;
+	while (len > 0) {
+		if (m == NULL)
+			panic("bpf_zerocopy_append_mbuf");
+		count = min(m->m_len, len);
+		bcopy(mtod(m, void *), dst, count);
+		m = m->m_next;
+		dst += count;
+		len -= count;
+	}
+}
+
+/*
+ * Notification from the BPF framework that a buffer in the store position
+ * is rejecting packets and may be considered full.  We mark the buffer as
+ * immediately assignable to user space so that it can be picked up by the
+ * application.
+ */
+void
+bpf_zerocopy_buffull(struct bpf_d *d)
+{
+	struct zbuf *zb;
+
+	KASSERT(d->bd_bufmode == BPF_BUFMODE_ZBUF,
+	    ("bpf_zerocopy_buffull: not in zbuf mode"));
+
+	zb = (struct zbuf *)d->bd_sbuf;
+	KASSERT(zb != NULL, ("bpf_zerocopy_buffull: zb == NULL"));
+
+	if ((zb->zb_flags & ZBUF_FLAG_ASSIGNED) == 0 && d->bd_slen != 0) {
+		zb->zb_flags |= ZBUF_FLAG_ASSIGNED;
+		zb->zb_header->bzh_kernel_len = d->bd_slen;
+		atomic_add_rel_int(&zb->zb_header->bzh_kernel_gen, 1);
+	}
+}
+
+/*
+ * Notification from the BPF framework that a buffer has moved into the held
+ * slot on a descriptor.  Zero-copy BPF will update the shared page to let
+ * the user process know and flag the buffer as assigned if it hasn't
+ * already been marked assigned due to filling while it was in the store
+ * position.
+ */
+void
+bpf_zerocopy_bufheld(struct bpf_d *d)
+{
+	struct zbuf *zb;
+
+	KASSERT(d->bd_bufmode == BPF_BUFMODE_ZBUF,
+	    ("bpf_zerocopy_bufheld: not in zbuf mode"));
+
+	zb = (struct zbuf *)d->bd_hbuf;
+	KASSERT(zb != NULL, ("bpf_zerocopy_bufheld: zb == NULL"));
+
+	if ((zb->zb_flags & ZBUF_FLAG_ASSIGNED) == 0) {
+		zb->zb_flags |= ZBUF_FLAG_ASSIGNED;
+		zb->zb_header->bzh_kernel_len = d->bd_hlen;
+		atomic_add_rel_int(&zb->zb_header->bzh_kernel_gen, 1);
+	}
+}
+
+/*
+ * Notification from the BPF framework that the free buffer has been been
+ * reclaimed from user space, so it may be written by the kernel again.
+ */
+void
+bpf_zerocopy_buf_reclaimed(struct bpf_d *d)
+{
+	struct zbuf *zb;
+
+	KASSERT(d->bd_bufmode == BPF_BUFMODE_ZBUF,
+	    ("bpf_zerocopy_buf_reclaimed: not in zbuf mode"));
+
+	zb = (struct zbuf *)d->bd_fbuf;
+	KASSERT(zb != NULL, ("bpf_zerocopy_buf_reclaimed: NULL free buf"));
+	zb->zb_flags &= ~ZBUF_FLAG_ASSIGNED;
+}
+
+/*
+ * Query from the BPF framework regarding whether the buffer currently in
+ * the held position can be moved to the free position, which can be
+ * indicated by the user process making their generation number equal to
+ * the kernel generation number.
+ */
+int
+bpf_zerocopy_canfreebuf(struct bpf_d *d)
+{
+	struct zbuf *zb;
+
+	KASSERT(d->bd_bufmode == BPF_BUFMODE_ZBUF,
+	    ("bpf_zerocopy_canfreebuf: not in zbuf mode"));
+
+	zb = (struct zbuf *)d->bd_hbuf;
+	if (zb == NULL)
+		return (0);
+	if (zb->zb_header->bzh_kernel_gen ==
+	    atomic_load_acq_int(&zb->zb_header->bzh_user_gen))
+		return (1);
+	return (0);
+}
+
+/*
+ * Query from the BPF framework as to whether or not the buffer current in
+ * the store position can actually be written to.  This may return false if
+ * the store buffer is assigned to user space before the hold buffer is
+ * cleared.
+ */
+int
+bpf_zerocopy_canwritebuf(struct bpf_d *d)
+{
+	struct zbuf *zb;
+
+	KASSERT(d->bd_bufmode == BPF_BUFMODE_ZBUF,
+	    ("bpf_zerocopy_canwritebuf: not in zbuf mode"));
+
+	zb = (struct zbuf *)d->bd_sbuf;
+	KASSERT(zb != NULL, ("bpf_zerocopy_canwritebuf: bd_sbuf NULL"));
+
+	if (zb->zb_flags & ZBUF_FLAG_ASSIGNED)
+		return (0);
+	return (1);
+}
+
+/*
+ * Free zero-copy buffers at request of descriptor.  The memory of the
+ * buffers belongs to the application.
+ */
+void
+bpf_zerocopy_free(struct bpf_d *d)
+{
+	struct zbuf *zb;
+
+	KASSERT(d->bd_bufmode == BPF_BUFMODE_ZBUF,
+	    ("bpf_zerocopy_free: not in zbuf mode"));
+
+	zb = (struct zbuf *)d->bd_sbuf;
+	if (zb != NULL)
+		zbuf_free(zb);
+	zb = (struct zbuf *)d->bd_hbuf;
+	if (zb != NULL)
+		zbuf_free(zb);
+	zb = (struct zbuf *)d->bd_fbuf;
+	if (zb != NULL)
+		zbuf_free(zb);
+}
+
+/*
+ * Ioctl to return the maximum buffer size.
+ */
+int
+bpf_zerocopy_ioctl_getzmax(struct thread *td, struct bpf_d *d, size_t *i)
+{
+
+	KASSERT(d->bd_bufmode == BPF_BUFMODE_ZBUF,
+	    ("bpf_zerocopy_ioctl_getzmax: not in zbuf mode"));
+
+	*i = BPF_MAX_ZBUF;
+	return (0);
+}
+
+/*
+ * Ioctl to force rotation of the two buffers, if there's any data
+ * available.  This can be used by user space to implement timeouts when
+ * waiting for a buffer to fill.
+ */
+int
+bpf_zerocopy_ioctl_rotzbuf(struct thread *td, struct bpf_d *d,
+    struct bpf_zbuf *bz)
+{
+	struct zbuf *bzh;
+
+	bzero(bz, sizeof(*bz));
+	BPFD_LOCK(d);
+	if (d->bd_hbuf == NULL && d->bd_slen != 0) {
+		ROTATE_BUFFERS(d);
+		bzh = (struct zbuf *)d->bd_hbuf;
+		bz->bz_bufa = bzh->zb_uaddr;
+		bz->bz_buflen = d->bd_hlen;
+	}
+	BPFD_UNLOCK(d);
+	return (0);
+}
+
+/*
+ * Ioctl to configure zero-copy buffers, which may be done only once.
+ */
+int
+bpf_zerocopy_ioctl_setzbuf(struct thread *td, struct bpf_d *d,
+    struct bpf_zbuf *bz)
+{
+	struct zbuf *zba, *zbb;
+
+	KASSERT(d->bd_bufmode == BPF_BUFMODE_ZBUF,
+	    ("bpf_zerocopy_ioctl_setzbuf: not in zbuf mode"));
+
+	/*
+	 * Must set both buffers.  Cannot clear them.
+	 */
+	if (bz->bz_bufa == NULL || bz->bz_bufb == NULL)
+		return (EINVAL);
+
+	/*
+	 * Buffers must be large enough for the header and some data, must
+	 * not exceed the maximum size and must not overlap.
+	 */
+	if (bz->bz_buflen <= sizeof(struct bpf_zbuf_header) ||
+	    bz->bz_buflen > BPF_MAX_ZBUF)
+		return (EINVAL);
+	if ((u_char *)bz->bz_bufa < (u_char *)bz->bz_bufb + bz->bz_buflen &&
+	    (u_char *)bz->bz_bufb < (u_char *)bz->bz_bufa + bz->bz_buflen)
+		return (EINVAL);
+
+	/*
+	 * The shared headers are accessed with atomic operations.
+	 */
+	if (((uintptr_t)bz->bz_bufa & (sizeof(u_int) - 1)) != 0 ||
+	    ((uintptr_t)bz->bz_bufb & (sizeof(u_int) - 1)) != 0)
+		return (EINVAL);
+
+	zba = zbuf_setup(bz->bz_bufa, bz->bz_buflen);
+	zbb = zbuf_setup(bz->bz_bufb, bz->bz_buflen);
+
+	/*
+	 * We only allow buffers to be installed once, so atomically check
+	 * that no buffers are currently installed and install new buffers.
+	 */
+	BPFD_LOCK(d);
+	if (d->bd_hbuf != NULL || d->bd_sbuf != NULL || d->bd_fbuf != NULL ||
+	    d->bd_bif != NULL) {
+		BPFD_UNLOCK(d);
+		zbuf_free(zba);
+		zbuf_free(zbb);
+		return (EINVAL);
+	}
+
+	/*
+	 * Point BPF descriptor at buffers; initialize sbuf as zba so that
+	 * it is always filled first in the sequence, per bpf(4).
+	 */
+	d->bd_fbuf = (caddr_t)zbb;
+	d->bd_sbuf = (caddr_t)zba;
+	d->bd_slen = 0;
+	d->bd_hlen = 0;
+
+	/*
+	 * We expose only the space left in the buffer after the size of the
+	 * shared management region.
+	 */
+	d->bd_bufsize = bz->bz_buflen - sizeof(struct bpf_zbuf_header);
+	BPFD_UNLOCK(d);
+	return (0);
+}
@@ -0,0 +1,345 @@
+/**
+ * @file
+ *
+ * @ingroup rtems_bsd_rtems
+ *
+ * @brief Per-processor IPv4 forwarding flow cache.
+ */
+
+/*
+ * Copyright (c) 2026 embedded brains GmbH.  All rights reserved.
+ *
+ *  embedded brains GmbH
+ *  Dornierstr. 4
+ *  82178 Puchheim
+ *  Germany
+ *  <rtems@embedded-brains.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * The cache is a direct mapped table per processor.  Each entry maps
+ * (fib, destination) to the next hop returned by fib4_lookup_nh_basic() and
+ * a copy of the link-level header of the next hop lltable entry.  An entry
+ * records the routing table and lltable generation counters sampled before
+ * the slow path lookups, so any route or neighbour change invalidates it.
+ * Entries also expire after net.flowtable.expire seconds, so that every flow
+ * periodically passes the regular resolution path which keeps the ARP
+ * refresh logic informed about used entries.
+ *
+ * The table of the current processor is protected by a mutex, a thread
+ * migration between the processor lookup and the lock acquisition only
+ * costs locality.
+ */
+
+#include <machine/rtems-bsd-kernel-space.h>
+
+#include <sys/param.h>
+#include <sys/systm.h>
+#include <sys/counter.h>
+#include <sys/kernel.h>
+#include <sys/lock.h>
+#include <sys/malloc.h>
+#include <sys/mutex.h>
+#include <sys/socket.h>
+#include <sys/sysctl.h>
+
+#include <net/ethernet.h>
+#include <net/flowtable.h>
+#include <net/if.h>
+#include <net/if_var.h>
+#include <net/if_llatbl.h>
+#include <net/route.h>
+
+#include <netinet/in.h>
+#include <netinet/in_fib.h>
+#include <netinet/in_var.h>
+
+#include <rtems/score/smp.h>
+
+#define	FLOWTABLE_SIZE	256	/* Entries per processor, power of two */
+
+struct flentry {
+	uint64_t	 fe_gen;
+	struct ifnet	*fe_ifp;	/* NULL for free entries */
+	struct in_addr	 fe_dst;
+	struct in_addr	 fe_gw;
+	uint32_t	 fe_fibnum;
+	uint32_t	 fe_mtu;
+	uint16_t	 fe_flags;
+	uint16_t	 fe_hdrlen;	/* 0 if L2 header is not known */
+	time_t		 fe_expire;
+	char		 fe_hdr[LLE_MAX_LINKHDR];
+};
+
+struct flowtable {
+	struct mtx	 ft_mtx;
+	struct flentry	 ft_table[FLOWTABLE_SIZE];
+};
+
+static MALLOC_DEFINE(M_FLOWTABLE, "flowtable", "IPv4 forwarding flow cache");
+
+static struct flowtable *flowtables;
+
+static counter_u64_t flowtable_stat[sizeof(struct flowtable_stat) /
+    sizeof(uint64_t)];
+
+#define	FLOWSTAT_INC(f)	counter_u64_add(flowtable_stat[			\
+    offsetof(struct flowtable_stat, f) / sizeof(uint64_t)], 1)
+
+#define	FLOWTABLE_LOCK(ft)	mtx_lock(&(ft)->ft_mtx)
+#define	FLOWTABLE_UNLOCK(ft)	mtx_unlock(&(ft)->ft_mtx)
+
+static SYSCTL_NODE(_net, OID_AUTO, flowtable, CTLFLAG_RD, NULL,
+    "Forwarding flow cache");
+static SYSCTL_NODE(_net_flowtable, OID_AUTO, ip4, CTLFLAG_RD, NULL,
+    "IPv4 forwarding flow cache");
+
+static int flowtable_enable = 1;
+SYSCTL_INT(_net_flowtable, OID_AUTO, enable, CTLFLAG_RW,
+    &flowtable_enable, 0, "Enable the forwarding flow cache");
+
+static int flowtable_expire = 30;
+SYSCTL_INT(_net_flowtable, OID_AUTO, expire, CTLFLAG_RW,
+    &flowtable_expire, 0,
+    "Seconds after which a flow is resolved again via the slow path");
+
+static int
+sysctl_flowtable_stat(SYSCTL_HANDLER_ARGS)
+{
+	struct flowtable_stat fs;
+	int error;
+
+	COUNTER_ARRAY_COPY(flowtable_stat, &fs, nitems(flowtable_stat));
+	error = SYSCTL_OUT(req, &fs, sizeof(fs));
+	if (error == 0 && req->newptr != NULL)
+		COUNTER_ARRAY_ZERO(flowtable_stat, nitems(flowtable_stat));
+
+	return (error);
+}
+SYSCTL_PROC(_net_flowtable_ip4, OID_AUTO, stat,
+    CTLTYPE_OPAQUE | CTLFLAG_RW, NULL, 0, sysctl_flowtable_stat,
+    "S,flowtable_stat",
+    "IPv4 flow cache statistics (struct flowtable_stat, net/flowtable.h)");
+
+static void
+flowtable_init(void *arg)
+{
+	uint32_t cpu_count;
+	uint32_t cpu;
+
+	(void)arg;
+
+	COUNTER_ARRAY_ALLOC(flowtable_stat, nitems(flowtable_stat), M_WAITOK);
+
+	cpu_count = _SMP_Get_processor_count();
+	flowtables = malloc(cpu_count * sizeof(*flowtables), M_FLOWTABLE,
+	    M_WAITOK | M_ZERO);
+	for (cpu = 0; cpu < cpu_count; ++cpu) {
+		mtx_init(&flowtables[cpu].ft_mtx, "flowtable", NULL,
+		    MTX_DEF);
+	}
+}
+SYSINIT(flowtable, SI_SUB_PROTO_BEGIN, SI_ORDER_ANY, flowtable_init, NULL);
+
+static inline struct flowtable *
+flowtable_get(void)
+{
+
+	return (&flowtables[_SMP_Get_current_processor()]);
+}
+
+static inline struct flentry *
+flowtable_entry4(struct flowtable *ft, uint32_t fibnum, struct in_addr dst)
+{
+	uint32_t h;
+
+	h = (dst.s_addr ^ (fibnum << 16)) * 2654435761U;
+
+	return (&ft->ft_table[h >> 24 & (FLOWTABLE_SIZE - 1)]);
+}
+
+static inline bool
+flowtable_match4(const struct flentry *fe, uint32_t fibnum,
+    struct in_addr dst)
+{
+
+	return (fe->fe_ifp != NULL && fe->fe_dst.s_addr == dst.s_addr &&
+	    fe->fe_fibnum == fibnum);
+}
+
+/*
+ * Copies the link-level header of the next hop into @hdr.  Only Ethernet
+ * style interfaces accept a pre-computed header via ro_prepend, see
+ * ether_output().  Returns the header length or 0 if it is not available.
+ */
+static size_t
+flowtable_fetch_l2(struct ifnet *ifp, struct in_addr gw, char *hdr)
+{
+	struct sockaddr_in sin;
+	struct llentry *lle;
+	size_t len;
+
+	if (ifp->if_output != ether_output ||
+	    ifp->if_afdata[AF_INET] == NULL)
+		return (0);
+
+	memset(&sin, 0, sizeof(sin));
+	sin.sin_family = AF_INET;
+	sin.sin_len = sizeof(sin);
+	sin.sin_addr = gw;
+
+	len = 0;
+	lltable_read_enter();
+	lle = lla_lookup(LLTABLE(ifp), LLE_UNLOCKED,
+	    (struct sockaddr *)&sin);
+	if (lle != NULL &&
+	    (lle->r_flags & (RLLE_VALID | RLLE_IFADDR)) == RLLE_VALID) {
+		atomic_thread_fence_acq();
+		len = lltable_read_linkhdr(lle, hdr);
+	}
+	lltable_read_exit();
+
+	return (len);
+}
+
+uint64_t
+flowtable_gen(sa_family_t af, uint32_t fibnum)
+{
+
+	return (((uint64_t)rt_tables_get_gen(fibnum, af) << 32) |
+	    lltable_gen);
+}
+
+/*
+ * Looks up the next hop for @dst in @fibnum.  On a hit, returns 0, fills
+ * @pnh and copies the link-level header to @hdr (at least
+ * LLE_MAX_LINKHDR bytes).  The header length is returned in @hdrlen, it is
+ * zero if the caller has to resolve the link-level address itself.
+ */
+int
+flowtable_lookup_nh4(uint32_t fibnum, struct in_addr dst,
+    struct nhop4_basic *pnh, char *hdr, size_t *hdrlen)
+{
+	struct flowtable *ft;
+	struct flentry *fe;
+	uint64_t gen;
+	size_t len;
+
+	if (flowtable_enable == 0)
+		return (ENOENT);
+
+	FLOWSTAT_INC(ft_lookups);
+	gen = flowtable_gen(AF_INET, fibnum);
+	ft = flowtable_get();
+	fe = flowtable_entry4(ft, fibnum, dst);
+
+	FLOWTABLE_LOCK(ft);
+	if (!flowtable_match4(fe, fibnum, dst)) {
+		FLOWTABLE_UNLOCK(ft);
+		FLOWSTAT_INC(ft_misses);
+		return (ENOENT);
+	}
+
+	FLOWSTAT_INC(ft_free_checks);
+	if (fe->fe_gen != gen || fe->fe_expire - time_uptime <= 0 ||
+	    !RT_LINK_IS_UP(fe->fe_ifp)) {
+		fe->fe_ifp = NULL;
+		FLOWTABLE_UNLOCK(ft);
+		FLOWSTAT_INC(ft_frees);
+		FLOWSTAT_INC(ft_misses);
+		return (ENOENT);
+	}
+
+	pnh->nh_ifp = fe->fe_ifp;
+	pnh->nh_mtu = fe->fe_mtu;
+	pnh->nh_flags = fe->fe_flags;
+	pnh->nh_addr = fe->fe_gw;
+	len = fe->fe_hdrlen;
+	memcpy(hdr, fe->fe_hdr, len);
+	FLOWTABLE_UNLOCK(ft);
+
+	if (len == 0) {
+		/*
+		 * The next hop was not resolved at insert time.  Try again
+		 * and complete the entry if nothing changed meanwhile.
+		 */
+		len = flowtable_fetch_l2(pnh->nh_ifp, pnh->nh_addr, hdr);
+		if (len != 0) {
+			FLOWTABLE_LOCK(ft);
+			if (flowtable_match4(fe, fibnum, dst) &&
+			    fe->fe_gen == gen &&
+			    flowtable_gen(AF_INET, fibnum) == gen) {
+				memcpy(fe->fe_hdr, hdr, len);
+				fe->fe_hdrlen = len;
+			} else
+				len = 0;
+			FLOWTABLE_UNLOCK(ft);
+		}
+		if (len == 0)
+			FLOWSTAT_INC(ft_fail_lle_invalid);
+	}
+
+	*hdrlen = len;
+	FLOWSTAT_INC(ft_hits);
+
+	return (0);
+}
+
+/*
+ * Caches the next hop @pnh for @dst in @fibnum.  The @gen value must be
+ * obtained by flowtable_gen() before the route lookup which produced @pnh.
+ */
+void
+flowtable_insert_nh4(uint32_t fibnum, struct in_addr dst,
+    const struct nhop4_basic *pnh, uint64_t gen)
+{
+	char hdr[LLE_MAX_LINKHDR];
+	struct flowtable *ft;
+	struct flentry *fe;
+	size_t len;
+
+	if (flowtable_enable == 0)
+		return;
+
+	len = flowtable_fetch_l2(pnh->nh_ifp, pnh->nh_addr, hdr);
+	ft = flowtable_get();
+	fe = flowtable_entry4(ft, fibnum, dst);
+
+	FLOWTABLE_LOCK(ft);
+	if (fe->fe_ifp != NULL && !flowtable_match4(fe, fibnum, dst))
+		FLOWSTAT_INC(ft_collisions);
+	fe->fe_gen = gen;
+	fe->fe_ifp = pnh->nh_ifp;
+	fe->fe_dst = dst;
+	fe->fe_gw = pnh->nh_addr;
+	fe->fe_fibnum = fibnum;
+	fe->fe_mtu = pnh->nh_mtu;
+	fe->fe_flags = pnh->nh_flags;
+	fe->fe_expire = time_uptime + flowtable_expire;
+	fe->fe_hdrlen = len;
+	memcpy(fe->fe_hdr, hdr, len);
+	FLOWTABLE_UNLOCK(ft);
+
+	FLOWSTAT_INC(ft_inserts);
+}
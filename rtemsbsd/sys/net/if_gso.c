@@ -0,0 +1,300 @@
+/**
+ * @file
+ *
+ * @ingroup rtems_bsd_rtems
+ *
+ * @brief Generic segmentation offload for Ethernet interfaces.
+ */
+
+/*
+ * Copyright (c) 2026 embedded brains GmbH.  All rights reserved.
+ *
+ *  embedded brains GmbH
+ *  Dornierstr. 4
+ *  82178 Puchheim
+ *  Germany
+ *  <rtems@embedded-brains.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Ethernet interfaces without TCP segmentation offload (TSO) are marked by
+ * ether_ifattach() for generic segmentation offload (GSO), see IF_GSO().
+ * TCP then builds super-segments of up to if_hw_tsomax bytes as if the
+ * interface could do TSO, so the IP output and the link-layer address
+ * resolution run once per super-segment instead of once per segment.
+ *
+ * ether_output_frame() hands the super-segments to ether_gso_output().  It
+ * splits them into segments of tso_segsz bytes of payload.  Each segment
+ * gets a copy of the Ethernet, IP and TCP headers of the super-segment
+ * with the lengths, the IP identification, the sequence number and the TCP
+ * flags adjusted.  The payload is shared with the super-segment through
+ * m_copym().  The checksums are left to the interface if it supports
+ * checksum offload, otherwise they are computed here.
+ */
+
+#include <machine/rtems-bsd-kernel-space.h>
+
+#include <rtems/bsd/local/opt_inet.h>
+#include <rtems/bsd/local/opt_inet6.h>
+
+#include <sys/param.h>
+#include <sys/systm.h>
+#include <sys/kernel.h>
+#include <sys/mbuf.h>
+#include <sys/socket.h>
+#include <sys/sysctl.h>
+
+#include <net/if.h>
+#include <net/if_var.h>
+#include <net/ethernet.h>
+
+#include <netinet/in.h>
+#include <netinet/in_systm.h>
+#include <netinet/ip.h>
+#include <netinet/ip6.h>
+#include <netinet/tcp.h>
+
+#include <machine/in_cksum.h>
+
+SYSCTL_DECL(_net_link_ether);
+
+static counter_u64_t ether_gso_sent;
+static counter_u64_t ether_gso_segments;
+static counter_u64_t ether_gso_failed;
+
+SYSCTL_COUNTER_U64(_net_link_ether, OID_AUTO, gso_sent, CTLFLAG_RD,
+    &ether_gso_sent, "TCP super-segments split by software TSO");
+SYSCTL_COUNTER_U64(_net_link_ether, OID_AUTO, gso_segments, CTLFLAG_RD,
+    &ether_gso_segments, "Segments produced by software TSO");
+SYSCTL_COUNTER_U64(_net_link_ether, OID_AUTO, gso_failed, CTLFLAG_RD,
+    &ether_gso_failed, "TCP super-segments dropped by software TSO");
+
+static void
+ether_gso_init(void *arg)
+{
+
+	(void)arg;
+	ether_gso_sent = counter_u64_alloc(M_WAITOK);
+	ether_gso_segments = counter_u64_alloc(M_WAITOK);
+	ether_gso_failed = counter_u64_alloc(M_WAITOK);
+}
+SYSINIT(ether_gso, SI_SUB_PROTO_IFATTACHDOMAIN, SI_ORDER_FIRST,
+    ether_gso_init, NULL);
+
+static struct mbuf *
+ether_gso_pullup(struct mbuf *m, int len)
+{
+
+	if (m->m_len < len)
+		m = m_pullup(m, len);
+	return (m);
+}
+
+int
+ether_gso_output(struct ifnet *ifp, struct mbuf *m)
+{
+	const struct ether_header *eh;
+	struct tcphdr *th;
+	struct mbuf *n;
+#ifdef INET
+	struct ip *ip;
+#endif
+#ifdef INET6
+	struct ip6_hdr *ip6;
+#endif
+	uint64_t csum_flags;
+	tcp_seq seq;
+	uint16_t etype, id;
+	int error, ehlen, hlen, iphlen, thoff, off, len, segsz, first;
+
+	ehlen = ETHER_HDR_LEN;
+	iphlen = 0;
+	segsz = m->m_pkthdr.tso_segsz;
+	id = 0;
+	error = 0;
+
+	m = ether_gso_pullup(m, ehlen);
+	if (m == NULL) {
+		error = ENOBUFS;
+		goto bad;
+	}
+	eh = mtod(m, struct ether_header *);
+	etype = ntohs(eh->ether_type);
+
+	/*
+	 * Locate the TCP header.  Only TCP over IPv4 and IPv6 without
+	 * extension headers uses CSUM_TSO, everything else is dropped.
+	 */
+	switch (etype) {
+#ifdef INET
+	case ETHERTYPE_IP:
+		m = ether_gso_pullup(m, ehlen + sizeof(*ip));
+		if (m == NULL) {
+			error = ENOBUFS;
+			goto bad;
+		}
+		ip = (struct ip *)(mtod(m, char *) + ehlen);
+		iphlen = ip->ip_hl << 2;
+		if (ip->ip_p != IPPROTO_TCP || iphlen < (int)sizeof(*ip)) {
+			error = EINVAL;
+			goto bad;
+		}
+		id = ntohs(ip->ip_id);
+		break;
+#endif
+#ifdef INET6
+	case ETHERTYPE_IPV6:
+		m = ether_gso_pullup(m, ehlen + sizeof(*ip6));
+		if (m == NULL) {
+			error = ENOBUFS;
+			goto bad;
+		}
+		ip6 = (struct ip6_hdr *)(mtod(m, char *) + ehlen);
+		iphlen = sizeof(*ip6);
+		if (ip6->ip6_nxt != IPPROTO_TCP) {
+			error = EINVAL;
+			goto bad;
+		}
+		break;
+#endif
+	default:
+		error = EINVAL;
+		goto bad;
+	}
+
+	m = ether_gso_pullup(m, ehlen + iphlen + sizeof(*th));
+	if (m == NULL) {
+		error = ENOBUFS;
+		goto bad;
+	}
+	th = (struct tcphdr *)(mtod(m, char *) + ehlen + iphlen);
+	thoff = th->th_off << 2;
+	hlen = ehlen + iphlen + thoff;
+	if (thoff < (int)sizeof(*th) || hlen > MHLEN || segsz <= 0) {
+		error = EINVAL;
+		goto bad;
+	}
+	m = ether_gso_pullup(m, hlen);
+	if (m == NULL) {
+		error = ENOBUFS;
+		goto bad;
+	}
+	th = (struct tcphdr *)(mtod(m, char *) + ehlen + iphlen);
+	seq = ntohl(th->th_seq);
+
+	counter_u64_add(ether_gso_sent, 1);
+
+	first = 1;
+	for (off = hlen; off < m->m_pkthdr.len; off += len) {
+		len = min(segsz, m->m_pkthdr.len - off);
+
+		n = m_gethdr(M_NOWAIT, MT_DATA);
+		if (n == NULL) {
+			error = ENOBUFS;
+			goto bad;
+		}
+		if (m_dup_pkthdr(n, m, M_NOWAIT) == 0) {
+			m_free(n);
+			error = ENOBUFS;
+			goto bad;
+		}
+		n->m_next = m_copym(m, off, len, M_NOWAIT);
+		if (n->m_next == NULL) {
+			m_free(n);
+			error = ENOBUFS;
+			goto bad;
+		}
+		memcpy(mtod(n, void *), mtod(m, void *), hlen);
+		n->m_len = hlen;
+		n->m_pkthdr.len = hlen + len;
+		n->m_pkthdr.tso_segsz = 0;
+		csum_flags = 0;
+
+		th = (struct tcphdr *)(mtod(n, char *) + ehlen + iphlen);
+		th->th_seq = htonl(seq + (off - hlen));
+		if (off + len < m->m_pkthdr.len)
+			th->th_flags &= ~(TH_FIN | TH_PUSH);
+		if (!first)
+			th->th_flags &= ~TH_CWR;
+
+		switch (etype) {
+#ifdef INET
+		case ETHERTYPE_IP:
+			ip = (struct ip *)(mtod(n, char *) + ehlen);
+			ip->ip_len = htons(iphlen + thoff + len);
+			ip->ip_id = htons(id);
+			ip->ip_sum = 0;
+			if ((ifp->if_hwassist & CSUM_IP) != 0)
+				csum_flags |= CSUM_IP;
+			else
+				ip->ip_sum = in_cksum_skip(n, ehlen + iphlen,
+				    ehlen);
+			th->th_sum = in_pseudo(ip->ip_src.s_addr,
+			    ip->ip_dst.s_addr,
+			    htons(thoff + len + IPPROTO_TCP));
+			if ((ifp->if_hwassist & CSUM_TCP) != 0) {
+				csum_flags |= CSUM_TCP;
+				n->m_pkthdr.csum_data =
+				    offsetof(struct tcphdr, th_sum);
+			} else
+				th->th_sum = in_cksum_skip(n, n->m_pkthdr.len,
+				    ehlen + iphlen);
+			++id;
+			break;
+#endif
+#ifdef INET6
+		case ETHERTYPE_IPV6:
+			ip6 = (struct ip6_hdr *)(mtod(n, char *) + ehlen);
+			ip6->ip6_plen = htons(thoff + len);
+			th->th_sum = in6_cksum_pseudo(ip6, thoff + len,
+			    IPPROTO_TCP, 0);
+			if ((ifp->if_hwassist & CSUM_TCP_IPV6) != 0) {
+				csum_flags |= CSUM_TCP_IPV6;
+				n->m_pkthdr.csum_data =
+				    offsetof(struct tcphdr, th_sum);
+			} else
+				th->th_sum = in_cksum_skip(n, n->m_pkthdr.len,
+				    ehlen + iphlen);
+			break;
+#endif
+		}
+		n->m_pkthdr.csum_flags = csum_flags;
+
+		error = (ifp->if_transmit)(ifp, n);
+		if (error != 0)
+			goto bad;
+
+		counter_u64_add(ether_gso_segments, 1);
+		first = 0;
+	}
+
+	m_freem(m);
+	return (0);
+
+bad:
+	counter_u64_add(ether_gso_failed, 1);
+	if (m != NULL)
+		m_freem(m);
+	return (error);
+}
@@ -0,0 +1,366 @@
+/**
+ * @file
+ *
+ * @ingroup rtems_bsd_rtems
+ *
+ * @brief RACK loss detection and tail loss probes for TCP.
+ */
+
+/*
+ * Copyright (c) 2026 embedded brains GmbH.  All rights reserved.
+ *
+ *  embedded brains GmbH
+ *  Dornierstr. 4
+ *  82178 Puchheim
+ *  Germany
+ *  <rtems@embedded-brains.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * The "rack" TCP function block is the default TCP stack with time based
+ * loss detection in the spirit of RACK and with tail loss probes (TLP),
+ * see RFC 8985.  It is selected per socket with the TCP_FUNCTION_BLK
+ * socket option or for all new sockets with the
+ * net.inet.tcp.functions_default sysctl.  The function block only sets
+ * TF2_RACK and TF2_TLP, the default stack checks these flags.
+ *
+ * RACK needs SACK.  If a duplicate ACK reports a hole, the hole is
+ * considered lost once it is outstanding for longer than the smoothed
+ * round-trip time plus a reordering window of a quarter of it.  The time
+ * the hole was sent is taken from the timestamp echoed by the receiver,
+ * which belongs to the last segment received in sequence.  Without
+ * timestamps it is estimated as one round-trip time before the first
+ * duplicate ACK.  Fast recovery is thus entered after the first duplicate
+ * ACK instead of the third if the reordering window expired, otherwise a
+ * reordering timer checks again when it expires.
+ *
+ * After new data was sent, the probe timeout (PTO) of two round-trip
+ * times replaces the retransmit timeout.  If the PTO expires, one segment
+ * of new data or otherwise the last segment is sent again.  The ACK of the
+ * probe either completes the exchange or reports the lost segments to
+ * RACK, so that short exchanges do not wait for the retransmit timeout.
+ *
+ * The reordering timer and the PTO use the retransmit timer, see
+ * TF2_RACK_REO and TF2_TLP_PTO.  Every other use of the retransmit timer
+ * clears these flags in tcp_timer_activate().
+ */
+
+#include <machine/rtems-bsd-kernel-space.h>
+
+#include <rtems/bsd/local/opt_inet.h>
+#include <rtems/bsd/local/opt_inet6.h>
+
+#include <sys/param.h>
+#include <sys/systm.h>
+#include <sys/kernel.h>
+#include <sys/mbuf.h>
+#include <sys/socket.h>
+#include <sys/socketvar.h>
+#include <sys/sysctl.h>
+
+#include <net/if.h>
+#include <net/if_var.h>
+#include <net/vnet.h>
+
+#include <netinet/in.h>
+#include <netinet/in_pcb.h>
+#include <netinet/tcp.h>
+#include <netinet/tcp_fsm.h>
+#include <netinet/tcp_seq.h>
+#include <netinet/tcp_timer.h>
+#include <netinet/tcp_var.h>
+#include <netinet/cc/cc.h>
+
+/* Worst case delayed ACK timer of the receiver, 200ms */
+#define	TCP_TLP_WCDELACK	(hz / 5)
+
+static SYSCTL_NODE(_net_inet_tcp, OID_AUTO, rack, CTLFLAG_RW, 0,
+    "TCP RACK loss detection");
+
+static VNET_DEFINE(int, tcp_rack_tlp) = 1;
+#define	V_tcp_rack_tlp			VNET(tcp_rack_tlp)
+SYSCTL_INT(_net_inet_tcp_rack, OID_AUTO, tlp, CTLFLAG_VNET | CTLFLAG_RW,
+    &VNET_NAME(tcp_rack_tlp), 0,
+    "Send tail loss probes on connections using the rack stack");
+
+static VNET_DEFINE(int, tcp_rack_tlp_min) = 10;
+#define	V_tcp_rack_tlp_min		VNET(tcp_rack_tlp_min)
+SYSCTL_INT(_net_inet_tcp_rack, OID_AUTO, tlp_min, CTLFLAG_VNET | CTLFLAG_RW,
+    &VNET_NAME(tcp_rack_tlp_min), 0,
+    "Minimum probe timeout in milliseconds");
+
+static void
+tcp_rack_fb_init(struct tcpcb *tp)
+{
+
+	tp->t_flags2 |= TF2_RACK;
+	if (V_tcp_rack_tlp)
+		tp->t_flags2 |= TF2_TLP;
+}
+
+static void
+tcp_rack_fb_fini(struct tcpcb *tp, int tcb_is_purged)
+{
+	int pending;
+
+	pending = tp->t_flags2 & (TF2_RACK_REO | TF2_TLP_PTO);
+	tp->t_flags2 &= ~(TF2_RACK | TF2_TLP | TF2_RACK_TS | TF2_RACK_REO |
+	    TF2_TLP_PTO | TF2_TLP_SENT);
+
+	/* The default stack only knows the retransmit timeout */
+	if (!tcb_is_purged && pending != 0)
+		tcp_timer_activate(tp, TT_REXMT, tp->t_rxtcur);
+}
+
+static int
+tcp_rack_handoff_ok(struct tcpcb *tp)
+{
+
+	/* The connection state is the one of the default stack */
+	(void)tp;
+	return (0);
+}
+
+static struct tcp_function_block tcp_rack_funcblk = {
+	.tfb_tcp_block_name = "rack",
+	.tfb_tcp_output = tcp_output,
+	.tfb_tcp_do_segment = tcp_do_segment,
+	.tfb_tcp_ctloutput = tcp_default_ctloutput,
+	.tfb_tcp_fb_init = tcp_rack_fb_init,
+	.tfb_tcp_fb_fini = tcp_rack_fb_fini,
+	.tfb_tcp_handoff_ok = tcp_rack_handoff_ok
+};
+
+static void
+tcp_rack_init(void *arg)
+{
+
+	(void)arg;
+	register_tcp_functions(&tcp_rack_funcblk, M_WAITOK);
+}
+SYSINIT(tcp_rack, SI_SUB_PROTO_IFATTACHDOMAIN, SI_ORDER_ANY, tcp_rack_init,
+    NULL);
+
+static int
+tcp_rack_srtt(const struct tcpcb *tp)
+{
+
+	return (max(tp->t_srtt >> TCP_RTT_SHIFT, 1));
+}
+
+/*
+ * Enters fast recovery like the third duplicate ACK does in
+ * tcp_do_segment().
+ */
+static void
+tcp_rack_recover(struct tcpcb *tp)
+{
+
+	tp->t_dupacks = tcprexmtthresh;
+	cc_cong_signal(tp, NULL, CC_NDUPACK);
+	tp->t_rtttime = 0;
+	TCPSTAT_INC(tcps_sack_recovery_episode);
+	TCPSTAT_INC(tcps_rack_recovery);
+	tp->sack_newdata = tp->snd_nxt;
+	if (CC_ALGO(tp)->cong_signal == NULL)
+		tp->snd_cwnd = tcp_maxseg(tp);
+	(void) tp->t_fb->tfb_tcp_output(tp);
+	if (!tcp_timer_active(tp, TT_REXMT))
+		tcp_timer_activate(tp, TT_REXMT, tp->t_rxtcur);
+}
+
+/*
+ * Returns true if the first hole is lost and fast recovery should be
+ * entered now.  Called for duplicate ACKs before the third one.
+ */
+int
+tcp_rack_dupack(struct tcpcb *tp, struct tcpopt *to)
+{
+	int srtt, delay;
+
+	INP_WLOCK_ASSERT(tp->t_inpcb);
+
+	if ((tp->t_flags2 & TF2_RACK) == 0 ||
+	    (tp->t_flags & TF_SACK_PERMIT) == 0 ||
+	    IN_FASTRECOVERY(tp->t_flags) || tp->t_rxtshift != 0 ||
+	    tp->t_srtt == 0 || TAILQ_EMPTY(&tp->snd_holes))
+		return (0);
+
+	srtt = tcp_rack_srtt(tp);
+	if ((tp->t_flags2 & TF2_RACK_TS) == 0 ||
+	    tp->t_rack_una != tp->snd_una) {
+		if ((to->to_flags & TOF_TS) != 0 && to->to_tsecr != 0)
+			tp->t_rack_ts = ticks -
+			    TCP_TS_TO_TICKS(tcp_ts_getticks() - to->to_tsecr);
+		else
+			tp->t_rack_ts = ticks - srtt;
+		tp->t_rack_una = tp->snd_una;
+		tp->t_flags2 |= TF2_RACK_TS;
+	}
+
+	delay = srtt + srtt / 4 - (int)(ticks - tp->t_rack_ts);
+	if (delay <= 0) {
+		tp->t_dupacks = tcprexmtthresh;
+		TCPSTAT_INC(tcps_rack_recovery);
+		return (1);
+	}
+
+	if ((tp->t_flags2 & TF2_RACK_REO) == 0) {
+		tcp_timer_activate(tp, TT_REXMT, delay);
+		tp->t_flags2 |= TF2_RACK_REO;
+	}
+	return (0);
+}
+
+/*
+ * Schedules the probe timeout for the current tail.
+ */
+void
+tcp_rack_arm_tlp(struct tcpcb *tp)
+{
+	int srtt, pto;
+
+	INP_WLOCK_ASSERT(tp->t_inpcb);
+
+	if ((tp->t_flags2 & (TF2_TLP | TF2_TLP_SENT)) != TF2_TLP ||
+	    (tp->t_flags & TF_SACK_PERMIT) == 0 ||
+	    !TCPS_HAVEESTABLISHED(tp->t_state) ||
+	    IN_RECOVERY(tp->t_flags) || tp->t_rxtshift != 0 ||
+	    tp->t_srtt == 0 || tp->snd_una == tp->snd_max ||
+	    !TAILQ_EMPTY(&tp->snd_holes) ||
+	    tcp_timer_active(tp, TT_PERSIST))
+		return;
+
+	srtt = tcp_rack_srtt(tp);
+	pto = 2 * srtt;
+	if (tp->snd_max - tp->snd_una <= tcp_maxseg(tp))
+		pto += TCP_TLP_WCDELACK;
+	pto = max(pto, max(V_tcp_rack_tlp_min * hz / 1000, 1));
+	if (pto >= tp->t_rxtcur)
+		return;
+
+	tcp_timer_activate(tp, TT_REXMT, pto);
+	tp->t_flags2 |= TF2_TLP_PTO;
+}
+
+/*
+ * Called for ACKs which advanced snd_una.
+ */
+void
+tcp_rack_ack(struct tcpcb *tp)
+{
+
+	INP_WLOCK_ASSERT(tp->t_inpcb);
+
+	if ((tp->t_flags2 & TF2_TLP_SENT) != 0 &&
+	    SEQ_GEQ(tp->snd_una, tp->t_tlp_high)) {
+		tp->t_flags2 &= ~TF2_TLP_SENT;
+		TCPSTAT_INC(tcps_tlp_acked);
+	}
+
+	if (tcp_timer_active(tp, TT_REXMT))
+		tcp_rack_arm_tlp(tp);
+}
+
+/*
+ * Sends one segment of new data, or the last segment again if there is
+ * no new data or the window does not allow it.
+ */
+static void
+tcp_rack_probe(struct tcpcb *tp)
+{
+	struct socket *so;
+	tcp_seq snd_max;
+	uint32_t snd_cwnd;
+	uint32_t flight;
+	u_int maxseg;
+	int avail;
+
+	so = tp->t_inpcb->inp_socket;
+	maxseg = tcp_maxseg(tp);
+	snd_max = tp->snd_max;
+	snd_cwnd = tp->snd_cwnd;
+	flight = tp->snd_max - tp->snd_una;
+
+	tp->t_flags2 |= TF2_TLP_SENT;
+	TCPSTAT_INC(tcps_tlp_probes);
+
+	SOCKBUF_LOCK(&so->so_snd);
+	avail = sbavail(&so->so_snd) - flight;
+	SOCKBUF_UNLOCK(&so->so_snd);
+
+	if (avail > 0 && tp->snd_nxt == tp->snd_max &&
+	    SEQ_LT(tp->snd_max, tp->snd_una + tp->snd_wnd)) {
+		tp->snd_cwnd = flight + maxseg;
+		(void) tp->t_fb->tfb_tcp_output(tp);
+	}
+
+	if (tp->snd_max == snd_max) {
+		tp->snd_nxt = tp->snd_max - min(flight, maxseg);
+		tp->snd_cwnd = flight;
+		/* Karn's rule, do not time a retransmitted segment */
+		tp->t_rtttime = 0;
+		(void) tp->t_fb->tfb_tcp_output(tp);
+		if (SEQ_LT(tp->snd_nxt, tp->snd_max))
+			tp->snd_nxt = tp->snd_max;
+	}
+
+	tp->snd_cwnd = snd_cwnd;
+	tp->t_tlp_high = tp->snd_max;
+}
+
+/*
+ * Called when the retransmit timer expired and stands for the reordering
+ * timer or the probe timeout.  Returns true if the expiration was
+ * handled, otherwise the retransmit timeout follows.
+ */
+int
+tcp_rack_timeout(struct tcpcb *tp)
+{
+
+	INP_WLOCK_ASSERT(tp->t_inpcb);
+
+	if ((tp->t_flags2 & TF2_RACK_REO) != 0) {
+		tp->t_flags2 &= ~TF2_RACK_REO;
+		TCPSTAT_INC(tcps_rack_reordertmo);
+		if (!IN_FASTRECOVERY(tp->t_flags) &&
+		    !TAILQ_EMPTY(&tp->snd_holes) &&
+		    tp->t_rack_una == tp->snd_una)
+			tcp_rack_recover(tp);
+		else if (tp->snd_una != tp->snd_max)
+			tcp_timer_activate(tp, TT_REXMT, tp->t_rxtcur);
+		return (1);
+	}
+
+	tp->t_flags2 &= ~TF2_TLP_PTO;
+	if (tp->snd_una == tp->snd_max)
+		return (1);
+
+	if (TCPS_HAVEESTABLISHED(tp->t_state) && !IN_RECOVERY(tp->t_flags))
+		tcp_rack_probe(tp);
+
+	if (!tcp_timer_active(tp, TT_REXMT))
+		tcp_timer_activate(tp, TT_REXMT, tp->t_rxtcur);
+	return (1);
+}
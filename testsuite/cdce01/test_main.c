@@ -0,0 +1,348 @@
+/*
+ * Copyright (c) 2026 embedded brains GmbH.  All rights reserved.
+ *
+ *  embedded brains GmbH
+ *  Dornierstr. 4
+ *  82178 Puchheim
+ *  Germany
+ *  <rtems@embedded-brains.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Throughput benchmark for the CDC NCM support of the cdce(4) USB Ethernet
+ * driver.  The test waits for the ue0 interface and sends TCP and UDP traffic
+ * to the discard service of NET_CFG_PEER_IP.  The TCP echo service of the
+ * peer is used to measure the receive path.  Each run is repeated for several
+ * NCM transmit hold-off times and prints the transfer block counters of the
+ * driver.
+ *
+ * The benchmark is meant for a dwc_otg gadget loopback, this is a cable
+ * between the dwc_otg OTG port and a host port of the same board.  LibBSD
+ * attaches the dwc_otg controller in host mode only and does not provide the
+ * USB device templates, so the NCM gadget side must be provided by other
+ * means, for example a Linux g_ncm gadget which runs the discard and echo
+ * services.
+ */
+
+#include <sys/param.h>
+#include <sys/socket.h>
+#include <sys/sysctl.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sysexits.h>
+#include <unistd.h>
+
+#include <machine/rtems-bsd-commands.h>
+
+#include <rtems.h>
+
+#define TEST_NAME "LIBBSD CDCE 1"
+
+#define IFNAME "ue0"
+
+#define DISCARD_PORT 9
+
+#define ECHO_PORT 7
+
+#define TCP_TOTAL (16 * 1024 * 1024)
+
+#define ECHO_TOTAL (4 * 1024 * 1024)
+
+#define UDP_COUNT 20000
+
+#define BUF_SIZE (64 * 1024)
+
+static uint8_t wbuf[BUF_SIZE];
+
+static uint8_t rbuf[BUF_SIZE];
+
+/* NCM transmit hold-off times in microseconds */
+static const int holdoffs[] = {
+	0,
+	100,
+	500
+};
+
+static const size_t udp_sizes[] = {
+	64,
+	512,
+	1472
+};
+
+static void
+wait_for_interface(void)
+{
+	int i;
+
+	for (i = 0; i < 300; ++i) {
+		rtems_status_code sc;
+
+		if (if_nametoindex(IFNAME) != 0)
+			return;
+
+		sc = rtems_task_wake_after(rtems_clock_get_ticks_per_second()
+		    / 10);
+		assert(sc == RTEMS_SUCCESSFUL);
+	}
+
+	printf("no %s interface, is a CDC NCM device attached?\n", IFNAME);
+	exit(1);
+}
+
+static void
+setup_interface(void)
+{
+	int exit_code;
+	char *ifcfg[] = {
+		"ifconfig",
+		IFNAME,
+		"inet",
+		NET_CFG_SELF_IP,
+		"netmask",
+		NET_CFG_NETMASK,
+		NULL
+	};
+
+	exit_code = rtems_bsd_command_ifconfig(RTEMS_BSD_ARGC(ifcfg), ifcfg);
+	assert(exit_code == EX_OK);
+}
+
+static void
+set_holdoff(int holdoff)
+{
+	int rv;
+
+	rv = sysctlbyname("hw.usb.cdce.ncm_tx_holdoff", NULL, NULL, &holdoff,
+	    sizeof(holdoff));
+	assert(rv == 0);
+}
+
+static u_int
+get_counter(const char *counter)
+{
+	char name[64];
+	size_t len;
+	u_int value;
+	int rv;
+
+	snprintf(name, sizeof(name), "dev.cdce.0.ncm.%s", counter);
+	len = sizeof(value);
+	rv = sysctlbyname(name, &value, &len, NULL, 0);
+	if (rv != 0)
+		return (0);
+
+	return (value);
+}
+
+static void
+print_counters(void)
+{
+	printf("  tx_ntb %u, tx_datagrams %u, tx_holdoff %u, rx_ntb %u, "
+	    "rx_ref %u, rx_copy %u\n", get_counter("tx_ntb"),
+	    get_counter("tx_datagrams"), get_counter("tx_holdoff"),
+	    get_counter("rx_ntb"), get_counter("rx_ref"),
+	    get_counter("rx_copy"));
+}
+
+static void
+print_rate(const char *what, int holdoff, size_t size, uint64_t bytes,
+    uint64_t ns)
+{
+	printf("%s: hold-off %3d us, size %5zu: %" PRIu64 " KiB/s\n", what,
+	    holdoff, size, ns != 0 ? (bytes * 1000000000) / (ns * 1024) : 0);
+}
+
+static int
+connect_peer(int type, in_port_t port)
+{
+	struct sockaddr_in addr;
+	int rv;
+	int sd;
+
+	sd = socket(PF_INET, type, 0);
+	assert(sd >= 0);
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_len = sizeof(addr);
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	rv = inet_pton(AF_INET, NET_CFG_PEER_IP, &addr.sin_addr);
+	assert(rv == 1);
+
+	rv = connect(sd, (const struct sockaddr *)&addr, sizeof(addr));
+	assert(rv == 0);
+
+	return (sd);
+}
+
+static void
+bench_tcp_tx(int holdoff)
+{
+	uint64_t t0;
+	size_t todo;
+	int rv;
+	int sd;
+
+	sd = connect_peer(SOCK_STREAM, DISCARD_PORT);
+	t0 = rtems_clock_get_uptime_nanoseconds();
+
+	for (todo = TCP_TOTAL; todo > 0; todo -= sizeof(wbuf)) {
+		ssize_t n;
+
+		n = write(sd, wbuf, sizeof(wbuf));
+		assert(n == (ssize_t)sizeof(wbuf));
+	}
+
+	print_rate("TCP transmit", holdoff, sizeof(wbuf), TCP_TOTAL,
+	    rtems_clock_get_uptime_nanoseconds() - t0);
+
+	rv = close(sd);
+	assert(rv == 0);
+}
+
+static void
+bench_udp_tx(int holdoff, size_t size)
+{
+	uint64_t bytes;
+	uint64_t t0;
+	int i;
+	int rv;
+	int sd;
+
+	sd = connect_peer(SOCK_DGRAM, DISCARD_PORT);
+	bytes = 0;
+	t0 = rtems_clock_get_uptime_nanoseconds();
+
+	for (i = 0; i < UDP_COUNT; ++i) {
+		ssize_t n;
+
+		/* Datagrams dropped due to a full interface queue are lost */
+		n = send(sd, wbuf, size, 0);
+		if (n == (ssize_t)size)
+			bytes += (uint64_t)n;
+	}
+
+	print_rate("UDP transmit", holdoff, size, bytes,
+	    rtems_clock_get_uptime_nanoseconds() - t0);
+
+	rv = close(sd);
+	assert(rv == 0);
+}
+
+static void
+echo_writer(rtems_task_argument arg)
+{
+	size_t todo;
+	int sd;
+
+	sd = (int)arg;
+
+	for (todo = ECHO_TOTAL; todo > 0; todo -= sizeof(wbuf)) {
+		ssize_t n;
+
+		n = write(sd, wbuf, sizeof(wbuf));
+		assert(n == (ssize_t)sizeof(wbuf));
+	}
+
+	rtems_task_exit();
+}
+
+static void
+bench_tcp_echo(int holdoff)
+{
+	rtems_status_code sc;
+	rtems_id id;
+	uint64_t t0;
+	size_t todo;
+	int rv;
+	int sd;
+
+	sd = connect_peer(SOCK_STREAM, ECHO_PORT);
+	t0 = rtems_clock_get_uptime_nanoseconds();
+
+	sc = rtems_task_create(rtems_build_name('E', 'C', 'H', 'O'),
+	    RTEMS_MAXIMUM_PRIORITY - 1, RTEMS_MINIMUM_STACK_SIZE,
+	    RTEMS_DEFAULT_MODES, RTEMS_FLOATING_POINT, &id);
+	assert(sc == RTEMS_SUCCESSFUL);
+
+	sc = rtems_task_start(id, echo_writer, (rtems_task_argument)sd);
+	assert(sc == RTEMS_SUCCESSFUL);
+
+	for (todo = ECHO_TOTAL; todo > 0; ) {
+		ssize_t n;
+
+		n = read(sd, rbuf, MIN(todo, sizeof(rbuf)));
+		assert(n > 0);
+		todo -= (size_t)n;
+	}
+
+	print_rate("TCP echo", holdoff, sizeof(rbuf), ECHO_TOTAL,
+	    rtems_clock_get_uptime_nanoseconds() - t0);
+
+	rv = close(sd);
+	assert(rv == 0);
+}
+
+static void
+test_main(void)
+{
+	size_t i;
+	size_t j;
+
+	for (i = 0; i < sizeof(wbuf); ++i)
+		wbuf[i] = (uint8_t)i;
+
+	wait_for_interface();
+	setup_interface();
+
+	for (i = 0; i < RTEMS_ARRAY_SIZE(holdoffs); ++i) {
+		set_holdoff(holdoffs[i]);
+
+		bench_tcp_tx(holdoffs[i]);
+		print_counters();
+
+		for (j = 0; j < RTEMS_ARRAY_SIZE(udp_sizes); ++j) {
+			bench_udp_tx(holdoffs[i], udp_sizes[j]);
+			print_counters();
+		}
+
+		bench_tcp_echo(holdoffs[i]);
+		print_counters();
+	}
+
+	exit(0);
+}
+
+#define DEFAULT_NETWORK_NO_INTERFACE_0
+
+#include <rtems/bsd/test/default-network-init.h>
+
+SYSINIT_DRIVER_REFERENCE(cdce, uhub);
@@ -273,6 +273,40 @@ test_wlanstats(void)
 	assert(rtems_resource_snapshot_check(&snapshot));
 }
 
+static void
+test_bootprof(void)
+{
+	rtems_resource_snapshot snapshot;
+	int exit_code;
+	char *bootprof[] = {
+		"bootprof",
+		NULL
+	};
+	char *bootprof_a[] = {
+		"bootprof",
+		"-a",
+		NULL
+	};
+	char *bootprof_x[] = {
+		"bootprof",
+		"-x",
+		NULL
+	};
+
+	exit_code = rtems_bsd_command_bootprof(ARGC(bootprof), bootprof);
+	assert(exit_code == EXIT_SUCCESS);
+
+	rtems_resource_snapshot_take(&snapshot);
+
+	exit_code = rtems_bsd_command_bootprof(ARGC(bootprof_a), bootprof_a);
+	assert(exit_code == EXIT_SUCCESS);
+
+	exit_code = rtems_bsd_command_bootprof(ARGC(bootprof_x), bootprof_x);
+	assert(exit_code == EXIT_FAILURE);
+
+	assert(rtems_resource_snapshot_check(&snapshot));
+}
+
 static void
 test_main(void)
 {
@@ -283,6 +317,7 @@ test_main(void)
 	test_ping6();
 	test_netstat();
 	test_wlanstats();
+	test_bootprof();
 
 	exit(0);
 }
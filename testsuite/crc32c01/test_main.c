@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2026 embedded brains GmbH.  All rights reserved.
+ *
+ *  embedded brains GmbH
+ *  Dornierstr. 4
+ *  82178 Puchheim
+ *  Germany
+ *  <rtems@embedded-brains.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Known answer and consistency tests for calculate_crc32c().  The results of
+ * the implementation selected at run time are compared with a bitwise
+ * reference for unaligned start addresses, lengths which are not a multiple
+ * of eight and buffers split across several calls.
+ */
+
+#include <machine/rtems-bsd-kernel-space.h>
+
+#include <sys/param.h>
+#include <sys/types.h>
+#include <sys/systm.h>
+#include <sys/libkern.h>
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <rtems.h>
+
+#define TEST_NAME "LIBBSD CRC32C 1"
+
+#define MAX_OFFSET 16
+
+#define MAX_LENGTH 256
+
+#define BENCH_SIZE 1500
+
+#define BENCH_COUNT 10000
+
+static unsigned char buf[MAX_OFFSET + MAX_LENGTH];
+
+static uint32_t
+crc32c_ref(uint32_t crc, const unsigned char *p, size_t len)
+{
+	int i;
+
+	while (len > 0) {
+		crc ^= *p++;
+		for (i = 0; i < 8; ++i)
+			crc = (crc >> 1) ^ (0x82f63b78 & -(crc & 1));
+		--len;
+	}
+
+	return (crc);
+}
+
+static uint32_t
+crc32c(const unsigned char *p, unsigned int len)
+{
+
+	return (~calculate_crc32c(0xffffffff, p, len));
+}
+
+static void
+test_known_answers(void)
+{
+	static const char check[] = "123456789";
+	unsigned char b[32];
+	size_t i;
+
+	puts("test known answers");
+
+	assert(crc32c((const unsigned char *)check, sizeof(check) - 1) ==
+	    0xe3069283);
+
+	/* RFC 3720, B.4 CRC Examples */
+	memset(b, 0, sizeof(b));
+	assert(crc32c(b, sizeof(b)) == 0x8a9136aa);
+	memset(b, 0xff, sizeof(b));
+	assert(crc32c(b, sizeof(b)) == 0x62a8ab43);
+	for (i = 0; i < sizeof(b); ++i)
+		b[i] = (unsigned char)i;
+	assert(crc32c(b, sizeof(b)) == 0x46dd794e);
+}
+
+static void
+test_offsets_and_lengths(void)
+{
+	size_t off;
+	size_t len;
+
+	puts("test unaligned offsets and lengths");
+
+	for (off = 0; off < MAX_OFFSET; ++off) {
+		for (len = 0; len <= MAX_LENGTH; ++len) {
+			assert(calculate_crc32c(0xffffffff, &buf[off], len) ==
+			    crc32c_ref(0xffffffff, &buf[off], len));
+		}
+	}
+}
+
+static void
+test_split_buffers(void)
+{
+	size_t off;
+	size_t a;
+	size_t b;
+
+	puts("test buffers split across calls");
+
+	for (off = 0; off < 8; ++off) {
+		const unsigned char *p;
+		uint32_t whole;
+
+		p = &buf[off];
+		whole = calculate_crc32c(0xffffffff, p, MAX_LENGTH);
+
+		for (a = 0; a <= MAX_LENGTH; a += 3) {
+			for (b = a; b <= MAX_LENGTH; b += 5) {
+				uint32_t crc;
+
+				crc = calculate_crc32c(0xffffffff, p, a);
+				crc = calculate_crc32c(crc, p + a, b - a);
+				crc = calculate_crc32c(crc, p + b,
+				    MAX_LENGTH - b);
+				assert(crc == whole);
+			}
+		}
+	}
+}
+
+static void
+bench_crc32c(void)
+{
+	unsigned char b[BENCH_SIZE];
+	uint64_t begin;
+	uint64_t delta;
+	uint32_t crc;
+	int i;
+
+	memset(b, 0x5a, sizeof(b));
+	crc = 0xffffffff;
+	begin = rtems_clock_get_uptime_nanoseconds();
+
+	for (i = 0; i < BENCH_COUNT; ++i)
+		crc = calculate_crc32c(crc, b, sizeof(b));
+
+	delta = rtems_clock_get_uptime_nanoseconds() - begin;
+
+	printf("crc32c: %" PRIu64 " ns per %i bytes (%08" PRIx32 ")\n",
+	    delta / BENCH_COUNT, BENCH_SIZE, crc);
+}
+
+static void
+test_main(void)
+{
+	size_t i;
+
+	for (i = 0; i < sizeof(buf); ++i)
+		buf[i] = (unsigned char)(i * 131 + 7);
+
+	test_known_answers();
+	test_offsets_and_lengths();
+	test_split_buffers();
+	bench_crc32c();
+
+	exit(0);
+}
+
+#include <rtems/bsd/test/default-init.h>
@@ -0,0 +1,417 @@
+/*
+ * Copyright (c) 2026 embedded brains GmbH.  All rights reserved.
+ *
+ *  embedded brains GmbH
+ *  Dornierstr. 4
+ *  82178 Puchheim
+ *  Germany
+ *  <rtems@embedded-brains.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Latency under load.  A bulk UDP sender saturates a 10Mbit/s dummynet
+ * pipe on one side of an epair(4) interface while small probe datagrams
+ * are sent to another port of the same destination.  The probes are
+ * captured with bpf(4) on the other side of the epair and their one way
+ * delay is reported for a plain FIFO pipe, the FQ-CoDel scheduler and the
+ * PIE AQM.  The probes must see a lower median delay with FQ-CoDel than
+ * with the FIFO, since they use a flow of their own.
+ */
+
+#include <sys/param.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <net/bpf.h>
+#include <net/ethernet.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <netinet/ip.h>
+#include <netinet/udp.h>
+#include <arpa/inet.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sysexits.h>
+#include <unistd.h>
+
+#include <machine/rtems-bsd-commands.h>
+#include <machine/rtems-bsd-rc-conf.h>
+
+#include <rtems.h>
+
+#define TEST_NAME "LIBBSD DUMMYNET 1"
+
+#define PIPE_COUNT 3
+
+#define BULK_PORT 9
+
+#define PROBE_PORT 7
+
+#define BULK_SIZE 1400
+
+#define PROBE_COUNT 200
+
+#define PROBE_INTERVAL_US 10000
+
+#define PROBE_MAGIC 0x444e5031
+
+typedef struct {
+	uint32_t magic;
+	uint32_t seq;
+	struct timeval sent;
+} probe;
+
+typedef struct {
+	volatile bool bulk_active;
+	int bulk_socket;
+	struct sockaddr_in bulk_dst;
+	uint32_t bulk_packets;
+	uint32_t latency_us[PROBE_COUNT];
+	size_t latency_count;
+	uint32_t median_us[PIPE_COUNT];
+	char bpf_buf[64 * 1024];
+} test_context;
+
+static test_context test_instance;
+
+static const char * const pipe_names[PIPE_COUNT] = {
+	"FIFO",
+	"FQ_CODEL",
+	"PIE"
+};
+
+static const char rc_conf_text[] =
+    "dummynet_enable=\"YES\"\n"
+    "dummynet_pipes=\"1 2 3\"\n"
+    "dummynet_pipe_1=\"bw 10Mbit/s queue 200\"\n"
+    "dummynet_pipe_1_ifname=\"epair0a\"\n"
+    "dummynet_pipe_2=\"bw 10Mbit/s queue 200 type fq_codel target 5ms\"\n"
+    "dummynet_pipe_2_ifname=\"epair1a\"\n"
+    "dummynet_pipe_3=\"bw 10Mbit/s queue 200 pie target 15ms\"\n"
+    "dummynet_pipe_3_ifname=\"epair2a\"\n"
+    "dummynet_accept=\"YES\"\n";
+
+static void
+ifconfig(char *ifname, char *arg0, char *arg1)
+{
+	char *argv[] = {
+		"ifconfig",
+		ifname,
+		arg0,
+		arg1,
+		NULL
+	};
+	int argc;
+	int exit_code;
+
+	argc = arg1 != NULL ? 4 : 3;
+	exit_code = rtems_bsd_command_ifconfig(argc, argv);
+	assert(exit_code == EX_OK);
+}
+
+static void
+dst_addr(struct sockaddr_in *sin, int i, int port)
+{
+	char addr[16];
+
+	snprintf(addr, sizeof(addr), "10.30.%d.2", i);
+	memset(sin, 0, sizeof(*sin));
+	sin->sin_len = sizeof(*sin);
+	sin->sin_family = AF_INET;
+	sin->sin_port = htons(port);
+	sin->sin_addr.s_addr = inet_addr(addr);
+}
+
+static void
+setup_network(void)
+{
+	char ifname[IFNAMSIZ];
+	char addr[16];
+	char lladdr[18];
+	char *arp[] = {
+		"arp",
+		"-s",
+		&addr[0],
+		&lladdr[0],
+		NULL
+	};
+	int exit_code;
+	int i;
+
+	for (i = 0; i < PIPE_COUNT; ++i) {
+		ifconfig("epair", "create", NULL);
+
+		snprintf(ifname, sizeof(ifname), "epair%da", i);
+		snprintf(addr, sizeof(addr), "10.30.%d.1/24", i);
+		ifconfig(ifname, addr, NULL);
+		ifconfig(ifname, "up", NULL);
+
+		snprintf(ifname, sizeof(ifname), "epair%db", i);
+		ifconfig(ifname, "up", NULL);
+
+		snprintf(addr, sizeof(addr), "10.30.%d.2", i);
+		snprintf(lladdr, sizeof(lladdr), "02:00:00:00:00:%02x", i);
+		exit_code = rtems_bsd_command_arp(RTEMS_BSD_ARGC(arp), arp);
+		assert(exit_code == EX_OK);
+	}
+
+	exit_code = rtems_bsd_run_rc_conf_script("internal", rc_conf_text, 15,
+	    true);
+	assert(exit_code == 0);
+}
+
+static void
+bulk_task(rtems_task_argument arg)
+{
+	test_context *ctx = (test_context *)arg;
+	char payload[BULK_SIZE];
+
+	memset(payload, 0, sizeof(payload));
+
+	while (true) {
+		ssize_t n;
+
+		if (!ctx->bulk_active) {
+			rtems_task_wake_after(1);
+			continue;
+		}
+
+		n = sendto(ctx->bulk_socket, payload, sizeof(payload), 0,
+		    (const struct sockaddr *)&ctx->bulk_dst,
+		    sizeof(ctx->bulk_dst));
+		if (n == (ssize_t)sizeof(payload))
+			++ctx->bulk_packets;
+		else
+			assert(errno == ENOBUFS);
+	}
+}
+
+static int
+open_bpf(int i)
+{
+	struct ifreq ifr;
+	struct timeval tv;
+	u_int on;
+	int fd;
+	int rv;
+
+	fd = open("/dev/bpf", O_RDWR);
+	assert(fd >= 0);
+
+	memset(&ifr, 0, sizeof(ifr));
+	snprintf(ifr.ifr_name, sizeof(ifr.ifr_name), "epair%db", i);
+	rv = ioctl(fd, BIOCSETIF, &ifr);
+	assert(rv == 0);
+
+	on = 1;
+	rv = ioctl(fd, BIOCIMMEDIATE, &on);
+	assert(rv == 0);
+
+	tv.tv_sec = 0;
+	tv.tv_usec = 1000;
+	rv = ioctl(fd, BIOCSRTIMEOUT, &tv);
+	assert(rv == 0);
+
+	return (fd);
+}
+
+static void
+collect_probes(test_context *ctx, int fd)
+{
+	ssize_t n;
+	char *p;
+
+	n = read(fd, ctx->bpf_buf, sizeof(ctx->bpf_buf));
+	if (n <= 0)
+		return;
+
+	p = ctx->bpf_buf;
+	while (p < ctx->bpf_buf + n) {
+		const struct bpf_hdr *bh = (const struct bpf_hdr *)p;
+		const char *frame = p + bh->bh_hdrlen;
+		const struct ether_header *eh;
+		const struct ip *ip;
+		const struct udphdr *uh;
+		probe pr;
+		int64_t delta;
+
+		p += BPF_WORDALIGN(bh->bh_hdrlen + bh->bh_caplen);
+
+		if (bh->bh_caplen < sizeof(*eh) + sizeof(*ip) + sizeof(*uh) +
+		    sizeof(pr))
+			continue;
+
+		eh = (const struct ether_header *)frame;
+		if (ntohs(eh->ether_type) != ETHERTYPE_IP)
+			continue;
+
+		ip = (const struct ip *)(eh + 1);
+		if (ip->ip_p != IPPROTO_UDP)
+			continue;
+
+		uh = (const struct udphdr *)((const char *)ip +
+		    (ip->ip_hl << 2));
+		if (ntohs(uh->uh_dport) != PROBE_PORT)
+			continue;
+
+		memcpy(&pr, uh + 1, sizeof(pr));
+		if (pr.magic != PROBE_MAGIC ||
+		    ctx->latency_count >= PROBE_COUNT)
+			continue;
+
+		delta = (int64_t)(bh->bh_tstamp.tv_sec - pr.sent.tv_sec) *
+		    1000000 + (bh->bh_tstamp.tv_usec - pr.sent.tv_usec);
+		if (delta < 0)
+			delta = 0;
+		ctx->latency_us[ctx->latency_count] = (uint32_t)delta;
+		++ctx->latency_count;
+	}
+}
+
+static int
+compare_latency(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *)a;
+	uint32_t y = *(const uint32_t *)b;
+
+	return (x < y ? -1 : (x > y ? 1 : 0));
+}
+
+static void
+test_pipe(test_context *ctx, int i)
+{
+	struct sockaddr_in probe_dst;
+	struct timeval start;
+	struct timeval now;
+	probe pr;
+	size_t count;
+	uint32_t seq;
+	int probe_socket;
+	int fd;
+
+	fd = open_bpf(i);
+
+	probe_socket = socket(PF_INET, SOCK_DGRAM, 0);
+	assert(probe_socket >= 0);
+	dst_addr(&probe_dst, i, PROBE_PORT);
+	dst_addr(&ctx->bulk_dst, i, BULK_PORT);
+
+	ctx->latency_count = 0;
+	ctx->bulk_packets = 0;
+	ctx->bulk_active = true;
+
+	/* Let the queue build up */
+	rtems_task_wake_after(rtems_clock_get_ticks_per_second());
+
+	for (seq = 0; seq < PROBE_COUNT; ++seq) {
+		ssize_t n;
+
+		pr.magic = PROBE_MAGIC;
+		pr.seq = seq;
+		gettimeofday(&pr.sent, NULL);
+		n = sendto(probe_socket, &pr, sizeof(pr), 0,
+		    (const struct sockaddr *)&probe_dst, sizeof(probe_dst));
+		assert(n == (ssize_t)sizeof(pr) || errno == ENOBUFS);
+
+		start = pr.sent;
+		do {
+			collect_probes(ctx, fd);
+			gettimeofday(&now, NULL);
+		} while ((now.tv_sec - start.tv_sec) * 1000000 +
+		    (now.tv_usec - start.tv_usec) < PROBE_INTERVAL_US);
+	}
+
+	ctx->bulk_active = false;
+
+	/* Drain the pipe */
+	gettimeofday(&start, NULL);
+	do {
+		collect_probes(ctx, fd);
+		gettimeofday(&now, NULL);
+	} while (now.tv_sec - start.tv_sec < 2);
+
+	close(probe_socket);
+	close(fd);
+
+	count = ctx->latency_count;
+	qsort(ctx->latency_us, count, sizeof(ctx->latency_us[0]),
+	    compare_latency);
+
+	printf("%-8s: %" PRIu32 " bulk packets, %zu of %d probes, ",
+	    pipe_names[i], ctx->bulk_packets, count, PROBE_COUNT);
+	assert(count > 0);
+	printf("p50 %" PRIu32 "us, p99 %" PRIu32 "us\n",
+	    ctx->latency_us[count / 2], ctx->latency_us[(count * 99) / 100]);
+	ctx->median_us[i] = ctx->latency_us[count / 2];
+}
+
+static void
+test_main(void)
+{
+	test_context *ctx = &test_instance;
+	rtems_status_code sc;
+	rtems_task_priority prio;
+	rtems_id id;
+	int i;
+
+	/* The bulk sender must only use the otherwise idle time */
+	sc = rtems_task_set_priority(RTEMS_SELF, 110, &prio);
+	assert(sc == RTEMS_SUCCESSFUL);
+
+	setup_network();
+
+	ctx->bulk_socket = socket(PF_INET, SOCK_DGRAM, 0);
+	assert(ctx->bulk_socket >= 0);
+
+	sc = rtems_task_create(rtems_build_name('B', 'U', 'L', 'K'), 200,
+	    RTEMS_MINIMUM_STACK_SIZE + BULK_SIZE, RTEMS_DEFAULT_MODES,
+	    RTEMS_DEFAULT_ATTRIBUTES, &id);
+	assert(sc == RTEMS_SUCCESSFUL);
+
+	sc = rtems_task_start(id, bulk_task, (rtems_task_argument)ctx);
+	assert(sc == RTEMS_SUCCESSFUL);
+
+	for (i = 0; i < PIPE_COUNT; ++i)
+		test_pipe(ctx, i);
+
+	assert(ctx->median_us[1] < ctx->median_us[0]);
+
+	sc = rtems_task_delete(id);
+	assert(sc == RTEMS_SUCCESSFUL);
+	close(ctx->bulk_socket);
+
+	exit(0);
+}
+
+#define RTEMS_BSD_CONFIG_NET_IF_EPAIR
+#define RTEMS_BSD_CONFIG_FIREWALL_DUMMYNET
+
+#include <rtems/bsd/test/default-init.h>
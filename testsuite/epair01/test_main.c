@@ -0,0 +1,238 @@
+/*
+ * Copyright (c) 2026 embedded brains GmbH.  All rights reserved.
+ *
+ *  embedded brains GmbH
+ *  Dornierstr. 4
+ *  82178 Puchheim
+ *  Germany
+ *  <rtems@embedded-brains.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Transmit microbenchmark.  UDP datagrams are sent through one side of an
+ * epair(4) interface to many neighbours with static ARP entries.  This
+ * exercises the route and link-level address lookups of the transmit path
+ * with an increasing number of concurrent senders.
+ */
+
+#include <sys/param.h>
+#include <sys/socket.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sysexits.h>
+#include <unistd.h>
+
+#include <machine/rtems-bsd-commands.h>
+
+#include <rtems.h>
+#include <rtems/test.h>
+
+#define TEST_NAME "LIBBSD EPAIR 1"
+
+#define CPU_COUNT 16
+
+#define NEIGHBOUR_COUNT 1024
+
+#define PAYLOAD_SIZE 64
+
+typedef struct {
+	rtems_test_parallel_context base;
+	int sockets[CPU_COUNT];
+	uint32_t packets[CPU_COUNT];
+	uint32_t nobufs[CPU_COUNT];
+	struct sockaddr_in neighbours[NEIGHBOUR_COUNT];
+} test_context;
+
+static test_context test_instance;
+
+static void
+neighbour_addr(char *buf, size_t size, int i)
+{
+
+	snprintf(buf, size, "10.10.%d.%d", 1 + i / 250, 1 + i % 250);
+}
+
+static void
+ifconfig(char *ifname, char *arg0, char *arg1)
+{
+	char *argv[] = {
+		"ifconfig",
+		ifname,
+		arg0,
+		arg1,
+		NULL
+	};
+	int argc;
+	int exit_code;
+
+	argc = arg1 != NULL ? 4 : 3;
+	exit_code = rtems_bsd_command_ifconfig(argc, argv);
+	assert(exit_code == EX_OK);
+}
+
+static void
+setup_network(test_context *ctx)
+{
+	char addr[16];
+	char lladdr[18];
+	char *arp[] = {
+		"arp",
+		"-s",
+		&addr[0],
+		&lladdr[0],
+		NULL
+	};
+	int exit_code;
+	int i;
+
+	ifconfig("epair", "create", NULL);
+	ifconfig("epair0a", "10.10.0.1/16", NULL);
+	ifconfig("epair0a", "up", NULL);
+	ifconfig("epair0b", "up", NULL);
+
+	for (i = 0; i < NEIGHBOUR_COUNT; ++i) {
+		struct sockaddr_in *sin;
+
+		neighbour_addr(addr, sizeof(addr), i);
+		snprintf(lladdr, sizeof(lladdr), "02:00:00:00:%02x:%02x",
+		    i >> 8, i & 0xff);
+		exit_code = rtems_bsd_command_arp(RTEMS_BSD_ARGC(arp), arp);
+		assert(exit_code == EX_OK);
+
+		sin = &ctx->neighbours[i];
+		sin->sin_len = sizeof(*sin);
+		sin->sin_family = AF_INET;
+		sin->sin_port = htons(9);
+		sin->sin_addr.s_addr = inet_addr(addr);
+	}
+}
+
+static rtems_interval
+test_init(rtems_test_parallel_context *base, void *arg, size_t active_workers)
+{
+	test_context *ctx = (test_context *)base;
+
+	memset(ctx->packets, 0, sizeof(ctx->packets));
+	memset(ctx->nobufs, 0, sizeof(ctx->nobufs));
+
+	return (5 * rtems_clock_get_ticks_per_second());
+}
+
+static void
+test_send_body(rtems_test_parallel_context *base, void *arg,
+    size_t active_workers, size_t worker_index)
+{
+	test_context *ctx = (test_context *)base;
+	char payload[PAYLOAD_SIZE];
+	int s = ctx->sockets[worker_index];
+	uint32_t i = worker_index * 97;
+	uint32_t packets = 0;
+	uint32_t nobufs = 0;
+
+	memset(payload, 0, sizeof(payload));
+
+	while (!rtems_test_parallel_stop_job(&ctx->base)) {
+		const struct sockaddr_in *sin;
+		ssize_t n;
+
+		sin = &ctx->neighbours[i % NEIGHBOUR_COUNT];
+		n = sendto(s, payload, sizeof(payload), 0,
+		    (const struct sockaddr *)sin, sizeof(*sin));
+		if (n == (ssize_t)sizeof(payload)) {
+			++packets;
+		} else {
+			assert(errno == ENOBUFS);
+			++nobufs;
+		}
+
+		++i;
+	}
+
+	ctx->packets[worker_index] = packets;
+	ctx->nobufs[worker_index] = nobufs;
+}
+
+static void
+test_fini(rtems_test_parallel_context *base, void *arg, size_t active_workers)
+{
+	test_context *ctx = (test_context *)base;
+	uint64_t packets = 0;
+	uint64_t nobufs = 0;
+	size_t i;
+
+	for (i = 0; i < active_workers; ++i) {
+		packets += ctx->packets[i];
+		nobufs += ctx->nobufs[i];
+	}
+
+	printf("senders %zu: %" PRIu64 " packets/s, %" PRIu64
+	    " ENOBUFS/s\n", active_workers, packets / 5, nobufs / 5);
+}
+
+static const rtems_test_parallel_job test_jobs[] = {
+	{
+		.init = test_init,
+		.body = test_send_body,
+		.fini = test_fini,
+		.cascade = true
+	}
+};
+
+static void
+test_main(void)
+{
+	test_context *ctx = &test_instance;
+	size_t i;
+
+	setup_network(ctx);
+
+	for (i = 0; i < rtems_get_processor_count(); ++i) {
+		ctx->sockets[i] = socket(PF_INET, SOCK_DGRAM, 0);
+		assert(ctx->sockets[i] >= 0);
+	}
+
+	printf("neighbours: %d\n", NEIGHBOUR_COUNT);
+	rtems_test_parallel(&ctx->base, NULL, &test_jobs[0],
+	    RTEMS_ARRAY_SIZE(test_jobs));
+
+	for (i = 0; i < rtems_get_processor_count(); ++i) {
+		close(ctx->sockets[i]);
+	}
+
+	exit(0);
+}
+
+#define CONFIGURE_MAXIMUM_PROCESSORS CPU_COUNT
+
+#define RTEMS_BSD_CONFIG_NET_IF_EPAIR
+
+#include <rtems/bsd/test/default-init.h>
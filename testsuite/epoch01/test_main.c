@@ -0,0 +1,257 @@
+/*
+ * Copyright (c) 2026 embedded brains GmbH.  All rights reserved.
+ *
+ *  embedded brains GmbH
+ *  Dornierstr. 4
+ *  82178 Puchheim
+ *  Germany
+ *  <rtems@embedded-brains.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Readers dereference a shared object in epoch sections while one worker
+ * replaces the object and retires the old one with epoch_call() or
+ * epoch_wait().  A retired object is poisoned before it is freed, so a
+ * reader which sees a poisoned object detected a premature reclamation.
+ */
+
+#include <machine/rtems-bsd-kernel-space.h>
+
+#include <sys/param.h>
+#include <sys/types.h>
+#include <sys/systm.h>
+#include <sys/epoch.h>
+#include <sys/malloc.h>
+
+#include <machine/atomic.h>
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <rtems.h>
+#include <rtems/test.h>
+
+#define TEST_NAME "LIBBSD EPOCH 1"
+
+#define CPU_COUNT 32
+
+#define OBJ_MAGIC 0x4f424a21
+
+typedef struct {
+	struct epoch_context ctx;
+	volatile uint32_t magic;
+} test_obj;
+
+typedef struct {
+	rtems_test_parallel_context base;
+	epoch_t epoch;
+	bool preempt;
+	test_obj *volatile obj;
+	volatile uint32_t retired;
+	uint64_t reads[CPU_COUNT];
+	uint64_t writes[CPU_COUNT];
+} test_context;
+
+static test_context test_instance;
+
+static test_obj *
+obj_alloc(void)
+{
+	test_obj *obj;
+
+	obj = malloc(sizeof(*obj), M_TEMP, M_WAITOK | M_ZERO);
+	obj->magic = OBJ_MAGIC;
+	return (obj);
+}
+
+static void
+obj_free(test_obj *obj)
+{
+
+	obj->magic = 0;
+	free(obj, M_TEMP);
+}
+
+static void
+obj_free_epoch(epoch_context_t ctx)
+{
+	test_context *ctx_test = &test_instance;
+
+	obj_free(__containerof(ctx, test_obj, ctx));
+	atomic_add_int(&ctx_test->retired, 1);
+}
+
+static void
+test_sequential(void)
+{
+	struct epoch_tracker et;
+	test_context *ctx = &test_instance;
+	test_obj *obj;
+
+	epoch_enter(global_epoch);
+	assert(in_epoch(global_epoch));
+	epoch_enter(global_epoch);
+	epoch_exit(global_epoch);
+	epoch_exit(global_epoch);
+	assert(!in_epoch(global_epoch));
+	epoch_wait(global_epoch);
+
+	epoch_enter_preempt(global_epoch_preempt, &et);
+	assert(in_epoch(global_epoch_preempt));
+	epoch_exit_preempt(global_epoch_preempt, &et);
+	assert(!in_epoch(global_epoch_preempt));
+	epoch_wait_preempt(global_epoch_preempt);
+
+	obj = obj_alloc();
+	epoch_call(global_epoch_preempt, &obj->ctx, obj_free_epoch);
+	while (ctx->retired == 0) {
+		rtems_task_wake_after(1);
+	}
+	ctx->retired = 0;
+}
+
+static rtems_interval
+test_init(rtems_test_parallel_context *base, void *arg, size_t active_workers)
+{
+	test_context *ctx = (test_context *)base;
+	size_t i;
+
+	for (i = 0; i < active_workers; ++i) {
+		ctx->reads[i] = 0;
+		ctx->writes[i] = 0;
+	}
+
+	return (rtems_clock_get_ticks_per_second());
+}
+
+static void
+test_body(rtems_test_parallel_context *base, void *arg,
+    size_t active_workers, size_t worker_index)
+{
+	test_context *ctx = (test_context *)base;
+	uint64_t reads = 0;
+	uint64_t writes = 0;
+
+	if (worker_index == 0 && active_workers > 1) {
+		while (!rtems_test_parallel_stop_job(&ctx->base)) {
+			test_obj *old;
+			test_obj *new;
+
+			old = ctx->obj;
+			new = obj_alloc();
+			atomic_thread_fence_rel();
+			ctx->obj = new;
+
+			if ((writes & 1) != 0) {
+				epoch_call(ctx->epoch, &old->ctx,
+				    obj_free_epoch);
+			} else {
+				if (ctx->preempt)
+					epoch_wait_preempt(ctx->epoch);
+				else
+					epoch_wait(ctx->epoch);
+				obj_free(old);
+			}
+
+			++writes;
+		}
+	} else {
+		while (!rtems_test_parallel_stop_job(&ctx->base)) {
+			struct epoch_tracker et;
+
+			if (ctx->preempt)
+				epoch_enter_preempt(ctx->epoch, &et);
+			else
+				epoch_enter(ctx->epoch);
+
+			assert(ctx->obj->magic == OBJ_MAGIC);
+
+			if (ctx->preempt)
+				epoch_exit_preempt(ctx->epoch, &et);
+			else
+				epoch_exit(ctx->epoch);
+
+			++reads;
+		}
+	}
+
+	ctx->reads[worker_index] = reads;
+	ctx->writes[worker_index] = writes;
+}
+
+static void
+test_fini(rtems_test_parallel_context *base, void *arg,
+    size_t active_workers)
+{
+	test_context *ctx = (test_context *)base;
+	uint64_t reads = 0;
+	uint64_t writes = 0;
+	size_t i;
+
+	for (i = 0; i < active_workers; ++i) {
+		reads += ctx->reads[i];
+		writes += ctx->writes[i];
+	}
+
+	printf("%s: processors %zu: %" PRIu64 " reads/s, %" PRIu64
+	    " writes/s\n", ctx->preempt ? "preempt" : "non-preempt",
+	    active_workers, reads, writes);
+}
+
+static const rtems_test_parallel_job test_jobs[] = {
+	{
+		.init = test_init,
+		.body = test_body,
+		.fini = test_fini,
+		.cascade = true
+	}
+};
+
+static void
+test_main(void)
+{
+	test_context *ctx = &test_instance;
+
+	test_sequential();
+
+	ctx->obj = obj_alloc();
+
+	ctx->epoch = global_epoch;
+	ctx->preempt = false;
+	rtems_test_parallel(&ctx->base, NULL, &test_jobs[0],
+	    RTEMS_ARRAY_SIZE(test_jobs));
+
+	ctx->epoch = global_epoch_preempt;
+	ctx->preempt = true;
+	rtems_test_parallel(&ctx->base, NULL, &test_jobs[0],
+	    RTEMS_ARRAY_SIZE(test_jobs));
+
+	exit(0);
+}
+
+#define CONFIGURE_MAXIMUM_PROCESSORS CPU_COUNT
+
+#include <rtems/bsd/test/default-init.h>
@@ -0,0 +1,507 @@
+/*
+ * Copyright (c) 2026 embedded brains GmbH.  All rights reserved.
+ *
+ *  embedded brains GmbH
+ *  Dornierstr. 4
+ *  82178 Puchheim
+ *  Germany
+ *  <rtems@embedded-brains.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * IPv4 forwarding through the flow cache of ip_tryforward().  Two epair(4)
+ * interfaces are attached to the router: epair0a (10.42.1.1/24) and epair1a
+ * (10.42.2.1/24).  The test injects UDP datagrams from a host on epair0b
+ * with bpf(4) and captures the forwarded frames on epair1b.  It checks the
+ * link-level destination taken from the cached header, the TTL and the
+ * net.flowtable.ip4.stat counters.  Changes of the ARP entry and of the
+ * route must invalidate the cached next hop, and net.flowtable.enable must
+ * bypass the cache.
+ */
+
+#include <sys/param.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/sysctl.h>
+#include <sys/time.h>
+#include <net/bpf.h>
+#include <net/ethernet.h>
+#include <net/flowtable.h>
+#include <net/if.h>
+#include <net/if_dl.h>
+#include <netinet/in.h>
+#include <netinet/ip.h>
+#include <netinet/udp.h>
+#include <arpa/inet.h>
+
+#include <assert.h>
+#include <fcntl.h>
+#include <ifaddrs.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sysexits.h>
+#include <unistd.h>
+
+#include <machine/rtems-bsd-commands.h>
+
+#include <rtems.h>
+
+#define TEST_NAME "LIBBSD FLOWTABLE 1"
+
+#define SRC_ADDR "10.42.1.2"
+
+#define SRC_LLADDR "02:00:00:00:42:01"
+
+#define DST_ADDR "10.42.2.2"
+
+#define DST_LLADDR "02:00:00:00:42:02"
+
+#define DST_LLADDR_2 "02:00:00:00:42:03"
+
+#define GW_ADDR "10.42.2.3"
+
+#define GW_LLADDR "02:00:00:00:42:04"
+
+#define REMOTE_ADDR "10.42.3.2"
+
+#define PORT 5002
+
+#define TTL 64
+
+#define PACKETS 8
+
+typedef struct {
+	int bpf_in;
+	int bpf_out;
+	uint8_t router_lladdr[2][ETHER_ADDR_LEN];
+	uint16_t ip_id;
+	char bpf_buf[4096];
+} test_context;
+
+static test_context test_instance;
+
+static void
+ifconfig(char *ifname, char *arg0, char *arg1)
+{
+	char *argv[] = {
+		"ifconfig",
+		ifname,
+		arg0,
+		arg1,
+		NULL
+	};
+	int argc;
+	int exit_code;
+
+	argc = arg1 != NULL ? 4 : 3;
+	exit_code = rtems_bsd_command_ifconfig(argc, argv);
+	assert(exit_code == EX_OK);
+}
+
+static void
+arp_set(char *addr, char *lladdr)
+{
+	char *argv[] = {
+		"arp",
+		"-s",
+		addr,
+		lladdr,
+		NULL
+	};
+	int exit_code;
+
+	exit_code = rtems_bsd_command_arp(RTEMS_BSD_ARGC(argv), argv);
+	assert(exit_code == EX_OK);
+}
+
+static void
+arp_delete(char *addr)
+{
+	char *argv[] = {
+		"arp",
+		"-d",
+		addr,
+		NULL
+	};
+	int exit_code;
+
+	exit_code = rtems_bsd_command_arp(RTEMS_BSD_ARGC(argv), argv);
+	assert(exit_code == EX_OK);
+}
+
+static void
+route(char *op, char *dst, char *gw)
+{
+	char *argv[] = {
+		"route",
+		op,
+		"-host",
+		dst,
+		gw,
+		NULL
+	};
+	int exit_code;
+
+	exit_code = rtems_bsd_command_route(RTEMS_BSD_ARGC(argv), argv);
+	assert(exit_code == EX_OK);
+}
+
+static void
+set_int(const char *name, int value)
+{
+	int rv;
+
+	rv = sysctlbyname(name, NULL, NULL, &value, sizeof(value));
+	assert(rv == 0);
+}
+
+static void
+get_stat(struct flowtable_stat *fs)
+{
+	size_t len;
+	int rv;
+
+	len = sizeof(*fs);
+	rv = sysctlbyname("net.flowtable.ip4.stat", fs, &len, NULL, 0);
+	assert(rv == 0);
+	assert(len == sizeof(*fs));
+}
+
+static void
+get_lladdr(const char *ifname, uint8_t *lladdr)
+{
+	struct ifaddrs *ifap;
+	struct ifaddrs *ifa;
+	int rv;
+
+	rv = getifaddrs(&ifap);
+	assert(rv == 0);
+
+	for (ifa = ifap; ifa != NULL; ifa = ifa->ifa_next) {
+		const struct sockaddr_dl *sdl;
+
+		if (ifa->ifa_addr == NULL ||
+		    ifa->ifa_addr->sa_family != AF_LINK ||
+		    strcmp(ifa->ifa_name, ifname) != 0)
+			continue;
+
+		sdl = (const struct sockaddr_dl *)ifa->ifa_addr;
+		assert(sdl->sdl_alen == ETHER_ADDR_LEN);
+		memcpy(lladdr, LLADDR(sdl), ETHER_ADDR_LEN);
+		freeifaddrs(ifap);
+		return;
+	}
+
+	assert(0);
+}
+
+static void
+setup_network(test_context *ctx)
+{
+
+	ifconfig("epair", "create", NULL);
+	ifconfig("epair", "create", NULL);
+	ifconfig("epair0a", "10.42.1.1/24", NULL);
+	ifconfig("epair0a", "up", NULL);
+	ifconfig("epair0b", "up", NULL);
+	ifconfig("epair1a", "10.42.2.1/24", NULL);
+	ifconfig("epair1a", "up", NULL);
+	ifconfig("epair1b", "up", NULL);
+
+	arp_set(DST_ADDR, DST_LLADDR);
+	arp_set(GW_ADDR, GW_LLADDR);
+	set_int("net.inet.ip.forwarding", 1);
+
+	get_lladdr("epair0a", ctx->router_lladdr[0]);
+	get_lladdr("epair1a", ctx->router_lladdr[1]);
+}
+
+static int
+open_bpf(test_context *ctx, const char *ifname)
+{
+	struct ifreq ifr;
+	struct timeval tv;
+	u_int val;
+	int fd;
+	int rv;
+
+	fd = open("/dev/bpf", O_RDWR);
+	assert(fd >= 0);
+
+	val = sizeof(ctx->bpf_buf);
+	rv = ioctl(fd, BIOCSBLEN, &val);
+	assert(rv == 0);
+
+	memset(&ifr, 0, sizeof(ifr));
+	strlcpy(ifr.ifr_name, ifname, sizeof(ifr.ifr_name));
+	rv = ioctl(fd, BIOCSETIF, &ifr);
+	assert(rv == 0);
+
+	val = 1;
+	rv = ioctl(fd, BIOCIMMEDIATE, &val);
+	assert(rv == 0);
+
+	rv = ioctl(fd, BIOCSHDRCMPLT, &val);
+	assert(rv == 0);
+
+	val = BPF_D_IN;
+	rv = ioctl(fd, BIOCSDIRECTION, &val);
+	assert(rv == 0);
+
+	tv.tv_sec = 0;
+	tv.tv_usec = 10000;
+	rv = ioctl(fd, BIOCSRTIMEOUT, &tv);
+	assert(rv == 0);
+
+	return (fd);
+}
+
+static uint16_t
+ip_cksum(const void *data, size_t len)
+{
+	const uint8_t *p = data;
+	uint32_t sum;
+
+	sum = 0;
+	while (len > 1) {
+		sum += ((uint32_t)p[0] << 8) | p[1];
+		p += 2;
+		len -= 2;
+	}
+
+	while ((sum >> 16) != 0)
+		sum = (sum & 0xffff) + (sum >> 16);
+
+	return ((uint16_t)~sum);
+}
+
+static void
+send_datagram(test_context *ctx, const char *dst)
+{
+	struct {
+		struct ether_header eh;
+		struct ip ip;
+		struct udphdr uh;
+		uint16_t id;
+	} __packed pkt;
+	struct ether_addr *ea;
+	ssize_t n;
+
+	memset(&pkt, 0, sizeof(pkt));
+	memcpy(pkt.eh.ether_dhost, ctx->router_lladdr[0], ETHER_ADDR_LEN);
+	ea = ether_aton(SRC_LLADDR);
+	assert(ea != NULL);
+	memcpy(pkt.eh.ether_shost, ea, ETHER_ADDR_LEN);
+	pkt.eh.ether_type = htons(ETHERTYPE_IP);
+
+	pkt.ip.ip_v = IPVERSION;
+	pkt.ip.ip_hl = sizeof(pkt.ip) >> 2;
+	pkt.ip.ip_len = htons(sizeof(pkt) - sizeof(pkt.eh));
+	pkt.ip.ip_id = htons(++ctx->ip_id);
+	pkt.ip.ip_ttl = TTL;
+	pkt.ip.ip_p = IPPROTO_UDP;
+	pkt.ip.ip_src.s_addr = inet_addr(SRC_ADDR);
+	pkt.ip.ip_dst.s_addr = inet_addr(dst);
+	pkt.ip.ip_sum = htons(ip_cksum(&pkt.ip, sizeof(pkt.ip)));
+
+	/* A zero checksum means no checksum for UDP over IPv4 */
+	pkt.uh.uh_sport = htons(PORT);
+	pkt.uh.uh_dport = htons(PORT);
+	pkt.uh.uh_ulen = htons(sizeof(pkt.uh) + sizeof(pkt.id));
+	pkt.id = htons(ctx->ip_id);
+
+	n = write(ctx->bpf_in, &pkt, sizeof(pkt));
+	assert(n == (ssize_t)sizeof(pkt));
+}
+
+/*
+ * Waits for the datagram sent last to show up on epair1b and checks that it
+ * was forwarded to @lladdr.
+ */
+static void
+receive_datagram(test_context *ctx, const char *dst, const char *lladdr)
+{
+	struct ether_addr *ea;
+	int retries;
+
+	ea = ether_aton(lladdr);
+	assert(ea != NULL);
+
+	for (retries = 0; retries < 100; ++retries) {
+		ssize_t n;
+		char *p;
+
+		n = read(ctx->bpf_out, ctx->bpf_buf, sizeof(ctx->bpf_buf));
+		if (n <= 0)
+			continue;
+
+		p = ctx->bpf_buf;
+		while (p < ctx->bpf_buf + n) {
+			const struct bpf_hdr *bh = (const struct bpf_hdr *)p;
+			const struct ether_header *eh;
+			const struct ip *ip;
+
+			eh = (const struct ether_header *)(p + bh->bh_hdrlen);
+			ip = (const struct ip *)(eh + 1);
+			p += BPF_WORDALIGN(bh->bh_hdrlen + bh->bh_caplen);
+
+			if (bh->bh_caplen < sizeof(*eh) + sizeof(*ip) ||
+			    ntohs(eh->ether_type) != ETHERTYPE_IP ||
+			    ip->ip_p != IPPROTO_UDP ||
+			    ntohs(ip->ip_id) != ctx->ip_id)
+				continue;
+
+			assert(memcmp(eh->ether_dhost, ea,
+			    ETHER_ADDR_LEN) == 0);
+			assert(memcmp(eh->ether_shost, ctx->router_lladdr[1],
+			    ETHER_ADDR_LEN) == 0);
+			assert(ip->ip_dst.s_addr == inet_addr(dst));
+			assert(ip->ip_ttl == TTL - 1);
+			assert(ip_cksum(ip, sizeof(*ip)) == 0);
+			return;
+		}
+	}
+
+	assert(0);
+}
+
+static void
+forward(test_context *ctx, const char *dst, const char *lladdr)
+{
+
+	send_datagram(ctx, dst);
+	receive_datagram(ctx, dst, lladdr);
+}
+
+static void
+test_hits(test_context *ctx)
+{
+	struct flowtable_stat before;
+	struct flowtable_stat after;
+	int i;
+
+	get_stat(&before);
+
+	for (i = 0; i < PACKETS; ++i)
+		forward(ctx, DST_ADDR, DST_LLADDR);
+
+	get_stat(&after);
+	assert(after.ft_lookups - before.ft_lookups == PACKETS);
+	assert(after.ft_hits + after.ft_misses -
+	    before.ft_hits - before.ft_misses == PACKETS);
+	assert(after.ft_inserts - before.ft_inserts ==
+	    after.ft_misses - before.ft_misses);
+	assert(after.ft_inserts > before.ft_inserts);
+	assert(after.ft_hits > before.ft_hits);
+}
+
+static void
+test_arp_change(test_context *ctx)
+{
+	struct flowtable_stat before;
+	struct flowtable_stat after;
+	int i;
+
+	arp_delete(DST_ADDR);
+	arp_set(DST_ADDR, DST_LLADDR_2);
+	get_stat(&before);
+
+	/* The cached link-level header must not be used any more */
+	for (i = 0; i < PACKETS; ++i)
+		forward(ctx, DST_ADDR, DST_LLADDR_2);
+
+	get_stat(&after);
+	assert(after.ft_misses > before.ft_misses);
+	assert(after.ft_hits > before.ft_hits);
+}
+
+static void
+test_route_change(test_context *ctx)
+{
+	struct flowtable_stat before;
+	struct flowtable_stat after;
+	int i;
+
+	route("add", REMOTE_ADDR, GW_ADDR);
+
+	for (i = 0; i < PACKETS; ++i)
+		forward(ctx, REMOTE_ADDR, GW_LLADDR);
+
+	get_stat(&before);
+	route("change", REMOTE_ADDR, DST_ADDR);
+
+	/* The cached next hop must not be used any more */
+	for (i = 0; i < PACKETS; ++i)
+		forward(ctx, REMOTE_ADDR, DST_LLADDR_2);
+
+	get_stat(&after);
+	assert(after.ft_misses > before.ft_misses);
+
+	route("delete", REMOTE_ADDR, DST_ADDR);
+}
+
+static void
+test_disable(test_context *ctx)
+{
+	struct flowtable_stat before;
+	struct flowtable_stat after;
+	int i;
+
+	set_int("net.flowtable.enable", 0);
+	get_stat(&before);
+
+	for (i = 0; i < PACKETS; ++i)
+		forward(ctx, DST_ADDR, DST_LLADDR_2);
+
+	get_stat(&after);
+	assert(after.ft_lookups == before.ft_lookups);
+	assert(after.ft_inserts == before.ft_inserts);
+	set_int("net.flowtable.enable", 1);
+}
+
+static void
+test_main(void)
+{
+	test_context *ctx = &test_instance;
+
+	setup_network(ctx);
+	ctx->bpf_in = open_bpf(ctx, "epair0b");
+	ctx->bpf_out = open_bpf(ctx, "epair1b");
+
+	test_hits(ctx);
+	test_arp_change(ctx);
+	test_route_change(ctx);
+	test_disable(ctx);
+
+	close(ctx->bpf_in);
+	close(ctx->bpf_out);
+	exit(0);
+}
+
+#define RTEMS_BSD_CONFIG_NET_IF_EPAIR
+
+#include <rtems/bsd/test/default-init.h>
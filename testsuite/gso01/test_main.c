@@ -0,0 +1,504 @@
+/*
+ * Copyright (c) 2026 embedded brains GmbH.  All rights reserved.
+ *
+ *  embedded brains GmbH
+ *  Dornierstr. 4
+ *  82178 Puchheim
+ *  Germany
+ *  <rtems@embedded-brains.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Bulk transfer over the software TSO (GSO) path of an epair(4) interface.
+ * A TCP client sends to a peer address which is mapped by a static ARP entry
+ * to the other side of the epair.  The test itself is the peer: it captures
+ * the segments with bpf(4) on epair0b, checks the frame size, the IP and TCP
+ * checksums and the payload, and injects the SYN-ACK and ACKs through the
+ * same bpf(4) device.  At the end net.link.ether.gso_segments must have
+ * increased.
+ */
+
+#include <sys/param.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/sysctl.h>
+#include <sys/time.h>
+#include <net/bpf.h>
+#include <net/ethernet.h>
+#include <net/if.h>
+#include <net/if_dl.h>
+#include <netinet/in.h>
+#include <netinet/ip.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include <assert.h>
+#include <fcntl.h>
+#include <ifaddrs.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sysexits.h>
+#include <unistd.h>
+
+#include <machine/rtems-bsd-commands.h>
+
+#include <rtems.h>
+
+#define TEST_NAME "LIBBSD GSO 1"
+
+#define SELF_ADDR "10.40.0.1"
+
+#define PEER_ADDR "10.40.0.2"
+
+#define PEER_LLADDR "02:00:00:00:40:02"
+
+#define PORT 5001
+
+#define MSS 1460
+
+#define WINDOW 32768
+
+#define TOTAL_SIZE (1024 * 1024)
+
+#define WRITE_SIZE (16 * 1024)
+
+#define PEER_ISS 1000
+
+typedef struct {
+	rtems_id main_task;
+	int bpf;
+	uint8_t self_lladdr[ETHER_ADDR_LEN];
+	uint8_t peer_lladdr[ETHER_ADDR_LEN];
+	in_port_t client_port;
+	uint32_t rcv_nxt;
+	uint32_t snd_nxt;
+	uint32_t data_start;
+	size_t received;
+	size_t frames;
+	bool fin;
+	uint8_t wbuf[WRITE_SIZE];
+	char bpf_buf[64 * 1024];
+} test_context;
+
+static test_context test_instance;
+
+static uint8_t
+pattern(size_t offset)
+{
+
+	return ((uint8_t)(offset * 7 + (offset >> 11)));
+}
+
+static void
+ifconfig(char *ifname, char *arg0, char *arg1)
+{
+	char *argv[] = {
+		"ifconfig",
+		ifname,
+		arg0,
+		arg1,
+		NULL
+	};
+	int argc;
+	int exit_code;
+
+	argc = arg1 != NULL ? 4 : 3;
+	exit_code = rtems_bsd_command_ifconfig(argc, argv);
+	assert(exit_code == EX_OK);
+}
+
+static void
+get_lladdr(const char *ifname, uint8_t *lladdr)
+{
+	struct ifaddrs *ifap;
+	struct ifaddrs *ifa;
+	int rv;
+
+	rv = getifaddrs(&ifap);
+	assert(rv == 0);
+
+	for (ifa = ifap; ifa != NULL; ifa = ifa->ifa_next) {
+		const struct sockaddr_dl *sdl;
+
+		if (ifa->ifa_addr == NULL ||
+		    ifa->ifa_addr->sa_family != AF_LINK ||
+		    strcmp(ifa->ifa_name, ifname) != 0)
+			continue;
+
+		sdl = (const struct sockaddr_dl *)ifa->ifa_addr;
+		assert(sdl->sdl_alen == ETHER_ADDR_LEN);
+		memcpy(lladdr, LLADDR(sdl), ETHER_ADDR_LEN);
+		freeifaddrs(ifap);
+		return;
+	}
+
+	assert(0);
+}
+
+static void
+setup_network(test_context *ctx)
+{
+	char *arp[] = {
+		"arp",
+		"-s",
+		PEER_ADDR,
+		PEER_LLADDR,
+		NULL
+	};
+	struct ether_addr *ea;
+	int exit_code;
+
+	ifconfig("epair", "create", NULL);
+	ifconfig("epair0a", SELF_ADDR "/24", NULL);
+	ifconfig("epair0a", "up", NULL);
+	ifconfig("epair0b", "up", NULL);
+
+	exit_code = rtems_bsd_command_arp(RTEMS_BSD_ARGC(arp), arp);
+	assert(exit_code == EX_OK);
+
+	get_lladdr("epair0a", ctx->self_lladdr);
+	ea = ether_aton(PEER_LLADDR);
+	assert(ea != NULL);
+	memcpy(ctx->peer_lladdr, ea, ETHER_ADDR_LEN);
+}
+
+static int
+open_bpf(void)
+{
+	struct ifreq ifr;
+	struct timeval tv;
+	u_int val;
+	int fd;
+	int rv;
+
+	fd = open("/dev/bpf", O_RDWR);
+	assert(fd >= 0);
+
+	val = sizeof(test_instance.bpf_buf);
+	rv = ioctl(fd, BIOCSBLEN, &val);
+	assert(rv == 0);
+
+	memset(&ifr, 0, sizeof(ifr));
+	strlcpy(ifr.ifr_name, "epair0b", sizeof(ifr.ifr_name));
+	rv = ioctl(fd, BIOCSETIF, &ifr);
+	assert(rv == 0);
+
+	val = 1;
+	rv = ioctl(fd, BIOCIMMEDIATE, &val);
+	assert(rv == 0);
+
+	rv = ioctl(fd, BIOCSHDRCMPLT, &val);
+	assert(rv == 0);
+
+	/* Do not capture the injected segments */
+	val = BPF_D_IN;
+	rv = ioctl(fd, BIOCSDIRECTION, &val);
+	assert(rv == 0);
+
+	tv.tv_sec = 0;
+	tv.tv_usec = 10000;
+	rv = ioctl(fd, BIOCSRTIMEOUT, &tv);
+	assert(rv == 0);
+
+	return (fd);
+}
+
+static uint32_t
+cksum_add(uint32_t sum, const void *data, size_t len)
+{
+	const uint8_t *p = data;
+
+	while (len > 1) {
+		sum += ((uint32_t)p[0] << 8) | p[1];
+		p += 2;
+		len -= 2;
+	}
+	if (len > 0)
+		sum += (uint32_t)p[0] << 8;
+
+	return (sum);
+}
+
+static uint16_t
+cksum_fold(uint32_t sum)
+{
+
+	while ((sum >> 16) != 0)
+		sum = (sum & 0xffff) + (sum >> 16);
+
+	return ((uint16_t)~sum);
+}
+
+static uint16_t
+tcp_cksum(const struct ip *ip, const void *th, size_t len)
+{
+	uint32_t sum;
+
+	sum = cksum_add(0, &ip->ip_src, sizeof(ip->ip_src));
+	sum = cksum_add(sum, &ip->ip_dst, sizeof(ip->ip_dst));
+	sum += IPPROTO_TCP;
+	sum += (uint32_t)len;
+
+	return (cksum_fold(cksum_add(sum, th, len)));
+}
+
+static void
+send_segment(test_context *ctx, uint8_t flags)
+{
+	struct {
+		struct ether_header eh;
+		struct ip ip;
+		struct tcphdr th;
+		uint8_t opt[4];
+	} __packed seg;
+	size_t tcplen;
+	ssize_t n;
+
+	memset(&seg, 0, sizeof(seg));
+	tcplen = sizeof(seg.th);
+	if ((flags & TH_SYN) != 0) {
+		seg.opt[0] = TCPOPT_MAXSEG;
+		seg.opt[1] = TCPOLEN_MAXSEG;
+		seg.opt[2] = MSS >> 8;
+		seg.opt[3] = MSS & 0xff;
+		tcplen += sizeof(seg.opt);
+	}
+
+	memcpy(seg.eh.ether_dhost, ctx->self_lladdr, ETHER_ADDR_LEN);
+	memcpy(seg.eh.ether_shost, ctx->peer_lladdr, ETHER_ADDR_LEN);
+	seg.eh.ether_type = htons(ETHERTYPE_IP);
+
+	seg.ip.ip_v = IPVERSION;
+	seg.ip.ip_hl = sizeof(seg.ip) >> 2;
+	seg.ip.ip_len = htons(sizeof(seg.ip) + tcplen);
+	seg.ip.ip_ttl = 64;
+	seg.ip.ip_p = IPPROTO_TCP;
+	seg.ip.ip_src.s_addr = inet_addr(PEER_ADDR);
+	seg.ip.ip_dst.s_addr = inet_addr(SELF_ADDR);
+	seg.ip.ip_sum = htons(cksum_fold(cksum_add(0, &seg.ip,
+	    sizeof(seg.ip))));
+
+	seg.th.th_sport = htons(PORT);
+	seg.th.th_dport = ctx->client_port;
+	seg.th.th_seq = htonl(ctx->snd_nxt);
+	seg.th.th_ack = htonl(ctx->rcv_nxt);
+	seg.th.th_off = tcplen >> 2;
+	seg.th.th_flags = flags;
+	seg.th.th_win = htons(WINDOW);
+	seg.th.th_sum = htons(tcp_cksum(&seg.ip, &seg.th, tcplen));
+
+	n = write(ctx->bpf, &seg, sizeof(seg.eh) + sizeof(seg.ip) + tcplen);
+	assert(n == (ssize_t)(sizeof(seg.eh) + sizeof(seg.ip) + tcplen));
+
+	if ((flags & (TH_SYN | TH_FIN)) != 0)
+		++ctx->snd_nxt;
+}
+
+static void
+input_segment(test_context *ctx, const uint8_t *frame, size_t caplen)
+{
+	const struct ether_header *eh;
+	const struct ip *ip;
+	const struct tcphdr *th;
+	const uint8_t *data;
+	size_t iplen;
+	size_t hlen;
+	size_t len;
+	uint32_t seq;
+	size_t i;
+
+	if (caplen < sizeof(*eh) + sizeof(*ip) + sizeof(*th))
+		return;
+
+	eh = (const struct ether_header *)frame;
+	if (ntohs(eh->ether_type) != ETHERTYPE_IP)
+		return;
+
+	ip = (const struct ip *)(eh + 1);
+	if (ip->ip_p != IPPROTO_TCP ||
+	    ip->ip_dst.s_addr != inet_addr(PEER_ADDR))
+		return;
+
+	/* The interface MTU applies to each segment */
+	iplen = ntohs(ip->ip_len);
+	assert(iplen <= ETHERMTU);
+	assert(caplen >= sizeof(*eh) + iplen);
+	assert(cksum_fold(cksum_add(0, ip, ip->ip_hl << 2)) == 0);
+
+	th = (const struct tcphdr *)((const uint8_t *)ip + (ip->ip_hl << 2));
+	assert(ntohs(th->th_dport) == PORT);
+	assert(tcp_cksum(ip, th, iplen - (ip->ip_hl << 2)) == 0);
+
+	++ctx->frames;
+	hlen = (ip->ip_hl << 2) + (th->th_off << 2);
+	len = iplen - hlen;
+	data = (const uint8_t *)ip + hlen;
+	seq = ntohl(th->th_seq);
+
+	if ((th->th_flags & TH_SYN) != 0) {
+		ctx->client_port = th->th_sport;
+		ctx->rcv_nxt = seq + 1;
+		ctx->data_start = seq + 1;
+		ctx->snd_nxt = PEER_ISS;
+		send_segment(ctx, TH_SYN | TH_ACK);
+		return;
+	}
+
+	if (seq == ctx->rcv_nxt && len > 0) {
+		size_t offset;
+
+		offset = seq - ctx->data_start;
+		assert(offset + len <= TOTAL_SIZE);
+		for (i = 0; i < len; ++i)
+			assert(data[i] == pattern(offset + i));
+
+		ctx->rcv_nxt += len;
+		ctx->received += len;
+	}
+
+	if ((th->th_flags & TH_FIN) != 0 && seq + len == ctx->rcv_nxt &&
+	    !ctx->fin) {
+		ctx->fin = true;
+		++ctx->rcv_nxt;
+		send_segment(ctx, TH_FIN | TH_ACK);
+		return;
+	}
+
+	/* Acknowledge everything, duplicates included */
+	if (len > 0 || (th->th_flags & TH_FIN) != 0)
+		send_segment(ctx, TH_ACK);
+}
+
+static void
+client_task(rtems_task_argument arg)
+{
+	test_context *ctx = (test_context *)arg;
+	struct sockaddr_in addr;
+	rtems_status_code sc;
+	size_t offset;
+	size_t i;
+	int rv;
+	int s;
+
+	s = socket(PF_INET, SOCK_STREAM, 0);
+	assert(s >= 0);
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_len = sizeof(addr);
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(PORT);
+	addr.sin_addr.s_addr = inet_addr(PEER_ADDR);
+	rv = connect(s, (const struct sockaddr *)&addr, sizeof(addr));
+	assert(rv == 0);
+
+	for (offset = 0; offset < TOTAL_SIZE; offset += WRITE_SIZE) {
+		ssize_t n;
+
+		for (i = 0; i < WRITE_SIZE; ++i)
+			ctx->wbuf[i] = pattern(offset + i);
+
+		n = write(s, ctx->wbuf, WRITE_SIZE);
+		assert(n == WRITE_SIZE);
+	}
+
+	rv = close(s);
+	assert(rv == 0);
+
+	sc = rtems_event_transient_send(ctx->main_task);
+	assert(sc == RTEMS_SUCCESSFUL);
+	rtems_task_exit();
+}
+
+static uint64_t
+get_gso_segments(void)
+{
+	uint64_t value;
+	size_t len;
+	int rv;
+
+	len = sizeof(value);
+	rv = sysctlbyname("net.link.ether.gso_segments", &value, &len, NULL,
+	    0);
+	assert(rv == 0);
+
+	return (value);
+}
+
+static void
+test_main(void)
+{
+	test_context *ctx = &test_instance;
+	rtems_status_code sc;
+	rtems_id id;
+	uint64_t gso_segments;
+
+	setup_network(ctx);
+	ctx->bpf = open_bpf();
+	ctx->main_task = rtems_task_self();
+	gso_segments = get_gso_segments();
+
+	sc = rtems_task_create(rtems_build_name('C', 'L', 'N', 'T'),
+	    RTEMS_MAXIMUM_PRIORITY - 1, RTEMS_MINIMUM_STACK_SIZE,
+	    RTEMS_DEFAULT_MODES, RTEMS_DEFAULT_ATTRIBUTES, &id);
+	assert(sc == RTEMS_SUCCESSFUL);
+
+	sc = rtems_task_start(id, client_task, (rtems_task_argument)ctx);
+	assert(sc == RTEMS_SUCCESSFUL);
+
+	while (!ctx->fin) {
+		ssize_t n;
+		char *p;
+
+		n = read(ctx->bpf, ctx->bpf_buf, sizeof(ctx->bpf_buf));
+		if (n <= 0)
+			continue;
+
+		p = ctx->bpf_buf;
+		while (p < ctx->bpf_buf + n) {
+			const struct bpf_hdr *bh = (const struct bpf_hdr *)p;
+
+			input_segment(ctx, (const uint8_t *)p + bh->bh_hdrlen,
+			    bh->bh_caplen);
+			p += BPF_WORDALIGN(bh->bh_hdrlen + bh->bh_caplen);
+		}
+	}
+
+	sc = rtems_event_transient_receive(RTEMS_WAIT, RTEMS_NO_TIMEOUT);
+	assert(sc == RTEMS_SUCCESSFUL);
+
+	assert(ctx->received == TOTAL_SIZE);
+	printf("%zu bytes in %zu frames, %" PRIu64 " GSO segments\n",
+	    ctx->received, ctx->frames, get_gso_segments() - gso_segments);
+	assert(get_gso_segments() > gso_segments);
+
+	close(ctx->bpf);
+	exit(0);
+}
+
+#define RTEMS_BSD_CONFIG_NET_IF_EPAIR
+
+#include <rtems/bsd/test/default-init.h>
@@ -367,6 +367,7 @@ Init(rtems_task_argument arg)
   &rtems_shell_TCPDUMP_Command, \
   &rtems_shell_SYSCTL_Command, \
   &rtems_shell_VMSTAT_Command, \
+  &rtems_shell_BOOTPROF_Command, \
   &rtems_shell_WLANSTATS_Command
 
 #define CONFIGURE_SHELL_COMMAND_CPUUSE
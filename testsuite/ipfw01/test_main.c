@@ -0,0 +1,286 @@
+/*
+ * Copyright (c) 2026 embedded brains GmbH.  All rights reserved.
+ *
+ *  embedded brains GmbH
+ *  Dornierstr. 4
+ *  82178 Puchheim
+ *  Germany
+ *  <rtems@embedded-brains.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <machine/rtems-bsd-kernel-space.h>
+
+#include <sys/param.h>
+#include <sys/types.h>
+#include <sys/systm.h>
+#include <sys/malloc.h>
+#include <sys/socket.h>
+
+#include <net/if.h>
+#include <netinet/in.h>
+#include <netinet/ip_var.h>
+#include <netinet/ip_fw.h>
+
+#include <netpfil/ipfw/ip_fw_private.h>
+#include <netpfil/ipfw/ip_fw_table.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <rtems.h>
+
+#define TEST_NAME "LIBBSD IPFW 1"
+
+#define PREFIX_COUNT 100000
+
+#define LOOKUP_COUNT 1000000
+
+#define VERIFY_COUNT 100000
+
+extern struct table_algo addr_radix;
+
+extern struct table_algo addr_dir;
+
+typedef struct {
+	struct table_algo *ta;
+	void *ta_state;
+	struct table_info ti;
+} test_table;
+
+static uint32_t rnd_state = 1;
+
+static uint32_t
+rnd(void)
+{
+
+	rnd_state = rnd_state * 1664525 + 1013904223;
+	return (rnd_state);
+}
+
+/*
+ * Prefixes are taken from 10.0.0.0/12 so that the tables look like a
+ * block list of one provider: mostly hosts and small networks.
+ */
+static void
+make_prefix(in_addr_t *addr, uint8_t *masklen)
+{
+	static const uint8_t lens[] = { 32, 32, 32, 32, 32, 30, 28, 24, 24,
+	    22, 20, 16 };
+	uint32_t a;
+	uint8_t len;
+
+	len = lens[rnd() % nitems(lens)];
+	a = 0x0a000000 | (rnd() & 0x000fffff);
+	a &= 0xffffffff << (32 - len);
+
+	*addr = htonl(a);
+	*masklen = len;
+}
+
+static in_addr_t
+make_key(void)
+{
+
+	return (htonl(0x0a000000 | (rnd() & 0x001fffff)));
+}
+
+static void
+table_init(test_table *t, struct table_algo *ta)
+{
+	int error;
+
+	memset(t, 0, sizeof(*t));
+	t->ta = ta;
+	error = (*ta->init)(NULL, &t->ta_state, &t->ti, NULL, 0);
+	assert(error == 0);
+}
+
+static int
+table_op(test_table *t, in_addr_t addr, uint8_t masklen, uint32_t value,
+    bool add)
+{
+	struct table_algo *ta;
+	struct tentry_info tei;
+	char ta_buf[128];
+	uint64_t pflags;
+	uint32_t num;
+	int error;
+
+	ta = t->ta;
+	assert(ta->ta_buf_size <= sizeof(ta_buf));
+
+	if (add && ta->need_modify != NULL &&
+	    (*ta->need_modify)(t->ta_state, &t->ti, 1, &pflags) != 0) {
+		memset(ta_buf, 0, sizeof(ta_buf));
+		error = (*ta->prepare_mod)(ta_buf, &pflags);
+		assert(error == 0);
+		error = (*ta->fill_mod)(t->ta_state, &t->ti, ta_buf, &pflags);
+		assert(error == 0);
+		(*ta->modify)(t->ta_state, &t->ti, ta_buf, pflags);
+		(*ta->flush_mod)(ta_buf);
+	}
+
+	memset(&tei, 0, sizeof(tei));
+	tei.paddr = &addr;
+	tei.masklen = masklen;
+	tei.subtype = AF_INET;
+	tei.value = value;
+
+	memset(ta_buf, 0, sizeof(ta_buf));
+	if (add) {
+		error = (*ta->prepare_add)(NULL, &tei, ta_buf);
+		assert(error == 0);
+		error = (*ta->add)(t->ta_state, &t->ti, &tei, ta_buf, &num);
+	} else {
+		error = (*ta->prepare_del)(NULL, &tei, ta_buf);
+		assert(error == 0);
+		error = (*ta->del)(t->ta_state, &t->ti, &tei, ta_buf, &num);
+	}
+	(*ta->flush_entry)(NULL, &tei, ta_buf);
+
+	return (error);
+}
+
+static void
+fill_tables(test_table *radix, test_table *dir)
+{
+	in_addr_t addr;
+	uint8_t masklen;
+	uint32_t i;
+	int error_radix;
+	int error_dir;
+
+	rnd_state = 1;
+
+	for (i = 0; i < PREFIX_COUNT; ++i) {
+		make_prefix(&addr, &masklen);
+		error_radix = table_op(radix, addr, masklen, i, true);
+		error_dir = table_op(dir, addr, masklen, i, true);
+		assert(error_radix == error_dir);
+		assert(error_dir == 0 || error_dir == EEXIST);
+	}
+}
+
+static void
+remove_half(test_table *radix, test_table *dir)
+{
+	in_addr_t addr;
+	uint8_t masklen;
+	uint32_t i;
+	int error_radix;
+	int error_dir;
+
+	rnd_state = 1;
+
+	for (i = 0; i < PREFIX_COUNT; ++i) {
+		make_prefix(&addr, &masklen);
+		if ((i % 2) != 0)
+			continue;
+		error_radix = table_op(radix, addr, masklen, 0, false);
+		error_dir = table_op(dir, addr, masklen, 0, false);
+		assert(error_radix == error_dir);
+		assert(error_dir == 0 || error_dir == ENOENT);
+	}
+}
+
+static void
+verify_tables(test_table *radix, test_table *dir)
+{
+	in_addr_t key;
+	uint32_t val_radix;
+	uint32_t val_dir;
+	uint32_t i;
+	int match_radix;
+	int match_dir;
+
+	for (i = 0; i < VERIFY_COUNT; ++i) {
+		key = make_key();
+		val_radix = 0;
+		val_dir = 0;
+		match_radix = (*radix->ti.lookup)(&radix->ti, &key,
+		    sizeof(key), &val_radix);
+		match_dir = (*dir->ti.lookup)(&dir->ti, &key, sizeof(key),
+		    &val_dir);
+		assert(match_radix == match_dir);
+		assert(val_radix == val_dir);
+	}
+}
+
+static void
+bench_lookup(const char *name, test_table *t)
+{
+	static in_addr_t keys[1024];
+	uint64_t begin;
+	uint64_t delta;
+	uint32_t val;
+	uint32_t i;
+	uint32_t matches;
+
+	for (i = 0; i < nitems(keys); ++i)
+		keys[i] = make_key();
+
+	matches = 0;
+	begin = rtems_clock_get_uptime_nanoseconds();
+
+	for (i = 0; i < LOOKUP_COUNT; ++i)
+		matches += (*t->ti.lookup)(&t->ti,
+		    &keys[i % nitems(keys)], sizeof(keys[0]), &val);
+
+	delta = rtems_clock_get_uptime_nanoseconds() - begin;
+
+	printf("%s: %" PRIu32 " lookups, %" PRIu32 " matches, %" PRIu64
+	    " ns per lookup\n", name, (uint32_t)LOOKUP_COUNT, matches,
+	    delta / LOOKUP_COUNT);
+}
+
+static void
+test_main(void)
+{
+	test_table radix;
+	test_table dir;
+
+	table_init(&radix, &addr_radix);
+	table_init(&dir, &addr_dir);
+
+	fill_tables(&radix, &dir);
+	verify_tables(&radix, &dir);
+	bench_lookup(addr_radix.name, &radix);
+	bench_lookup(addr_dir.name, &dir);
+
+	remove_half(&radix, &dir);
+	verify_tables(&radix, &dir);
+	bench_lookup(addr_radix.name, &radix);
+	bench_lookup(addr_dir.name, &dir);
+
+	(*radix.ta->destroy)(radix.ta_state, &radix.ti);
+	(*dir.ta->destroy)(dir.ta_state, &dir.ti);
+
+	exit(0);
+}
+
+#include <rtems/bsd/test/default-init.h>
@@ -0,0 +1,288 @@
+/*
+ * Copyright (c) 2026 embedded brains GmbH.  All rights reserved.
+ *
+ *  embedded brains GmbH
+ *  Dornierstr. 4
+ *  82178 Puchheim
+ *  Germany
+ *  <rtems@embedded-brains.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Multicast receive cost for a socket with many group memberships.  A
+ * receiver socket joins N groups on the loopback interface and a sender
+ * transmits datagrams to the most recently joined group.  The average
+ * time to send and receive one datagram is reported for each N.  Some
+ * sockets bound to other ports are present, so that the delivery has to
+ * find the PCBs bound to the destination port.  The delivery is checked
+ * for groups which were never joined and for groups which were left.
+ */
+
+#include <sys/param.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sysexits.h>
+#include <unistd.h>
+
+#include <machine/rtems-bsd-commands.h>
+
+#include <rtems.h>
+
+#define TEST_NAME "LIBBSD MCAST 1"
+
+#define PORT 1234
+
+#define OTHER_SOCKET_COUNT 16
+
+#define DATAGRAM_COUNT 1000
+
+static const int group_counts[] = {
+	1,
+	64,
+	512
+};
+
+static void
+setup_network(void)
+{
+	char *lo0[] = {
+		"ifconfig",
+		"lo0",
+		"inet",
+		"127.0.0.1",
+		"netmask",
+		"255.0.0.0",
+		NULL
+	};
+	int exit_code;
+
+	exit_code = rtems_bsd_command_ifconfig(RTEMS_BSD_ARGC(lo0), lo0);
+	assert(exit_code == EX_OK);
+}
+
+static struct in_addr
+group_addr(int i)
+{
+	struct in_addr addr;
+
+	addr.s_addr = htonl(0xef010000 | (uint32_t)i);
+	return (addr);
+}
+
+static void
+set_membership(int s, int i, int optname)
+{
+	struct ip_mreq mreq;
+	int rv;
+
+	mreq.imr_multiaddr = group_addr(i);
+	mreq.imr_interface.s_addr = htonl(INADDR_LOOPBACK);
+	rv = setsockopt(s, IPPROTO_IP, optname, &mreq, sizeof(mreq));
+	assert(rv == 0);
+}
+
+static int
+open_socket(int port)
+{
+	struct sockaddr_in sin;
+	int rv;
+	int s;
+
+	s = socket(PF_INET, SOCK_DGRAM, 0);
+	assert(s >= 0);
+
+	memset(&sin, 0, sizeof(sin));
+	sin.sin_len = sizeof(sin);
+	sin.sin_family = AF_INET;
+	sin.sin_port = htons(port);
+	sin.sin_addr.s_addr = htonl(INADDR_ANY);
+	rv = bind(s, (const struct sockaddr *)&sin, sizeof(sin));
+	assert(rv == 0);
+
+	return (s);
+}
+
+static int
+open_sender(void)
+{
+	struct in_addr ifaddr;
+	u_char loop;
+	int rv;
+	int s;
+
+	s = open_socket(0);
+
+	ifaddr.s_addr = htonl(INADDR_LOOPBACK);
+	rv = setsockopt(s, IPPROTO_IP, IP_MULTICAST_IF, &ifaddr,
+	    sizeof(ifaddr));
+	assert(rv == 0);
+
+	loop = 1;
+	rv = setsockopt(s, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+	assert(rv == 0);
+
+	return (s);
+}
+
+static void
+send_to_group(int s, int i, uint32_t seq)
+{
+	struct sockaddr_in sin;
+	ssize_t n;
+
+	memset(&sin, 0, sizeof(sin));
+	sin.sin_len = sizeof(sin);
+	sin.sin_family = AF_INET;
+	sin.sin_port = htons(PORT);
+	sin.sin_addr = group_addr(i);
+	n = sendto(s, &seq, sizeof(seq), 0, (const struct sockaddr *)&sin,
+	    sizeof(sin));
+	assert(n == (ssize_t)sizeof(seq));
+}
+
+static uint32_t
+receive(int s)
+{
+	uint32_t seq;
+	ssize_t n;
+
+	n = recv(s, &seq, sizeof(seq), 0);
+	assert(n == (ssize_t)sizeof(seq));
+	return (seq);
+}
+
+static void
+expect_nothing(int s)
+{
+	uint32_t seq;
+	ssize_t n;
+	int flags;
+	int rv;
+
+	/* Give the loopback interface a chance to deliver */
+	usleep(10000);
+
+	flags = fcntl(s, F_GETFL, 0);
+	assert(flags >= 0);
+	rv = fcntl(s, F_SETFL, flags | O_NONBLOCK);
+	assert(rv == 0);
+
+	n = recv(s, &seq, sizeof(seq), 0);
+	assert(n == -1);
+	assert(errno == EAGAIN);
+
+	rv = fcntl(s, F_SETFL, flags);
+	assert(rv == 0);
+}
+
+static void
+test_groups(int group_count)
+{
+	uint64_t start;
+	uint64_t delta;
+	uint32_t seq;
+	int snd;
+	int rcv;
+	int rv;
+	int i;
+
+	rcv = open_socket(PORT);
+	snd = open_sender();
+
+	for (i = 0; i < group_count; ++i)
+		set_membership(rcv, i, IP_ADD_MEMBERSHIP);
+
+	start = rtems_clock_get_uptime_nanoseconds();
+
+	for (seq = 0; seq < DATAGRAM_COUNT; ++seq) {
+		send_to_group(snd, group_count - 1, seq);
+		assert(receive(rcv) == seq);
+	}
+
+	delta = rtems_clock_get_uptime_nanoseconds() - start;
+
+	printf("%4d groups: %d datagrams, %" PRIu64 "ns per datagram\n",
+	    group_count, DATAGRAM_COUNT, delta / DATAGRAM_COUNT);
+
+	/*
+	 * Leave every second group, the remaining ones must still match.
+	 * The loopback interface delivers in order, so a datagram to a
+	 * group which was never joined or which was left shows up before
+	 * the next expected one.
+	 */
+	for (i = 0; i < group_count; i += 2)
+		set_membership(rcv, i, IP_DROP_MEMBERSHIP);
+
+	send_to_group(snd, group_count, seq);
+
+	for (i = 0; i < group_count; ++i) {
+		++seq;
+		send_to_group(snd, i, seq);
+
+		if (i % 2 != 0)
+			assert(receive(rcv) == seq);
+	}
+
+	expect_nothing(rcv);
+
+	rv = close(snd);
+	assert(rv == 0);
+
+	rv = close(rcv);
+	assert(rv == 0);
+}
+
+static void
+test_main(void)
+{
+	int other[OTHER_SOCKET_COUNT];
+	size_t i;
+	int rv;
+
+	setup_network();
+
+	for (i = 0; i < nitems(other); ++i)
+		other[i] = open_socket(PORT + 1 + (int)i);
+
+	for (i = 0; i < nitems(group_counts); ++i)
+		test_groups(group_counts[i]);
+
+	for (i = 0; i < nitems(other); ++i) {
+		rv = close(other[i]);
+		assert(rv == 0);
+	}
+
+	exit(0);
+}
+
+#include <rtems/bsd/test/default-init.h>
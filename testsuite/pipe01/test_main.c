@@ -0,0 +1,395 @@
+/*
+ * Copyright (c) 2026 embedded brains GmbH.  All rights reserved.
+ *
+ *  embedded brains GmbH
+ *  Dornierstr. 4
+ *  82178 Puchheim
+ *  Germany
+ *  <rtems@embedded-brains.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Checks the data integrity of pipe(2) transfers and compares throughput
+ * and latency of the buffered mode with the direct write mode and adaptive
+ * buffer sizes.
+ */
+
+#include <sys/param.h>
+#include <sys/sysctl.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <rtems.h>
+
+#define TEST_NAME "LIBBSD PIPE 1"
+
+#define PRIO_MASTER 2
+
+#define PRIO_WORKER 2
+
+#define EVENT_THROUGHPUT RTEMS_EVENT_0
+
+#define EVENT_LATENCY RTEMS_EVENT_1
+
+#define EVENT_DONE RTEMS_EVENT_2
+
+#define TOTAL_SIZE (16 * 1024 * 1024)
+
+#define MAX_BLOCK_SIZE (64 * 1024)
+
+#define ROUND_TRIPS 10000
+
+typedef struct {
+	rtems_id master_task;
+	rtems_id worker_task;
+	int data[2];
+	int reply[2];
+	size_t block_size;
+	bool verify;
+	uint8_t wbuf[MAX_BLOCK_SIZE];
+	uint8_t rbuf[MAX_BLOCK_SIZE];
+} test_context;
+
+static test_context test_instance;
+
+static const size_t block_sizes[] = {
+	64,
+	512,
+	4096,
+	16384,
+	65536
+};
+
+static void
+set_sysctl(const char *name, int value)
+{
+	int rv;
+
+	rv = sysctlbyname(name, NULL, NULL, &value, sizeof(value));
+	assert(rv == 0);
+}
+
+static void
+send_events(rtems_id task, rtems_event_set events)
+{
+	rtems_status_code sc;
+
+	sc = rtems_event_send(task, events);
+	assert(sc == RTEMS_SUCCESSFUL);
+}
+
+static rtems_event_set
+receive_events(void)
+{
+	rtems_status_code sc;
+	rtems_event_set events;
+
+	sc = rtems_event_receive(RTEMS_ALL_EVENTS, RTEMS_EVENT_ANY | RTEMS_WAIT,
+	    RTEMS_NO_TIMEOUT, &events);
+	assert(sc == RTEMS_SUCCESSFUL);
+
+	return (events);
+}
+
+static void
+worker_throughput(test_context *ctx)
+{
+	size_t todo;
+
+	todo = TOTAL_SIZE;
+
+	while (todo > 0) {
+		ssize_t n;
+
+		n = read(ctx->data[0], ctx->rbuf, MIN(todo, ctx->block_size));
+		assert(n > 0);
+
+		if (ctx->verify) {
+			size_t offset;
+			size_t i;
+
+			offset = TOTAL_SIZE - todo;
+			for (i = 0; i < (size_t)n; ++i) {
+				assert(ctx->rbuf[i] ==
+				    ctx->wbuf[(offset + i) % sizeof(ctx->wbuf)]);
+			}
+		}
+
+		todo -= (size_t)n;
+	}
+}
+
+static void
+worker_latency(test_context *ctx)
+{
+	int i;
+
+	for (i = 0; i < ROUND_TRIPS; ++i) {
+		ssize_t n;
+		char c;
+
+		n = read(ctx->data[0], &c, sizeof(c));
+		assert(n == 1);
+		n = write(ctx->reply[1], &c, sizeof(c));
+		assert(n == 1);
+	}
+}
+
+static void
+worker_task(rtems_task_argument arg)
+{
+	test_context *ctx = (test_context *)arg;
+
+	while (true) {
+		rtems_event_set events;
+
+		events = receive_events();
+
+		if ((events & EVENT_THROUGHPUT) != 0)
+			worker_throughput(ctx);
+
+		if ((events & EVENT_LATENCY) != 0)
+			worker_latency(ctx);
+
+		send_events(ctx->master_task, EVENT_DONE);
+	}
+}
+
+static void
+test_integrity(test_context *ctx, size_t write_size, size_t read_size)
+{
+	size_t written;
+	size_t received;
+	size_t i;
+
+	for (i = 0; i < write_size; ++i)
+		ctx->wbuf[i] = (uint8_t)(i * 7 + write_size);
+
+	written = 0;
+	received = 0;
+	while (received < write_size) {
+		ssize_t n;
+
+		if (written < write_size) {
+			n = write(ctx->data[1], &ctx->wbuf[written],
+			    MIN(write_size - written, 4096));
+			assert(n > 0);
+			written += (size_t)n;
+		}
+
+		n = read(ctx->data[0], &ctx->rbuf[received],
+		    MIN(write_size - received, read_size));
+		assert(n > 0);
+		received += (size_t)n;
+	}
+
+	assert(memcmp(ctx->wbuf, ctx->rbuf, write_size) == 0);
+}
+
+static void
+test_direct_write_read(test_context *ctx)
+{
+	size_t i;
+
+	for (i = 0; i < sizeof(ctx->wbuf); ++i)
+		ctx->wbuf[i] = (uint8_t)(i * 13);
+
+	/* The worker reads the data of the direct writes in small blocks */
+	ctx->block_size = 1000;
+	ctx->verify = true;
+	send_events(ctx->worker_task, EVENT_THROUGHPUT);
+
+	for (i = 0; i < TOTAL_SIZE / sizeof(ctx->wbuf); ++i) {
+		ssize_t n;
+
+		n = write(ctx->data[1], ctx->wbuf, sizeof(ctx->wbuf));
+		assert(n == (ssize_t)sizeof(ctx->wbuf));
+	}
+
+	assert(receive_events() == EVENT_DONE);
+	ctx->verify = false;
+}
+
+static void
+test_throughput(test_context *ctx, const char *mode)
+{
+	size_t i;
+
+	for (i = 0; i < RTEMS_ARRAY_SIZE(block_sizes); ++i) {
+		uint64_t t0;
+		uint64_t t1;
+		size_t todo;
+
+		ctx->block_size = block_sizes[i];
+		todo = TOTAL_SIZE;
+
+		t0 = rtems_clock_get_uptime_nanoseconds();
+		send_events(ctx->worker_task, EVENT_THROUGHPUT);
+
+		while (todo > 0) {
+			ssize_t n;
+
+			n = write(ctx->data[1], ctx->wbuf,
+			    MIN(todo, ctx->block_size));
+			assert(n > 0);
+			todo -= (size_t)n;
+		}
+
+		assert(receive_events() == EVENT_DONE);
+		t1 = rtems_clock_get_uptime_nanoseconds();
+
+		printf("%s: block size %6zu: %" PRIu64 " KiB/s\n", mode,
+		    ctx->block_size, ((uint64_t)TOTAL_SIZE * 1000000000 /
+		    1024) / (t1 - t0 + 1));
+	}
+}
+
+static void
+test_latency(test_context *ctx, const char *mode)
+{
+	uint64_t t0;
+	uint64_t t1;
+	int i;
+
+	t0 = rtems_clock_get_uptime_nanoseconds();
+	send_events(ctx->worker_task, EVENT_LATENCY);
+
+	for (i = 0; i < ROUND_TRIPS; ++i) {
+		ssize_t n;
+		char c;
+
+		c = (char)i;
+		n = write(ctx->data[1], &c, sizeof(c));
+		assert(n == 1);
+		n = read(ctx->reply[0], &c, sizeof(c));
+		assert(n == 1);
+		assert(c == (char)i);
+	}
+
+	assert(receive_events() == EVENT_DONE);
+	t1 = rtems_clock_get_uptime_nanoseconds();
+
+	printf("%s: round trip latency %" PRIu64 " ns\n", mode,
+	    (t1 - t0) / ROUND_TRIPS);
+}
+
+static void
+open_pipes(test_context *ctx)
+{
+	int rv;
+
+	rv = pipe(ctx->data);
+	assert(rv == 0);
+	rv = pipe(ctx->reply);
+	assert(rv == 0);
+}
+
+static void
+close_pipes(test_context *ctx)
+{
+	int rv;
+
+	rv = close(ctx->data[0]);
+	assert(rv == 0);
+	rv = close(ctx->data[1]);
+	assert(rv == 0);
+	rv = close(ctx->reply[0]);
+	assert(rv == 0);
+	rv = close(ctx->reply[1]);
+	assert(rv == 0);
+}
+
+static void
+test_mode(test_context *ctx, const char *mode, int direct, int resize)
+{
+
+	set_sysctl("kern.ipc.pipedirectallowed", direct);
+	set_sysctl("kern.ipc.piperesizeallowed", resize);
+
+	/* New pipes start with the default buffer size */
+	open_pipes(ctx);
+	test_throughput(ctx, mode);
+	test_latency(ctx, mode);
+	close_pipes(ctx);
+}
+
+static void
+start_worker(test_context *ctx)
+{
+	rtems_status_code sc;
+
+	sc = rtems_task_create(
+		rtems_build_name('W', 'O', 'R', 'K'),
+		PRIO_WORKER,
+		RTEMS_MINIMUM_STACK_SIZE,
+		RTEMS_DEFAULT_MODES,
+		RTEMS_FLOATING_POINT,
+		&ctx->worker_task
+	);
+	assert(sc == RTEMS_SUCCESSFUL);
+
+	sc = rtems_task_start(
+		ctx->worker_task,
+		worker_task,
+		(rtems_task_argument) ctx
+	);
+	assert(sc == RTEMS_SUCCESSFUL);
+}
+
+static void
+test_main(void)
+{
+	test_context *ctx = &test_instance;
+	rtems_status_code sc;
+	rtems_task_priority prio;
+
+	sc = rtems_task_set_priority(RTEMS_SELF, PRIO_MASTER, &prio);
+	assert(sc == RTEMS_SUCCESSFUL);
+
+	ctx->master_task = rtems_task_self();
+	start_worker(ctx);
+
+	open_pipes(ctx);
+	test_integrity(ctx, 1, 1);
+	test_integrity(ctx, 4095, 100);
+	test_integrity(ctx, 20000, 3000);
+	test_integrity(ctx, MAX_BLOCK_SIZE, MAX_BLOCK_SIZE);
+	test_direct_write_read(ctx);
+	close_pipes(ctx);
+
+	test_mode(ctx, "buffered", 0, 0);
+	test_mode(ctx, "direct", 1, 0);
+	test_mode(ctx, "direct/resize", 1, 1);
+
+	exit(0);
+}
+
+#include <rtems/bsd/test/default-init.h>
@@ -0,0 +1,609 @@
+/*
+ * Copyright (c) 2026 embedded brains GmbH.  All rights reserved.
+ *
+ *  embedded brains GmbH
+ *  Dornierstr. 4
+ *  82178 Puchheim
+ *  Germany
+ *  <rtems@embedded-brains.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * IPv4 and IPv6 fragment reassembly.  The fragments of UDP datagrams are
+ * injected with bpf(4) on epair0b and the reassembled datagrams are received
+ * by a UDP socket bound to epair0a.  The fragment sequences cover in-order,
+ * out-of-order and overlapping fragments, a full reassembly hash bucket and a
+ * resize of the reassembly hash table with pending fragments.
+ */
+
+#include <sys/param.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/sysctl.h>
+#include <sys/time.h>
+#include <net/bpf.h>
+#include <net/ethernet.h>
+#include <net/if.h>
+#include <net/if_dl.h>
+#include <netinet/in.h>
+#include <netinet/ip.h>
+#include <netinet/ip6.h>
+#include <netinet/ip_var.h>
+#include <netinet/udp.h>
+#include <netinet6/ip6_var.h>
+#include <arpa/inet.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <ifaddrs.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sysexits.h>
+#include <unistd.h>
+
+#include <machine/rtems-bsd-commands.h>
+
+#include <rtems.h>
+
+#define TEST_NAME "LIBBSD REASS 1"
+
+#define SELF_ADDR "10.41.0.1"
+
+#define PEER_ADDR "10.41.0.2"
+
+#define SELF_ADDR6 "fd00:41::1"
+
+#define PEER_ADDR6 "fd00:41::2"
+
+#define PEER_LLADDR "02:00:00:00:41:02"
+
+#define PORT 7001
+
+#define PEER_PORT 7000
+
+#define DGRAM_SIZE 4000
+
+#define FRAG_SIZE 1000
+
+typedef struct {
+	int af;
+	int bpf;
+	int s;
+	uint8_t self_lladdr[ETHER_ADDR_LEN];
+	uint8_t peer_lladdr[ETHER_ADDR_LEN];
+	struct in_addr src;
+	struct in_addr dst;
+	struct in6_addr src6;
+	struct in6_addr dst6;
+	uint8_t dgram[DGRAM_SIZE];
+	uint8_t frame[ETHER_HDR_LEN + sizeof(struct ip6_hdr) +
+	    sizeof(struct ip6_frag) + DGRAM_SIZE];
+	uint8_t rbuf[DGRAM_SIZE];
+} test_context;
+
+static test_context test_instance;
+
+static void
+ifconfig(char *ifname, char *arg0, char *arg1)
+{
+	char *argv[] = {
+		"ifconfig",
+		ifname,
+		arg0,
+		arg1,
+		NULL
+	};
+	int argc;
+	int exit_code;
+
+	argc = arg1 != NULL ? 4 : 3;
+	exit_code = rtems_bsd_command_ifconfig(argc, argv);
+	assert(exit_code == EX_OK);
+}
+
+static void
+get_lladdr(const char *ifname, uint8_t *lladdr)
+{
+	struct ifaddrs *ifap;
+	struct ifaddrs *ifa;
+	int rv;
+
+	rv = getifaddrs(&ifap);
+	assert(rv == 0);
+
+	for (ifa = ifap; ifa != NULL; ifa = ifa->ifa_next) {
+		const struct sockaddr_dl *sdl;
+
+		if (ifa->ifa_addr == NULL ||
+		    ifa->ifa_addr->sa_family != AF_LINK ||
+		    strcmp(ifa->ifa_name, ifname) != 0)
+			continue;
+
+		sdl = (const struct sockaddr_dl *)ifa->ifa_addr;
+		assert(sdl->sdl_alen == ETHER_ADDR_LEN);
+		memcpy(lladdr, LLADDR(sdl), ETHER_ADDR_LEN);
+		freeifaddrs(ifap);
+		return;
+	}
+
+	assert(0);
+}
+
+static int
+get_int(const char *name)
+{
+	size_t len;
+	int value;
+	int rv;
+
+	len = sizeof(value);
+	rv = sysctlbyname(name, &value, &len, NULL, 0);
+	assert(rv == 0);
+
+	return (value);
+}
+
+static void
+set_int(const char *name, int value)
+{
+	int rv;
+
+	rv = sysctlbyname(name, NULL, NULL, &value, sizeof(value));
+	assert(rv == 0);
+}
+
+static void
+setup_network(test_context *ctx)
+{
+	struct ether_addr *ea;
+	char *argv[] = {
+		"ifconfig",
+		"epair",
+		"create",
+		NULL
+	};
+	int exit_code;
+	int rv;
+
+	exit_code = rtems_bsd_command_ifconfig(RTEMS_BSD_ARGC(argv), argv);
+	assert(exit_code == EX_OK);
+
+	/* The injected fragments must not wait for the address to settle */
+	set_int("net.inet6.ip6.dad_count", 0);
+
+	ifconfig("epair0a", "inet", SELF_ADDR "/24");
+	ifconfig("epair0a", "inet6", SELF_ADDR6 "/64");
+	ifconfig("epair0a", "up", NULL);
+	ifconfig("epair0b", "up", NULL);
+
+	get_lladdr("epair0a", ctx->self_lladdr);
+	ea = ether_aton(PEER_LLADDR);
+	assert(ea != NULL);
+	memcpy(ctx->peer_lladdr, ea, ETHER_ADDR_LEN);
+
+	rv = inet_pton(AF_INET, PEER_ADDR, &ctx->src);
+	assert(rv == 1);
+	rv = inet_pton(AF_INET, SELF_ADDR, &ctx->dst);
+	assert(rv == 1);
+	rv = inet_pton(AF_INET6, PEER_ADDR6, &ctx->src6);
+	assert(rv == 1);
+	rv = inet_pton(AF_INET6, SELF_ADDR6, &ctx->dst6);
+	assert(rv == 1);
+}
+
+static int
+open_bpf(void)
+{
+	struct ifreq ifr;
+	u_int val;
+	int fd;
+	int rv;
+
+	fd = open("/dev/bpf", O_RDWR);
+	assert(fd >= 0);
+
+	memset(&ifr, 0, sizeof(ifr));
+	strlcpy(ifr.ifr_name, "epair0b", sizeof(ifr.ifr_name));
+	rv = ioctl(fd, BIOCSETIF, &ifr);
+	assert(rv == 0);
+
+	val = 1;
+	rv = ioctl(fd, BIOCSHDRCMPLT, &val);
+	assert(rv == 0);
+
+	return (fd);
+}
+
+static uint32_t
+cksum_add(uint32_t sum, const void *data, size_t len)
+{
+	const uint8_t *p = data;
+
+	while (len > 1) {
+		sum += ((uint32_t)p[0] << 8) | p[1];
+		p += 2;
+		len -= 2;
+	}
+	if (len > 0)
+		sum += (uint32_t)p[0] << 8;
+
+	return (sum);
+}
+
+static uint16_t
+cksum_fold(uint32_t sum)
+{
+
+	while ((sum >> 16) != 0)
+		sum = (sum & 0xffff) + (sum >> 16);
+
+	return ((uint16_t)~sum);
+}
+
+static void
+open_socket(test_context *ctx, int af)
+{
+	struct sockaddr_storage ss;
+	struct timeval tv;
+	socklen_t len;
+	int rv;
+
+	ctx->af = af;
+	ctx->s = socket(af, SOCK_DGRAM, 0);
+	assert(ctx->s >= 0);
+
+	memset(&ss, 0, sizeof(ss));
+	if (af == AF_INET) {
+		struct sockaddr_in *sin = (struct sockaddr_in *)&ss;
+
+		sin->sin_len = sizeof(*sin);
+		sin->sin_family = AF_INET;
+		sin->sin_port = htons(PORT);
+		sin->sin_addr = ctx->dst;
+		len = sizeof(*sin);
+	} else {
+		struct sockaddr_in6 *sin6 = (struct sockaddr_in6 *)&ss;
+
+		sin6->sin6_len = sizeof(*sin6);
+		sin6->sin6_family = AF_INET6;
+		sin6->sin6_port = htons(PORT);
+		sin6->sin6_addr = ctx->dst6;
+		len = sizeof(*sin6);
+	}
+
+	rv = bind(ctx->s, (const struct sockaddr *)&ss, len);
+	assert(rv == 0);
+
+	tv.tv_sec = 0;
+	tv.tv_usec = 200000;
+	rv = setsockopt(ctx->s, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+	assert(rv == 0);
+}
+
+/*
+ * Build the UDP datagram of the given fragment identifier.  The payload
+ * depends on the identifier, so that the datagrams can be told apart.
+ */
+static void
+build_dgram(test_context *ctx, uint32_t id)
+{
+	struct udphdr *uh;
+	uint32_t sum;
+	size_t i;
+
+	uh = (struct udphdr *)&ctx->dgram[0];
+	uh->uh_sport = htons(PEER_PORT);
+	uh->uh_dport = htons(PORT);
+	uh->uh_ulen = htons(DGRAM_SIZE);
+	uh->uh_sum = 0;
+
+	for (i = sizeof(*uh); i < DGRAM_SIZE; ++i)
+		ctx->dgram[i] = (uint8_t)(id + i * 13);
+
+	/* The UDP checksum is mandatory for IPv6 */
+	if (ctx->af == AF_INET6) {
+		sum = cksum_add(0, &ctx->src6, sizeof(ctx->src6));
+		sum = cksum_add(sum, &ctx->dst6, sizeof(ctx->dst6));
+		sum += DGRAM_SIZE;
+		sum += IPPROTO_UDP;
+		sum = cksum_add(sum, ctx->dgram, DGRAM_SIZE);
+		uh->uh_sum = htons(cksum_fold(sum));
+		if (uh->uh_sum == 0)
+			uh->uh_sum = 0xffff;
+	}
+}
+
+static void
+send_frag(test_context *ctx, uint32_t id, size_t off, size_t len)
+{
+	struct ether_header *eh;
+	bool mf;
+	size_t n;
+	ssize_t rv;
+
+	assert(off % 8 == 0);
+	assert(off + len <= DGRAM_SIZE);
+	mf = off + len < DGRAM_SIZE;
+
+	eh = (struct ether_header *)&ctx->frame[0];
+	memcpy(eh->ether_dhost, ctx->self_lladdr, ETHER_ADDR_LEN);
+	memcpy(eh->ether_shost, ctx->peer_lladdr, ETHER_ADDR_LEN);
+	n = sizeof(*eh);
+
+	if (ctx->af == AF_INET) {
+		struct ip *ip = (struct ip *)&ctx->frame[n];
+
+		eh->ether_type = htons(ETHERTYPE_IP);
+		memset(ip, 0, sizeof(*ip));
+		ip->ip_v = IPVERSION;
+		ip->ip_hl = sizeof(*ip) >> 2;
+		ip->ip_len = htons(sizeof(*ip) + len);
+		ip->ip_id = htons((uint16_t)id);
+		ip->ip_off = htons((off >> 3) | (mf ? IP_MF : 0));
+		ip->ip_ttl = 64;
+		ip->ip_p = IPPROTO_UDP;
+		ip->ip_src = ctx->src;
+		ip->ip_dst = ctx->dst;
+		ip->ip_sum = htons(cksum_fold(cksum_add(0, ip, sizeof(*ip))));
+		n += sizeof(*ip);
+	} else {
+		struct ip6_hdr *ip6 = (struct ip6_hdr *)&ctx->frame[n];
+		struct ip6_frag *ip6f = (struct ip6_frag *)(ip6 + 1);
+
+		eh->ether_type = htons(ETHERTYPE_IPV6);
+		memset(ip6, 0, sizeof(*ip6) + sizeof(*ip6f));
+		ip6->ip6_vfc = IPV6_VERSION;
+		ip6->ip6_plen = htons(sizeof(*ip6f) + len);
+		ip6->ip6_nxt = IPPROTO_FRAGMENT;
+		ip6->ip6_hlim = 64;
+		ip6->ip6_src = ctx->src6;
+		ip6->ip6_dst = ctx->dst6;
+		ip6f->ip6f_nxt = IPPROTO_UDP;
+		ip6f->ip6f_offlg = htons((uint16_t)off) |
+		    (mf ? IP6F_MORE_FRAG : 0);
+		ip6f->ip6f_ident = htonl(id);
+		n += sizeof(*ip6) + sizeof(*ip6f);
+	}
+
+	memcpy(&ctx->frame[n], &ctx->dgram[off], len);
+	n += len;
+
+	rv = write(ctx->bpf, ctx->frame, n);
+	assert(rv == (ssize_t)n);
+}
+
+/*
+ * Send the datagram from the offset to its end in fragments which fit into
+ * the interface MTU.
+ */
+static void
+send_rest(test_context *ctx, uint32_t id, size_t off)
+{
+
+	for (; off < DGRAM_SIZE; off += FRAG_SIZE)
+		send_frag(ctx, id, off, MIN(FRAG_SIZE, DGRAM_SIZE - off));
+}
+
+static void
+expect_dgram(test_context *ctx, uint32_t id)
+{
+	ssize_t n;
+
+	build_dgram(ctx, id);
+	n = recv(ctx->s, ctx->rbuf, sizeof(ctx->rbuf), 0);
+	assert(n == DGRAM_SIZE - sizeof(struct udphdr));
+	assert(memcmp(ctx->rbuf, &ctx->dgram[sizeof(struct udphdr)],
+	    (size_t)n) == 0);
+}
+
+static void
+expect_nothing(test_context *ctx)
+{
+	ssize_t n;
+
+	n = recv(ctx->s, ctx->rbuf, sizeof(ctx->rbuf), 0);
+	assert(n == -1);
+	assert(errno == EAGAIN || errno == EWOULDBLOCK);
+}
+
+static uint64_t
+get_fragappended(test_context *ctx)
+{
+	size_t len;
+	int rv;
+
+	if (ctx->af == AF_INET) {
+		struct ipstat ips;
+
+		len = sizeof(ips);
+		rv = sysctlbyname("net.inet.ip.stats", &ips, &len, NULL, 0);
+		assert(rv == 0);
+		return (ips.ips_fragappended);
+	} else {
+		struct ip6stat ip6s;
+
+		len = sizeof(ip6s);
+		rv = sysctlbyname("net.inet6.ip6.stats", &ip6s, &len, NULL, 0);
+		assert(rv == 0);
+		return (ip6s.ip6s_fragappended);
+	}
+}
+
+static uint64_t
+get_reassbucketfull(test_context *ctx)
+{
+	size_t len;
+	int rv;
+
+	if (ctx->af == AF_INET) {
+		struct ipstat ips;
+
+		len = sizeof(ips);
+		rv = sysctlbyname("net.inet.ip.stats", &ips, &len, NULL, 0);
+		assert(rv == 0);
+		return (ips.ips_reassbucketfull);
+	} else {
+		struct ip6stat ip6s;
+
+		len = sizeof(ip6s);
+		rv = sysctlbyname("net.inet6.ip6.stats", &ip6s, &len, NULL, 0);
+		assert(rv == 0);
+		return (ip6s.ip6s_reassbucketfull);
+	}
+}
+
+static void
+test_in_order(test_context *ctx, uint32_t id)
+{
+	uint64_t appended;
+
+	appended = get_fragappended(ctx);
+	build_dgram(ctx, id);
+	send_rest(ctx, id, 0);
+	expect_dgram(ctx, id);
+	assert(get_fragappended(ctx) - appended ==
+	    DGRAM_SIZE / FRAG_SIZE - 1);
+}
+
+static void
+test_out_of_order(test_context *ctx, uint32_t id)
+{
+
+	build_dgram(ctx, id);
+	send_frag(ctx, id, 2 * FRAG_SIZE, FRAG_SIZE);
+	send_frag(ctx, id, 0, FRAG_SIZE);
+	expect_nothing(ctx);
+	send_frag(ctx, id, 3 * FRAG_SIZE, FRAG_SIZE);
+	send_frag(ctx, id, FRAG_SIZE, FRAG_SIZE);
+	expect_dgram(ctx, id);
+}
+
+/*
+ * IPv4 trims the parts of the second and third fragment which overlap their
+ * predecessor.  IPv6 drops the overlapping second fragment.  In both cases
+ * the remaining fragments complete the datagram.
+ */
+static void
+test_overlap(test_context *ctx, uint32_t id)
+{
+
+	build_dgram(ctx, id);
+	send_frag(ctx, id, 0, 1200);
+	send_frag(ctx, id, 800, 1200);
+	expect_nothing(ctx);
+	send_frag(ctx, id, 1200, 1000);
+	send_rest(ctx, id, 2200);
+	expect_dgram(ctx, id);
+}
+
+/*
+ * With a single hash bucket of two queues, the third datagram replaces the
+ * oldest queue.  A resize of the hash table keeps the pending queues.
+ */
+static void
+test_bucket(test_context *ctx, uint32_t id)
+{
+	const char *hashsize_name;
+	const char *bucketsize_name;
+	uint64_t bucketfull;
+	int hashsize;
+	int bucketsize;
+	uint32_t i;
+
+	if (ctx->af == AF_INET) {
+		hashsize_name = "net.inet.ip.reass_hashsize";
+		bucketsize_name = "net.inet.ip.maxfragbucketsize";
+	} else {
+		hashsize_name = "net.inet6.ip6.reass_hashsize";
+		bucketsize_name = "net.inet6.ip6.maxfragbucketsize";
+	}
+
+	hashsize = get_int(hashsize_name);
+	bucketsize = get_int(bucketsize_name);
+	set_int(hashsize_name, 1);
+	set_int(bucketsize_name, 2);
+	bucketfull = get_reassbucketfull(ctx);
+
+	for (i = 0; i < 3; ++i) {
+		build_dgram(ctx, id + i);
+		send_frag(ctx, id + i, 0, FRAG_SIZE);
+	}
+
+	assert(get_reassbucketfull(ctx) - bucketfull == 1);
+
+	for (i = 1; i < 3; ++i) {
+		build_dgram(ctx, id + i);
+		send_rest(ctx, id + i, FRAG_SIZE);
+		expect_dgram(ctx, id + i);
+	}
+
+	/* The first queue is gone, the rest starts a new queue */
+	build_dgram(ctx, id);
+	send_rest(ctx, id, FRAG_SIZE);
+	expect_nothing(ctx);
+
+	/* Complete it across a resize of the hash table */
+	send_frag(ctx, id, 0, 496);
+	set_int(hashsize_name, 64);
+	assert(get_int(hashsize_name) == 64);
+	send_frag(ctx, id, 496, FRAG_SIZE - 496);
+	expect_dgram(ctx, id);
+
+	set_int(hashsize_name, hashsize);
+	set_int(bucketsize_name, bucketsize);
+}
+
+static void
+test_reass(test_context *ctx, int af)
+{
+
+	open_socket(ctx, af);
+	test_in_order(ctx, 0x100);
+	test_out_of_order(ctx, 0x200);
+	test_overlap(ctx, 0x300);
+	test_bucket(ctx, 0x400);
+	close(ctx->s);
+}
+
+static void
+test_main(void)
+{
+	test_context *ctx = &test_instance;
+
+	setup_network(ctx);
+	ctx->bpf = open_bpf();
+
+	test_reass(ctx, AF_INET);
+	test_reass(ctx, AF_INET6);
+
+	close(ctx->bpf);
+	exit(0);
+}
+
+#define RTEMS_BSD_CONFIG_NET_IF_EPAIR
+
+#include <rtems/bsd/test/default-init.h>
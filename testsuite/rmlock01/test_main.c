@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) 2026 embedded brains GmbH.  All rights reserved.
+ *
+ *  embedded brains GmbH
+ *  Dornierstr. 4
+ *  82178 Puchheim
+ *  Germany
+ *  <rtems@embedded-brains.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Reader scaling test for rmlock(9).  An increasing number of processors
+ * acquire and release a read lock in a tight loop.  In a second job one
+ * worker is a writer and the readers verify that they never observe the
+ * protected data in an intermediate state.
+ */
+
+#include <machine/rtems-bsd-kernel-space.h>
+
+#include <sys/param.h>
+#include <sys/types.h>
+#include <sys/systm.h>
+#include <sys/lock.h>
+#include <sys/mutex.h>
+#include <sys/rmlock.h>
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <rtems.h>
+#include <rtems/test.h>
+
+#define TEST_NAME "LIBBSD RMLOCK 1"
+
+#define CPU_COUNT 32
+
+typedef struct {
+	rtems_test_parallel_context base;
+	struct rmlock rm;
+	struct rmlock rm_recurse;
+	volatile uint32_t data[2];
+	uint64_t reads[CPU_COUNT];
+	uint64_t writes[CPU_COUNT];
+} test_context;
+
+static test_context test_instance;
+
+static void
+test_sequential(test_context *ctx)
+{
+	struct rm_priotracker tracker;
+	struct rm_priotracker tracker2;
+	int rv;
+
+	rm_rlock(&ctx->rm, &tracker);
+	rm_runlock(&ctx->rm, &tracker);
+
+	rv = rm_try_rlock(&ctx->rm, &tracker);
+	assert(rv == 1);
+	rm_runlock(&ctx->rm, &tracker);
+
+	rm_wlock(&ctx->rm);
+	assert(rm_wowned(&ctx->rm));
+	rm_rlock(&ctx->rm, &tracker);
+	rm_runlock(&ctx->rm, &tracker);
+	rm_wunlock(&ctx->rm);
+	assert(!rm_wowned(&ctx->rm));
+
+	rm_rlock(&ctx->rm_recurse, &tracker);
+	rm_rlock(&ctx->rm_recurse, &tracker2);
+	rm_runlock(&ctx->rm_recurse, &tracker2);
+	rm_runlock(&ctx->rm_recurse, &tracker);
+
+	rm_wlock(&ctx->rm_recurse);
+	rm_wunlock(&ctx->rm_recurse);
+}
+
+static rtems_interval
+test_init(rtems_test_parallel_context *base, void *arg, size_t active_workers)
+{
+	test_context *ctx = (test_context *)base;
+	size_t i;
+
+	for (i = 0; i < active_workers; ++i) {
+		ctx->reads[i] = 0;
+		ctx->writes[i] = 0;
+	}
+
+	return (rtems_clock_get_ticks_per_second());
+}
+
+static void
+test_read_body(rtems_test_parallel_context *base, void *arg,
+    size_t active_workers, size_t worker_index)
+{
+	test_context *ctx = (test_context *)base;
+	uint64_t reads = 0;
+
+	while (!rtems_test_parallel_stop_job(&ctx->base)) {
+		struct rm_priotracker tracker;
+
+		rm_rlock(&ctx->rm, &tracker);
+		assert(ctx->data[0] == ctx->data[1]);
+		rm_runlock(&ctx->rm, &tracker);
+		++reads;
+	}
+
+	ctx->reads[worker_index] = reads;
+}
+
+static void
+test_read_write_body(rtems_test_parallel_context *base, void *arg,
+    size_t active_workers, size_t worker_index)
+{
+	test_context *ctx = (test_context *)base;
+	uint64_t writes = 0;
+
+	if (worker_index != 0) {
+		test_read_body(base, arg, active_workers, worker_index);
+		return;
+	}
+
+	while (!rtems_test_parallel_stop_job(&ctx->base)) {
+		rm_wlock(&ctx->rm);
+		++ctx->data[0];
+		++ctx->data[1];
+		rm_wunlock(&ctx->rm);
+		++writes;
+	}
+
+	ctx->writes[worker_index] = writes;
+}
+
+static void
+test_print(test_context *ctx, const char *name, size_t active_workers)
+{
+	uint64_t reads = 0;
+	uint64_t writes = 0;
+	size_t i;
+
+	for (i = 0; i < active_workers; ++i) {
+		reads += ctx->reads[i];
+		writes += ctx->writes[i];
+	}
+
+	printf("%s: processors %zu: %" PRIu64 " reads/s, %" PRIu64
+	    " writes/s\n", name, active_workers, reads, writes);
+}
+
+static void
+test_read_fini(rtems_test_parallel_context *base, void *arg,
+    size_t active_workers)
+{
+
+	test_print((test_context *)base, "read", active_workers);
+}
+
+static void
+test_read_write_fini(rtems_test_parallel_context *base, void *arg,
+    size_t active_workers)
+{
+
+	test_print((test_context *)base, "read/write", active_workers);
+}
+
+static const rtems_test_parallel_job test_jobs[] = {
+	{
+		.init = test_init,
+		.body = test_read_body,
+		.fini = test_read_fini,
+		.cascade = true
+	}, {
+		.init = test_init,
+		.body = test_read_write_body,
+		.fini = test_read_write_fini,
+		.cascade = true
+	}
+};
+
+static void
+test_main(void)
+{
+	test_context *ctx = &test_instance;
+
+	rm_init(&ctx->rm, "test");
+	rm_init_flags(&ctx->rm_recurse, "test recurse", RM_RECURSE);
+
+	test_sequential(ctx);
+
+	rtems_test_parallel(&ctx->base, NULL, &test_jobs[0],
+	    RTEMS_ARRAY_SIZE(test_jobs));
+
+	rm_destroy(&ctx->rm_recurse);
+	rm_destroy(&ctx->rm);
+
+	exit(0);
+}
+
+#define CONFIGURE_MAXIMUM_PROCESSORS CPU_COUNT
+
+#include <rtems/bsd/test/default-init.h>
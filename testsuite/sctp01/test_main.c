@@ -0,0 +1,276 @@
+/*
+ * Copyright (c) 2026 embedded brains GmbH.  All rights reserved.
+ *
+ *  embedded brains GmbH
+ *  Dornierstr. 4
+ *  82178 Puchheim
+ *  Germany
+ *  <rtems@embedded-brains.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Multi-association throughput over the loopback interface.  Each round
+ * opens a number of one-to-one style SCTP associations to a local server.
+ * A sender task per association writes messages as fast as it can and a
+ * receiver task per association reads them.  The aggregate throughput is
+ * reported for each round, so that a contention on global locks shows up
+ * as a throughput which does not scale with the count of associations.
+ */
+
+#include <sys/param.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sysexits.h>
+#include <unistd.h>
+
+#include <machine/rtems-bsd-commands.h>
+
+#include <rtems.h>
+
+#define TEST_NAME "LIBBSD SCTP 1"
+
+#define ASSOC_MAX 8
+
+#define MSG_SIZE 1024
+
+#define PORT 2905
+
+#define RUN_SECONDS 2
+
+typedef struct {
+	int client;
+	int server;
+	uint64_t bytes;
+} assoc;
+
+typedef struct {
+	volatile bool active;
+	rtems_id master;
+	int listener;
+	assoc assocs[ASSOC_MAX];
+} test_context;
+
+static test_context test_instance;
+
+static void
+ifconfig_lo0(void)
+{
+	char *lo0[] = {
+		"ifconfig",
+		"lo0",
+		"inet",
+		"127.0.0.1",
+		"netmask",
+		"255.0.0.0",
+		NULL
+	};
+	int exit_code;
+
+	exit_code = rtems_bsd_command_ifconfig(RTEMS_BSD_ARGC(lo0), lo0);
+	assert(exit_code == EX_OK);
+}
+
+static void
+server_addr(struct sockaddr_in *sin)
+{
+
+	memset(sin, 0, sizeof(*sin));
+	sin->sin_len = sizeof(*sin);
+	sin->sin_family = AF_INET;
+	sin->sin_port = htons(PORT);
+	sin->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+}
+
+static void
+start_task(rtems_task_entry entry, rtems_task_argument arg)
+{
+	rtems_status_code sc;
+	rtems_id id;
+
+	sc = rtems_task_create(rtems_build_name('S', 'C', 'T', 'P'), 120,
+	    RTEMS_MINIMUM_STACK_SIZE + MSG_SIZE, RTEMS_DEFAULT_MODES,
+	    RTEMS_DEFAULT_ATTRIBUTES, &id);
+	assert(sc == RTEMS_SUCCESSFUL);
+
+	sc = rtems_task_start(id, entry, arg);
+	assert(sc == RTEMS_SUCCESSFUL);
+}
+
+static void
+sender_task(rtems_task_argument arg)
+{
+	test_context *ctx = &test_instance;
+	assoc *as = &ctx->assocs[arg];
+	char msg[MSG_SIZE];
+	int rv;
+
+	memset(msg, (int)arg, sizeof(msg));
+
+	while (ctx->active) {
+		ssize_t n;
+
+		n = write(as->client, msg, sizeof(msg));
+		assert(n == (ssize_t)sizeof(msg));
+	}
+
+	rv = close(as->client);
+	assert(rv == 0);
+
+	rtems_task_delete(RTEMS_SELF);
+}
+
+static void
+receiver_task(rtems_task_argument arg)
+{
+	test_context *ctx = &test_instance;
+	assoc *as = &ctx->assocs[arg];
+	char msg[MSG_SIZE];
+	rtems_status_code sc;
+	ssize_t n;
+	int rv;
+
+	while ((n = read(as->server, msg, sizeof(msg))) > 0)
+		as->bytes += (uint64_t)n;
+
+	assert(n == 0);
+
+	rv = close(as->server);
+	assert(rv == 0);
+
+	sc = rtems_event_send(ctx->master, RTEMS_EVENT_0 << arg);
+	assert(sc == RTEMS_SUCCESSFUL);
+
+	rtems_task_delete(RTEMS_SELF);
+}
+
+static void
+run(test_context *ctx, int count)
+{
+	struct sockaddr_in sin;
+	rtems_status_code sc;
+	rtems_event_set events;
+	uint64_t start;
+	uint64_t delta;
+	uint64_t bytes;
+	int i;
+	int rv;
+
+	server_addr(&sin);
+
+	for (i = 0; i < count; ++i) {
+		assoc *as = &ctx->assocs[i];
+
+		as->client = socket(PF_INET, SOCK_STREAM, IPPROTO_SCTP);
+		assert(as->client >= 0);
+
+		rv = connect(as->client, (const struct sockaddr *)&sin,
+		    sizeof(sin));
+		assert(rv == 0);
+
+		as->server = accept(ctx->listener, NULL, NULL);
+		assert(as->server >= 0);
+
+		as->bytes = 0;
+	}
+
+	ctx->active = true;
+	start = rtems_clock_get_uptime_nanoseconds();
+
+	for (i = 0; i < count; ++i) {
+		start_task(receiver_task, (rtems_task_argument)i);
+		start_task(sender_task, (rtems_task_argument)i);
+	}
+
+	sc = rtems_task_wake_after(RUN_SECONDS *
+	    rtems_clock_get_ticks_per_second());
+	assert(sc == RTEMS_SUCCESSFUL);
+
+	ctx->active = false;
+
+	sc = rtems_event_receive((RTEMS_EVENT_0 << count) - 1,
+	    RTEMS_EVENT_ALL | RTEMS_WAIT, RTEMS_NO_TIMEOUT, &events);
+	assert(sc == RTEMS_SUCCESSFUL);
+
+	delta = rtems_clock_get_uptime_nanoseconds() - start;
+
+	bytes = 0;
+	for (i = 0; i < count; ++i)
+		bytes += ctx->assocs[i].bytes;
+
+	printf("%d association(s): %" PRIu64 " KiB in %" PRIu64
+	    "ms, %" PRIu64 " KiB/s\n", count, bytes / 1024,
+	    delta / 1000000, (bytes * 1000000000 / delta) / 1024);
+}
+
+static void
+test_main(void)
+{
+	test_context *ctx = &test_instance;
+	struct sockaddr_in sin;
+	rtems_status_code sc;
+	rtems_task_priority prio;
+	int count;
+	int rv;
+
+	/* The sender and receiver tasks must not be starved */
+	sc = rtems_task_set_priority(RTEMS_SELF, 110, &prio);
+	assert(sc == RTEMS_SUCCESSFUL);
+
+	ctx->master = rtems_task_self();
+
+	ifconfig_lo0();
+
+	ctx->listener = socket(PF_INET, SOCK_STREAM, IPPROTO_SCTP);
+	if (ctx->listener < 0) {
+		assert(errno == EPROTONOSUPPORT);
+		printf("SCTP is not enabled\n");
+		exit(0);
+	}
+
+	server_addr(&sin);
+	rv = bind(ctx->listener, (const struct sockaddr *)&sin, sizeof(sin));
+	assert(rv == 0);
+
+	rv = listen(ctx->listener, ASSOC_MAX);
+	assert(rv == 0);
+
+	for (count = 1; count <= ASSOC_MAX; count *= 2)
+		run(ctx, count);
+
+	rv = close(ctx->listener);
+	assert(rv == 0);
+
+	exit(0);
+}
+
+#include <rtems/bsd/test/default-init.h>
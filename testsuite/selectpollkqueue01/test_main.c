@@ -52,6 +52,7 @@
 
 #include <machine/rtems-bsd-commands.h>
 
+#include <rtems/bsd/kevent.h>
 #include <rtems/libcsupport.h>
 #include <rtems.h>
 
@@ -1026,6 +1027,173 @@ test_kqueue_user(test_context *ctx)
 	assert(rv == 0);
 }
 
+static void
+test_kqueue_rtems_event(test_context *ctx)
+{
+	static const struct timespec no_wait;
+	rtems_event_set events;
+	rtems_status_code sc;
+	struct kevent change;
+	struct kevent event;
+	int kq;
+	int rv;
+
+	puts("test kqueue RTEMS event");
+
+	kq = kqueue();
+	assert(kq >= 0);
+
+	EV_SET(&change, RTEMS_SELF, EVFILT_RTEMS_EVENT, EV_ADD | EV_ENABLE,
+	    RTEMS_EVENT_7 | RTEMS_EVENT_8, 0, TEST_UDATA);
+
+	rv = kevent(kq, &change, 1, NULL, 0, NULL);
+	assert(rv == 0);
+
+	sc = rtems_bsd_event_send(RTEMS_SELF, RTEMS_EVENT_7 | RTEMS_EVENT_9);
+	assert(sc == RTEMS_SUCCESSFUL);
+
+	memset(&event, 0, sizeof(event));
+	rv = kevent(kq, NULL, 0, &event, 1, NULL);
+	assert(rv == 1);
+	assert(event.ident == RTEMS_SELF);
+	assert(event.filter == EVFILT_RTEMS_EVENT);
+	assert(event.flags == EV_CLEAR);
+	assert(event.fflags == RTEMS_EVENT_7);
+	assert(event.udata == TEST_UDATA);
+
+	rv = kevent(kq, NULL, 0, &event, 1, &no_wait);
+	assert(rv == 0);
+
+	events = 0;
+	sc = rtems_event_receive(RTEMS_EVENT_7 | RTEMS_EVENT_9,
+	    RTEMS_EVENT_ALL | RTEMS_NO_WAIT, 0, &events);
+	assert(sc == RTEMS_SUCCESSFUL);
+	assert(events == (RTEMS_EVENT_7 | RTEMS_EVENT_9));
+
+	rv = close(kq);
+	assert(rv == 0);
+}
+
+static void
+test_kqueue_rtems_mq(test_context *ctx)
+{
+	static const struct timespec no_wait;
+	rtems_status_code sc;
+	struct kevent change;
+	struct kevent event;
+	rtems_id id;
+	size_t size;
+	int kq;
+	int rv;
+
+	puts("test kqueue RTEMS message queue");
+
+	sc = rtems_message_queue_create(rtems_build_name('K', 'Q', 'M', 'Q'),
+	    2, sizeof(msg), RTEMS_DEFAULT_ATTRIBUTES, &id);
+	assert(sc == RTEMS_SUCCESSFUL);
+
+	kq = kqueue();
+	assert(kq >= 0);
+
+	EV_SET(&change, id, EVFILT_RTEMS_MQ, EV_ADD | EV_ENABLE, 0, 0,
+	    TEST_UDATA);
+
+	rv = kevent(kq, &change, 1, NULL, 0, NULL);
+	assert(rv == 0);
+
+	rv = kevent(kq, NULL, 0, &event, 1, &no_wait);
+	assert(rv == 0);
+
+	sc = rtems_message_queue_send(id, msg, sizeof(msg));
+	assert(sc == RTEMS_SUCCESSFUL);
+
+	sc = rtems_message_queue_send(id, msg, sizeof(msg));
+	assert(sc == RTEMS_SUCCESSFUL);
+
+	memset(&event, 0, sizeof(event));
+	rv = kevent(kq, NULL, 0, &event, 1, NULL);
+	assert(rv == 1);
+	assert(event.ident == id);
+	assert(event.filter == EVFILT_RTEMS_MQ);
+	assert(event.flags == 0);
+	assert(event.data == 2);
+	assert(event.udata == TEST_UDATA);
+
+	sc = rtems_message_queue_receive(id, &ctx->buf[0], &size,
+	    RTEMS_NO_WAIT, 0);
+	assert(sc == RTEMS_SUCCESSFUL);
+	assert(size == sizeof(msg));
+
+	memset(&event, 0, sizeof(event));
+	rv = kevent(kq, NULL, 0, &event, 1, &no_wait);
+	assert(rv == 1);
+	assert(event.data == 1);
+
+	sc = rtems_message_queue_receive(id, &ctx->buf[0], &size,
+	    RTEMS_NO_WAIT, 0);
+	assert(sc == RTEMS_SUCCESSFUL);
+
+	rv = kevent(kq, NULL, 0, &event, 1, &no_wait);
+	assert(rv == 0);
+
+	rv = close(kq);
+	assert(rv == 0);
+
+	sc = rtems_message_queue_delete(id);
+	assert(sc == RTEMS_SUCCESSFUL);
+}
+
+static void
+test_kqueue_rtems_sem(test_context *ctx)
+{
+	static const struct timespec no_wait;
+	rtems_status_code sc;
+	struct kevent change;
+	struct kevent event;
+	rtems_id id;
+	int kq;
+	int rv;
+
+	puts("test kqueue RTEMS semaphore");
+
+	sc = rtems_semaphore_create(rtems_build_name('K', 'Q', 'S', 'M'), 0,
+	    RTEMS_COUNTING_SEMAPHORE, 0, &id);
+	assert(sc == RTEMS_SUCCESSFUL);
+
+	kq = kqueue();
+	assert(kq >= 0);
+
+	EV_SET(&change, id, EVFILT_RTEMS_SEM, EV_ADD | EV_ENABLE, 0, 0,
+	    TEST_UDATA);
+
+	rv = kevent(kq, &change, 1, NULL, 0, NULL);
+	assert(rv == 0);
+
+	sc = rtems_bsd_semaphore_release(id);
+	assert(sc == RTEMS_SUCCESSFUL);
+
+	sc = rtems_bsd_semaphore_release(id);
+	assert(sc == RTEMS_SUCCESSFUL);
+
+	memset(&event, 0, sizeof(event));
+	rv = kevent(kq, NULL, 0, &event, 1, NULL);
+	assert(rv == 1);
+	assert(event.ident == id);
+	assert(event.filter == EVFILT_RTEMS_SEM);
+	assert(event.flags == EV_CLEAR);
+	assert(event.data == 2);
+	assert(event.udata == TEST_UDATA);
+
+	rv = kevent(kq, NULL, 0, &event, 1, &no_wait);
+	assert(rv == 0);
+
+	rv = close(kq);
+	assert(rv == 0);
+
+	sc = rtems_semaphore_delete(id);
+	assert(sc == RTEMS_SUCCESSFUL);
+}
+
 static void
 test_pipe_timeout(test_context *ctx)
 {
@@ -1207,6 +1375,9 @@ test_main(void)
 	test_kqueue_write(ctx);
 	test_kqueue_close(ctx);
 	test_kqueue_user(ctx);
+	test_kqueue_rtems_event(ctx);
+	test_kqueue_rtems_mq(ctx);
+	test_kqueue_rtems_sem(ctx);
 
 	test_pipe_timeout(ctx);
 	test_pipe_read(ctx);
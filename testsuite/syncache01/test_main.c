@@ -0,0 +1,399 @@
+/*
+ * Copyright (c) 2026 embedded brains GmbH.  All rights reserved.
+ *
+ *  embedded brains GmbH
+ *  Dornierstr. 4
+ *  82178 Puchheim
+ *  Germany
+ *  <rtems@embedded-brains.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Reconnect storm.  Client tasks connect to a local server over the
+ * loopback interface and reset the connection immediately, as after a
+ * network flap.  The accepted connections per second are reported first
+ * without and then with a flood of spoofed SYNs.  The spoofed sources are
+ * routed to a blackhole, so their entries stay in the syncache until it
+ * exceeds its memory limit and falls back to SYN cookies.  Finally the
+ * syncache zones are shown by vmstat -z.
+ */
+
+#include <sys/param.h>
+#include <sys/socket.h>
+#include <sys/sysctl.h>
+#include <netinet/in.h>
+#include <netinet/in_systm.h>
+#include <netinet/ip.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sysexits.h>
+#include <unistd.h>
+
+#include <machine/rtems-bsd-commands.h>
+
+#include <rtems.h>
+
+#define TEST_NAME "LIBBSD SYNCACHE 1"
+
+#define CLIENT_COUNT 4
+
+#define PORT 1234
+
+#define RUN_SECONDS 2
+
+#define FLOOD_BURST 32
+
+typedef struct {
+	volatile bool clients_active;
+	volatile bool flood_active;
+	volatile uint32_t accepted;
+	volatile uint32_t failed;
+	int listener;
+	int raw;
+} test_context;
+
+static test_context test_instance;
+
+static void
+command(int (*cmd)(int, char **), char **argv, int argc)
+{
+	int exit_code;
+
+	exit_code = (*cmd)(argc, argv);
+	assert(exit_code == EX_OK);
+}
+
+static void
+setup_network(void)
+{
+	char *lo0[] = {
+		"ifconfig",
+		"lo0",
+		"inet",
+		"127.0.0.1",
+		"netmask",
+		"255.0.0.0",
+		NULL
+	};
+	char *blackhole[] = {
+		"route",
+		"add",
+		"-net",
+		"10.99.0.0/16",
+		"127.0.0.1",
+		"-blackhole",
+		NULL
+	};
+
+	command(rtems_bsd_command_ifconfig, lo0, RTEMS_BSD_ARGC(lo0));
+	command(rtems_bsd_command_route, blackhole, RTEMS_BSD_ARGC(blackhole));
+}
+
+static void
+server_addr(struct sockaddr_in *sin)
+{
+
+	memset(sin, 0, sizeof(*sin));
+	sin->sin_len = sizeof(*sin);
+	sin->sin_family = AF_INET;
+	sin->sin_port = htons(PORT);
+	sin->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+}
+
+static void
+start_task(rtems_task_entry entry, rtems_task_priority prio,
+    rtems_task_argument arg)
+{
+	rtems_status_code sc;
+	rtems_id id;
+
+	sc = rtems_task_create(rtems_build_name('S', 'T', 'R', 'M'), prio,
+	    RTEMS_MINIMUM_STACK_SIZE, RTEMS_DEFAULT_MODES,
+	    RTEMS_DEFAULT_ATTRIBUTES, &id);
+	assert(sc == RTEMS_SUCCESSFUL);
+
+	sc = rtems_task_start(id, entry, arg);
+	assert(sc == RTEMS_SUCCESSFUL);
+}
+
+static void
+server_task(rtems_task_argument arg)
+{
+	test_context *ctx = (test_context *)arg;
+
+	while (true) {
+		int s;
+
+		s = accept(ctx->listener, NULL, NULL);
+		if (s >= 0) {
+			++ctx->accepted;
+			close(s);
+		}
+	}
+}
+
+static void
+client_task(rtems_task_argument arg)
+{
+	test_context *ctx = (test_context *)arg;
+	struct sockaddr_in sin;
+	struct linger l;
+
+	server_addr(&sin);
+	l.l_onoff = 1;
+	l.l_linger = 0;
+
+	while (true) {
+		int rv;
+		int s;
+
+		if (!ctx->clients_active) {
+			rtems_task_wake_after(1);
+			continue;
+		}
+
+		s = socket(PF_INET, SOCK_STREAM, 0);
+		assert(s >= 0);
+
+		/* Reset on close, so that no TIME_WAIT state is left behind */
+		rv = setsockopt(s, SOL_SOCKET, SO_LINGER, &l, sizeof(l));
+		assert(rv == 0);
+
+		rv = connect(s, (const struct sockaddr *)&sin, sizeof(sin));
+		if (rv != 0)
+			++ctx->failed;
+
+		rv = close(s);
+		assert(rv == 0);
+	}
+}
+
+static uint16_t
+cksum(const void *data, size_t len, uint32_t sum)
+{
+	const uint16_t *w = data;
+
+	while (len > 1) {
+		sum += *w;
+		++w;
+		len -= 2;
+	}
+	if (len > 0)
+		sum += *(const uint8_t *)w;
+
+	sum = (sum >> 16) + (sum & 0xffff);
+	sum += sum >> 16;
+	return ((uint16_t)~sum);
+}
+
+static void
+send_syn(test_context *ctx, uint32_t n)
+{
+	struct {
+		struct ip ip;
+		struct tcphdr th;
+	} pkt;
+	struct {
+		struct in_addr src;
+		struct in_addr dst;
+		uint8_t zero;
+		uint8_t proto;
+		uint16_t len;
+		struct tcphdr th;
+	} pseudo;
+	struct sockaddr_in sin;
+	ssize_t rv;
+
+	memset(&pkt, 0, sizeof(pkt));
+	pkt.ip.ip_v = IPVERSION;
+	pkt.ip.ip_hl = sizeof(pkt.ip) >> 2;
+	pkt.ip.ip_len = htons(sizeof(pkt));
+	pkt.ip.ip_ttl = 64;
+	pkt.ip.ip_p = IPPROTO_TCP;
+	pkt.ip.ip_src.s_addr = htonl(0x0a630000 | (n & 0xffff));
+	pkt.ip.ip_dst.s_addr = htonl(INADDR_LOOPBACK);
+	pkt.th.th_sport = htons(1024 + (n >> 16));
+	pkt.th.th_dport = htons(PORT);
+	pkt.th.th_seq = htonl(n);
+	pkt.th.th_off = sizeof(pkt.th) >> 2;
+	pkt.th.th_flags = TH_SYN;
+	pkt.th.th_win = htons(65535);
+
+	memset(&pseudo, 0, sizeof(pseudo));
+	pseudo.src = pkt.ip.ip_src;
+	pseudo.dst = pkt.ip.ip_dst;
+	pseudo.proto = IPPROTO_TCP;
+	pseudo.len = htons(sizeof(pkt.th));
+	pseudo.th = pkt.th;
+	pkt.th.th_sum = cksum(&pseudo, sizeof(pseudo), 0);
+
+	server_addr(&sin);
+	rv = sendto(ctx->raw, &pkt, sizeof(pkt), 0,
+	    (const struct sockaddr *)&sin, sizeof(sin));
+	assert(rv == (ssize_t)sizeof(pkt) || errno == ENOBUFS);
+}
+
+static void
+flood_task(rtems_task_argument arg)
+{
+	test_context *ctx = (test_context *)arg;
+	uint32_t n;
+
+	n = 0;
+
+	while (true) {
+		int i;
+
+		if (ctx->flood_active) {
+			for (i = 0; i < FLOOD_BURST; ++i) {
+				send_syn(ctx, n);
+				++n;
+			}
+		}
+
+		rtems_task_wake_after(1);
+	}
+}
+
+static u_int
+get_uint(const char *name)
+{
+	u_int value;
+	size_t len;
+	int rv;
+
+	len = sizeof(value);
+	rv = sysctlbyname(name, &value, &len, NULL, 0);
+	assert(rv == 0);
+	return (value);
+}
+
+static u_long
+get_ulong(const char *name)
+{
+	u_long value;
+	size_t len;
+	int rv;
+
+	len = sizeof(value);
+	rv = sysctlbyname(name, &value, &len, NULL, 0);
+	assert(rv == 0);
+	return (value);
+}
+
+static void
+run(test_context *ctx, const char *name)
+{
+	uint32_t accepted;
+	uint32_t failed;
+	uint64_t start;
+	uint64_t delta;
+
+	accepted = ctx->accepted;
+	failed = ctx->failed;
+	start = rtems_clock_get_uptime_nanoseconds();
+	ctx->clients_active = true;
+
+	rtems_task_wake_after(RUN_SECONDS * rtems_clock_get_ticks_per_second());
+
+	ctx->clients_active = false;
+	delta = rtems_clock_get_uptime_nanoseconds() - start;
+	accepted = ctx->accepted - accepted;
+	failed = ctx->failed - failed;
+
+	printf("%s: %" PRIu32 " connections accepted, %" PRIu64 "/s, "
+	    "%" PRIu32 " failed, syncache hash size %u, %u entries\n", name,
+	    accepted, (uint64_t)accepted * 1000000000 / delta, failed,
+	    get_uint("net.inet.tcp.syncache.hashsize"),
+	    get_uint("net.inet.tcp.syncache.count"));
+}
+
+static void
+test_main(void)
+{
+	test_context *ctx = &test_instance;
+	struct sockaddr_in sin;
+	rtems_status_code sc;
+	rtems_task_priority prio;
+	char *vmstat[] = {
+		"vmstat",
+		"-z",
+		NULL
+	};
+	int on;
+	int rv;
+	int i;
+
+	sc = rtems_task_set_priority(RTEMS_SELF, 110, &prio);
+	assert(sc == RTEMS_SUCCESSFUL);
+
+	setup_network();
+
+	ctx->listener = socket(PF_INET, SOCK_STREAM, 0);
+	assert(ctx->listener >= 0);
+
+	server_addr(&sin);
+	rv = bind(ctx->listener, (const struct sockaddr *)&sin, sizeof(sin));
+	assert(rv == 0);
+
+	rv = listen(ctx->listener, SOMAXCONN);
+	assert(rv == 0);
+
+	ctx->raw = socket(PF_INET, SOCK_RAW, IPPROTO_RAW);
+	assert(ctx->raw >= 0);
+
+	on = 1;
+	rv = setsockopt(ctx->raw, IPPROTO_IP, IP_HDRINCL, &on, sizeof(on));
+	assert(rv == 0);
+
+	start_task(server_task, 120, (rtems_task_argument)ctx);
+	for (i = 0; i < CLIENT_COUNT; ++i)
+		start_task(client_task, 121, (rtems_task_argument)ctx);
+	start_task(flood_task, 122, (rtems_task_argument)ctx);
+
+	printf("syncache hash size %u, limit %u entries, %lu bytes\n",
+	    get_uint("net.inet.tcp.syncache.hashsize"),
+	    get_uint("net.inet.tcp.syncache.cachelimit"),
+	    get_ulong("net.inet.tcp.syncache.memlimit"));
+
+	run(ctx, "reconnect");
+
+	ctx->flood_active = true;
+	run(ctx, "reconnect with SYN flood");
+	ctx->flood_active = false;
+
+	command(rtems_bsd_command_vmstat, vmstat, RTEMS_BSD_ARGC(vmstat));
+
+	exit(0);
+}
+
+#include <rtems/bsd/test/default-init.h>
@@ -0,0 +1,349 @@
+/*
+ * Copyright (c) 2026 embedded brains GmbH.  All rights reserved.
+ *
+ *  embedded brains GmbH
+ *  Dornierstr. 4
+ *  82178 Puchheim
+ *  Germany
+ *  <rtems@embedded-brains.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Tail latency of short request/response exchanges on a lossy link.  A
+ * dummynet pipe with a delay of 10ms and a packet loss rate of 3% is
+ * attached to the loopback interface, so that data and ACKs are delayed
+ * and lost in both directions.  A client sends requests of a few segments
+ * to an echo server over one connection and waits for the short response.
+ * The exchange latency is reported for the default TCP stack and for the
+ * rack stack with RACK loss detection and tail loss probes, followed by
+ * the TCP statistics.  Only the rack stack must send tail loss probes and
+ * start recoveries through RACK.
+ *
+ * Everything runs in one network stack, so the loopback interface is used
+ * instead of an epair(4) interface.
+ */
+
+#include <sys/param.h>
+#include <sys/socket.h>
+#include <sys/sysctl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netinet/tcp_var.h>
+#include <arpa/inet.h>
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sysexits.h>
+#include <unistd.h>
+
+#include <machine/rtems-bsd-commands.h>
+#include <machine/rtems-bsd-rc-conf.h>
+
+#include <rtems.h>
+
+#define TEST_NAME "LIBBSD TCP RACK 1"
+
+#define PORT 1234
+
+#define MTU "1500"
+
+#define REQUEST_SIZE (4 * 1400)
+
+#define RESPONSE_SIZE 64
+
+#define EXCHANGE_COUNT 200
+
+typedef struct {
+	const char *stack;
+	int listener;
+	rtems_id main_task;
+	uint32_t latency_us[EXCHANGE_COUNT];
+	char request[REQUEST_SIZE];
+	char response[REQUEST_SIZE];
+} test_context;
+
+static test_context test_instance;
+
+static const char * const stacks[] = {
+	"default",
+	"rack"
+};
+
+static const char rc_conf_text[] =
+    "dummynet_enable=\"YES\"\n"
+    "dummynet_pipes=\"1\"\n"
+    "dummynet_pipe_1=\"delay 10 plr 0.03\"\n"
+    "dummynet_pipe_1_ifname=\"lo0\"\n"
+    "dummynet_accept=\"YES\"\n";
+
+static void
+setup_network(void)
+{
+	char *lo0[] = {
+		"ifconfig",
+		"lo0",
+		"inet",
+		"127.0.0.1",
+		"netmask",
+		"255.0.0.0",
+		"mtu",
+		MTU,
+		NULL
+	};
+	int exit_code;
+
+	exit_code = rtems_bsd_command_ifconfig(RTEMS_BSD_ARGC(lo0), lo0);
+	assert(exit_code == EX_OK);
+
+	exit_code = rtems_bsd_run_rc_conf_script("internal", rc_conf_text, 15,
+	    true);
+	assert(exit_code == 0);
+}
+
+static void
+server_addr(struct sockaddr_in *sin, int port)
+{
+
+	memset(sin, 0, sizeof(*sin));
+	sin->sin_len = sizeof(*sin);
+	sin->sin_family = AF_INET;
+	sin->sin_port = htons(port);
+	sin->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+}
+
+static void
+set_options(int s, const char *stack)
+{
+	struct tcp_function_set fs;
+	int on;
+	int rv;
+
+	memset(&fs, 0, sizeof(fs));
+	strlcpy(fs.function_set_name, stack, sizeof(fs.function_set_name));
+	rv = setsockopt(s, IPPROTO_TCP, TCP_FUNCTION_BLK, &fs, sizeof(fs));
+	assert(rv == 0);
+
+	on = 1;
+	rv = setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+	assert(rv == 0);
+}
+
+static bool
+read_all(int s, char *buf, size_t size)
+{
+
+	while (size > 0) {
+		ssize_t n;
+
+		n = read(s, buf, size);
+		if (n <= 0)
+			return (false);
+
+		buf += n;
+		size -= (size_t)n;
+	}
+
+	return (true);
+}
+
+static void
+server_task(rtems_task_argument arg)
+{
+	test_context *ctx = (test_context *)arg;
+	struct tcp_function_set fs;
+	socklen_t len;
+	rtems_status_code sc;
+	int rv;
+	int s;
+
+	s = accept(ctx->listener, NULL, NULL);
+	assert(s >= 0);
+
+	/* The accepted connection inherits the stack of the listener */
+	len = sizeof(fs);
+	rv = getsockopt(s, IPPROTO_TCP, TCP_FUNCTION_BLK, &fs, &len);
+	assert(rv == 0);
+	assert(strcmp(fs.function_set_name, ctx->stack) == 0);
+
+	while (read_all(s, ctx->response, REQUEST_SIZE)) {
+		ssize_t n;
+
+		n = write(s, ctx->response, RESPONSE_SIZE);
+		assert(n == RESPONSE_SIZE);
+	}
+
+	rv = close(s);
+	assert(rv == 0);
+
+	sc = rtems_event_transient_send(ctx->main_task);
+	assert(sc == RTEMS_SUCCESSFUL);
+
+	rtems_task_delete(RTEMS_SELF);
+}
+
+static void
+get_tcpstat(struct tcpstat *stat)
+{
+	size_t len;
+	int rv;
+
+	len = sizeof(*stat);
+	rv = sysctlbyname("net.inet.tcp.stats", stat, &len, NULL, 0);
+	assert(rv == 0);
+}
+
+static int
+compare_latency(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *)a;
+	uint32_t y = *(const uint32_t *)b;
+
+	return (x < y ? -1 : (x > y ? 1 : 0));
+}
+
+static void
+test_stack(test_context *ctx, int i)
+{
+	struct tcpstat before;
+	struct tcpstat after;
+	struct sockaddr_in sin;
+	rtems_status_code sc;
+	rtems_id id;
+	char response[RESPONSE_SIZE];
+	int port;
+	int rv;
+	int s;
+	int j;
+
+	ctx->stack = stacks[i];
+	port = PORT + i;
+	server_addr(&sin, port);
+
+	ctx->listener = socket(PF_INET, SOCK_STREAM, 0);
+	assert(ctx->listener >= 0);
+
+	set_options(ctx->listener, ctx->stack);
+
+	rv = bind(ctx->listener, (const struct sockaddr *)&sin, sizeof(sin));
+	assert(rv == 0);
+
+	rv = listen(ctx->listener, 1);
+	assert(rv == 0);
+
+	sc = rtems_task_create(rtems_build_name('S', 'R', 'V', ' '), 120,
+	    RTEMS_MINIMUM_STACK_SIZE, RTEMS_DEFAULT_MODES,
+	    RTEMS_DEFAULT_ATTRIBUTES, &id);
+	assert(sc == RTEMS_SUCCESSFUL);
+
+	sc = rtems_task_start(id, server_task, (rtems_task_argument)ctx);
+	assert(sc == RTEMS_SUCCESSFUL);
+
+	s = socket(PF_INET, SOCK_STREAM, 0);
+	assert(s >= 0);
+
+	set_options(s, ctx->stack);
+	get_tcpstat(&before);
+
+	rv = connect(s, (const struct sockaddr *)&sin, sizeof(sin));
+	assert(rv == 0);
+
+	for (j = 0; j < EXCHANGE_COUNT; ++j) {
+		uint64_t start;
+		ssize_t n;
+		bool ok;
+
+		start = rtems_clock_get_uptime_nanoseconds();
+
+		n = write(s, ctx->request, REQUEST_SIZE);
+		assert(n == REQUEST_SIZE);
+
+		ok = read_all(s, response, RESPONSE_SIZE);
+		assert(ok);
+
+		ctx->latency_us[j] = (uint32_t)
+		    ((rtems_clock_get_uptime_nanoseconds() - start) / 1000);
+	}
+
+	rv = close(s);
+	assert(rv == 0);
+
+	sc = rtems_event_transient_receive(RTEMS_WAIT, RTEMS_NO_TIMEOUT);
+	assert(sc == RTEMS_SUCCESSFUL);
+
+	rv = close(ctx->listener);
+	assert(rv == 0);
+
+	get_tcpstat(&after);
+
+	qsort(ctx->latency_us, EXCHANGE_COUNT, sizeof(ctx->latency_us[0]),
+	    compare_latency);
+
+	printf("%-8s: %d exchanges, p50 %" PRIu32 "us, p90 %" PRIu32
+	    "us, p99 %" PRIu32 "us, max %" PRIu32 "us\n", ctx->stack,
+	    EXCHANGE_COUNT, ctx->latency_us[EXCHANGE_COUNT / 2],
+	    ctx->latency_us[(EXCHANGE_COUNT * 90) / 100],
+	    ctx->latency_us[(EXCHANGE_COUNT * 99) / 100],
+	    ctx->latency_us[EXCHANGE_COUNT - 1]);
+
+	if (strcmp(ctx->stack, "rack") == 0) {
+		assert(after.tcps_tlp_probes > before.tcps_tlp_probes);
+		assert(after.tcps_rack_recovery > before.tcps_rack_recovery);
+	} else {
+		assert(after.tcps_tlp_probes == before.tcps_tlp_probes);
+		assert(after.tcps_rack_recovery == before.tcps_rack_recovery);
+	}
+}
+
+static void
+test_main(void)
+{
+	test_context *ctx = &test_instance;
+	char *netstat[] = {
+		"netstat",
+		"-s",
+		"-p",
+		"tcp",
+		NULL
+	};
+	size_t i;
+	int exit_code;
+
+	ctx->main_task = rtems_task_self();
+
+	setup_network();
+
+	for (i = 0; i < nitems(stacks); ++i)
+		test_stack(ctx, (int)i);
+
+	exit_code = rtems_bsd_command_netstat(RTEMS_BSD_ARGC(netstat), netstat);
+	assert(exit_code == EX_OK);
+
+	exit(0);
+}
+
+#include <rtems/bsd/test/default-init.h>
@@ -0,0 +1,343 @@
+/*
+ * Copyright (c) 2026 embedded brains GmbH.  All rights reserved.
+ *
+ *  embedded brains GmbH
+ *  Dornierstr. 4
+ *  82178 Puchheim
+ *  Germany
+ *  <rtems@embedded-brains.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Deferred receive wakeups of UDP sockets with a receive low-water mark.
+ * Datagrams below SO_RCVLOWAT are not readable until the UDP_RCVLOWAT_TIMEO
+ * time limit expires.  After that poll(), select() and kevent() report the
+ * socket as readable until the receive buffer is drained, then the next
+ * datagram is deferred again.  A limit of zero disables the deferral, so
+ * data below the mark stays unreadable, and -1 selects the
+ * net.inet.udp.rcvlowat_timeo default.
+ */
+
+#include <sys/param.h>
+#include <sys/event.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sysexits.h>
+#include <unistd.h>
+
+#include <machine/rtems-bsd-commands.h>
+
+#include <rtems/bsd/kevent.h>
+#include <rtems.h>
+
+#define TEST_NAME "LIBBSD UDP LOWAT 1"
+
+#define PORT 1234
+
+#define LOWAT 1000
+
+#define DATAGRAM_SIZE 100
+
+/* Deferral time limit in microseconds */
+#define TIMEO 20000
+
+static void
+setup_network(void)
+{
+	char *lo0[] = {
+		"ifconfig",
+		"lo0",
+		"inet",
+		"127.0.0.1",
+		"netmask",
+		"255.0.0.0",
+		NULL
+	};
+	int exit_code;
+
+	exit_code = rtems_bsd_command_ifconfig(RTEMS_BSD_ARGC(lo0), lo0);
+	assert(exit_code == EX_OK);
+}
+
+static void
+loopback_addr(struct sockaddr_in *sin, int port)
+{
+
+	memset(sin, 0, sizeof(*sin));
+	sin->sin_len = sizeof(*sin);
+	sin->sin_family = AF_INET;
+	sin->sin_port = htons(port);
+	sin->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+}
+
+static int
+open_receiver(int timeo)
+{
+	struct sockaddr_in sin;
+	int optval;
+	int rv;
+	int s;
+
+	s = socket(PF_INET, SOCK_DGRAM, 0);
+	assert(s >= 0);
+
+	loopback_addr(&sin, PORT);
+	rv = bind(s, (const struct sockaddr *)&sin, sizeof(sin));
+	assert(rv == 0);
+
+	optval = LOWAT;
+	rv = setsockopt(s, SOL_SOCKET, SO_RCVLOWAT, &optval, sizeof(optval));
+	assert(rv == 0);
+
+	optval = timeo;
+	rv = setsockopt(s, IPPROTO_UDP, UDP_RCVLOWAT_TIMEO, &optval,
+	    sizeof(optval));
+	assert(rv == 0);
+
+	return (s);
+}
+
+static int
+get_timeo(int s)
+{
+	socklen_t len;
+	int optval;
+	int rv;
+
+	len = sizeof(optval);
+	rv = getsockopt(s, IPPROTO_UDP, UDP_RCVLOWAT_TIMEO, &optval, &len);
+	assert(rv == 0);
+	assert(len == sizeof(optval));
+	return (optval);
+}
+
+static void
+send_datagram(int s)
+{
+	struct sockaddr_in sin;
+	char buf[DATAGRAM_SIZE];
+	ssize_t n;
+
+	memset(buf, 0, sizeof(buf));
+	loopback_addr(&sin, PORT);
+	n = sendto(s, buf, sizeof(buf), 0, (const struct sockaddr *)&sin,
+	    sizeof(sin));
+	assert(n == (ssize_t)sizeof(buf));
+}
+
+static void
+receive_datagram(int s)
+{
+	char buf[DATAGRAM_SIZE];
+	ssize_t n;
+
+	n = recv(s, buf, sizeof(buf), 0);
+	assert(n == (ssize_t)sizeof(buf));
+}
+
+static int
+poll_readable(int s, int timeout_ms)
+{
+	struct pollfd pfd;
+	int rv;
+
+	pfd.fd = s;
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+	rv = poll(&pfd, 1, timeout_ms);
+	assert(rv >= 0);
+	assert(rv == 0 || (pfd.revents & POLLIN) != 0);
+	return (rv);
+}
+
+static int
+select_readable(int s)
+{
+	struct timeval tv;
+	fd_set set;
+	int rv;
+
+	FD_ZERO(&set);
+	FD_SET(s, &set);
+	tv.tv_sec = 0;
+	tv.tv_usec = 0;
+	rv = select(s + 1, &set, NULL, NULL, &tv);
+	assert(rv >= 0);
+	return (rv);
+}
+
+static int
+kevent_readable(int kq)
+{
+	struct timespec ts;
+	struct kevent event;
+	int rv;
+
+	ts.tv_sec = 0;
+	ts.tv_nsec = 0;
+	rv = kevent(kq, NULL, 0, &event, 1, &ts);
+	assert(rv >= 0);
+	return (rv);
+}
+
+static void
+test_options(void)
+{
+	int optval;
+	int rv;
+	int s;
+
+	s = socket(PF_INET, SOCK_DGRAM, 0);
+	assert(s >= 0);
+
+	/* New sockets use the default */
+	assert(get_timeo(s) == -1);
+
+	optval = 0;
+	rv = setsockopt(s, IPPROTO_UDP, UDP_RCVLOWAT_TIMEO, &optval,
+	    sizeof(optval));
+	assert(rv == 0);
+	assert(get_timeo(s) == 0);
+
+	optval = -2;
+	errno = 0;
+	rv = setsockopt(s, IPPROTO_UDP, UDP_RCVLOWAT_TIMEO, &optval,
+	    sizeof(optval));
+	assert(rv == -1);
+	assert(errno == EINVAL);
+	assert(get_timeo(s) == 0);
+
+	rv = close(s);
+	assert(rv == 0);
+}
+
+static void
+test_deferral(int snd)
+{
+	struct kevent change;
+	int rcv;
+	int kq;
+	int rv;
+	int i;
+
+	rcv = open_receiver(TIMEO);
+
+	kq = kqueue();
+	assert(kq >= 0);
+
+	EV_SET(&change, rcv, EVFILT_READ, EV_ADD, 0, 0, NULL);
+	rv = kevent(kq, &change, 1, NULL, 0, NULL);
+	assert(rv == 0);
+
+	for (i = 0; i < 2; ++i) {
+		send_datagram(snd);
+
+		/* The datagram is below the low-water mark */
+		assert(poll_readable(rcv, 0) == 0);
+		assert(select_readable(rcv) == 0);
+		assert(kevent_readable(kq) == 0);
+
+		/* The expired deferral makes it readable */
+		assert(poll_readable(rcv, 1000) == 1);
+		assert(select_readable(rcv) == 1);
+		assert(kevent_readable(kq) == 1);
+
+		/* Further datagrams are readable without a new deferral */
+		send_datagram(snd);
+		assert(poll_readable(rcv, 1000) == 1);
+
+		receive_datagram(rcv);
+		receive_datagram(rcv);
+
+		/* Nothing left to read */
+		assert(poll_readable(rcv, 0) == 0);
+		assert(kevent_readable(kq) == 0);
+	}
+
+	rv = close(kq);
+	assert(rv == 0);
+
+	rv = close(rcv);
+	assert(rv == 0);
+}
+
+static void
+test_disabled(int snd)
+{
+	int rcv;
+	int rv;
+	int i;
+
+	rcv = open_receiver(0);
+
+	/* Without a deferral limit only the low-water mark counts */
+	send_datagram(snd);
+	assert(poll_readable(rcv, 5 * TIMEO / 1000) == 0);
+	assert(select_readable(rcv) == 0);
+
+	for (i = 1; i < LOWAT / DATAGRAM_SIZE; ++i)
+		send_datagram(snd);
+
+	assert(poll_readable(rcv, 1000) == 1);
+
+	for (i = 0; i < LOWAT / DATAGRAM_SIZE; ++i)
+		receive_datagram(rcv);
+
+	assert(poll_readable(rcv, 0) == 0);
+
+	rv = close(rcv);
+	assert(rv == 0);
+}
+
+static void
+test_main(void)
+{
+	int snd;
+	int rv;
+
+	setup_network();
+
+	snd = socket(PF_INET, SOCK_DGRAM, 0);
+	assert(snd >= 0);
+
+	test_options();
+	test_deferral(snd);
+	test_disabled(snd);
+
+	rv = close(snd);
+	assert(rv == 0);
+
+	exit(0);
+}
+
+#include <rtems/bsd/test/default-init.h>
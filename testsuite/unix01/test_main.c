@@ -34,10 +34,13 @@
 #include <sys/un.h>
 #include <sys/stat.h>
 #include <sys/socket.h>
+#include <sys/sysctl.h>
+#include <sys/time.h>
 #include <fcntl.h>
 
 #include <assert.h>
 #include <errno.h>
+#include <inttypes.h>
 #include <limits.h>
 #include <stdbool.h>
 #include <stdio.h>
@@ -52,6 +55,48 @@
 
 static const char name[] = "unix01.sock";
 
+#define PRIO_MASTER 2
+
+#define PRIO_WORKER 2
+
+#define EVENT_STREAM RTEMS_EVENT_0
+
+#define EVENT_DGRAM RTEMS_EVENT_1
+
+#define EVENT_LATENCY RTEMS_EVENT_2
+
+#define EVENT_DONE RTEMS_EVENT_3
+
+#define TOTAL_SIZE (16 * 1024 * 1024)
+
+#define MAX_BLOCK_SIZE (64 * 1024)
+
+#define DGRAM_SIZE 128
+
+#define DGRAM_COUNT 100000
+
+#define ROUND_TRIPS 10000
+
+typedef struct {
+	rtems_id master_task;
+	rtems_id worker_task;
+	int sd[2];
+	size_t block_size;
+	bool verify;
+	uint8_t wbuf[MAX_BLOCK_SIZE];
+	uint8_t rbuf[MAX_BLOCK_SIZE];
+} bench_context;
+
+static bench_context bench_instance;
+
+static const size_t block_sizes[] = {
+	64,
+	512,
+	4096,
+	16384,
+	65536
+};
+
 static void
 test_unix_socket(bool do_resource_check)
 {
@@ -235,6 +280,391 @@ test_unix_listen_connect_accept_write_read(void)
 	assert(rtems_resource_snapshot_check(&snapshot));
 }
 
+static void
+set_sysctl(const char *sysctl_name, int value)
+{
+	int rv;
+
+	rv = sysctlbyname(sysctl_name, NULL, NULL, &value, sizeof(value));
+	assert(rv == 0);
+}
+
+static void
+send_events(rtems_id task, rtems_event_set events)
+{
+	rtems_status_code sc;
+
+	sc = rtems_event_send(task, events);
+	assert(sc == RTEMS_SUCCESSFUL);
+}
+
+static rtems_event_set
+receive_events(void)
+{
+	rtems_status_code sc;
+	rtems_event_set events;
+
+	sc = rtems_event_receive(RTEMS_ALL_EVENTS, RTEMS_EVENT_ANY | RTEMS_WAIT,
+	    RTEMS_NO_TIMEOUT, &events);
+	assert(sc == RTEMS_SUCCESSFUL);
+
+	return (events);
+}
+
+static void
+worker_stream(bench_context *ctx)
+{
+	size_t todo;
+
+	todo = TOTAL_SIZE;
+
+	while (todo > 0) {
+		ssize_t n;
+
+		n = read(ctx->sd[1], ctx->rbuf, MIN(todo, ctx->block_size));
+		assert(n > 0);
+
+		if (ctx->verify) {
+			size_t offset;
+			size_t i;
+
+			offset = TOTAL_SIZE - todo;
+			for (i = 0; i < (size_t)n; ++i) {
+				assert(ctx->rbuf[i] ==
+				    ctx->wbuf[(offset + i) % sizeof(ctx->wbuf)]);
+			}
+		}
+
+		todo -= (size_t)n;
+	}
+}
+
+static void
+worker_dgram(bench_context *ctx)
+{
+	int i;
+
+	for (i = 0; i < DGRAM_COUNT; ++i) {
+		ssize_t n;
+
+		n = recv(ctx->sd[1], ctx->rbuf, sizeof(ctx->rbuf), 0);
+		assert(n == DGRAM_SIZE);
+	}
+}
+
+static void
+worker_latency(bench_context *ctx)
+{
+	int i;
+
+	for (i = 0; i < ROUND_TRIPS; ++i) {
+		ssize_t n;
+		char c;
+
+		n = read(ctx->sd[1], &c, sizeof(c));
+		assert(n == 1);
+		n = write(ctx->sd[1], &c, sizeof(c));
+		assert(n == 1);
+	}
+}
+
+static void
+worker_task(rtems_task_argument arg)
+{
+	bench_context *ctx = (bench_context *)arg;
+
+	while (true) {
+		rtems_event_set events;
+
+		events = receive_events();
+
+		if ((events & EVENT_STREAM) != 0)
+			worker_stream(ctx);
+
+		if ((events & EVENT_DGRAM) != 0)
+			worker_dgram(ctx);
+
+		if ((events & EVENT_LATENCY) != 0)
+			worker_latency(ctx);
+
+		send_events(ctx->master_task, EVENT_DONE);
+	}
+}
+
+static void
+start_worker(bench_context *ctx)
+{
+	rtems_status_code sc;
+
+	sc = rtems_task_create(
+		rtems_build_name('W', 'O', 'R', 'K'),
+		PRIO_WORKER,
+		RTEMS_MINIMUM_STACK_SIZE,
+		RTEMS_DEFAULT_MODES,
+		RTEMS_FLOATING_POINT,
+		&ctx->worker_task
+	);
+	assert(sc == RTEMS_SUCCESSFUL);
+
+	sc = rtems_task_start(
+		ctx->worker_task,
+		worker_task,
+		(rtems_task_argument) ctx
+	);
+	assert(sc == RTEMS_SUCCESSFUL);
+}
+
+static void
+open_pair(bench_context *ctx, int type)
+{
+	int rv;
+
+	rv = socketpair(PF_UNIX, type, 0, ctx->sd);
+	assert(rv == 0);
+}
+
+static void
+close_pair(bench_context *ctx)
+{
+	int rv;
+
+	rv = close(ctx->sd[0]);
+	assert(rv == 0);
+	rv = close(ctx->sd[1]);
+	assert(rv == 0);
+}
+
+static void
+read_all(int sd, uint8_t *buf, size_t size)
+{
+	while (size > 0) {
+		ssize_t n;
+
+		n = read(sd, buf, size);
+		assert(n > 0);
+		buf += n;
+		size -= (size_t)n;
+	}
+}
+
+static void
+test_unix_stream_write_then_read(bench_context *ctx)
+{
+	struct timeval tv;
+	socklen_t len;
+	ssize_t n;
+	size_t i;
+	int sndbuf;
+	int rv;
+
+	puts("test UNIX(4) stream write then read");
+
+	for (i = 0; i < sizeof(ctx->wbuf); ++i)
+		ctx->wbuf[i] = (uint8_t)(i * 7 + 1);
+
+	open_pair(ctx, SOCK_STREAM);
+
+	len = sizeof(sndbuf);
+	rv = getsockopt(ctx->sd[0], SOL_SOCKET, SO_SNDBUF, &sndbuf, &len);
+	assert(rv == 0);
+	assert(sndbuf >= 2 * MCLBYTES);
+	assert(2 * (size_t)sndbuf <= sizeof(ctx->wbuf));
+
+	/* Writes which fit into the receive buffer return without a reader */
+	n = write(ctx->sd[0], ctx->wbuf, (size_t)sndbuf);
+	assert(n == sndbuf);
+	n = write(ctx->sd[1], ctx->wbuf, (size_t)sndbuf);
+	assert(n == sndbuf);
+
+	memset(ctx->rbuf, 0, sizeof(ctx->rbuf));
+	read_all(ctx->sd[1], ctx->rbuf, (size_t)sndbuf);
+	assert(memcmp(ctx->rbuf, ctx->wbuf, (size_t)sndbuf) == 0);
+	memset(ctx->rbuf, 0, sizeof(ctx->rbuf));
+	read_all(ctx->sd[0], ctx->rbuf, (size_t)sndbuf);
+	assert(memcmp(ctx->rbuf, ctx->wbuf, (size_t)sndbuf) == 0);
+
+	/* A write larger than the receive buffer returns after the timeout */
+	tv.tv_sec = 0;
+	tv.tv_usec = 10000;
+	rv = setsockopt(ctx->sd[0], SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+	assert(rv == 0);
+
+	n = write(ctx->sd[0], ctx->wbuf, 2 * (size_t)sndbuf);
+	assert(n > 0 && n < 2 * sndbuf);
+
+	/* The sender buffer may change once the write returned */
+	memset(ctx->wbuf, 0, sizeof(ctx->wbuf));
+	read_all(ctx->sd[1], ctx->rbuf, (size_t)n);
+	for (i = 0; i < (size_t)n; ++i)
+		assert(ctx->rbuf[i] == (uint8_t)(i * 7 + 1));
+
+	close_pair(ctx);
+}
+
+static void
+bench_stream_verify(bench_context *ctx)
+{
+	size_t i;
+
+	puts("test UNIX(4) stream data integrity");
+
+	for (i = 0; i < sizeof(ctx->wbuf); ++i)
+		ctx->wbuf[i] = (uint8_t)(i * 13);
+
+	open_pair(ctx, SOCK_STREAM);
+	ctx->block_size = 1000;
+	ctx->verify = true;
+	send_events(ctx->worker_task, EVENT_STREAM);
+
+	for (i = 0; i < TOTAL_SIZE / sizeof(ctx->wbuf); ++i) {
+		ssize_t n;
+
+		n = write(ctx->sd[0], ctx->wbuf, sizeof(ctx->wbuf));
+		assert(n == (ssize_t)sizeof(ctx->wbuf));
+	}
+
+	assert(receive_events() == EVENT_DONE);
+	ctx->verify = false;
+	close_pair(ctx);
+}
+
+static void
+bench_stream(bench_context *ctx, const char *mode)
+{
+	size_t i;
+
+	open_pair(ctx, SOCK_STREAM);
+
+	for (i = 0; i < RTEMS_ARRAY_SIZE(block_sizes); ++i) {
+		uint64_t t0;
+		uint64_t t1;
+		size_t todo;
+
+		ctx->block_size = block_sizes[i];
+		todo = TOTAL_SIZE;
+
+		t0 = rtems_clock_get_uptime_nanoseconds();
+		send_events(ctx->worker_task, EVENT_STREAM);
+
+		while (todo > 0) {
+			ssize_t n;
+
+			n = write(ctx->sd[0], ctx->wbuf,
+			    MIN(todo, ctx->block_size));
+			assert(n > 0);
+			todo -= (size_t)n;
+		}
+
+		assert(receive_events() == EVENT_DONE);
+		t1 = rtems_clock_get_uptime_nanoseconds();
+
+		printf("%s: stream block size %6zu: %" PRIu64 " KiB/s\n",
+		    mode, ctx->block_size, ((uint64_t)TOTAL_SIZE *
+		    1000000000 / 1024) / (t1 - t0 + 1));
+	}
+
+	close_pair(ctx);
+}
+
+static void
+bench_dgram(bench_context *ctx)
+{
+	uint64_t t0;
+	uint64_t t1;
+	int i;
+
+	open_pair(ctx, SOCK_DGRAM);
+
+	t0 = rtems_clock_get_uptime_nanoseconds();
+	send_events(ctx->worker_task, EVENT_DGRAM);
+
+	for (i = 0; i < DGRAM_COUNT; ++i) {
+		ssize_t n;
+
+		n = send(ctx->sd[0], ctx->wbuf, DGRAM_SIZE, 0);
+		if (n < 0) {
+			/* Receive buffer full, let the worker catch up */
+			assert(errno == ENOBUFS);
+			rtems_task_wake_after(RTEMS_YIELD_PROCESSOR);
+			--i;
+			continue;
+		}
+		assert(n == DGRAM_SIZE);
+	}
+
+	assert(receive_events() == EVENT_DONE);
+	t1 = rtems_clock_get_uptime_nanoseconds();
+
+	printf("dgram size %d: %" PRIu64 " datagrams/s\n", DGRAM_SIZE,
+	    (uint64_t)DGRAM_COUNT * 1000000000 / (t1 - t0 + 1));
+
+	close_pair(ctx);
+}
+
+static void
+bench_latency(bench_context *ctx, int type, const char *mode)
+{
+	uint64_t t0;
+	uint64_t t1;
+	int i;
+
+	open_pair(ctx, type);
+
+	t0 = rtems_clock_get_uptime_nanoseconds();
+	send_events(ctx->worker_task, EVENT_LATENCY);
+
+	for (i = 0; i < ROUND_TRIPS; ++i) {
+		ssize_t n;
+		char c;
+
+		c = (char)i;
+		n = write(ctx->sd[0], &c, sizeof(c));
+		assert(n == 1);
+		n = read(ctx->sd[0], &c, sizeof(c));
+		assert(n == 1);
+		assert(c == (char)i);
+	}
+
+	assert(receive_events() == EVENT_DONE);
+	t1 = rtems_clock_get_uptime_nanoseconds();
+
+	printf("%s: round trip latency %" PRIu64 " ns\n", mode,
+	    (t1 - t0) / ROUND_TRIPS);
+
+	close_pair(ctx);
+}
+
+static void
+test_unix_benchmark(void)
+{
+	bench_context *ctx = &bench_instance;
+	rtems_status_code sc;
+	rtems_task_priority prio;
+
+	puts("test UNIX(4) throughput and latency");
+
+	sc = rtems_task_set_priority(RTEMS_SELF, PRIO_MASTER, &prio);
+	assert(sc == RTEMS_SUCCESSFUL);
+
+	ctx->master_task = rtems_task_self();
+	start_worker(ctx);
+
+	test_unix_stream_write_then_read(ctx);
+	bench_stream_verify(ctx);
+
+	set_sysctl("net.local.stream.direct", 0);
+	bench_stream(ctx, "copy");
+	set_sysctl("net.local.stream.direct", 1);
+	bench_stream(ctx, "direct");
+
+	bench_dgram(ctx);
+	bench_latency(ctx, SOCK_STREAM, "stream");
+	bench_latency(ctx, SOCK_DGRAM, "dgram");
+
+	sc = rtems_task_set_priority(RTEMS_SELF, prio, &prio);
+	assert(sc == RTEMS_SUCCESSFUL);
+}
+
 static void
 test_main(void)
 {
@@ -244,6 +674,7 @@ test_main(void)
 	test_unix_bind(false);
 	test_unix_bind(true);
 	test_unix_listen_connect_accept_write_read();
+	test_unix_benchmark();
 
 	exit(0);
 }